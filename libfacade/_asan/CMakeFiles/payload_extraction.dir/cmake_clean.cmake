@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/payload_extraction.dir/example/payload_extraction.cpp.o"
+  "CMakeFiles/payload_extraction.dir/example/payload_extraction.cpp.o.d"
+  "payload_extraction"
+  "payload_extraction.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/payload_extraction.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
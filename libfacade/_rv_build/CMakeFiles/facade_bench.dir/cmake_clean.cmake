@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/facade_bench.dir/bench/main.cpp.o"
+  "CMakeFiles/facade_bench.dir/bench/main.cpp.o.d"
+  "facade_bench"
+  "facade_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/facade_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,27 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/libfacade.dir/src/convert.cpp.o"
+  "CMakeFiles/libfacade.dir/src/convert.cpp.o.d"
+  "CMakeFiles/libfacade.dir/src/executor.cpp.o"
+  "CMakeFiles/libfacade.dir/src/executor.cpp.o.d"
+  "CMakeFiles/libfacade.dir/src/ico.cpp.o"
+  "CMakeFiles/libfacade.dir/src/ico.cpp.o.d"
+  "CMakeFiles/libfacade.dir/src/payload.cpp.o"
+  "CMakeFiles/libfacade.dir/src/payload.cpp.o.d"
+  "CMakeFiles/libfacade.dir/src/png.cpp.o"
+  "CMakeFiles/libfacade.dir/src/png.cpp.o.d"
+  "CMakeFiles/libfacade.dir/src/signatures.cpp.o"
+  "CMakeFiles/libfacade.dir/src/signatures.cpp.o.d"
+  "CMakeFiles/libfacade.dir/src/stats.cpp.o"
+  "CMakeFiles/libfacade.dir/src/stats.cpp.o.d"
+  "CMakeFiles/libfacade.dir/src/steganalysis.cpp.o"
+  "CMakeFiles/libfacade.dir/src/steganalysis.cpp.o.d"
+  "CMakeFiles/libfacade.dir/src/utility.cpp.o"
+  "CMakeFiles/libfacade.dir/src/utility.cpp.o.d"
+  "libfacade.a"
+  "libfacade.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/libfacade.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/png_manipulation.dir/example/png_manipulation.cpp.o"
+  "CMakeFiles/png_manipulation.dir/example/png_manipulation.cpp.o.d"
+  "png_manipulation"
+  "png_manipulation.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/png_manipulation.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,14 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo/libfacade
+# Build directory: /root/repo/libfacade/_rv_build
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+add_test([=[testfacade]=] "/root/repo/libfacade/_rv_build/testfacade")
+set_tests_properties([=[testfacade]=] PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/libfacade/CMakeLists.txt;114;add_test;/root/repo/libfacade/CMakeLists.txt;0;")
+add_test([=[payload_creation]=] "/root/repo/libfacade/_rv_build/payload_creation")
+set_tests_properties([=[payload_creation]=] PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/libfacade/CMakeLists.txt;118;add_test;/root/repo/libfacade/CMakeLists.txt;0;")
+add_test([=[payload_extraction]=] "/root/repo/libfacade/_rv_build/payload_extraction")
+set_tests_properties([=[payload_extraction]=] PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/libfacade/CMakeLists.txt;122;add_test;/root/repo/libfacade/CMakeLists.txt;0;")
+add_test([=[png_manipulation]=] "/root/repo/libfacade/_rv_build/png_manipulation")
+set_tests_properties([=[png_manipulation]=] PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/libfacade/CMakeLists.txt;126;add_test;/root/repo/libfacade/CMakeLists.txt;0;")
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/facade_e2e.dir/bench/e2e.cpp.o"
+  "CMakeFiles/facade_e2e.dir/bench/e2e.cpp.o.d"
+  "facade_e2e"
+  "facade_e2e.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/facade_e2e.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
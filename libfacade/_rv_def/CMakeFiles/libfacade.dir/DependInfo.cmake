@@ -0,0 +1,27 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/libfacade/src/convert.cpp" "CMakeFiles/libfacade.dir/src/convert.cpp.o" "gcc" "CMakeFiles/libfacade.dir/src/convert.cpp.o.d"
+  "/root/repo/libfacade/src/executor.cpp" "CMakeFiles/libfacade.dir/src/executor.cpp.o" "gcc" "CMakeFiles/libfacade.dir/src/executor.cpp.o.d"
+  "/root/repo/libfacade/src/ico.cpp" "CMakeFiles/libfacade.dir/src/ico.cpp.o" "gcc" "CMakeFiles/libfacade.dir/src/ico.cpp.o.d"
+  "/root/repo/libfacade/src/payload.cpp" "CMakeFiles/libfacade.dir/src/payload.cpp.o" "gcc" "CMakeFiles/libfacade.dir/src/payload.cpp.o.d"
+  "/root/repo/libfacade/src/png.cpp" "CMakeFiles/libfacade.dir/src/png.cpp.o" "gcc" "CMakeFiles/libfacade.dir/src/png.cpp.o.d"
+  "/root/repo/libfacade/src/signatures.cpp" "CMakeFiles/libfacade.dir/src/signatures.cpp.o" "gcc" "CMakeFiles/libfacade.dir/src/signatures.cpp.o.d"
+  "/root/repo/libfacade/src/stats.cpp" "CMakeFiles/libfacade.dir/src/stats.cpp.o" "gcc" "CMakeFiles/libfacade.dir/src/stats.cpp.o.d"
+  "/root/repo/libfacade/src/steganalysis.cpp" "CMakeFiles/libfacade.dir/src/steganalysis.cpp.o" "gcc" "CMakeFiles/libfacade.dir/src/steganalysis.cpp.o.d"
+  "/root/repo/libfacade/src/utility.cpp" "CMakeFiles/libfacade.dir/src/utility.cpp.o" "gcc" "CMakeFiles/libfacade.dir/src/utility.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/testfacade.dir/test/main.cpp.o"
+  "CMakeFiles/testfacade.dir/test/main.cpp.o.d"
+  "testfacade"
+  "testfacade.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/testfacade.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/facade_carriers.dir/bench/carriers.cpp.o"
+  "CMakeFiles/facade_carriers.dir/bench/carriers.cpp.o.d"
+  "facade_carriers"
+  "facade_carriers.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/facade_carriers.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/payload_creation.dir/example/payload_creation.cpp.o"
+  "CMakeFiles/payload_creation.dir/example/payload_creation.cpp.o.d"
+  "payload_creation"
+  "payload_creation.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/payload_creation.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,311 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bench
+{
+   /// @brief Keep the compiler from optimizing away the computation of a value.
+   template <typename T>
+   inline void do_not_optimize(const T &value) {
+#if defined(_MSC_VER)
+      static const void *volatile sink;
+      sink = &value;
+#else
+      asm volatile("" : : "g"(&value) : "memory");
+#endif
+   }
+
+   /// @brief Write a string to a stream as a quoted JSON string.
+   inline void write_json_string(std::ostream &stream, const std::string &value) {
+      stream << '"';
+
+      for (auto c : value)
+      {
+         if (c == '"' || c == '\\') { stream << '\\' << c; }
+         else if (static_cast<unsigned char>(c) < 0x20) { stream << ' '; }
+         else { stream << c; }
+      }
+
+      stream << '"';
+   }
+
+   /// @brief Hardware counter totals, averaged per operation.
+   struct Counters
+   {
+      bool available = false;
+      double cycles = 0;
+      double instructions = 0;
+      double cache_misses = 0;
+      double branch_misses = 0;
+   };
+
+   /// @brief A group of hardware counters read through perf_event_open.
+   ///
+   /// This is only available on Linux, and only if the kernel lets us open the counters (see
+   /// `/proc/sys/kernel/perf_event_paranoid`). Everywhere else it quietly reports nothing.
+   ///
+   class PerfCounters
+   {
+      static const std::size_t Events = 4;
+      int fds[Events] = { -1, -1, -1, -1 };
+
+   public:
+      PerfCounters() {}
+      PerfCounters(const PerfCounters &other) = delete;
+      ~PerfCounters() { this->close(); }
+
+      bool open() {
+#if defined(__linux__)
+         const std::uint64_t configs[Events] = { PERF_COUNT_HW_CPU_CYCLES,
+                                                 PERF_COUNT_HW_INSTRUCTIONS,
+                                                 PERF_COUNT_HW_CACHE_MISSES,
+                                                 PERF_COUNT_HW_BRANCH_MISSES };
+
+         for (std::size_t i=0; i<Events; ++i)
+         {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = configs[i];
+            attr.disabled = (i == 0);
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.inherit = 1;
+
+            auto fd = syscall(SYS_perf_event_open, &attr, 0, -1, (i == 0) ? -1 : this->fds[0], 0);
+            if (fd < 0) { this->close(); return false; }
+
+            this->fds[i] = static_cast<int>(fd);
+         }
+
+         return true;
+#else
+         return false;
+#endif
+      }
+
+      void close() {
+#if defined(__linux__)
+         for (auto &fd : this->fds)
+         {
+            if (fd >= 0) { ::close(fd); }
+            fd = -1;
+         }
+#endif
+      }
+
+      bool available() const { return this->fds[0] >= 0; }
+
+      void start() {
+#if defined(__linux__)
+         if (!this->available()) { return; }
+
+         ioctl(this->fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+         ioctl(this->fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+      }
+
+      Counters stop(std::size_t operations) {
+         Counters result;
+#if defined(__linux__)
+         if (!this->available() || operations == 0) { return result; }
+
+         ioctl(this->fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+         double values[Events];
+
+         for (std::size_t i=0; i<Events; ++i)
+         {
+            std::uint64_t value = 0;
+            if (read(this->fds[i], &value, sizeof(value)) != sizeof(value)) { return result; }
+
+            values[i] = static_cast<double>(value) / operations;
+         }
+
+         result.available = true;
+         result.cycles = values[0];
+         result.instructions = values[1];
+         result.cache_misses = values[2];
+         result.branch_misses = values[3];
+#endif
+         return result;
+      }
+   };
+
+   /// @brief The measurements of a single benchmark.
+   struct Result
+   {
+      std::string name;
+      std::size_t iterations;
+      double ns_per_op;
+      double mb_per_s;
+      double ns_per_pixel;
+      Counters counters;
+   };
+
+   /// @brief Command-line settings for a benchmark run.
+   struct Options
+   {
+      /// @brief Only run benchmarks whose name contains this string.
+      std::string filter;
+      /// @brief Write the results as JSON to this file, or to stdout if it's `-`.
+      std::string json_path;
+      /// @brief Try to collect hardware counters.
+      bool counters = false;
+      /// @brief The minimum time, in milliseconds, to spend measuring each benchmark.
+      double min_time_ms = 200;
+   };
+
+   /// @brief Times benchmarks and collects their results.
+   ///
+   /// Each benchmark is warmed up once, then run in batches whose size doubles until a batch takes a fifth of the
+   /// minimum time. Five batches of that size are timed and the fastest one is reported, which keeps a stray context
+   /// switch from showing up as a regression.
+   ///
+   class Runner
+   {
+      Options options;
+      PerfCounters perf;
+      std::vector<std::pair<std::string, std::string>> context;
+      std::vector<Result> results;
+
+      static double now_ns() {
+         return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+      }
+
+   public:
+      Runner(const Options &options) : options(options) {
+         if (this->options.counters && !this->perf.open())
+            std::cerr << "[-] [bench] hardware counters are unavailable, continuing without them." << std::endl;
+      }
+
+      /// @brief Record something about the machine or build that the results depend on, for the JSON report.
+      void add_context(const std::string &key, const std::string &value) {
+         this->context.push_back(std::make_pair(key, value));
+      }
+
+      /// @brief Whether a benchmark of the given name passes the filter.
+      bool enabled(const std::string &name) const {
+         return this->options.filter.empty() || name.find(this->options.filter) != std::string::npos;
+      }
+
+      /// @brief Time the given function.
+      /// @param name The name of the benchmark, as it appears in the report.
+      /// @param bytes The number of bytes processed by one call, or 0 if throughput doesn't apply.
+      /// @param pixels The number of pixels processed by one call, or 0 if it doesn't apply.
+      /// @param fn The function to time.
+      ///
+      template <typename Fn>
+      void run(const std::string &name, std::size_t bytes, std::size_t pixels, Fn &&fn) {
+         if (!this->enabled(name)) { return; }
+
+         fn();
+
+         auto batch_target = this->options.min_time_ms * 1e6 / 5;
+         std::size_t batch = 1;
+
+         for (;;)
+         {
+            auto start = now_ns();
+
+            for (std::size_t i=0; i<batch; ++i)
+               fn();
+
+            if (now_ns() - start >= batch_target || batch >= (std::size_t(1) << 30)) { break; }
+
+            batch *= 2;
+         }
+
+         double best = std::numeric_limits<double>::max();
+         this->perf.start();
+
+         for (std::size_t round=0; round<5; ++round)
+         {
+            auto start = now_ns();
+
+            for (std::size_t i=0; i<batch; ++i)
+               fn();
+
+            best = std::min(best, (now_ns() - start) / batch);
+         }
+
+         Result result;
+         result.name = name;
+         result.iterations = batch * 5;
+         result.counters = this->perf.stop(batch * 5);
+         result.ns_per_op = best;
+         result.mb_per_s = (bytes == 0) ? 0 : (bytes / (1024.0 * 1024.0)) / (best / 1e9);
+         result.ns_per_pixel = (pixels == 0) ? 0 : best / pixels;
+
+         std::printf("%-48s %14.1f ns/op", name.c_str(), result.ns_per_op);
+         if (bytes != 0) { std::printf(" %10.1f MB/s", result.mb_per_s); }
+         if (pixels != 0) { std::printf(" %8.3f ns/pixel", result.ns_per_pixel); }
+         if (result.counters.available)
+            std::printf(" %6.2f IPC", result.counters.instructions / std::max(result.counters.cycles, 1.0));
+         std::printf("\n");
+         std::fflush(stdout);
+
+         this->results.push_back(result);
+      }
+
+      /// @brief Write every result collected so far as a JSON document.
+      void write_json(std::ostream &stream) const {
+         stream << std::setprecision(10) << "{\n  \"context\": {";
+
+         for (std::size_t i=0; i<this->context.size(); ++i)
+         {
+            stream << ((i == 0) ? " " : ", ");
+            write_json_string(stream, this->context[i].first);
+            stream << ": ";
+            write_json_string(stream, this->context[i].second);
+         }
+
+         stream << " },\n  \"benchmarks\": [";
+
+         for (std::size_t i=0; i<this->results.size(); ++i)
+         {
+            auto &result = this->results[i];
+
+            stream << ((i == 0) ? "\n" : ",\n") << "    { \"name\": ";
+            write_json_string(stream, result.name);
+            stream << ", \"iterations\": " << result.iterations
+                   << ", \"ns_per_op\": " << result.ns_per_op
+                   << ", \"mb_per_s\": " << result.mb_per_s
+                   << ", \"ns_per_pixel\": " << result.ns_per_pixel;
+
+            if (result.counters.available)
+            {
+               stream << ", \"counters\": { \"cycles\": " << result.counters.cycles
+                      << ", \"instructions\": " << result.counters.instructions
+                      << ", \"cache_misses\": " << result.counters.cache_misses
+                      << ", \"branch_misses\": " << result.counters.branch_misses << " }";
+            }
+
+            stream << " }";
+         }
+
+         stream << "\n  ]\n}\n";
+      }
+
+      const Options &settings() const { return this->options; }
+   };
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <facade.hpp>
+
+namespace bench
+{
+   /// @brief The header values and a short name for one of the 15 pixel types.
+   struct PixelFormat
+   {
+      facade::png::PixelEnum pixel_type;
+      const char *name;
+      std::uint8_t bit_depth;
+      std::uint8_t color_type;
+   };
+
+   /// @brief Every pixel type libfacade knows about, in facade::png::PixelEnum order.
+   const PixelFormat PIXEL_FORMATS[15] = {
+      { facade::png::GRAYSCALE_PIXEL_1BIT, "grayscale1", 1, facade::png::ColorType::GRAYSCALE },
+      { facade::png::GRAYSCALE_PIXEL_2BIT, "grayscale2", 2, facade::png::ColorType::GRAYSCALE },
+      { facade::png::GRAYSCALE_PIXEL_4BIT, "grayscale4", 4, facade::png::ColorType::GRAYSCALE },
+      { facade::png::GRAYSCALE_PIXEL_8BIT, "grayscale8", 8, facade::png::ColorType::GRAYSCALE },
+      { facade::png::GRAYSCALE_PIXEL_16BIT, "grayscale16", 16, facade::png::ColorType::GRAYSCALE },
+      { facade::png::TRUE_COLOR_PIXEL_8BIT, "truecolor8", 8, facade::png::ColorType::TRUE_COLOR },
+      { facade::png::TRUE_COLOR_PIXEL_16BIT, "truecolor16", 16, facade::png::ColorType::TRUE_COLOR },
+      { facade::png::PALETTE_PIXEL_1BIT, "palette1", 1, facade::png::ColorType::PALETTE },
+      { facade::png::PALETTE_PIXEL_2BIT, "palette2", 2, facade::png::ColorType::PALETTE },
+      { facade::png::PALETTE_PIXEL_4BIT, "palette4", 4, facade::png::ColorType::PALETTE },
+      { facade::png::PALETTE_PIXEL_8BIT, "palette8", 8, facade::png::ColorType::PALETTE },
+      { facade::png::ALPHA_GRAYSCALE_PIXEL_8BIT, "alphagrayscale8", 8, facade::png::ColorType::ALPHA_GRAYSCALE },
+      { facade::png::ALPHA_GRAYSCALE_PIXEL_16BIT, "alphagrayscale16", 16, facade::png::ColorType::ALPHA_GRAYSCALE },
+      { facade::png::ALPHA_TRUE_COLOR_PIXEL_8BIT, "alphatruecolor8", 8, facade::png::ColorType::ALPHA_TRUE_COLOR },
+      { facade::png::ALPHA_TRUE_COLOR_PIXEL_16BIT, "alphatruecolor16", 16, facade::png::ColorType::ALPHA_TRUE_COLOR }
+   };
+
+   /// @brief A description of a synthetic carrier image.
+   ///
+   /// The content is a diagonal gradient with noise mixed into its low bits. `entropy` picks how many of the eight
+   /// bits of every byte are noise, from 0.0 (a perfectly smooth gradient that deflates to almost nothing) to 1.0
+   /// (uniform noise that doesn't deflate at all).
+   ///
+   struct CarrierSpec
+   {
+      PixelFormat format;
+      std::uint32_t width;
+      std::uint32_t height;
+      double entropy = 0.5;
+      std::uint32_t seed = 0xFACADE;
+
+      facade::png::Header header() const {
+         return facade::png::Header(this->width, this->height, this->format.bit_depth, this->format.color_type);
+      }
+
+      /// @brief The size, in bytes, of one row of pixel data, not counting the filter byte.
+      std::size_t row_size() const {
+         return (static_cast<std::size_t>(this->width) * this->header().pixel_size() + 7) / 8;
+      }
+
+      /// @brief A file name which describes the carrier.
+      std::string file_name() const {
+         return std::string(this->format.name) + "_" + std::to_string(this->width) + "x" + std::to_string(this->height)
+            + "_e" + std::to_string(static_cast<int>(std::lround(this->entropy * 100))) + ".png";
+      }
+
+      /// @brief Fill the given buffer with row `y` of the carrier, without its filter byte.
+      ///
+      /// Every row is generated independently, so a carrier can be written out a row at a time no matter its size.
+      ///
+      void row(std::uint32_t y, std::uint8_t *out) const {
+         auto noise_bits = static_cast<int>(std::lround(std::min(std::max(this->entropy, 0.0), 1.0) * 8));
+         std::uint8_t mask = static_cast<std::uint8_t>((1 << noise_bits) - 1);
+         std::uint32_t state = (this->seed ^ (y * 0x9E3779B9u)) | 1;
+
+         for (std::size_t x=0; x<this->row_size(); ++x)
+         {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+
+            auto gradient = static_cast<std::uint8_t>((x + y) / 4);
+            out[x] = static_cast<std::uint8_t>((gradient & ~mask) | ((gradient ^ state) & mask));
+         }
+      }
+   };
+
+   /// @brief Write one chunk to a PNG stream.
+   inline void write_chunk(std::ostream &stream, const char *tag, const std::uint8_t *data, std::size_t size) {
+      auto length = facade::endian_swap_32(static_cast<std::uint32_t>(size));
+      auto crc = facade::crc32(tag, 4);
+      if (size > 0) { crc = facade::crc32(data, size, crc); }
+      crc = facade::endian_swap_32(crc);
+
+      stream.write(reinterpret_cast<const char *>(&length), 4);
+      stream.write(tag, 4);
+      if (size > 0) { stream.write(reinterpret_cast<const char *>(data), size); }
+      stream.write(reinterpret_cast<const char *>(&crc), 4);
+   }
+
+   /// @brief Write a carrier image to the given stream.
+   ///
+   /// This streams rows straight through deflate into `IDAT` chunks, so memory use stays flat even for 32k by 32k
+   /// carriers. Palette carriers get a grayscale `PLTE` chunk so that they're valid for other decoders too.
+   ///
+   /// @throws facade::exception::ZLibError
+   ///
+   inline void write_carrier(std::ostream &stream, const CarrierSpec &spec, int level=6) {
+      const std::size_t idat_size = 1024 * 1024;
+
+      stream.write(reinterpret_cast<const char *>(facade::png::Image::Signature), 8);
+
+      auto header = spec.header();
+      write_chunk(stream, "IHDR", header.data().data(), header.data().size());
+
+      if (spec.format.color_type == facade::png::ColorType::PALETTE)
+      {
+         std::size_t entries = std::size_t(1) << spec.format.bit_depth;
+         std::vector<std::uint8_t> palette;
+
+         for (std::size_t i=0; i<entries; ++i)
+            palette.insert(palette.end(), 3, static_cast<std::uint8_t>(i * 255 / (entries - 1)));
+
+         write_chunk(stream, "PLTE", palette.data(), palette.size());
+      }
+
+      z_stream zstream;
+      zstream.zalloc = Z_NULL;
+      zstream.zfree = Z_NULL;
+      zstream.opaque = Z_NULL;
+
+      auto result = deflateInit(&zstream, level);
+      if (result != Z_OK) { throw facade::exception::ZLibError(result); }
+
+      std::vector<std::uint8_t> row(spec.row_size() + 1);
+      std::vector<std::uint8_t> idat(idat_size);
+      zstream.next_out = idat.data();
+      zstream.avail_out = static_cast<uInt>(idat.size());
+
+      for (std::uint32_t y=0; y<=spec.height; ++y)
+      {
+         auto flush = (y == spec.height) ? Z_FINISH : Z_NO_FLUSH;
+
+         if (y < spec.height)
+         {
+            row[0] = facade::png::FilterType::NONE;
+            spec.row(y, &row[1]);
+            zstream.next_in = row.data();
+            zstream.avail_in = static_cast<uInt>(row.size());
+         }
+
+         do
+         {
+            result = deflate(&zstream, flush);
+            if (result == Z_STREAM_ERROR) { deflateEnd(&zstream); throw facade::exception::ZLibError(result); }
+
+            if (zstream.avail_out == 0)
+            {
+               write_chunk(stream, "IDAT", idat.data(), idat.size());
+               zstream.next_out = idat.data();
+               zstream.avail_out = static_cast<uInt>(idat.size());
+            }
+         } while (zstream.avail_in > 0 || (flush == Z_FINISH && result != Z_STREAM_END));
+      }
+
+      if (zstream.avail_out < idat.size())
+         write_chunk(stream, "IDAT", idat.data(), idat.size() - zstream.avail_out);
+
+      deflateEnd(&zstream);
+      write_chunk(stream, "IEND", nullptr, 0);
+   }
+
+   /// @brief Write a carrier image to the given file.
+   /// @throws facade::exception::OpenFileFailure
+   /// @throws facade::exception::ZLibError
+   ///
+   inline void write_carrier(const std::string &filename, const CarrierSpec &spec, int level=6) {
+      std::ofstream stream(filename, std::ios::binary);
+      if (!stream) { throw facade::exception::OpenFileFailure(filename); }
+
+      write_carrier(stream, spec, level);
+   }
+
+   /// @brief Generate the raw, unfiltered image data of a carrier in memory, filter bytes included.
+   inline std::vector<std::uint8_t> carrier_raw(const CarrierSpec &spec) {
+      auto row_size = spec.row_size();
+      std::vector<std::uint8_t> result((row_size + 1) * spec.height);
+
+      for (std::uint32_t y=0; y<spec.height; ++y)
+      {
+         result[y * (row_size + 1)] = facade::png::FilterType::NONE;
+         spec.row(y, &result[y * (row_size + 1) + 1]);
+      }
+
+      return result;
+   }
+}
@@ -0,0 +1,127 @@
+#include <carrier.hpp>
+
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+
+using namespace facade;
+
+/* split a comma-separated list. */
+static std::vector<std::string> split(const std::string &list) {
+   std::vector<std::string> result;
+   std::stringstream stream(list);
+   std::string item;
+
+   while (std::getline(stream, item, ','))
+      if (!item.empty()) { result.push_back(item); }
+
+   return result;
+}
+
+static int usage(const char *program) {
+   std::cerr << "usage: " << program << " --output DIR [--sizes 256,1024,...] [--entropy 0.5,...] [--types NAME,...]"
+             << " [--level 0-9] [--seed N] [--force]" << std::endl;
+   std::cerr << "pixel types:";
+
+   for (auto &format : bench::PIXEL_FORMATS)
+      std::cerr << " " << format.name;
+
+   std::cerr << std::endl;
+   return 1;
+}
+
+int
+main
+(int argc, char *argv[])
+{
+   std::string output;
+   std::vector<std::uint32_t> sizes = { 256, 1024, 4096, 16384, 32768 };
+   std::vector<double> entropies = { 0.5 };
+   std::vector<bench::PixelFormat> formats(std::begin(bench::PIXEL_FORMATS), std::end(bench::PIXEL_FORMATS));
+   int level = 6;
+   std::uint32_t seed = 0xFACADE;
+   bool force = false;
+
+   try {
+      for (int i=1; i<argc; ++i)
+      {
+         std::string arg = argv[i];
+
+         if (arg == "--force") { force = true; }
+         else if (arg == "--output" && i+1 < argc) { output = argv[++i]; }
+         else if (arg == "--level" && i+1 < argc) { level = std::stoi(argv[++i]); }
+         else if (arg == "--seed" && i+1 < argc) { seed = static_cast<std::uint32_t>(std::stoul(argv[++i])); }
+         else if (arg == "--sizes" && i+1 < argc)
+         {
+            sizes.clear();
+
+            for (auto &size : split(argv[++i]))
+               sizes.push_back(static_cast<std::uint32_t>(std::stoul(size)));
+         }
+         else if (arg == "--entropy" && i+1 < argc)
+         {
+            entropies.clear();
+
+            for (auto &entropy : split(argv[++i]))
+               entropies.push_back(std::stod(entropy));
+         }
+         else if (arg == "--types" && i+1 < argc)
+         {
+            formats.clear();
+
+            for (auto &name : split(argv[++i]))
+            {
+               auto format = std::find_if(std::begin(bench::PIXEL_FORMATS), std::end(bench::PIXEL_FORMATS),
+                                          [&name](const bench::PixelFormat &format) { return name == format.name; });
+               if (format == std::end(bench::PIXEL_FORMATS)) { return usage(argv[0]); }
+
+               formats.push_back(*format);
+            }
+         }
+         else { return usage(argv[0]); }
+      }
+   }
+   catch (std::logic_error &) {
+      return usage(argv[0]);
+   }
+
+   if (output.empty() || sizes.empty() || entropies.empty() || formats.empty()) { return usage(argv[0]); }
+
+   std::filesystem::create_directories(output);
+
+   for (auto size : sizes)
+   {
+      for (auto &format : formats)
+      {
+         for (auto entropy : entropies)
+         {
+            bench::CarrierSpec spec;
+            spec.format = format;
+            spec.width = size;
+            spec.height = size;
+            spec.entropy = entropy;
+            spec.seed = seed;
+
+            auto path = std::filesystem::path(output) / spec.file_name();
+
+            if (!force && std::filesystem::exists(path))
+            {
+               std::cout << "[!] [carriers] " << path.string() << " exists, skipping." << std::endl;
+               continue;
+            }
+
+            try {
+               bench::write_carrier(path.string(), spec, level);
+            }
+            catch (exception::Exception &exc) {
+               std::cerr << "[-] [carriers] failed to write " << path.string() << ": " << exc.error << std::endl;
+               return 2;
+            }
+
+            std::cout << "[+] [carriers] " << path.string() << " (" << std::filesystem::file_size(path) << " bytes)" << std::endl;
+         }
+      }
+   }
+
+   return 0;
+}
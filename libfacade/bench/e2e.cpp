@@ -0,0 +1,308 @@
+#include <bench.hpp>
+#include <facade.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+using namespace facade;
+
+/* the measurements of one CLI invocation. */
+struct Run
+{
+   std::string pipeline;
+   std::string carrier;
+   std::size_t threads;
+   std::size_t payload_size;
+   int exit_code;
+   double wall_ms;
+   double cpu_ms;
+   std::size_t peak_rss;
+};
+
+static std::vector<std::string> split(const std::string &list) {
+   std::vector<std::string> result;
+   std::stringstream stream(list);
+   std::string item;
+
+   while (std::getline(stream, item, ','))
+      if (!item.empty()) { result.push_back(item); }
+
+   return result;
+}
+
+/* the CPUs this process may run on, so that a run pinned to n threads gets the first n of them. */
+static std::vector<int> allowed_cpus() {
+   std::vector<int> result;
+#if defined(__linux__)
+   cpu_set_t set;
+   CPU_ZERO(&set);
+
+   if (sched_getaffinity(0, sizeof(set), &set) == 0)
+      for (int cpu=0; cpu<CPU_SETSIZE; ++cpu)
+         if (CPU_ISSET(cpu, &set)) { result.push_back(cpu); }
+#endif
+   if (result.empty())
+      for (unsigned cpu=0; cpu<std::max(1u, std::thread::hardware_concurrency()); ++cpu)
+         result.push_back(static_cast<int>(cpu));
+
+   return result;
+}
+
+/* run the given command pinned to the first `threads` allowed CPUs, with its output discarded. */
+static Run execute(const std::vector<std::string> &command, const std::vector<int> &cpus, std::size_t threads) {
+   Run run;
+   run.threads = threads;
+
+   std::vector<char *> argv;
+
+   for (auto &arg : command)
+      argv.push_back(const_cast<char *>(arg.c_str()));
+
+   argv.push_back(nullptr);
+
+   auto start = std::chrono::steady_clock::now();
+   auto pid = fork();
+
+   if (pid == 0)
+   {
+#if defined(__linux__)
+      cpu_set_t set;
+      CPU_ZERO(&set);
+
+      for (std::size_t i=0; i<threads && i<cpus.size(); ++i)
+         CPU_SET(cpus[i], &set);
+
+      sched_setaffinity(0, sizeof(set), &set);
+#endif
+      auto null_fd = open("/dev/null", O_WRONLY);
+      dup2(null_fd, STDOUT_FILENO);
+      dup2(null_fd, STDERR_FILENO);
+      execv(argv[0], argv.data());
+      _exit(127);
+   }
+
+   int status = 0;
+   rusage usage;
+   std::memset(&usage, 0, sizeof(usage));
+
+   if (pid < 0 || wait4(pid, &status, 0, &usage) < 0)
+   {
+      run.exit_code = -1;
+      run.wall_ms = run.cpu_ms = 0;
+      run.peak_rss = 0;
+      return run;
+   }
+
+   run.wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+   run.cpu_ms = (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e3 + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e3;
+#if defined(__APPLE__)
+   run.peak_rss = static_cast<std::size_t>(usage.ru_maxrss);
+#else
+   run.peak_rss = static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+#endif
+   run.exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+
+   return run;
+}
+
+static void report(const Run &run) {
+   std::printf("%-8s %-40s %3zu threads %12.1f ms wall %12.1f ms cpu %6.2fx %10.1f MiB peak",
+               run.pipeline.c_str(), run.carrier.c_str(), run.threads, run.wall_ms, run.cpu_ms,
+               run.cpu_ms / std::max(run.wall_ms, 1e-3), run.peak_rss / (1024.0 * 1024.0));
+
+   if (run.exit_code != 0) { std::printf("  (exit %d)", run.exit_code); }
+
+   std::printf("\n");
+   std::fflush(stdout);
+}
+
+static void write_json(std::ostream &stream, const std::vector<Run> &runs, const std::vector<int> &cpus) {
+   stream << std::setprecision(10) << "{\n  \"context\": { \"cpus\": " << cpus.size() << " },\n  \"runs\": [";
+
+   for (std::size_t i=0; i<runs.size(); ++i)
+   {
+      auto &run = runs[i];
+
+      stream << ((i == 0) ? "\n" : ",\n") << "    { \"pipeline\": ";
+      bench::write_json_string(stream, run.pipeline);
+      stream << ", \"carrier\": ";
+      bench::write_json_string(stream, run.carrier);
+      stream << ", \"threads\": " << run.threads
+             << ", \"payload_size\": " << run.payload_size
+             << ", \"exit_code\": " << run.exit_code
+             << ", \"wall_ms\": " << run.wall_ms
+             << ", \"cpu_ms\": " << run.cpu_ms
+             << ", \"peak_rss\": " << run.peak_rss << " }";
+   }
+
+   stream << "\n  ]\n}\n";
+}
+
+static int usage(const char *program) {
+   std::cerr << "usage: " << program << " --facade PATH --corpus DIR [--work DIR] [--threads 1,2,4,...]"
+             << " [--payload-size BYTES] [--pipelines create,extract,detect] [--repeat N] [--json FILE|-]" << std::endl;
+   return 1;
+}
+
+int
+main
+(int argc, char *argv[])
+{
+   std::string facade_path, corpus, json_path;
+   auto work = (std::filesystem::temp_directory_path() / "facade_e2e").string();
+   auto cpus = allowed_cpus();
+   std::vector<std::size_t> thread_counts;
+   std::vector<std::string> pipelines = { "create", "extract", "detect" };
+   std::size_t payload_size = 64 * 1024;
+   std::size_t repeat = 1;
+
+   try {
+      for (int i=1; i<argc; ++i)
+      {
+         std::string arg = argv[i];
+
+         if (arg == "--facade" && i+1 < argc) { facade_path = argv[++i]; }
+         else if (arg == "--corpus" && i+1 < argc) { corpus = argv[++i]; }
+         else if (arg == "--work" && i+1 < argc) { work = argv[++i]; }
+         else if (arg == "--json" && i+1 < argc) { json_path = argv[++i]; }
+         else if (arg == "--payload-size" && i+1 < argc) { payload_size = std::stoul(argv[++i]); }
+         else if (arg == "--repeat" && i+1 < argc) { repeat = std::max<std::size_t>(1, std::stoul(argv[++i])); }
+         else if (arg == "--pipelines" && i+1 < argc) { pipelines = split(argv[++i]); }
+         else if (arg == "--threads" && i+1 < argc)
+         {
+            for (auto &count : split(argv[++i]))
+               thread_counts.push_back(std::max<std::size_t>(1, std::stoul(count)));
+         }
+         else { return usage(argv[0]); }
+      }
+   }
+   catch (std::logic_error &) {
+      return usage(argv[0]);
+   }
+
+   if (facade_path.empty() || corpus.empty()) { return usage(argv[0]); }
+
+   /* by default, scale from one thread up to every CPU we're allowed, doubling each time */
+   if (thread_counts.empty())
+   {
+      for (std::size_t count=1; count<cpus.size(); count*=2)
+         thread_counts.push_back(count);
+
+      thread_counts.push_back(cpus.size());
+   }
+
+   std::vector<std::filesystem::path> carriers;
+
+   for (auto &entry : std::filesystem::directory_iterator(corpus))
+      if (entry.is_regular_file() && entry.path().extension() == ".png") { carriers.push_back(entry.path()); }
+
+   std::sort(carriers.begin(), carriers.end());
+
+   if (carriers.empty())
+   {
+      std::cerr << "[-] [e2e] no carriers found in " << corpus << ", generate some with facade_carriers." << std::endl;
+      return 2;
+   }
+
+   std::filesystem::create_directories(work);
+
+   auto wants = [&pipelines](const std::string &name) {
+      return std::find(pipelines.begin(), pipelines.end(), name) != pipelines.end();
+   };
+
+   std::vector<Run> runs;
+
+   for (auto &carrier : carriers)
+   {
+      std::size_t capacity = 0;
+
+      /* only the header is needed to size the payload, so validation and loading are skipped */
+      try {
+         png::Image image(carrier.string(), false);
+         auto header = image.header();
+
+         /* stego stores 12 bits per pixel, after a 7-byte header */
+         auto stego_bytes = static_cast<std::size_t>(header.width()) * header.height() * 12 / 8;
+         capacity = (stego_bytes > 7) ? stego_bytes - 7 : 0;
+      }
+      catch (exception::Exception &exc) {
+         std::cerr << "[-] [e2e] skipping " << carrier.string() << ": " << exc.error << std::endl;
+         continue;
+      }
+
+      auto size = std::min(payload_size, capacity);
+      auto payload_path = (std::filesystem::path(work) / "payload.bin").string();
+      auto output_path = (std::filesystem::path(work) / "output.png").string();
+      auto extract_path = (std::filesystem::path(work) / "extracted").string();
+
+      {
+         std::vector<std::uint8_t> payload(size);
+
+         for (std::size_t i=0; i<size; ++i)
+            payload[i] = static_cast<std::uint8_t>((i * 2654435761u) >> 13);
+
+         std::ofstream stream(payload_path, std::ios::binary);
+         stream.write(reinterpret_cast<const char *>(payload.data()), payload.size());
+      }
+
+      for (auto threads : thread_counts)
+      {
+         std::vector<std::pair<std::string, std::vector<std::string>>> commands;
+         auto thread_count = std::to_string(threads);
+
+         /* the CLI sizes its thread pool to match the CPUs it's pinned to */
+         if (wants("create"))
+            commands.push_back({ "create", { facade_path, "create", "-i", carrier.string(), "-o", output_path, "-s", payload_path, "--threads", thread_count } });
+         if (wants("extract"))
+            commands.push_back({ "extract", { facade_path, "extract", "-i", output_path, "-o", extract_path, "-s", "--threads", thread_count } });
+         if (wants("detect"))
+            commands.push_back({ "detect", { facade_path, "detect", output_path, "--threads", thread_count } });
+
+         bool created = !wants("create");
+
+         for (auto &command : commands)
+         {
+            /* extract and detect work on what create wrote, so skip them if it failed */
+            if (command.first != "create" && !created) { continue; }
+            if (command.first == "extract") { std::filesystem::create_directories(extract_path); }
+
+            Run best;
+            best.wall_ms = -1;
+
+            for (std::size_t r=0; r<repeat; ++r)
+            {
+               auto run = execute(command.second, cpus, threads);
+               if (best.wall_ms < 0 || run.wall_ms < best.wall_ms) { best = run; }
+            }
+
+            best.pipeline = command.first;
+            best.carrier = carrier.filename().string();
+            best.payload_size = size;
+
+            if (command.first == "create") { created = (best.exit_code == 0); }
+
+            report(best);
+            runs.push_back(best);
+         }
+      }
+   }
+
+   if (json_path == "-")
+      write_json(std::cout, runs, cpus);
+   else if (!json_path.empty())
+   {
+      std::ofstream json(json_path);
+      if (!json) { std::cerr << "[-] [e2e] could not open " << json_path << std::endl; return 3; }
+
+      write_json(json, runs, cpus);
+   }
+
+   return 0;
+}
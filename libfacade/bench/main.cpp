@@ -0,0 +1,226 @@
+#include <bench.hpp>
+#include <carrier.hpp>
+#include <facade.hpp>
+
+#include <fstream>
+#include <sstream>
+
+using namespace facade;
+
+/* a deterministic xorshift stream, so every run measures the same data */
+static std::vector<std::uint8_t> noise(std::size_t size, std::uint32_t seed) {
+   std::vector<std::uint8_t> result(size);
+   std::uint32_t state = seed;
+
+   for (auto &byte : result)
+   {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      byte = static_cast<std::uint8_t>(state);
+   }
+
+   return result;
+}
+
+/* a carrier of the given pixel type with three bits of noise per byte, which gives the filters and deflate something
+   realistic to work with. */
+static bench::CarrierSpec carrier(bench::PixelFormat format, std::uint32_t width, std::uint32_t height) {
+   bench::CarrierSpec spec;
+   spec.format = format;
+   spec.width = width;
+   spec.height = height;
+   spec.entropy = 3.0 / 8;
+
+   return spec;
+}
+
+static png::Image make_image(const bench::CarrierSpec &spec) {
+   std::ostringstream stream;
+   bench::write_carrier(stream, spec);
+   auto file = stream.str();
+
+   png::Image image(file.data(), file.size());
+   image.load();
+
+   return image;
+}
+
+static void bench_utility(bench::Runner &runner) {
+   auto raw = bench::carrier_raw(carrier(bench::PIXEL_FORMATS[png::ALPHA_TRUE_COLOR_PIXEL_8BIT], 1024, 1024));
+   auto random = noise(raw.size(), 0xFACADE);
+
+   runner.run("crc32", raw.size(), 0, [&]() { bench::do_not_optimize(crc32(raw.data(), raw.size())); });
+
+   for (int level : { 1, 6, 9 })
+   {
+      auto compressed = compress(raw, level);
+
+      runner.run("compress/level" + std::to_string(level), raw.size(), 0, [&]() {
+         bench::do_not_optimize(compress(raw.data(), raw.size(), level));
+      });
+      runner.run("decompress/level" + std::to_string(level), raw.size(), 0, [&]() {
+         bench::do_not_optimize(decompress(compressed.data(), compressed.size()));
+      });
+   }
+
+   auto encoded = base64_encode(random);
+
+   runner.run("base64_encode", random.size(), 0, [&]() { bench::do_not_optimize(base64_encode(random.data(), random.size())); });
+   runner.run("base64_decode", random.size(), 0, [&]() { bench::do_not_optimize(base64_decode(encoded.data(), encoded.size())); });
+}
+
+/* filter and reconstruct every row of an image of the given scanline type, with each filter type. */
+template <typename ScanlineType>
+static void bench_filters(bench::Runner &runner, const bench::PixelFormat &format) {
+   static const char *filter_names[5] = { "none", "sub", "up", "average", "paeth" };
+
+   std::string pixel_name = format.name;
+   auto prefix = "filter/" + pixel_name + "/";
+   bool enabled = runner.enabled(prefix + "adaptive");
+
+   for (auto filter_name : filter_names)
+      enabled |= runner.enabled(prefix + filter_name) || runner.enabled("reconstruct/" + pixel_name + "/" + filter_name);
+
+   if (!enabled) { return; }
+
+   auto spec = carrier(format, 512, 512);
+   auto header = spec.header();
+   auto raw = bench::carrier_raw(spec);
+   auto lines = ScanlineType::from_raw(header, raw);
+   auto bytes = header.buffer_size();
+   auto pixels = header.width() * header.height();
+
+   for (std::size_t f=0; f<5; ++f)
+   {
+      auto filter_type = static_cast<png::FilterType>(f);
+      std::vector<ScanlineType> filtered;
+
+      for (std::size_t y=0; y<lines.size(); ++y)
+         filtered.push_back(lines[y].filter(filter_type, (y == 0) ? std::nullopt : std::optional<ScanlineType>(lines[y-1])));
+
+      runner.run(prefix + filter_names[f], bytes, pixels, [&]() {
+         for (std::size_t y=0; y<lines.size(); ++y)
+            bench::do_not_optimize(lines[y].filter(filter_type, (y == 0) ? std::nullopt : std::optional<ScanlineType>(lines[y-1])));
+      });
+      runner.run("reconstruct/" + pixel_name + "/" + filter_names[f], bytes, pixels, [&]() {
+         for (std::size_t y=0; y<filtered.size(); ++y)
+            bench::do_not_optimize(filtered[y].reconstruct((y == 0) ? std::nullopt : std::optional<ScanlineType>(lines[y-1])));
+      });
+   }
+
+   runner.run(prefix + "adaptive", bytes, pixels, [&]() {
+      for (std::size_t y=0; y<lines.size(); ++y)
+         bench::do_not_optimize(lines[y].filter((y == 0) ? std::nullopt : std::optional<ScanlineType>(lines[y-1])));
+   });
+}
+
+static void bench_all_filters(bench::Runner &runner) {
+   using namespace png;
+   auto &formats = bench::PIXEL_FORMATS;
+
+   bench_filters<GrayscaleScanline1Bit>(runner, formats[GRAYSCALE_PIXEL_1BIT]);
+   bench_filters<GrayscaleScanline2Bit>(runner, formats[GRAYSCALE_PIXEL_2BIT]);
+   bench_filters<GrayscaleScanline4Bit>(runner, formats[GRAYSCALE_PIXEL_4BIT]);
+   bench_filters<GrayscaleScanline8Bit>(runner, formats[GRAYSCALE_PIXEL_8BIT]);
+   bench_filters<GrayscaleScanline16Bit>(runner, formats[GRAYSCALE_PIXEL_16BIT]);
+   bench_filters<TrueColorScanline8Bit>(runner, formats[TRUE_COLOR_PIXEL_8BIT]);
+   bench_filters<TrueColorScanline16Bit>(runner, formats[TRUE_COLOR_PIXEL_16BIT]);
+   bench_filters<PaletteScanline1Bit>(runner, formats[PALETTE_PIXEL_1BIT]);
+   bench_filters<PaletteScanline2Bit>(runner, formats[PALETTE_PIXEL_2BIT]);
+   bench_filters<PaletteScanline4Bit>(runner, formats[PALETTE_PIXEL_4BIT]);
+   bench_filters<PaletteScanline8Bit>(runner, formats[PALETTE_PIXEL_8BIT]);
+   bench_filters<AlphaGrayscaleScanline8Bit>(runner, formats[ALPHA_GRAYSCALE_PIXEL_8BIT]);
+   bench_filters<AlphaGrayscaleScanline16Bit>(runner, formats[ALPHA_GRAYSCALE_PIXEL_16BIT]);
+   bench_filters<AlphaTrueColorScanline8Bit>(runner, formats[ALPHA_TRUE_COLOR_PIXEL_8BIT]);
+   bench_filters<AlphaTrueColorScanline16Bit>(runner, formats[ALPHA_TRUE_COLOR_PIXEL_16BIT]);
+}
+
+static void bench_stego(bench::Runner &runner) {
+   if (!runner.enabled("stego/write") && !runner.enabled("stego/read")) { return; }
+
+   auto image = make_image(carrier(bench::PIXEL_FORMATS[png::TRUE_COLOR_PIXEL_8BIT], 512, 512));
+   PNGPayload payload(image.to_file());
+   payload.load();
+
+   /* every pixel holds 12 bits of payload */
+   auto capacity = (payload.width() * payload.height() * 12) / 8;
+   auto data = noise(capacity, 0xD00D);
+   auto pixels = payload.width() * payload.height();
+
+   runner.run("stego/write", capacity, pixels, [&]() { payload.write_stego_data(data, 0); });
+   runner.run("stego/read", capacity, pixels, [&]() { bench::do_not_optimize(payload.read_stego_data(0, capacity)); });
+}
+
+static void bench_chunks(bench::Runner &runner) {
+   if (!runner.enabled("chunks/parse") && !runner.enabled("chunks/parse_unvalidated") && !runner.enabled("chunks/to_file")) { return; }
+
+   auto image = make_image(carrier(bench::PIXEL_FORMATS[png::ALPHA_TRUE_COLOR_PIXEL_8BIT], 1024, 1024));
+   image.filter();
+   image.compress(8192, 6);
+
+   for (std::size_t i=0; i<64; ++i)
+      image.add_text("bench" + std::to_string(i), std::string(256, 'a' + (i % 26)));
+
+   auto file = image.to_file();
+
+   runner.run("chunks/parse", file.size(), 0, [&]() { bench::do_not_optimize(png::Image(file)); });
+   runner.run("chunks/parse_unvalidated", file.size(), 0, [&]() { bench::do_not_optimize(png::Image(file, false)); });
+   runner.run("chunks/to_file", file.size(), 0, [&]() { bench::do_not_optimize(image.to_file()); });
+}
+
+static int usage(const char *program) {
+   std::cerr << "usage: " << program << " [--filter SUBSTRING] [--json FILE|-] [--counters] [--min-time MS]" << std::endl;
+   return 1;
+}
+
+int
+main
+(int argc, char *argv[])
+{
+   bench::Options options;
+
+   for (int i=1; i<argc; ++i)
+   {
+      std::string arg = argv[i];
+
+      if (arg == "--counters") { options.counters = true; }
+      else if (arg == "--filter" && i+1 < argc) { options.filter = argv[++i]; }
+      else if (arg == "--json" && i+1 < argc) { options.json_path = argv[++i]; }
+      else if (arg == "--min-time" && i+1 < argc) { options.min_time_ms = std::stod(argv[++i]); }
+      else { return usage(argv[0]); }
+   }
+
+   bench::Runner runner(options);
+   runner.add_context("ssse3", cpu_has_ssse3() ? "true" : "false");
+   runner.add_context("avx2", cpu_has_avx2() ? "true" : "false");
+   runner.add_context("threads", std::to_string(std::thread::hardware_concurrency()));
+#if defined(NDEBUG)
+   runner.add_context("build", "release");
+#else
+   runner.add_context("build", "debug");
+#endif
+
+   try {
+      bench_utility(runner);
+      bench_all_filters(runner);
+      bench_stego(runner);
+      bench_chunks(runner);
+   }
+   catch (std::exception &exc) {
+      std::cerr << "[-] [bench] benchmark failed: " << exc.what() << std::endl;
+      return 2;
+   }
+
+   if (options.json_path == "-")
+      runner.write_json(std::cout);
+   else if (!options.json_path.empty())
+   {
+      std::ofstream json(options.json_path);
+      if (!json) { std::cerr << "[-] [bench] could not open " << options.json_path << std::endl; return 3; }
+
+      runner.write_json(json);
+   }
+
+   return 0;
+}
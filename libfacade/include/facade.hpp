@@ -27,8 +27,12 @@
 
 #include <facade/platform.hpp>
 #include <facade/utility.hpp>
+#include <facade/executor.hpp>
+#include <facade/signatures.hpp>
+#include <facade/stats.hpp>
 #include <facade/png.hpp>
 #include <facade/ico.hpp>
 #include <facade/payload.hpp>
+#include <facade/steganalysis.hpp>
 
 #endif
@@ -252,6 +252,22 @@ namespace exception
       }
    };
 
+   /// @brief An exception thrown when the interlace method of a PNG header is neither 0 (none) nor 1 (Adam7).
+   class InvalidInterlaceMethod : public Exception
+   {
+   public:
+      /// @brief The offending interlace method value.
+      std::uint8_t interlace_method;
+
+      InvalidInterlaceMethod(std::uint8_t interlace_method) : interlace_method(interlace_method), Exception() {
+         std::stringstream stream;
+
+         stream << "Invalid interlace method: the given interlace method " << static_cast<int>(interlace_method) << " was not a valid value.";
+
+         this->error = stream.str();
+      }
+   };
+
    /// @brief An exception thrown when the PNG image has already been filtered.
    class AlreadyFiltered : public Exception
    {
@@ -259,6 +275,13 @@ namespace exception
       AlreadyFiltered() : Exception("Already filtered: the given scanline has already had a filter applied to it.") {}
    };
 
+   /// @brief An exception thrown when reading from or writing to a stream fails.
+   class StreamFailure : public Exception
+   {
+   public:
+      StreamFailure() : Exception("Stream failure: reading from or writing to the given stream failed.") {}
+   };
+
    /// @brief An exception thrown when a given integer overflows.
    class IntegerOverflow : public Exception
    {
@@ -332,11 +355,13 @@ namespace exception
    public:
       /// @brief The offending character which was encountered.
       char c;
+      /// @brief The offset into the decoded string where the character was encountered.
+      std::size_t offset;
 
-      InvalidBase64Character(char c) : c(c), Exception() {
+      InvalidBase64Character(char c, std::size_t offset) : c(c), offset(offset), Exception() {
          std::stringstream stream;
 
-         stream << "Invalid Base64 character: the given character, '" << c << "', is not a valid Base64 character.";
+         stream << "Invalid Base64 character: the given character, '" << c << "', at offset " << offset << " is not a valid Base64 character.";
 
          this->error = stream.str();
       }
@@ -358,6 +383,49 @@ namespace exception
       }
    };
 
+   /// @brief An exception thrown when a binary data chunk names a codec this library doesn't know.
+   /// @sa facade::png::BinaryCodec
+   class UnsupportedBinaryCodec : public Exception
+   {
+   public:
+      /// @brief The offending codec value.
+      std::uint8_t codec;
+
+      UnsupportedBinaryCodec(std::uint8_t codec) : codec(codec), Exception() {
+         std::stringstream stream;
+
+         stream << "Unsupported binary codec: the given codec value, " << static_cast<int>(codec) << ", is not a known binary data codec.";
+
+         this->error = stream.str();
+      }
+   };
+
+   /// @brief An exception thrown when the given binary data chunk is not found in the PNG data.
+   class BinaryDataNotFound : public Exception
+   {
+   public:
+      BinaryDataNotFound() : Exception("Binary data not found: the given binary data chunk was not found in the PNG image.") {}
+   };
+
+   /// @brief An exception thrown when a segmented `zTXt` payload or a striped stego payload is missing a segment or has one out of order.
+   class InvalidSegment : public Exception
+   {
+   public:
+      /// @brief The sequence number of the offending segment.
+      std::size_t sequence;
+      /// @brief The segment count the offending segment claims.
+      std::size_t total;
+
+      InvalidSegment(std::size_t sequence, std::size_t total) : sequence(sequence), total(total), Exception() {
+         std::stringstream stream;
+
+         stream << "Invalid segment: segment " << sequence << " of " << total
+                << " is out of order, duplicated or belongs to an incomplete payload.";
+
+         this->error = stream.str();
+      }
+   };
+
    /// @brief An exception thrown when the given pixel enum type is not supported.
    class UnsupportedPixelType : public Exception
    {
@@ -374,6 +442,40 @@ namespace exception
       }
    };
 
+   /// @brief An exception thrown when image data has more colors than a palette of the requested bit depth can hold,
+   ///        or a color which isn't in the palette it's being converted to.
+   class TooManyColors : public Exception
+   {
+   public:
+      /// @brief The number of colors the palette can hold.
+      std::size_t limit;
+
+      TooManyColors(std::size_t limit) : limit(limit), Exception() {
+         std::stringstream stream;
+
+         stream << "Too many colors: the image data has colors which don't fit in a palette of " << limit << " colors.";
+
+         this->error = stream.str();
+      }
+   };
+
+   /// @brief An exception thrown when an animation frame is missing its image data or doesn't match its frame control.
+   class InvalidFrame : public Exception
+   {
+   public:
+      /// @brief The index of the offending frame.
+      std::size_t index;
+
+      InvalidFrame(std::size_t index) : index(index), Exception() {
+         std::stringstream stream;
+
+         stream << "Invalid frame: frame " << index << " of the animation is missing its image data, or its image "
+                << "doesn't match its frame control.";
+
+         this->error = stream.str();
+      }
+   };
+
    /// @brief An exception thrown when the possible space provided by the image data is too small for the given operation.
    class ImageTooSmall : public Exception
    {
@@ -393,6 +495,28 @@ namespace exception
       }
    };
 
+   /// @brief An exception thrown when an allocation would take a facade::TrackingResource past its limit.
+   class MemoryLimitExceeded : public Exception
+   {
+   public:
+      /// @brief The size of the allocation which was refused.
+      std::size_t requested;
+      /// @brief The number of bytes already allocated.
+      std::size_t allocated;
+      /// @brief The limit of the resource.
+      std::size_t limit;
+
+      MemoryLimitExceeded(std::size_t requested, std::size_t allocated, std::size_t limit)
+         : requested(requested), allocated(allocated), limit(limit), Exception() {
+         std::stringstream stream;
+
+         stream << "Memory limit exceeded: allocating " << requested << " bytes on top of the " << allocated
+                << " bytes already allocated would exceed the limit of " << limit << " bytes.";
+
+         this->error = stream.str();
+      }
+   };
+
    /// @brief An exception thrown when no steganographic data is present.
    class NoStegoData : public Exception
    {
@@ -459,5 +583,24 @@ namespace exception
    public:
       NoPNGIcon() : Exception("No PNG icon: the given icon file does not have a PNG section present.") {}
    };
+
+   /// @brief An exception thrown when an icon entry isn't a bitmap which can carry a stego payload.
+   ///
+   /// Only uncompressed 24- and 32-bit bitmaps with their AND mask present can.
+   ///
+   class NoBMPIcon : public Exception
+   {
+   public:
+      /// @brief The index of the offending entry.
+      std::size_t index;
+
+      NoBMPIcon(std::size_t index) : index(index), Exception() {
+         std::stringstream stream;
+
+         stream << "No BMP icon: entry " << index << " of the icon is not an uncompressed 24- or 32-bit bitmap.";
+
+         this->error = stream.str();
+      }
+   };
 }}
 #endif
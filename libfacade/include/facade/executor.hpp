@@ -0,0 +1,246 @@
+#ifndef __FACADE_EXECUTOR_HPP
+#define __FACADE_EXECUTOR_HPP
+
+//! @file executor.hpp
+//! @brief The thread pool every parallel path in libfacade runs on.
+//!
+//! Parallel work, such as unfiltering Adam7 passes or encoding zTXt segments, is handed to a facade::Executor rather
+//! than spawning threads of its own. By default this is a process-wide facade::ThreadPool with a thread per core,
+//! which can be swapped out with facade::set_default_executor, or per image with facade::png::Image::set_executor.
+//!
+//! Threads waiting on parallel work run queued tasks themselves rather than blocking, so nested parallelism, such as
+//! a batch of images each loaded in parallel, shares the same threads instead of oversubscribing the machine.
+//!
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <facade/platform.hpp>
+
+namespace facade
+{
+   /// @brief The interface parallel work is scheduled through.
+   ///
+   /// An implementation only has to queue tasks and run one on request. Everything else, like
+   /// facade::Executor::parallel_for and facade::TaskGroup, is built on top of that. Tasks submitted to an
+   /// executor must not throw; use a facade::TaskGroup to get exceptions back to the caller.
+   ///
+   class
+   EXPORT
+   Executor
+   {
+   public:
+      /// @brief A unit of work.
+      using Task = std::function<void()>;
+
+      virtual ~Executor() {}
+
+      /// @brief The number of threads that can run tasks at once, counting a caller waiting on them.
+      ///
+      virtual std::size_t concurrency() const = 0;
+      /// @brief Queue a task to be run by the executor.
+      ///
+      virtual void submit(Task task) = 0;
+      /// @brief Run one queued task on the calling thread, if there is one.
+      /// @return Whether a task was run.
+      ///
+      /// Waiting threads call this to help with the work they're waiting on, which is what keeps nested parallelism
+      /// from deadlocking or starting more threads.
+      ///
+      virtual bool run_pending() = 0;
+
+      /// @brief Call the given task over contiguous ranges covering [0, count), in parallel.
+      ///
+      /// The calling thread runs ranges too, and returns once every range has finished. The first exception thrown by
+      /// a task is rethrown after that.
+      ///
+      /// @param count The number of indexes to cover.
+      /// @param grain The fewest indexes to put in one range, so that small tasks aren't scheduled one at a time.
+      /// @param task A callable taking the `std::size_t` start and end of a range.
+      ///
+      template <typename RangeTask>
+      void parallel_for_ranges(std::size_t count, std::size_t grain, RangeTask task);
+
+      /// @brief Call the given task for every index in [0, count), in parallel.
+      /// @sa facade::Executor::parallel_for_ranges
+      ///
+      /// @param count The number of indexes to run the task over.
+      /// @param task A callable taking a `std::size_t` index.
+      ///
+      template <typename IndexTask>
+      void parallel_for(std::size_t count, IndexTask task) {
+         this->parallel_for_ranges(count, 1, [&task](std::size_t begin, std::size_t end) {
+            for (std::size_t i=begin; i<end; ++i)
+               task(i);
+         });
+      }
+   };
+
+   /// @brief A set of tasks run on an executor which can be waited on together.
+   ///
+   /// ```cpp
+   /// facade::TaskGroup group(facade::default_executor());
+   /// group.run([&]() { first_half(); });
+   /// group.run([&]() { second_half(); });
+   /// group.wait();
+   /// ```
+   ///
+   class
+   EXPORT
+   TaskGroup
+   {
+      Executor &executor;
+      std::mutex mutex;
+      std::condition_variable done;
+      std::size_t pending;
+      std::exception_ptr error;
+
+   public:
+      explicit TaskGroup(Executor &executor) : executor(executor), pending(0) {}
+      TaskGroup(const TaskGroup &other) = delete;
+      /// @brief Wait on any tasks still running. Their exceptions are discarded.
+      ///
+      ~TaskGroup();
+
+      /// @brief Queue a task as part of this group.
+      ///
+      template <typename Function>
+      void run(Function function) {
+         {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            ++this->pending;
+         }
+
+         this->executor.submit([this, function]() mutable {
+            try {
+               function();
+            }
+            catch (...) {
+               this->fail(std::current_exception());
+            }
+
+            this->finish();
+         });
+      }
+
+      /// @brief Run queued tasks on the calling thread until every task in the group has finished.
+      /// @throws The first exception thrown by a task in the group.
+      ///
+      void wait();
+
+      /// @brief Record an exception as the group's result, unless one was recorded already.
+      ///
+      void fail(std::exception_ptr exception);
+
+   private:
+      void finish();
+   };
+
+   /// @brief The default facade::Executor: a pool of threads, each with its own deque of tasks.
+   ///
+   /// A worker takes the newest task from its own deque, and when that runs dry, takes the oldest task from another
+   /// worker's deque, so parallel ranges split among threads without going through one shared queue. Tasks submitted
+   /// from outside the pool go into a queue of their own that every worker takes from.
+   ///
+   /// The thread that waits on the work counts as one of the pool's threads, so a pool of `n` threads starts `n-1`
+   /// workers. A pool of one thread runs every task as it's submitted.
+   ///
+   class
+   EXPORT
+   ThreadPool : public Executor
+   {
+      struct Queue
+      {
+         std::mutex mutex;
+         std::deque<Task> tasks;
+      };
+
+      std::size_t threads;
+      /* one deque per worker, then the queue for tasks submitted from outside the pool */
+      std::vector<std::unique_ptr<Queue>> queues;
+      std::vector<std::thread> workers;
+      std::mutex sleep_mutex;
+      std::condition_variable wake;
+      std::atomic<std::size_t> queued;
+      bool stopping;
+
+   public:
+      /// @param threads The number of threads to run tasks on, including a waiting caller, or 0 for one per core.
+      ///
+      explicit ThreadPool(std::size_t threads=0);
+      ThreadPool(const ThreadPool &other) = delete;
+      /// @brief Finish every queued task, then stop the workers.
+      ///
+      ~ThreadPool();
+
+      std::size_t concurrency() const override;
+      void submit(Task task) override;
+      bool run_pending() override;
+
+   private:
+      std::size_t queue_index() const;
+      bool take(std::size_t index, Task &task);
+      void work(std::size_t index);
+   };
+
+   /// @brief Get the executor used by anything not given one of its own.
+   ///
+   /// Unless replaced with facade::set_default_executor, this is a facade::ThreadPool with a thread per core, started
+   /// on first use.
+   ///
+   EXPORT Executor &default_executor();
+   /// @brief Replace the default executor, or restore the built-in pool with a null pointer.
+   ///
+   /// The executor must outlive its use as the default, and shouldn't be replaced while work is running on it.
+   ///
+   EXPORT void set_default_executor(Executor *executor);
+
+   /// @brief Call the given task for every index in [0, count) on the default executor.
+   /// @sa facade::Executor::parallel_for
+   ///
+   template <typename IndexTask>
+   void parallel_for(std::size_t count, IndexTask task) {
+      default_executor().parallel_for(count, task);
+   }
+
+   template <typename RangeTask>
+   void Executor::parallel_for_ranges(std::size_t count, std::size_t grain, RangeTask task) {
+      if (count == 0) { return; }
+
+      /* split into a few ranges per thread, so threads which finish early can take over the slack */
+      auto threads = std::max<std::size_t>(1, this->concurrency());
+      auto range_size = std::max<std::size_t>(std::max<std::size_t>(1, grain), (count + threads * 4 - 1) / (threads * 4));
+      auto ranges = (count + range_size - 1) / range_size;
+
+      if (threads == 1 || ranges == 1)
+      {
+         task(0, count);
+         return;
+      }
+
+      TaskGroup group(*this);
+
+      for (std::size_t r=1; r<ranges; ++r)
+         group.run([&task, r, range_size, count]() { task(r * range_size, std::min(count, (r+1) * range_size)); });
+
+      try {
+         task(0, range_size);
+      }
+      catch (...) {
+         group.fail(std::current_exception());
+      }
+
+      group.wait();
+   }
+}
+
+#endif
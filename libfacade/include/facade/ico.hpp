@@ -7,6 +7,8 @@
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
+#include <memory>
+#include <memory_resource>
 #include <string>
 #include <vector>
 #include <utility>
@@ -80,15 +82,64 @@ namespace ico
       RGBQuad colors[1];
    };
 
+   /// @brief An entry of an icon: its directory entry and its image data.
+   ///
+   /// Entries parsed from a file are views into the file's buffer, which the icon and its copies share, so parsing
+   /// doesn't copy any image data. Setting an entry's data gives it a buffer of its own.
+   ///
+   class
+   EXPORT
+   IconEntry
+   {
+      std::shared_ptr<const std::vector<std::uint8_t>> _buffer;
+      std::size_t _offset = 0;
+      std::size_t _size = 0;
+
+   public:
+      /// @brief The directory entry of this image.
+      ///
+      /// Its `bytes` and `offset` fields are filled in when the icon is written.
+      ///
+      IconDirEntry dir_entry;
+
+      IconEntry() : dir_entry() {}
+      IconEntry(const IconDirEntry &dir_entry, const std::vector<std::uint8_t> &data)
+         : _buffer(std::make_shared<const std::vector<std::uint8_t>>(data)), _offset(0), _size(data.size()), dir_entry(dir_entry) {}
+      /// @brief Create an entry viewing the given range of a shared buffer.
+      /// @throws facade::exception::OutOfBounds
+      ///
+      IconEntry(const IconDirEntry &dir_entry, std::shared_ptr<const std::vector<std::uint8_t>> buffer, std::size_t offset, std::size_t size);
+
+      /// @brief Get a pointer to the image data of this entry.
+      ///
+      const std::uint8_t *data() const;
+      /// @brief Get the size, in bytes, of the image data of this entry.
+      ///
+      std::size_t size() const;
+      /// @brief Copy the image data of this entry into a vector.
+      ///
+      std::vector<std::uint8_t> to_vector() const;
+      /// @brief Give this entry its own copy of the given image data.
+      ///
+      void set_data(const std::vector<std::uint8_t> &data);
+
+      /// @brief Check whether this entry views the given range of the given buffer.
+      ///
+      bool views(const std::shared_ptr<const std::vector<std::uint8_t>> &buffer, std::size_t offset, std::size_t size) const;
+   };
+
    class
    EXPORT
    Icon
    {
    public:
-      using Entry = std::pair<IconDirEntry, std::vector<std::uint8_t>>;
+      using Entry = IconEntry;
 
    private:
       std::vector<Entry> _entries;
+      /* the file the icon was parsed from, which parsed entries are views into */
+      std::shared_ptr<const std::vector<std::uint8_t>> _source;
+      std::pmr::memory_resource *_resource = std::pmr::get_default_resource();
 
    public:
       enum EntryType
@@ -98,13 +149,19 @@ namespace ico
       };
       
       Icon() {}
-      Icon(const void *ptr, std::size_t size) { this->parse(ptr, size); }
-      Icon(const std::vector<std::uint8_t> &vec) { this->parse(vec); }
-      Icon(const std::string &filename) { this->parse(filename); }
-      Icon(const Icon &other) : _entries(other._entries) {}
+      explicit Icon(std::pmr::memory_resource *resource) : _resource(resource) {}
+      Icon(const void *ptr, std::size_t size, std::pmr::memory_resource *resource=std::pmr::get_default_resource())
+         : _resource(resource) { this->parse(ptr, size); }
+      Icon(const std::vector<std::uint8_t> &vec, std::pmr::memory_resource *resource=std::pmr::get_default_resource())
+         : _resource(resource) { this->parse(vec); }
+      Icon(const std::string &filename, std::pmr::memory_resource *resource=std::pmr::get_default_resource())
+         : _resource(resource) { this->parse(filename); }
+      Icon(const Icon &other) : _entries(other._entries), _source(other._source), _resource(other._resource) {}
 
       Icon &operator=(const Icon &other) {
          this->_entries = other._entries;
+         this->_source = other._source;
+         this->_resource = other._resource;
 
          return *this;
       }
@@ -117,8 +174,22 @@ namespace ico
 
       std::size_t size(void) const;
 
+      /// @brief Get the memory resource that images decoded from this icon's entries allocate from.
+      ///
+      std::pmr::memory_resource *memory_resource(void) const;
+      /// @brief Set the memory resource that images decoded from this icon's entries allocate from.
+      ///
+      void set_memory_resource(std::pmr::memory_resource *resource);
+
+      /// @brief Parse an icon out of the given buffer.
+      ///
+      /// The buffer is copied once, and every entry is a view into that copy.
+      ///
       void parse(const void *ptr, std::size_t size);
       void parse(const std::vector<std::uint8_t> &vec);
+      /// @brief Parse an icon out of the given buffer, sharing it rather than copying it.
+      ///
+      void parse(std::shared_ptr<const std::vector<std::uint8_t>> buffer);
       void parse(const std::string &filename);
 
       Entry &get_entry(std::size_t index);
@@ -127,7 +198,19 @@ namespace ico
       void set_entry(std::size_t index, const IconDirEntry &entry, const std::vector<std::uint8_t> &data);
 
       EntryType entry_type(std::size_t index) const;
-
+      /// @brief Check whether the entry at the given index differs from the file the icon was parsed from.
+      ///
+      /// This is true for every entry of an icon which wasn't parsed from a file.
+      ///
+      bool is_modified(std::size_t index) const;
+
+      /// @brief Serialize the icon.
+      ///
+      /// If the icon was parsed from a file and still has the same entries in the same slots, the file is spliced
+      /// rather than rebuilt: only modified entries are replaced, the offsets of the entries after them are fixed up,
+      /// and everything else in the file, including any bytes between or after the entries, is kept as it was.
+      /// Otherwise, the entries are laid out one after another behind the directory.
+      ///
       std::vector<std::uint8_t> to_file() const;
       void save(const std::string &filename) const;
 
@@ -137,6 +220,11 @@ namespace ico
       Entry &append_entry(const Entry &entry);
       Entry &append_entry(const IconDirEntry &entry, const std::vector<std::uint8_t> &data);
       void remove_entry(std::size_t index);
+
+   private:
+      bool can_splice() const;
+      std::vector<std::uint8_t> splice() const;
+      std::vector<std::uint8_t> rebuild() const;
    };
 }}
 #endif
@@ -6,6 +6,10 @@
 //! @sa facade::PNGPayload
 //!
 
+
+#include <istream>
+#include <ostream>
+
 #include <facade/png.hpp>
 #include <facade/ico.hpp>
 
@@ -13,12 +17,18 @@ namespace facade
 {
    /// @brief A PNG-based payload helper class.
    ///
-   /// There are four main ways to add payloads to images:
+   /// There are five main ways to add payloads to images:
    /// * **Trailing data**: data appended to the very end of a PNG image. This is the "quick and dirty" solution to adding arbitrary
    ///                      payload data to a PNG image. See facade::png::Image::set_trailing_data.
    /// * **tEXt section**: a `tEXt` chunk with base64-encoded binary data. See facade::PNGPayload::add_text_payload.
    /// * **zTXt section**: a `zTXt` chunk where the base64-encoded data is compressed. See facade::PNGPayload::add_ztext_payload.
-   /// * **Steganography**: a steganographic payload across the raw PNG image data. See facade::PNGPayload::create_stego_payload.
+   ///                     Large payloads can be split across several `zTXt` chunks, see facade::PNGPayload::add_segmented_ztext_payload.
+   /// * **faCd section**: a private `faCd` chunk holding the raw binary data, optionally compressed, with no base64 overhead.
+   ///                     See facade::PNGPayload::add_binary_payload.
+   /// * **Steganography**: a steganographic payload across the raw PNG image data. See facade::PNGPayload::create_stego_payload,
+   ///                      and facade::ICOPayload::create_striped_stego_payload to spread one across every image of an icon.
+   ///                      Icon bitmaps can carry one too, see facade::ICOPayload::create_bmp_stego_payload, and animated
+   ///                      PNGs can spread one across their frames, see facade::PNGPayload::create_frame_stego_payload.
    ///
    /// Here is an example of encoding payloads into a PNG image:
    /// @include payload_creation.cpp
@@ -31,11 +41,21 @@ namespace facade
    PNGPayload : public png::Image
    {
    public:
+      /// @brief The default number of payload bytes stored in each segment of a segmented `zTXt` payload.
+      static const std::size_t ZTextSegmentSize = 1024 * 1024;
+      /// @brief The default number of payload bytes compressed into each block of a stego stream.
+      static const std::size_t StegoBlockSize = 1024 * 1024;
+
       PNGPayload() : png::Image() {}
-      PNGPayload(const void *ptr, std::size_t size) : png::Image(ptr, size) {}
-      PNGPayload(const std::vector<std::uint8_t> &vec) : png::Image(vec) {}
-      PNGPayload(const std::string &filename) : png::Image(filename) {}
+      explicit PNGPayload(std::pmr::memory_resource *resource) : png::Image(resource) {}
+      PNGPayload(const void *ptr, std::size_t size, std::pmr::memory_resource *resource=std::pmr::get_default_resource())
+         : png::Image(ptr, size, resource) {}
+      PNGPayload(const std::vector<std::uint8_t> &vec, std::pmr::memory_resource *resource=std::pmr::get_default_resource())
+         : png::Image(vec, resource) {}
+      PNGPayload(const std::string &filename, std::pmr::memory_resource *resource=std::pmr::get_default_resource())
+         : png::Image(filename, resource) {}
       PNGPayload(const PNGPayload &other) : png::Image(other) {}
+      explicit PNGPayload(const png::Image &image) : png::Image(image) {}
 
       /// @brief Add a `tEXt` section payload to the PNG file.
       ///
@@ -67,17 +87,21 @@ namespace facade
       void remove_text_payload(const png::Text &payload);
 
       /// @brief Get all corresponding `tEXt` payloads that match the given keyword.
+      ///
+      /// Chunks which aren't base64, such as ordinary text sharing the keyword, aren't payloads and are left out.
+      ///
       /// @param keyword The keyword to retrieve payloads from.
-      /// @return A vector of facade::png::Text objects corresponding
-      /// @throws facade::exception::InvalidBase64String
+      /// @return A view of the facade::png::Text chunks corresponding to the keyword.
+      /// @sa facade::png::Image::get_text
       ///
-      std::vector<png::Text> get_text_payloads(const std::string &keyword) const;
+      png::ChunkView<png::Text> get_text_payloads(const std::string &keyword) const;
 
       /// @brief Extract the binary data from the `tEXt` payloads corresponding to a given keyword.
+      ///
+      /// Chunks which aren't base64, such as ordinary text sharing the keyword, aren't payloads and are skipped.
+      ///
       /// @param keyword The keyword of the given payloads.
       /// @return A vector of byte vectors corresponding to the payloads matching the keyword argument.
-      /// @throws facade::exception::InvalidBase64String
-      /// @throws facade::exception::InvalidBase64Character
       ///
       std::vector<std::vector<std::uint8_t>> extract_text_payloads(const std::string &keyword) const;
 
@@ -110,23 +134,99 @@ namespace facade
       ///
       void remove_ztext_payload(const png::ZText &payload);
 
+      /// @brief Add a `zTXt` payload split across as many `zTXt` chunks as needed.
+      ///
+      /// Every chunk carries the same keyword, and its text is prefixed with a `sequence/total:` header ahead of the
+      /// base64 data of that segment. This lifts the chunk length ceiling on `zTXt` payloads, and the segments are
+      /// encoded and compressed concurrently. Segmented payloads are reassembled transparently by
+      /// facade::PNGPayload::extract_ztext_payloads.
+      ///
+      /// @param keyword The keyword to give to every segment.
+      /// @param ptr The given data pointer.
+      /// @param size The size of the data pointer, in bytes.
+      /// @param segment_size The number of payload bytes to store in each segment. Default is facade::PNGPayload::ZTextSegmentSize.
+      /// @return The number of segments added to the image.
+      /// @throws facade::exception::KeywordTooLong
+      /// @throws facade::exception::ZLibError
+      ///
+      std::size_t add_segmented_ztext_payload(const std::string &keyword, const void *ptr, std::size_t size, std::size_t segment_size=ZTextSegmentSize);
+
+      /// @brief Add a `zTXt` payload split across as many `zTXt` chunks as needed.
+      /// @sa facade::PNGPayload::add_segmented_ztext_payload(const std::string &, const void *, std::size_t, std::size_t)
+      ///
+      std::size_t add_segmented_ztext_payload(const std::string &keyword, const std::vector<std::uint8_t> &data, std::size_t segment_size=ZTextSegmentSize);
+
+      /// @brief Check whether the given decompressed `zTXt` text is one segment of a segmented payload.
+      ///
+      static bool is_ztext_segment(std::string_view text);
+
       /// @brief Get all corresponding `zTXt` payloads that match the given keyword.
+      ///
+      /// Segments of segmented payloads are returned individually. Chunks which aren't base64 or a segment, such as
+      /// ordinary text sharing the keyword, aren't payloads and are left out.
+      ///
       /// @param keyword The keyword to retrieve payloads from.
-      /// @return A vector of facade::png::Text objects corresponding
-      /// @throws facade::exception::InvalidBase64String
+      /// @return A view of the facade::png::ZText chunks corresponding to the keyword.
+      /// @throws facade::exception::InvalidBase64String if a segment isn't valid base64.
       /// @throws facade::exception::ZLibError
+      /// @sa facade::png::Image::get_ztext
       ///
-      std::vector<png::ZText> get_ztext_payloads(const std::string &keyword) const;
+      png::ChunkView<png::ZText> get_ztext_payloads(const std::string &keyword) const;
 
       /// @brief Extract the binary data from the `zTXt` payloads corresponding to a given keyword.
+      ///
+      /// All matching chunks are decompressed and decoded concurrently. Segmented payloads are reassembled
+      /// in order and returned as a single payload. Chunks which aren't base64 or a segment, such as ordinary text
+      /// sharing the keyword, aren't payloads and are skipped.
+      ///
       /// @param keyword The keyword of the given payloads.
       /// @return A vector of byte vectors corresponding to the payloads matching the keyword argument.
-      /// @throws facade::exception::InvalidBase64String
-      /// @throws facade::exception::InvalidBase64Character
+      /// @throws facade::exception::InvalidBase64Character if a segment isn't valid base64.
+      /// @throws facade::exception::InvalidSegment
       /// @throws facade::exception::ZLibError
       ///
       std::vector<std::vector<std::uint8_t>> extract_ztext_payloads(const std::string &keyword) const;
 
+      /// @brief Add a `faCd` section payload to the PNG file.
+      ///
+      /// The same keyword can be added multiple times. The data is stored as-is, or compressed if the
+      /// codec is facade::png::BINARY_ZLIB.
+      ///
+      /// @param keyword The keyword to give to the `faCd` section payload.
+      /// @param ptr The given data pointer.
+      /// @param size The size of the data pointer, in bytes.
+      /// @param codec The facade::png::BinaryCodec to store the payload with. Default is facade::png::BINARY_RAW.
+      /// @return A facade::png::BinaryData object representing the newly added section to the PNG image.
+      /// @sa facade::png::BinaryData
+      ///
+      png::BinaryData &add_binary_payload(const std::string &keyword, const void *ptr, std::size_t size, std::uint8_t codec=png::BINARY_RAW);
+
+      /// @brief Add a `faCd` section payload to the PNG file.
+      /// @sa facade::PNGPayload::add_binary_payload(const std::string &, const void *, std::size_t, std::uint8_t)
+      ///
+      png::BinaryData &add_binary_payload(const std::string &keyword, const std::vector<std::uint8_t> &data, std::uint8_t codec=png::BINARY_RAW);
+
+      /// @brief Remove the given `faCd` payload from the PNG image.
+      /// @param payload The payload section to remove.
+      /// @throws facade::exception::BinaryDataNotFound
+      ///
+      void remove_binary_payload(const png::BinaryData &payload);
+
+      /// @brief Get all corresponding `faCd` payloads that match the given keyword.
+      /// @param keyword The keyword to retrieve payloads from.
+      /// @return A view of the facade::png::BinaryData chunks corresponding to the keyword.
+      /// @sa facade::png::Image::get_binary
+      ///
+      png::ChunkView<png::BinaryData> get_binary_payloads(const std::string &keyword) const;
+
+      /// @brief Extract the binary data from the `faCd` payloads corresponding to a given keyword.
+      /// @param keyword The keyword of the given payloads.
+      /// @return A vector of byte vectors corresponding to the payloads matching the keyword argument.
+      /// @throws facade::exception::UnsupportedBinaryCodec
+      /// @throws facade::exception::ZLibError
+      ///
+      std::vector<std::vector<std::uint8_t>> extract_binary_payloads(const std::string &keyword) const;
+
       /// @brief Read steganographically-encoded data at an arbitrary bit offset in the image.
       ///
       /// Note that the bit offset must be a multiple of 4.
@@ -167,22 +267,30 @@ namespace facade
       void write_stego_data(const std::vector<std::uint8_t> &data, std::size_t bit_offset);
 
       /// @brief Check if the image has a steganographically-encoded payload.
+      ///
+      /// Both the original layout and the stego stream of facade::PNGPayload::create_stego_stream_payload are found.
+      ///
       /// @return Whether or not this image has steganographically-encoded data.
       /// @throws facade::exception::NoImageData
       ///
       bool has_stego_payload() const;
       /// @brief Create a copy of the payload with a steganographically-encoded payload within the image data.
+      ///
+      /// The payload is carried by 8-bit true color pixels. Images of any other pixel type are converted to 8-bit true
+      /// color as they're loaded, with an alpha channel if they have any transparency. The original layout records the
+      /// compressed size in 32 bits, so payloads of 4 GiB or more, or which compress to 4 GiB or more, are written as a
+      /// stego stream instead, see facade::PNGPayload::create_stego_stream_payload.
+      ///
       /// @param ptr The buffer of data to encode in the image.
       /// @param size The size, in bytes, of the given pointer data.
       /// @return A facade::PNGPayload object with a steganographic payload.
-      /// @throws facade::exception::UnsupportedPixelType
+      /// @sa facade::png::Image::load(facade::png::PixelEnum, bool)
       /// @throws facade::exception::ImageTooSmall
       ///
       PNGPayload create_stego_payload(const void *ptr, std::size_t size) const;
       /// @brief Create a copy of the payload with a steganographically-encoded payload within the image data.
       /// @param data The vector of byte data to encode in the image.
       /// @return A facade::PNGPayload object with a steganographic payload.
-      /// @throws facade::exception::UnsupportedPixelType
       /// @throws facade::exception::ImageTooSmall
       ///
       PNGPayload create_stego_payload(const std::vector<std::uint8_t> &data) const;
@@ -190,8 +298,93 @@ namespace facade
       /// @return A byte vector of the encoded data.
       /// @throws facade::exception::NoImageData
       /// @throws facade::exception::NoStegoData
+      /// @throws facade::exception::BadCRC if a block of a stego stream is corrupt.
+      /// @throws facade::exception::InvalidSegment if a block of a stego stream inflates to the wrong size.
       ///
       std::vector<std::uint8_t> extract_stego_payload() const;
+      /// @brief Write the steganographically-encoded data from the image to the given stream.
+      ///
+      /// A stego stream is checked, inflated and written a block at a time, with a batch of blocks inflated concurrently,
+      /// so the payload never has to fit in memory.
+      ///
+      /// @return The number of bytes written.
+      /// @throws facade::exception::StreamFailure
+      /// @sa facade::PNGPayload::extract_stego_payload() const
+      ///
+      std::uint64_t extract_stego_payload(std::ostream &stream) const;
+
+      /// @brief Create a copy of the payload with a stego stream within the image data.
+      ///
+      /// A stego stream records the payload's size in 64 bits and splits the payload into blocks of @p block_size
+      /// bytes, each compressed on its own and stored with its compressed size and CRC. A batch of blocks is compressed
+      /// concurrently and written into the image before the next is read, so neither the payload nor its compressed
+      /// form is held in memory all at once, and payloads past 4 GiB fit in carriers big enough to hold them.
+      ///
+      /// @param ptr The buffer of data to encode in the image.
+      /// @param size The size, in bytes, of the given pointer data.
+      /// @param block_size The number of payload bytes in each block. Default is facade::PNGPayload::StegoBlockSize.
+      /// @return A facade::PNGPayload object with a stego stream.
+      /// @throws facade::exception::NoData if the block size is 0.
+      /// @throws facade::exception::IntegerOverflow if the block size doesn't fit in 32 bits.
+      /// @throws facade::exception::ImageTooSmall
+      ///
+      PNGPayload create_stego_stream_payload(const void *ptr, std::size_t size, std::size_t block_size=StegoBlockSize) const;
+      /// @brief Create a copy of the payload with a stego stream within the image data.
+      /// @sa facade::PNGPayload::create_stego_stream_payload(const void *, std::size_t, std::size_t) const
+      ///
+      PNGPayload create_stego_stream_payload(const std::vector<std::uint8_t> &data, std::size_t block_size=StegoBlockSize) const;
+      /// @brief Create a copy of the payload with a stego stream of everything left in the given input stream.
+      ///
+      /// The input is read a batch of blocks at a time, so it can be larger than memory.
+      ///
+      /// @throws facade::exception::StreamFailure
+      /// @sa facade::PNGPayload::create_stego_stream_payload(const void *, std::size_t, std::size_t) const
+      ///
+      PNGPayload create_stego_stream_payload(std::istream &stream, std::size_t block_size=StegoBlockSize) const;
+
+      /// @brief Get how many bytes a frame stego payload can hold across the frames of the animation.
+      ///
+      /// Frames of any pixel type count, since they're converted to 8-bit truecolor to carry a stripe. This is the
+      /// space left over after every stripe's header and footer, before compression.
+      ///
+      std::size_t frame_stego_capacity() const;
+      /// @brief Check if the frames of the animation carry a frame stego payload.
+      ///
+      /// The frames are loaded concurrently to look for stripes.
+      ///
+      /// @throws facade::exception::Exception The first exception thrown while loading a frame.
+      ///
+      bool has_frame_stego_payload() const;
+      /// @brief Create a copy of the animated image with a payload steganographically spread across its frames.
+      ///
+      /// Every frame of an animated PNG is its own zlib stream, which makes each one a separate unit of work. The
+      /// payload is compressed once and split into stripes sized to the capacity of each frame, in the same layout as
+      /// facade::ICOPayload::create_striped_stego_payload, then every frame is decompressed, given its stripe, filtered
+      /// and compressed again on its own worker. If the image isn't already 8-bit truecolor, every frame and the
+      /// default image are converted to it.
+      ///
+      /// @param ptr The buffer of data to encode in the frames.
+      /// @param size The size, in bytes, of the given pointer data.
+      /// @return A facade::PNGPayload object with a frame stego payload.
+      /// @throws facade::exception::ChunkNotFound if the image has no frames.
+      /// @throws facade::exception::ImageTooSmall
+      /// @sa facade::png::Image::frames
+      /// @sa facade::png::Image::set_frame
+      ///
+      PNGPayload create_frame_stego_payload(const void *ptr, std::size_t size) const;
+      /// @brief Create a copy of the animated image with a payload steganographically spread across its frames.
+      /// @sa facade::PNGPayload::create_frame_stego_payload(const void *, std::size_t) const
+      ///
+      PNGPayload create_frame_stego_payload(const std::vector<std::uint8_t> &data) const;
+      /// @brief Decode and reassemble the frame stego payload of the animation.
+      ///
+      /// The frames are loaded and their stripes read out concurrently.
+      ///
+      /// @return A byte vector of the encoded data.
+      /// @throws facade::exception::NoStegoData
+      /// @throws facade::exception::InvalidSegment
+      ///
+      std::vector<std::uint8_t> extract_frame_stego_payload() const;
    };
 
    class
@@ -200,24 +393,164 @@ namespace facade
    {
       std::optional<std::size_t> _index;
       std::optional<PNGPayload> _payload;
+      Executor *workers = nullptr;
       
    public:
       ICOPayload() : ico::Icon() {}
-      ICOPayload(const void *ptr, std::size_t size) : ico::Icon(ptr, size) { this->find_png(); }
-      ICOPayload(const std::vector<std::uint8_t> &vec) : ico::Icon(vec) { this->find_png(); }
-      ICOPayload(const std::string &filename) : ico::Icon(filename) { this->find_png(); }
-      ICOPayload(const ICOPayload &other) : _index(other._index), _payload(other._payload), ico::Icon(other) {}
+      explicit ICOPayload(std::pmr::memory_resource *resource) : ico::Icon(resource) {}
+      ICOPayload(const void *ptr, std::size_t size, std::pmr::memory_resource *resource=std::pmr::get_default_resource())
+         : ico::Icon(ptr, size, resource) { this->select_first_png(); }
+      ICOPayload(const std::vector<std::uint8_t> &vec, std::pmr::memory_resource *resource=std::pmr::get_default_resource())
+         : ico::Icon(vec, resource) { this->select_first_png(); }
+      ICOPayload(const std::string &filename, std::pmr::memory_resource *resource=std::pmr::get_default_resource())
+         : ico::Icon(filename, resource) { this->select_first_png(); }
+      ICOPayload(const ICOPayload &other) : _index(other._index), _payload(other._payload), workers(other.workers), ico::Icon(other) {}
 
       ICOPayload &operator=(const ICOPayload &other);
       PNGPayload *operator->(void);
       PNGPayload &operator*(void);
 
+      /// @brief Check whether a PNG entry has been parsed into facade::ICOPayload::png_payload.
+      ///
+      /// Icons parsed without any PNG entry, such as those made only of bitmaps, have none.
+      ///
+      bool has_png(void) const;
       PNGPayload &png_payload(void);
       const PNGPayload &png_payload(void) const;
-      
+
+      /// @brief Get the index of the entry facade::ICOPayload::png_payload was parsed from.
+      /// @throws facade::exception::NoPNGIcon
+      ///
+      std::size_t png_index(void) const;
+      /// @brief Get the executor this icon runs its parallel stages on.
+      ///
+      /// This is facade::default_executor unless one was given with facade::ICOPayload::set_executor.
+      ///
+      Executor &executor(void) const;
+      /// @brief Run the parallel stages of this icon, such as parsing its entries and striping payloads across them,
+      ///        on the given executor, or on facade::default_executor if it's null.
+      ///
+      /// The entries parsed from the icon, including facade::ICOPayload::png_payload, run on it too. Copies of the icon
+      /// keep the executor. It must outlive its use by the icon and its copies.
+      ///
+      void set_executor(Executor *executor);
+
+      /// @brief Get the indexes of every PNG entry in the icon, in order.
+      ///
+      std::vector<std::size_t> png_indexes(void) const;
+      /// @brief Parse every PNG entry of the icon concurrently, on facade::ICOPayload::executor.
+      ///
+      /// Multi-resolution icons carry a PNG per size, and a payload can be in any of them. The entry at
+      /// facade::ICOPayload::png_index is copied from facade::ICOPayload::png_payload rather than parsed again, which
+      /// is cheap since copies share their chunks.
+      ///
+      /// @param load Whether to load the image data of each entry as well.
+      /// @return The parsed entries, in the order of facade::ICOPayload::png_indexes.
+      /// @throws facade::exception::Exception The first exception thrown while parsing or loading an entry.
+      ///
+      std::vector<PNGPayload> png_payloads(bool load=false) const;
+
+      /// @brief Parse the first PNG entry of the icon into facade::ICOPayload::png_payload.
+      /// @throws facade::exception::NoPNGIcon
+      ///
       void find_png(void);
+      /// @brief Parse the PNG entry at the given index into facade::ICOPayload::png_payload.
+      /// @throws facade::exception::NoPNGIcon
+      ///
+      void select_png(std::size_t index);
+      /// @brief Parse facade::ICOPayload::png_payload again from its entry, dropping any changes.
+      ///
       void reset_png(void);
+      /// @brief Write facade::ICOPayload::png_payload back into its entry.
+      ///
+      /// Only that entry is replaced, and facade::ico::Icon::to_file splices it into the original file.
+      ///
       void set_png(void);
+
+      /// @brief Get how many bytes a striped stego payload can hold across the PNG entries of the icon.
+      ///
+      /// Entries of any pixel type count, since they're converted to 8-bit truecolor to carry a stripe. This is the
+      /// space left over after every stripe's header and footer, before compression.
+      ///
+      std::size_t striped_stego_capacity(void) const;
+      /// @brief Check if the icon has a striped stego payload.
+      ///
+      /// The PNG entries are loaded concurrently to look for stripes.
+      ///
+      /// @throws facade::exception::Exception The first exception thrown while parsing or loading an entry.
+      ///
+      bool has_striped_stego_payload(void) const;
+      /// @brief Create a copy of the icon with a payload steganographically spread across all of its PNG entries.
+      ///
+      /// facade::PNGPayload::create_stego_payload is limited to the space of one image, while icons usually carry
+      /// several sizes of the same image. This compresses the payload once, splits it into stripes sized to the
+      /// capacity of each PNG entry, and encodes every stripe into its entry concurrently on facade::ICOPayload::executor,
+      /// converting entries to 8-bit truecolor where needed. Each stripe carries a small header recording its place in
+      /// the layout, so the stripes can be put back together no matter the order of the entries.
+      ///
+      /// Any changes made to facade::ICOPayload::png_payload are carried into its stripe.
+      ///
+      /// @param ptr The buffer of data to encode in the icon.
+      /// @param size The size, in bytes, of the given pointer data.
+      /// @return A facade::ICOPayload object with a striped stego payload.
+      /// @throws facade::exception::NoPNGIcon
+      /// @throws facade::exception::ImageTooSmall
+      ///
+      ICOPayload create_striped_stego_payload(const void *ptr, std::size_t size) const;
+      /// @brief Create a copy of the icon with a payload steganographically spread across all of its PNG entries.
+      /// @sa facade::ICOPayload::create_striped_stego_payload(const void *, std::size_t) const
+      ///
+      ICOPayload create_striped_stego_payload(const std::vector<std::uint8_t> &data) const;
+      /// @brief Decode and reassemble the striped stego payload of the icon.
+      ///
+      /// The stripes are read out of their entries concurrently.
+      ///
+      /// @return A byte vector of the encoded data.
+      /// @throws facade::exception::NoStegoData
+      /// @throws facade::exception::InvalidSegment
+      ///
+      std::vector<std::uint8_t> extract_striped_stego_payload(void) const;
+
+      /// @brief Get the indexes of every bitmap entry in the icon which can carry a stego payload, in order.
+      ///
+      /// These are the uncompressed 24- and 32-bit bitmap entries.
+      ///
+      std::vector<std::size_t> bmp_indexes(void) const;
+      /// @brief Get how many bytes a stego payload in the given bitmap entry can take up, before compression.
+      /// @throws facade::exception::NoBMPIcon
+      ///
+      std::size_t bmp_stego_capacity(std::size_t index) const;
+      /// @brief Check if the given bitmap entry has a stego payload.
+      /// @throws facade::exception::NoBMPIcon
+      ///
+      bool has_bmp_stego_payload(std::size_t index) const;
+      /// @brief Create a copy of the icon with a payload steganographically encoded in the given bitmap entry.
+      ///
+      /// Bitmap entries hold their pixels raw, so unlike facade::PNGPayload::create_stego_payload, there's no image
+      /// data to inflate, unfilter, filter or deflate again: the payload is written straight into the low bits of the
+      /// color channels in a single pass over the entry. Pixels are visited top row first whichever way the rows are
+      /// stored, and the alpha channel and AND mask are left alone, so the icon's transparency doesn't change.
+      ///
+      /// @param index The index of the bitmap entry to encode the payload in.
+      /// @param ptr The buffer of data to encode in the icon.
+      /// @param size The size, in bytes, of the given pointer data.
+      /// @return A facade::ICOPayload object with a stego payload in the given entry.
+      /// @throws facade::exception::NoBMPIcon
+      /// @throws facade::exception::ImageTooSmall
+      ///
+      ICOPayload create_bmp_stego_payload(std::size_t index, const void *ptr, std::size_t size) const;
+      /// @brief Create a copy of the icon with a payload steganographically encoded in the given bitmap entry.
+      /// @sa facade::ICOPayload::create_bmp_stego_payload(std::size_t, const void *, std::size_t) const
+      ///
+      ICOPayload create_bmp_stego_payload(std::size_t index, const std::vector<std::uint8_t> &data) const;
+      /// @brief Return the stego payload of the given bitmap entry.
+      /// @throws facade::exception::NoBMPIcon
+      /// @throws facade::exception::NoStegoData
+      ///
+      std::vector<std::uint8_t> extract_bmp_stego_payload(std::size_t index) const;
+
+   private:
+      void select_first_png(void);
    };
 }
 
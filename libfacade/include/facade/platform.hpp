@@ -22,6 +22,13 @@
 /// * `PACK(alignment)`: on MSVC, this evaluates to `__pragma(pack(push, alignment))`. if MSVC is not detected,
 ///                      this evaluates to `__attribute__((packed,aligned(alignment)))`.
 /// * `UNPACK()`: on MSVC, this evaluates to `__pragma(pack(pop))`. if MSVC is not detected, this evaluates to nothing.
+/// * `LIBFACADE_X86`: defined when compiling for an x86 or x86-64 target, where the SSSE3/AVX2 code paths are available
+///                    and selected at runtime.
+/// * `LIBFACADE_BIG_ENDIAN`: defined when compiling for a big-endian target, whose native byte order already matches
+///                           the big-endian samples of a PNG file.
+/// * `LIBFACADE_TARGET(features)`: on gcc and clang, this evaluates to `__attribute__((target(features)))` so a single
+///                                 function can be compiled for an instruction set the rest of the library does not
+///                                 assume. on MSVC, this evaluates to nothing, as intrinsics are always available.
 ///
 
 #if defined(_WIN32) || defined(WIN32)
@@ -54,6 +61,20 @@
 #define UNPACK()
 #endif
 
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define LIBFACADE_X86
+#endif
+
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define LIBFACADE_BIG_ENDIAN
+#endif
+
+#if defined(LIBFACADE_WIN32)
+#define LIBFACADE_TARGET(features)
+#else
+#define LIBFACADE_TARGET(features) __attribute__((target(features)))
+#endif
+
 #if defined(LIBFACADE_WIN32)
 /* this warning is in relation to a right-shift of 64, which is expected to result in a 0 value. */
 #pragma warning( disable: 4293 )
@@ -75,6 +75,8 @@
 //!
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
@@ -82,10 +84,15 @@
 #include <fstream>
 #include <limits>
 #include <map>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <optional>
 #include <set>
 #include <string>
+#include <string_view>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -93,11 +100,26 @@
 #include <facade/platform.hpp>
 #include <facade/exception.hpp>
 #include <facade/utility.hpp>
+#include <facade/stats.hpp>
+#include <facade/executor.hpp>
+#include <facade/signatures.hpp>
 
 namespace facade
 {
 namespace png
 {
+   /// @brief Compute the 32-bit FourCC value of a four-character chunk tag.
+   ///
+   /// The value is the four tag bytes read in big-endian order, the same order they appear in the file, so `fourcc("IHDR")`
+   /// is `0x49484452`. Being constexpr, tag constants cost nothing at runtime and compare as a single integer.
+   ///
+   constexpr std::uint32_t fourcc(const char (&tag)[5]) {
+      return (static_cast<std::uint32_t>(static_cast<std::uint8_t>(tag[0])) << 24)
+         | (static_cast<std::uint32_t>(static_cast<std::uint8_t>(tag[1])) << 16)
+         | (static_cast<std::uint32_t>(static_cast<std::uint8_t>(tag[2])) << 8)
+         | static_cast<std::uint32_t>(static_cast<std::uint8_t>(tag[3]));
+   }
+
    /// @brief The string tag identifying a given facade::png::ChunkVec or facade::png::ChunkPtr.
    ///
    class
@@ -146,6 +168,11 @@ namespace png
       /// @brief Convert this chunk tag to a std::string value.
       ///
       std::string to_string() const;
+
+      /// @brief Convert this chunk tag to its 32-bit FourCC value.
+      /// @sa facade::png::fourcc
+      ///
+      std::uint32_t fourcc() const;
    };
    UNPACK()
 
@@ -155,22 +182,58 @@ namespace png
    ///
    /// This is the base class of many different types of PNG chunks, such as facade::png::Header and facade::png::Text.
    ///
+   /// The chunk data is copy-on-write: copies of a chunk share one buffer until one of them asks for mutable data,
+   /// at which point that copy takes a private buffer. This keeps copying chunks, and the images holding them, cheap.
+   ///
    class
    EXPORT
    ChunkVec
    {
       ChunkTag _tag;
-      std::vector<std::uint8_t> _data;
+      std::shared_ptr<std::vector<std::uint8_t>> _data;
+
+   protected:
+      /// @brief Values derived from the chunk data which are expensive to recompute.
+      ///
+      /// Higher-level chunks like facade::png::Text are reached with upcast, so they can't carry members of their own.
+      /// Whatever they want to remember about the chunk data lives here instead, and is dropped whenever the data can change.
+      ///
+      struct Cache {
+         /// @brief Whether or not the null_terminator value has been computed.
+         bool has_null_terminator = false;
+         /// @brief The offset of the keyword null terminator, if any.
+         std::optional<std::size_t> null_terminator;
+         /// @brief The decompressed text of a `zTXt` chunk.
+         std::shared_ptr<const std::string> inflated;
+      };
+
+      /// @brief The cache of derived values for this chunk.
+      ///
+      /// Const accessors fill this in, so it's only read or written with facade::png::ChunkVec::_cache_mutex held.
+      /// That makes const accessors of one chunk safe to call from multiple threads at once.
+      ///
+      mutable Cache _cache;
+      /// @brief Guards facade::png::ChunkVec::_cache.
+      mutable std::mutex _cache_mutex;
+
+      /// @brief Drop any cached values derived from the chunk data.
+      ///
+      void invalidate_cache() const;
 
    public:
-      ChunkVec(const ChunkTag tag) : _tag(tag) {}
+      ChunkVec(const ChunkTag tag) : _tag(tag), _data(std::make_shared<std::vector<std::uint8_t>>()) {}
       ChunkVec(const ChunkTag tag, const void *ptr, std::size_t size)
          : _tag(tag),
-           _data(&reinterpret_cast<const std::uint8_t *>(ptr)[0],
-                 &reinterpret_cast<const std::uint8_t *>(ptr)[size]) {}
-      ChunkVec(const ChunkTag tag, const std::vector<std::uint8_t> &data) : _tag(tag), _data(data) {}
-      ChunkVec(const ChunkVec &other) : _tag(other._tag), _data(other._data) {}
+           _data(std::make_shared<std::vector<std::uint8_t>>(&reinterpret_cast<const std::uint8_t *>(ptr)[0],
+                                                             &reinterpret_cast<const std::uint8_t *>(ptr)[size])) {}
+      ChunkVec(const ChunkTag tag, const std::vector<std::uint8_t> &data) : _tag(tag), _data(std::make_shared<std::vector<std::uint8_t>>(data)) {}
+      ChunkVec(const ChunkVec &other) : _tag(other._tag), _data(other._data) {
+         std::lock_guard<std::mutex> lock(other._cache_mutex);
+         this->_cache = other._cache;
+      }
 
+      /// @brief Syntactic sugar for assigning to a chunk.
+      ChunkVec &operator=(const ChunkVec &other);
       bool operator==(const ChunkVec &other) const;
 
       /// @brief Return the length of this chunk's data.
@@ -186,6 +249,10 @@ namespace png
 
       /// @brief Return the chunk data reference associated with this chunk.
       ///
+      /// Because the returned reference can be used to modify the chunk, this drops any cached values derived from it and
+      /// gives this chunk its own copy of the data if it was shared with another chunk. Don't hold onto the reference across
+      /// calls to other accessors of this chunk or across copies of it.
+      ///
       std::vector<std::uint8_t> &data();
       /// @brief Return const chunk data reference associated with this chunk.
       ///
@@ -199,6 +266,10 @@ namespace png
       ///
       std::uint32_t crc() const;
 
+      /// @brief Check whether this chunk currently shares its data buffer with a copy of itself.
+      ///
+      bool is_shared() const;
+
       /// @brief Convert this ChunkVec to a facade::png::ChunkPtr.
       /// @warning If the vector returned by this function goes out of scope, the returned ChunkPtr will point
       ///          at deleted data. Make sure the vector and the ChunkPtr object retain the same scope.
@@ -380,7 +451,7 @@ namespace png
       
       Sample() : _value(0) {}
       Sample(Base value) { this->set_value(value); }
-      Sample(const Sample &other) { this->set_value(other._value); }
+      Sample(const Sample &other) : _value(other._value) {}
 
       /// @brief Syntactic sugar to get the value of this sample.
       /// @sa facade::png::Sample::value
@@ -442,7 +513,7 @@ namespace png
       GrayscalePixel(_Base value) : Sample<_Base, _Bits>(value) {}
       GrayscalePixel(const GrayscalePixel &other) : Sample<_Base, _Bits>(other) {}
 
-      /* TODO: color conversion functions */
+      /* color conversion works a row at a time, see facade::png::convert_row */
    };
 
    /// @brief A facade::png::GrayscalePixel with a 1-bit facade::png::Sample value.
@@ -538,7 +609,7 @@ namespace png
       PalettePixel(std::uint8_t value) : Sample<std::uint8_t, _Bits>(value) {}
       PalettePixel(const PalettePixel &other) : Sample<std::uint8_t, _Bits>(other) {}
 
-      /* TODO: convert to rgb */
+      /* palette indexes are expanded to rgb a row at a time, see facade::png::convert_row */
    };
 
    /// @brief A facade::png::PalettePixel object with a 1-bit facade::png::Sample value.
@@ -713,7 +784,7 @@ namespace png
       } _data;
 
    public:
-      PixelSpan() {}
+      PixelSpan() : _data() {}
       PixelSpan(const PixelSpan &other) { std::memcpy(&this->_data, &other._data, sizeof(this->_data)); }
 
       /// @brief The amount of samples possibly contained within this pixel span.
@@ -785,9 +856,12 @@ namespace png
    };
 
    /// @brief A vector of a facade::png::PixelSpan of the given pixel type.
+   ///
+   /// This is a polymorphic-allocator vector so that scanlines can be allocated from the memory resource of their image.
+   ///
    /// @tparam PixelType The base type of pixel to make this vector.
    template <typename PixelType>
-   using PixelRow = std::vector<PixelSpan<PixelType>>;
+   using PixelRow = std::pmr::vector<PixelSpan<PixelType>>;
 
    /// @brief Convert a row of facade::png::PixelSpan of the given pixel type into a vector of bytes.
    /// @tparam PixelType The pixel type of the row of span objects.
@@ -807,6 +881,102 @@ namespace png
       return result;
    }
 
+   /// @brief Unpack a row of packed samples into one byte per sample.
+   ///
+   /// Samples are read most-significant bits first, the way they're stored in a PNG scanline. This is the bulk form of
+   /// facade::png::PixelSpan::get for sub-byte pixel types, which works a whole byte at a time out of a lookup table.
+   ///
+   /// @param packed The packed samples. This must hold at least `(count * bits + 7) / 8` bytes.
+   /// @param count The number of samples to unpack.
+   /// @param bits The size, in bits, of each sample. Valid values are 1, 2, 4 and 8.
+   /// @param unpacked The buffer to unpack into. This must hold at least `count` bytes.
+   /// @throws facade::exception::InvalidBitDepth
+   ///
+   EXPORT void unpack_samples(const std::uint8_t *packed, std::size_t count, std::size_t bits, std::uint8_t *unpacked);
+   /// @brief Pack a row of one byte per sample into packed samples.
+   ///
+   /// This is the inverse of facade::png::unpack_samples. Only the low `bits` bits of each sample are used, and any
+   /// bits of the final byte past the last sample are left as they were.
+   ///
+   /// @param unpacked The samples to pack, one per byte. This must hold at least `count` bytes.
+   /// @param count The number of samples to pack.
+   /// @param bits The size, in bits, of each sample. Valid values are 1, 2, 4 and 8.
+   /// @param packed The buffer to pack into. This must hold at least `(count * bits + 7) / 8` bytes.
+   /// @throws facade::exception::InvalidBitDepth
+   ///
+   EXPORT void pack_samples(const std::uint8_t *unpacked, std::size_t count, std::size_t bits, std::uint8_t *packed);
+
+   /// @brief The colors that the `PLTE` and `tRNS` chunks of an image give its samples.
+   ///
+   /// This is what facade::png::convert_row looks palette indexes and color keys up in. Converting to a palette type
+   /// looks colors up the other way, so the palette should hold every color in the rows being converted.
+   ///
+   /// @sa facade::png::Image::color_table
+   ///
+   class
+   EXPORT
+   ColorTable
+   {
+      /* RGBA entries, in the byte order they appear in memory */
+      std::vector<std::uint32_t> entries;
+      std::unordered_map<std::uint32_t, std::size_t> index;
+
+   public:
+      /// @brief The transparent color of a grayscale or true color image, from its `tRNS` chunk.
+      ///
+      /// Samples are at the bit depth of the image. Grayscale images only use the first sample.
+      ///
+      std::optional<std::array<std::uint16_t, 3>> color_key;
+
+      ColorTable() {}
+
+      /// @brief The number of colors in the palette.
+      ///
+      std::size_t palette_size() const;
+      /// @brief Get the RGBA color of the given palette index.
+      /// @throws facade::exception::OutOfBounds
+      ///
+      std::array<std::uint8_t, 4> color(std::size_t index) const;
+      /// @brief Get the palette index of the given RGBA color.
+      /// @return std::nullopt if the color isn't in the palette.
+      ///
+      std::optional<std::size_t> find_color(const std::uint8_t *rgba) const;
+      /// @brief Add an RGBA color to the end of the palette, unless it's already there.
+      /// @return The palette index of the color.
+      ///
+      std::size_t add_color(const std::uint8_t *rgba);
+      /// @brief Check whether any palette color has an alpha value other than 255, or a color key is set.
+      ///
+      bool has_transparency() const;
+   };
+
+   /// @brief Get the size, in bytes, of a row of the given pixel type, not counting the filter byte.
+   /// @throws facade::exception::UnsupportedPixelType
+   ///
+   EXPORT std::size_t row_size(PixelEnum pixel_type, std::size_t width);
+   /// @brief Convert a row of pixels from one pixel type to another.
+   ///
+   /// Rows are in the form they take in PNG image data, with 16-bit samples in big-endian order and sub-byte samples
+   /// packed most-significant bits first. Palette indexes and color keys are expanded with the given color table, and
+   /// converting to a palette type looks each color up in it. Samples are scaled between bit depths, with 16-bit samples
+   /// reduced to their high byte. Color is reduced to gray by its luma, and alpha is dropped by types without it,
+   /// except that converting to a palette type keeps it. The common cases, such as reducing a 16-bit type to its 8-bit
+   /// form and adding or dropping the alpha channel of 8-bit true color, are vectorized.
+   ///
+   /// @param from The pixel type of the source row.
+   /// @param src The source row. This must hold `row_size(from, width)` bytes.
+   /// @param to The pixel type to convert to.
+   /// @param dst The buffer to write the row to. This must hold `row_size(to, width)` bytes and not overlap the source.
+   /// @param width The number of pixels in the row.
+   /// @param colors The palette or color key of the source, and the palette to look colors up in when converting to a
+   ///               palette type. Converting between two palette types uses the same palette for both.
+   /// @throws facade::exception::UnsupportedPixelType
+   /// @throws facade::exception::TooManyColors if converting to a palette type and a color isn't in the palette, or
+   ///                                         its index doesn't fit in the bit depth.
+   ///
+   EXPORT void convert_row(PixelEnum from, const std::uint8_t *src, PixelEnum to, std::uint8_t *dst, std::size_t width,
+                           const ColorTable &colors=ColorTable());
+
    /// @brief A PNG header object.
    /// @sa facade::png::ChunkVec
    ///
@@ -840,7 +1010,7 @@ namespace png
       /// @param color_type Set the color type of this image. Use facade::png::ColorType for valid values.
       /// @param compression_method Set the compression method. The only valid type is 0.
       /// @param filter_method Set the filter method of this PNG image. The only currently supported type is 0.
-      /// @param interlace_method Set the interlace method of this PNG image. The only currently supported type is 0.
+      /// @param interlace_method Set the interlace method of this PNG image. Valid values are 0 (none) and 1 (Adam7).
       /// @warning This interface explicitly allows you to set invalid types! If you set an invalid type, you may encounter
       ///          exceptions when parsing or creating an image.
       void set(std::uint32_t width, std::uint32_t height, std::uint8_t bit_depth,
@@ -896,9 +1066,37 @@ namespace png
       std::size_t pixel_size() const;
       /// @brief Return the expected raw pixel data buffer size of the decompressed image data, in bytes.
       ///
+      /// For Adam7-interlaced images this is the combined size of the seven passes.
+      ///
       std::size_t buffer_size() const;
    };
 
+   /// @brief The origin and spacing of one of the seven passes of an Adam7-interlaced image.
+   ///
+   struct Adam7Pass
+   {
+      std::size_t x, y, dx, dy;
+
+      /// @brief The width, in pixels, of this pass for an image of the given width.
+      ///
+      constexpr std::size_t width(std::size_t image_width) const { return (image_width > x) ? (image_width - x + dx - 1) / dx : 0; }
+      /// @brief The height, in pixels, of this pass for an image of the given height.
+      ///
+      constexpr std::size_t height(std::size_t image_height) const { return (image_height > y) ? (image_height - y + dy - 1) / dy : 0; }
+   };
+
+   /// @brief The seven passes of Adam7 interlacing, in the order they're stored in the image data.
+   ///
+   constexpr Adam7Pass ADAM7_PASSES[7] = {
+      { 0, 0, 8, 8 },
+      { 4, 0, 8, 8 },
+      { 0, 4, 4, 8 },
+      { 2, 0, 4, 4 },
+      { 0, 2, 2, 4 },
+      { 1, 0, 2, 2 },
+      { 0, 1, 1, 2 }
+   };
+
    /// @brief A `tEXt` chunk object.
    ///
    class
@@ -932,6 +1130,13 @@ namespace png
       /// @throws facade::exception::NoKeyword
       ///
       std::string keyword() const;
+      /// @brief A view of the keyword value, if present.
+      ///
+      /// Unlike keyword, this does not copy the keyword. The view is valid until the chunk is modified or destroyed.
+      ///
+      /// @throws facade::exception::NoKeyword
+      ///
+      std::string_view keyword_view() const;
       /// @brief Set the keyword of this `tEXt` chunk, with the option to validate the value given.
       /// @param keyword The keyword string to set.
       /// @param validate Validate with an exception if the keyword is too long. Default is true.
@@ -946,6 +1151,11 @@ namespace png
       /// @brief Get the text data from this `tEXt` chunk.
       ///
       std::string text() const;
+      /// @brief Get a view of the text data from this `tEXt` chunk.
+      ///
+      /// The view points directly into the chunk data and is valid until the chunk is modified or destroyed.
+      ///
+      std::string_view text_view() const;
       /// @brief Set the text data for this `tEXt chunk.
       ///
       void set_text(std::string text);
@@ -963,7 +1173,7 @@ namespace png
          this->set_compression_method(0);
          this->set_text(text);
       }
-      ZText(const Text &other) : ChunkVec(other) {}
+      ZText(const Text &other) : ChunkVec(other) { this->invalidate_cache(); }
 
    protected:
       /// @brief Get the null terminator, if present, separating the keyword from the text value.
@@ -985,6 +1195,13 @@ namespace png
       /// @throws facade::exception::NoKeyword
       ///
       std::string keyword() const;
+      /// @brief A view of the keyword value, if present.
+      ///
+      /// Unlike keyword, this does not copy the keyword. The view is valid until the chunk is modified or destroyed.
+      ///
+      /// @throws facade::exception::NoKeyword
+      ///
+      std::string_view keyword_view() const;
       /// @brief Set the keyword of this `zTXt` chunk, with the option to validate the value given.
       /// @param keyword The keyword string to set.
       /// @param validate Validate with an exception if the keyword is too long. Default is true.
@@ -1006,12 +1223,114 @@ namespace png
       bool has_text() const;
       /// @brief Get the text data from this `zTXt` chunk.
       ///
+      /// The text is decompressed on the first call and cached until the chunk is modified, so repeated calls are cheap.
+      ///
       std::string text() const;
+      /// @brief Get a view of the decompressed text data from this `zTXt` chunk.
+      ///
+      /// This decompresses at most once, like text, but doesn't copy the result. The view is valid until the chunk
+      /// is modified or destroyed.
+      ///
+      std::string_view text_view() const;
       /// @brief Set the text data for this `zTXt chunk.
       ///
       void set_text(std::string text);
    };
 
+   /// @brief The codec applied to the payload of a facade::png::BinaryData chunk.
+   ///
+   enum BinaryCodec
+   {
+      BINARY_RAW = 0,
+      BINARY_ZLIB = 1
+   };
+
+   /// @brief A private `faCd` chunk carrying raw binary data.
+   ///
+   /// Unlike `tEXt` and `zTXt` chunks, this data is not required to be Latin-1 text, so it is stored as-is without
+   /// base64 encoding. The tag marks the chunk as ancillary, private and safe-to-copy, so decoders which don't
+   /// understand it will skip it and editors will keep it. The chunk data is laid out as a null-terminated keyword,
+   /// a single facade::png::BinaryCodec byte, then the (possibly compressed) payload.
+   ///
+   class
+   EXPORT
+   BinaryData : public ChunkVec {
+   public:
+      BinaryData() : ChunkVec(std::string("faCd")) {}
+      BinaryData(std::string keyword, const void *ptr, std::size_t size, std::uint8_t codec=BINARY_RAW) : ChunkVec(std::string("faCd")) {
+         this->set_keyword(keyword);
+         this->set_payload(ptr, size, codec);
+      }
+      BinaryData(std::string keyword, const std::vector<std::uint8_t> &data, std::uint8_t codec=BINARY_RAW) : ChunkVec(std::string("faCd")) {
+         this->set_keyword(keyword);
+         this->set_payload(data, codec);
+      }
+      BinaryData(const BinaryData &other) : ChunkVec(other) {}
+
+   protected:
+      /// @brief Get the null terminator, if present, separating the keyword from the codec and payload.
+      /// @return std::nullopt if no null terminator is present, the offset to the null terminator otherwise.
+      ///
+      std::optional<std::size_t> null_terminator() const;
+
+      /// @brief Return the offset to the underlying payload data.
+      ///
+      std::size_t payload_offset() const;
+
+   public:
+      /// @brief Check if this `faCd` chunk has a keyword set.
+      /// @return True if a keyword is present, false otherwise.
+      ///
+      bool has_keyword() const;
+      /// @brief The keyword value, if present.
+      /// @return A std::string representation of the keyword.
+      /// @throws facade::exception::NoKeyword
+      ///
+      std::string keyword() const;
+      /// @brief A view of the keyword value, if present.
+      ///
+      /// Unlike keyword, this does not copy the keyword. The view is valid until the chunk is modified or destroyed.
+      ///
+      /// @throws facade::exception::NoKeyword
+      ///
+      std::string_view keyword_view() const;
+      /// @brief Set the keyword of this `faCd` chunk, with the option to validate the value given.
+      /// @param keyword The keyword string to set.
+      /// @param validate Validate with an exception if the keyword is too long. Default is true.
+      /// @throws facade::exception::KeywordTooLong
+      ///
+      void set_keyword(std::string keyword, bool validate=true);
+
+      /// @brief Return the codec used for the payload of this `faCd` chunk.
+      /// @throws facade::exception::NoKeyword
+      /// @throws facade::exception::OutOfBounds
+      /// @sa facade::png::BinaryCodec
+      ///
+      std::uint8_t codec() const;
+
+      /// @brief Check if this `faCd` chunk has payload data.
+      /// @return True if payload data is present, false otherwise.
+      ///
+      bool has_payload() const;
+      /// @brief Get the payload of this `faCd` chunk, decompressing it if necessary.
+      /// @throws facade::exception::UnsupportedBinaryCodec
+      /// @throws facade::exception::ZLibError
+      ///
+      std::vector<std::uint8_t> payload() const;
+      /// @brief Set the payload of this `faCd` chunk.
+      /// @param ptr The data to store.
+      /// @param size The size, in bytes, of the data.
+      /// @param codec The facade::png::BinaryCodec to apply to the data. Default is facade::png::BINARY_RAW.
+      /// @throws facade::exception::NoKeyword
+      /// @throws facade::exception::UnsupportedBinaryCodec
+      ///
+      void set_payload(const void *ptr, std::size_t size, std::uint8_t codec=BINARY_RAW);
+      /// @brief Set the payload of this `faCd` chunk.
+      /// @sa facade::png::BinaryData::set_payload(const void *, std::size_t, std::uint8_t)
+      ///
+      void set_payload(const std::vector<std::uint8_t> &data, std::uint8_t codec=BINARY_RAW);
+   };
+
    /// @brief The end chunk for a given PNG file.
    ///
    class
@@ -1022,6 +1341,116 @@ namespace png
       End(const End &other) : ChunkVec(other) {}
    };
 
+   /// @brief The animation control chunk (`acTL`) of an animated PNG.
+   ///
+   /// Its presence is what marks a PNG as animated, see facade::png::Image::is_animated.
+   ///
+   class
+   EXPORT
+   AnimationControl : public ChunkVec {
+   public:
+      AnimationControl() : ChunkVec(std::string("acTL"), std::vector<std::uint8_t>(8)) {}
+      AnimationControl(const void *ptr, std::size_t size) : ChunkVec(std::string("acTL"), ptr, size) {}
+      AnimationControl(const std::vector<std::uint8_t> &vec) : ChunkVec(std::string("acTL"), vec) {}
+      AnimationControl(const AnimationControl &other) : ChunkVec(other) {}
+
+      /// @brief Get the number of frames in the animation.
+      /// @throws facade::exception::InsufficientSize
+      ///
+      std::uint32_t frames() const;
+      /// @brief Set the number of frames in the animation.
+      /// @throws facade::exception::InsufficientSize
+      ///
+      void set_frames(std::uint32_t frames);
+
+      /// @brief Get the number of times to play the animation, where 0 plays it forever.
+      /// @throws facade::exception::InsufficientSize
+      ///
+      std::uint32_t plays() const;
+      /// @brief Set the number of times to play the animation.
+      /// @throws facade::exception::InsufficientSize
+      ///
+      void set_plays(std::uint32_t plays);
+   };
+
+   /// @brief What happens to the region of a frame once it's been shown, before the next frame is drawn.
+   ///
+   enum DisposeOp
+   {
+      DISPOSE_OP_NONE = 0,
+      DISPOSE_OP_BACKGROUND = 1,
+      DISPOSE_OP_PREVIOUS = 2
+   };
+
+   /// @brief How a frame is drawn over the output buffer.
+   ///
+   enum BlendOp
+   {
+      BLEND_OP_SOURCE = 0,
+      BLEND_OP_OVER = 1
+   };
+
+   /// @brief The frame control chunk (`fcTL`) which starts each frame of an animated PNG.
+   ///
+   /// The image data of a frame follows its frame control: the `IDAT` chunks if the frame is the default image, or
+   /// `fdAT` chunks otherwise. Frame controls and `fdAT` chunks share one sequence counter, which
+   /// facade::png::Image::set_frame keeps in order.
+   ///
+   class
+   EXPORT
+   FrameControl : public ChunkVec {
+   public:
+      FrameControl() : ChunkVec(std::string("fcTL"), std::vector<std::uint8_t>(26)) {}
+      FrameControl(const void *ptr, std::size_t size) : ChunkVec(std::string("fcTL"), ptr, size) {}
+      FrameControl(const std::vector<std::uint8_t> &vec) : ChunkVec(std::string("fcTL"), vec) {}
+      FrameControl(const FrameControl &other) : ChunkVec(other) {}
+
+      /// @brief Get the sequence number of this chunk.
+      std::uint32_t sequence_number() const;
+      /// @brief Set the sequence number of this chunk.
+      void set_sequence_number(std::uint32_t sequence_number);
+
+      /// @brief Get the width, in pixels, of the frame.
+      std::uint32_t width() const;
+      /// @brief Set the width, in pixels, of the frame.
+      void set_width(std::uint32_t width);
+
+      /// @brief Get the height, in pixels, of the frame.
+      std::uint32_t height() const;
+      /// @brief Set the height, in pixels, of the frame.
+      void set_height(std::uint32_t height);
+
+      /// @brief Get the x offset of the frame on the canvas.
+      std::uint32_t x_offset() const;
+      /// @brief Set the x offset of the frame on the canvas.
+      void set_x_offset(std::uint32_t x_offset);
+
+      /// @brief Get the y offset of the frame on the canvas.
+      std::uint32_t y_offset() const;
+      /// @brief Set the y offset of the frame on the canvas.
+      void set_y_offset(std::uint32_t y_offset);
+
+      /// @brief Get the numerator of the frame delay, in seconds.
+      std::uint16_t delay_numerator() const;
+      /// @brief Set the numerator of the frame delay, in seconds.
+      void set_delay_numerator(std::uint16_t delay_numerator);
+
+      /// @brief Get the denominator of the frame delay, in seconds. 0 means 100.
+      std::uint16_t delay_denominator() const;
+      /// @brief Set the denominator of the frame delay, in seconds.
+      void set_delay_denominator(std::uint16_t delay_denominator);
+
+      /// @brief Get the facade::png::DisposeOp of the frame.
+      std::uint8_t dispose_op() const;
+      /// @brief Set the facade::png::DisposeOp of the frame.
+      void set_dispose_op(std::uint8_t dispose_op);
+
+      /// @brief Get the facade::png::BlendOp of the frame.
+      std::uint8_t blend_op() const;
+      /// @brief Set the facade::png::BlendOp of the frame.
+      void set_blend_op(std::uint8_t blend_op);
+   };
+
    /// @brief The filter type to use for a given scanline.
    ///
    enum FilterType
@@ -1033,6 +1462,110 @@ namespace png
       PAETH
    };
 
+   /// @brief A view of the 16-bit samples of a scanline, in the order they appear in the row.
+   ///
+   /// Every channel of every pixel is one element, so a row of facade::png::AlphaTrueColorPixel16Bit pixels reads as
+   /// red, green, blue, alpha, red, and so on. The samples are in whatever byte order the scanline holds them in, which
+   /// is the native order of the machine once facade::png::Image::to_native_endian has been called. The view is only
+   /// valid for as long as the scanline it came from is alive and unmodified.
+   ///
+   /// Rows of packed pixels have no alignment to speak of, so samples are read and written through
+   /// facade::png::SampleView::Reference a byte at a time rather than as `std::uint16_t` objects. Compilers turn this
+   /// into plain unaligned loads and stores where the machine allows them.
+   ///
+   /// @tparam T The sample type, either `std::uint16_t` or `const std::uint16_t`.
+   ///
+   template <typename T>
+   class SampleView
+   {
+      static_assert(std::is_same<typename std::remove_const<T>::type, std::uint16_t>::value, "SampleView type must be a 16-bit sample");
+
+      using Byte = typename std::conditional<std::is_const<T>::value, const std::uint8_t, std::uint8_t>::type;
+
+      Byte *_data;
+      std::size_t _size;
+
+   public:
+      /// @brief A reference to one sample of a facade::png::SampleView.
+      ///
+      class Reference
+      {
+         Byte *_ptr;
+
+      public:
+         explicit Reference(Byte *ptr) : _ptr(ptr) {}
+         Reference(const Reference &other) : _ptr(other._ptr) {}
+
+         /// @brief Read the sample.
+         ///
+         operator std::uint16_t() const {
+            std::uint16_t value;
+            std::memcpy(&value, this->_ptr, sizeof(value));
+
+            return value;
+         }
+
+         /// @brief Write the sample.
+         ///
+         Reference &operator=(std::uint16_t value) {
+            static_assert(!std::is_const<T>::value, "Can't write to a const SampleView");
+
+            std::memcpy(this->_ptr, &value, sizeof(value));
+
+            return *this;
+         }
+
+         /// @brief Copy the value of another sample into this one.
+         ///
+         Reference &operator=(const Reference &other) { return *this = static_cast<std::uint16_t>(other); }
+      };
+
+      /// @brief An iterator over the samples of a facade::png::SampleView.
+      ///
+      class iterator
+      {
+         Byte *_ptr;
+
+      public:
+         explicit iterator(Byte *ptr) : _ptr(ptr) {}
+
+         Reference operator*() const { return Reference(this->_ptr); }
+         iterator &operator++() { this->_ptr += sizeof(std::uint16_t); return *this; }
+         bool operator==(const iterator &other) const { return this->_ptr == other._ptr; }
+         bool operator!=(const iterator &other) const { return this->_ptr != other._ptr; }
+      };
+
+      SampleView() : _data(nullptr), _size(0) {}
+      SampleView(Byte *data, std::size_t size) : _data(data), _size(size) {}
+      SampleView(const SampleView &other) : _data(other._data), _size(other._size) {}
+
+      /// @brief Get the sample at the given index without bounds checking.
+      ///
+      Reference operator[](std::size_t index) const { return Reference(this->_data + index * sizeof(std::uint16_t)); }
+
+      /// @brief Get the sample at the given index.
+      /// @throws facade::exception::OutOfBounds
+      ///
+      Reference at(std::size_t index) const {
+         if (index >= this->_size) { throw exception::OutOfBounds(index, this->_size); }
+
+         return (*this)[index];
+      }
+
+      /// @brief The bytes of the first sample of the view.
+      ///
+      Byte *data() const { return this->_data; }
+      /// @brief The number of samples in the view.
+      ///
+      std::size_t size() const { return this->_size; }
+      /// @brief Whether the view holds no samples.
+      ///
+      bool empty() const { return this->_size == 0; }
+
+      iterator begin() const { return iterator(this->_data); }
+      iterator end() const { return iterator(this->_data + this->_size * sizeof(std::uint16_t)); }
+   };
+
    /// @brief The base scanline class containing a row of facade::png::PixelSpan of the given pixel type.
    /// @tparam PixelType The pixel type this scanline holds.
    ///
@@ -1049,15 +1582,39 @@ namespace png
 
    private:
       std::uint8_t _filter_type;
-      std::vector<Span> _pixel_data;
+      /// @brief The pixel data, shared between copies of the scanline until one of them is written to.
+      ///
+      /// Both the row and its shared state are allocated from the memory resource the scanline was created with.
+      ///
+      std::shared_ptr<PixelRow<PixelType>> _pixel_data;
+
+      /// @brief Allocate a shared pixel row from the given memory resource, constructed from the given arguments.
+      ///
+      template <typename... Args>
+      static std::shared_ptr<PixelRow<PixelType>> make_pixel_data(std::pmr::memory_resource *resource, Args&&... args) {
+         return std::allocate_shared<PixelRow<PixelType>>(std::pmr::polymorphic_allocator<PixelRow<PixelType>>(resource),
+                                                          std::forward<Args>(args)...);
+      }
+
+      /// @brief Get the pixel data for writing, taking a private copy first if it is shared.
+      ///
+      PixelRow<PixelType> &mutable_pixel_data();
 
    public:
-      ScanlineBase() : _filter_type(0) {}
-      ScanlineBase(std::uint8_t filter_type, std::size_t width)
+      ScanlineBase() : _filter_type(0), _pixel_data(make_pixel_data(std::pmr::get_default_resource())) {}
+      ScanlineBase(std::uint8_t filter_type, std::size_t width, std::pmr::memory_resource *resource=std::pmr::get_default_resource())
+         : _filter_type(filter_type),
+           _pixel_data(make_pixel_data(resource, width / Span::Samples + static_cast<int>(width % Span::Samples != 0))) {}
+      ScanlineBase(std::uint8_t filter_type, const Span *spans, std::size_t count, std::pmr::memory_resource *resource=std::pmr::get_default_resource())
          : _filter_type(filter_type),
-           _pixel_data(width / Span::Samples + static_cast<int>(width % Span::Samples != 0)) {}
-      ScanlineBase(std::uint8_t filter_type, std::vector<Span> pixel_data) : _filter_type(filter_type), _pixel_data(pixel_data) {}
+           _pixel_data(make_pixel_data(resource, &spans[0], &spans[count])) {}
+      ScanlineBase(std::uint8_t filter_type, PixelRow<PixelType> pixel_data)
+         : _filter_type(filter_type),
+           _pixel_data(make_pixel_data(pixel_data.get_allocator().resource(), std::move(pixel_data))) {}
+      ScanlineBase(std::uint8_t filter_type, const std::vector<Span> &pixel_data)
+         : ScanlineBase(filter_type, pixel_data.data(), pixel_data.size()) {}
       ScanlineBase(const ScanlineBase &other) : _filter_type(other._filter_type), _pixel_data(other._pixel_data) {}
+      ScanlineBase &operator=(const ScanlineBase &other) = default;
 
       /// @brief Create a scanline object from raw data at the given data offset.
       /// @param raw_data The raw data byte vector to read from.
@@ -1067,6 +1624,17 @@ namespace png
       /// @throws facade::exception::OutOfBounds
       ///
       static ScanlineBase read_line(const std::vector<std::uint8_t> &raw_data, std::size_t offset, std::size_t width);
+      /// @brief Create a scanline object from a raw data buffer at the given data offset.
+      /// @param raw_data The raw data buffer to read from.
+      /// @param size The size, in bytes, of the raw data buffer.
+      /// @param offset The offset to begin reading the scanline.
+      /// @param width The width of the scanline.
+      /// @param resource The memory resource to allocate the scanline's pixels from.
+      /// @return The parsed scanline from the raw data.
+      /// @throws facade::exception::OutOfBounds
+      ///
+      static ScanlineBase read_line(const std::uint8_t *raw_data, std::size_t size, std::size_t offset, std::size_t width,
+                                    std::pmr::memory_resource *resource=std::pmr::get_default_resource());
 
       /// @brief Collect a vector of scanlines from the given raw data.
       /// @param header The header of the given image to collect scanlines from.
@@ -1076,6 +1644,17 @@ namespace png
       /// @throws facade::exception::OutOfBounds
       ///
       static std::vector<ScanlineBase> from_raw(const Header &header, const std::vector<std::uint8_t> &raw_data);
+      /// @brief Collect a vector of scanlines from the given raw data buffer.
+      /// @param header The header of the given image to collect scanlines from.
+      /// @param raw_data The raw pixel data from the uncompressed `IDAT` chunks.
+      /// @param size The size, in bytes, of the raw pixel data.
+      /// @param resource The memory resource to allocate the scanlines' pixels from.
+      /// @return A vector of scanlines of the given scanline type.
+      /// @throws facade::exception::PixelMismatch
+      /// @throws facade::exception::OutOfBounds
+      ///
+      static std::vector<ScanlineBase> from_raw(const Header &header, const std::uint8_t *raw_data, std::size_t size,
+                                                std::pmr::memory_resource *resource=std::pmr::get_default_resource());
 
       /// @brief Syntactic sugar for getting a facade::png::Pixel variant.
       /// @sa facade::png::ScanlineBase::get_pixel
@@ -1094,7 +1673,13 @@ namespace png
 #endif
       /// @brief Return a const reference to the underlying pixel data array.
       ///
-      const std::vector<Span> &pixel_data() const;
+      const PixelRow<PixelType> &pixel_data() const;
+      /// @brief Return the memory resource this scanline's pixels are allocated from.
+      ///
+      std::pmr::memory_resource *memory_resource() const;
+      /// @brief Check whether this scanline currently shares its pixel data with a copy of itself.
+      ///
+      bool is_shared() const;
 
       /// @brief Return the size, in terms of pixel span objects, of the underlying scanline.
       /// @warning This is not always equivalent to facade::png::Header::width-- sometimes it's less than that,
@@ -1148,9 +1733,64 @@ namespace png
       ///
       void set_pixel(const Pixel &pixel, std::size_t index);
 
+      /// @brief Unpack the first `count` samples of this scanline into one byte per sample.
+      ///
+      /// This is the bulk form of facade::png::ScanlineBase::get_pixel for the single-channel pixel types of 8 bits or
+      /// less, and avoids building a facade::png::Pixel variant for every sample.
+      ///
+      /// @param samples The buffer to unpack into. This must hold at least `count` bytes.
+      /// @param count The number of samples to unpack, bound by facade::png::ScanlineBase::pixel_width.
+      /// @sa facade::png::unpack_samples
+      /// @throws facade::exception::OutOfBounds
+      /// @throws facade::exception::PixelMismatch
+      ///
+      void unpack_samples(std::uint8_t *samples, std::size_t count) const;
+      /// @brief Unpack every sample of this scanline into one byte per sample.
+      /// @sa facade::png::ScanlineBase::unpack_samples(std::uint8_t *, std::size_t) const
+      ///
+      std::vector<std::uint8_t> unpack_samples() const;
+      /// @brief Pack `count` samples of one byte each into the start of this scanline.
+      ///
+      /// This is the bulk form of facade::png::ScanlineBase::set_pixel. Samples past `count` are left as they were.
+      ///
+      /// @param samples The samples to pack.
+      /// @param count The number of samples to pack, bound by facade::png::ScanlineBase::pixel_width.
+      /// @sa facade::png::pack_samples
+      /// @throws facade::exception::OutOfBounds
+      /// @throws facade::exception::PixelMismatch
+      ///
+      void pack_samples(const std::uint8_t *samples, std::size_t count);
+      /// @brief Pack a vector of samples of one byte each into the start of this scanline.
+      /// @sa facade::png::ScanlineBase::pack_samples(const std::uint8_t *, std::size_t)
+      ///
+      void pack_samples(const std::vector<std::uint8_t> &samples);
+
+      /// @brief Get a view of the 16-bit samples of this scanline, taking a private copy first if it is shared.
+      /// @sa facade::png::SampleView
+      /// @throws facade::exception::PixelMismatch if the pixel type doesn't have 16-bit samples.
+      ///
+      SampleView<std::uint16_t> samples_16();
+      /// @brief Get a read-only view of the 16-bit samples of this scanline.
+      /// @sa facade::png::SampleView
+      /// @throws facade::exception::PixelMismatch if the pixel type doesn't have 16-bit samples.
+      ///
+      SampleView<const std::uint16_t> samples_16() const;
+      /// @brief Swap the byte order of every sample in this scanline.
+      ///
+      /// This does nothing for pixel types whose samples are 8 bits or less.
+      ///
+      /// @sa facade::png::Image::to_native_endian
+      ///
+      void swap_endian();
+
       /// @brief Convert this scanline to raw byte form.
       ///
       std::vector<std::uint8_t> to_raw() const;
+      /// @brief Append the raw byte form of this scanline to the given buffer.
+      ///
+      /// This saves a temporary vector per scanline when a whole image is being written out.
+      ///
+      void to_raw(std::pmr::vector<std::uint8_t> &buffer) const;
 
       /// @brief Reconstruct the scanline based on its filter value.
       ///
@@ -1288,14 +1928,187 @@ namespace png
       ///
       void set_pixel(const Pixel &pixel, std::size_t index);
 
+      /// @brief Visit the variant type held and unpack every sample into one byte per sample.
+      /// @sa facade::png::ScanlineBase::unpack_samples
+      ///
+      std::vector<std::uint8_t> unpack_samples() const;
+      /// @brief Visit the variant type held and pack the given samples of one byte each into it.
+      /// @sa facade::png::ScanlineBase::pack_samples
+      ///
+      void pack_samples(const std::vector<std::uint8_t> &samples);
+
+      /// @brief Visit the variant type held and swap the byte order of its samples.
+      /// @sa facade::png::ScanlineBase::swap_endian
+      ///
+      void swap_endian();
+
       /// @brief Visit the variant type held and get the raw bytes of the pixels represented.
       /// @sa facade::png::ScanlineBase::to_raw
       ///
       std::vector<std::uint8_t> to_raw() const;
+      /// @brief Visit the variant type held and append the raw bytes of the pixels represented to the given buffer.
+      /// @sa facade::png::ScanlineBase::to_raw
+      ///
+      void to_raw(std::pmr::vector<std::uint8_t> &buffer) const;
+   };
+
+   /// @brief A read-only view of a set of chunks in an image, in file order.
+   ///
+   /// This is what facade::png::Image::get_chunks returns in place of a copied vector, and what the keyword lookups like
+   /// facade::png::Image::get_text return with the chunks upcast to their higher-level type. The view refers to the chunks
+   /// held by the image, so it is only valid until chunks are added to or removed from that image. It converts to a
+   /// std::vector of copies if one is needed.
+   ///
+   /// @tparam T The facade::png::ChunkVec derivative to present the chunks as.
+   ///
+   template <typename T=ChunkVec>
+   class ChunkView
+   {
+      static_assert(std::is_base_of<ChunkVec, T>::value, "ChunkView type must derive ChunkVec");
+      
+      const std::vector<ChunkVec> *_chunks;
+      const std::vector<std::size_t> *_offsets;
+      std::shared_ptr<const std::vector<std::size_t>> _owned_offsets;
+
+   public:
+      /// @brief An iterator over the chunks of a facade::png::ChunkView.
+      ///
+      class const_iterator
+      {
+         const std::vector<ChunkVec> *_chunks;
+         const std::size_t *_offset;
+
+      public:
+         using iterator_category = std::forward_iterator_tag;
+         using value_type = T;
+         using difference_type = std::ptrdiff_t;
+         using pointer = const T *;
+         using reference = const T &;
+
+         const_iterator() : _chunks(nullptr), _offset(nullptr) {}
+         const_iterator(const std::vector<ChunkVec> *chunks, const std::size_t *offset) : _chunks(chunks), _offset(offset) {}
+         const_iterator(const const_iterator &other) : _chunks(other._chunks), _offset(other._offset) {}
+
+         const_iterator &operator=(const const_iterator &other) {
+            this->_chunks = other._chunks;
+            this->_offset = other._offset;
+
+            return *this;
+         }
+         
+         reference operator*() const { return (*this->_chunks)[*this->_offset].template upcast<T>(); }
+         pointer operator->() const { return &(*this->_chunks)[*this->_offset].template upcast<T>(); }
+         const_iterator &operator++() { ++this->_offset; return *this; }
+         const_iterator operator++(int) { auto result = *this; ++this->_offset; return result; }
+         bool operator==(const const_iterator &other) const { return this->_offset == other._offset; }
+         bool operator!=(const const_iterator &other) const { return this->_offset != other._offset; }
+      };
+
+      ChunkView() : _chunks(nullptr), _offsets(nullptr) {}
+      ChunkView(const std::vector<ChunkVec> &chunks, const std::vector<std::size_t> &offsets) : _chunks(&chunks), _offsets(&offsets) {}
+      /// @brief Create a view over offsets of its own, such as the chunks of a lookup that passed a filter.
+      ///
+      ChunkView(const std::vector<ChunkVec> &chunks, std::vector<std::size_t> &&offsets)
+         : _chunks(&chunks),
+           _offsets(nullptr),
+           _owned_offsets(std::make_shared<const std::vector<std::size_t>>(std::move(offsets))) {
+         this->_offsets = this->_owned_offsets.get();
+      }
+      ChunkView(const ChunkView &other) : _chunks(other._chunks), _offsets(other._offsets), _owned_offsets(other._owned_offsets) {}
+
+      /// @brief Syntactic sugar for assigning to a view.
+      ChunkView &operator=(const ChunkView &other) {
+         this->_chunks = other._chunks;
+         this->_offsets = other._offsets;
+         this->_owned_offsets = other._owned_offsets;
+
+         return *this;
+      }
+
+      /// @brief Syntactic sugar for getting a chunk in the view.
+      /// @sa facade::png::ChunkView::at
+      ///
+      const T &operator[](std::size_t index) const { return this->at(index); }
+
+      /// @brief Copy the chunks in this view into a vector.
+      ///
+      operator std::vector<T>() const { return std::vector<T>(this->begin(), this->end()); }
+
+      /// @brief Get the chunk at the given index within the view.
+      /// @throws facade::exception::OutOfBounds
+      ///
+      const T &at(std::size_t index) const {
+         if (index >= this->size()) { throw exception::OutOfBounds(index, this->size()); }
+
+         return (*this->_chunks)[(*this->_offsets)[index]].template upcast<T>();
+      }
+
+      /// @brief Return the number of chunks in the view.
+      ///
+      std::size_t size() const { return (this->_offsets == nullptr) ? 0 : this->_offsets->size(); }
+      /// @brief Check whether the view contains no chunks.
+      ///
+      bool empty() const { return this->size() == 0; }
+
+      /// @brief Return the first chunk in the view.
+      /// @throws facade::exception::OutOfBounds
+      ///
+      const T &front() const { return this->at(0); }
+      /// @brief Return the last chunk in the view.
+      /// @throws facade::exception::OutOfBounds
+      ///
+      const T &back() const { return this->at(this->size()-1); }
+      
+      /// @brief Return an iterator to the first chunk in the view.
+      ///
+      const_iterator begin() const {
+         if (this->_offsets == nullptr) { return const_iterator(); }
+
+         return const_iterator(this->_chunks, this->_offsets->data());
+      }
+      /// @brief Return an iterator past the last chunk in the view.
+      ///
+      const_iterator end() const {
+         if (this->_offsets == nullptr) { return const_iterator(); }
+
+         return const_iterator(this->_chunks, this->_offsets->data() + this->_offsets->size());
+      }
+   };
+   
+   /// @brief A breakdown of the memory held by a facade::png::Image, in bytes.
+   ///
+   /// Buffers shared between copies of an image, such as copy-on-write chunk data and scanlines, are counted in full
+   /// by every copy holding them, and their share of the total is reported in facade::png::MemoryUsage::shared.
+   ///
+   struct MemoryUsage
+   {
+      /// @brief The capacity of the data buffers of every chunk.
+      std::size_t chunk_data = 0;
+      /// @brief The capacity of the pixel rows of the loaded image data.
+      std::size_t pixel_data = 0;
+      /// @brief The capacity of the trailing data buffer.
+      std::size_t trailing_data = 0;
+      /// @brief An estimate of the bookkeeping around the buffers: the chunk and scanline containers, the shared
+      ///        buffer control blocks and the chunk indexes.
+      std::size_t overhead = 0;
+      /// @brief How much of the above is in buffers shared with another copy of the image.
+      std::size_t shared = 0;
+
+      /// @brief The sum of the chunk, pixel and trailing data and the overhead.
+      std::size_t total() const { return this->chunk_data + this->pixel_data + this->trailing_data + this->overhead; }
    };
 
    /// @brief A class for loading and manipulating PNG images.
    ///
+   /// Chunk data, trailing data and scanline pixels are all copy-on-write, so copying an image only copies
+   /// the chunk list and row list. The bytes are copied later, and only for the parts that a copy modifies.
+   ///
+   /// An image can be given a `std::pmr::memory_resource` to allocate its decoded scanlines and its compression
+   /// buffers from, including *zlib*'s own state. A batch job can hand each file a `std::pmr::monotonic_buffer_resource`
+   /// and release everything the image allocated in one go. The resource must outlive the image and every copy of it,
+   /// since copies share its scanlines. Chunk data stays on the global heap, as facade::png::ChunkVec::data hands out
+   /// a plain `std::vector`.
+   ///
    /// Here is an example of how to use this class object in particular:
    /// @include png_manipulation.cpp
    ///
@@ -1308,19 +2121,66 @@ namespace png
       static const std::uint8_t Signature[8];
             
    protected:
-      /// @brief A map of chunk tags to their corresponding facade::png::ChunkVec types.
-      std::map<std::string, std::vector<ChunkVec>> chunk_map;
+      /// @brief The chunks of the image, in the order they're written to the file.
+      std::vector<ChunkVec> chunks;
+      /// @brief An index of chunk FourCC values to the offsets of those chunks in facade::png::Image::chunks, in ascending order.
+      std::unordered_map<std::uint32_t, std::vector<std::size_t>> chunk_index;
+      /// @brief An index of keyword chunks (`tEXt`, `zTXt` and `faCd`) by FourCC and keyword to their offsets in facade::png::Image::chunks.
+      ///
+      /// This is built along with facade::png::Image::chunk_index, then kept up to date as chunks are added and removed.
+      /// The keyword of the chunk most recently added with facade::png::Image::add_chunk can still be changed through
+      /// the returned reference, so that one chunk is re-keyed by the next keyword lookup or change to the image.
+      ///
+      mutable std::unordered_map<std::uint32_t, std::unordered_map<std::string, std::vector<std::size_t>>> keyword_index;
+      /// @brief The offset of the chunk most recently added with facade::png::Image::add_chunk and the keyword it was
+      ///        indexed under, if it hasn't been re-keyed yet.
+      mutable std::optional<std::pair<std::size_t, std::optional<std::string>>> keyword_pending;
+      /// @brief Guards re-keying facade::png::Image::keyword_index from const keyword lookups.
+      mutable std::mutex keyword_index_mutex;
       /// @brief A container for trailing data, if present when parsing or when writing afterward.
-      std::optional<std::vector<std::uint8_t>> trailing_data;
+      ///
+      /// Like chunk data, this is shared between copies of the image until one of them asks for mutable access.
+      ///
+      std::shared_ptr<std::vector<std::uint8_t>> trailing_data;
       /// @brief The loaded image data from the compressed `IDAT` chunks.
       std::optional<std::vector<Scanline>> image_data;
+      /// @brief Whether the 16-bit samples of the loaded image data are in native rather than PNG byte order.
+      bool native_endian = false;
+      /// @brief The memory resource that scanlines and compression buffers are allocated from.
+      std::pmr::memory_resource *resource = std::pmr::get_default_resource();
+      /// @brief The stats object that pipeline stages are recorded in, or a null pointer if they aren't recorded.
+      ///
+      /// Copies of the image share this object.
+      ///
+      std::shared_ptr<Stats> statistics;
+      /// @brief The executor that parallel stages run on, or a null pointer for facade::default_executor.
+      Executor *workers = nullptr;
 
    public:
       Image() {}
+      explicit Image(std::pmr::memory_resource *resource) : resource(resource) {}
       Image(const void *ptr, std::size_t size, bool validate=true) { this->parse(ptr, size, validate); }
       Image(const std::vector<std::uint8_t> &data, bool validate=true) { this->parse(data, validate); }
       Image(const std::string &filename, bool validate=true) { this->parse(filename, validate); }
-      Image(const Image &other) : chunk_map(other.chunk_map), trailing_data(other.trailing_data), image_data(other.image_data) {}
+      Image(const void *ptr, std::size_t size, std::pmr::memory_resource *resource, bool validate=true)
+         : resource(resource) { this->parse(ptr, size, validate); }
+      Image(const std::vector<std::uint8_t> &data, std::pmr::memory_resource *resource, bool validate=true)
+         : resource(resource) { this->parse(data, validate); }
+      Image(const std::string &filename, std::pmr::memory_resource *resource, bool validate=true)
+         : resource(resource) { this->parse(filename, validate); }
+      Image(const Image &other)
+         : chunks(other.chunks),
+           chunk_index(other.chunk_index),
+           trailing_data(other.trailing_data),
+           image_data(other.image_data),
+           native_endian(other.native_endian),
+           resource(other.resource),
+           statistics(other.statistics),
+           workers(other.workers) {
+         std::lock_guard<std::mutex> lock(other.keyword_index_mutex);
+         this->keyword_index = other.keyword_index;
+         this->keyword_pending = other.keyword_pending;
+      }
 
       /// @brief Syntatic sugar for assigning to an image object.
       Image &operator=(const Image &other);
@@ -1334,18 +2194,147 @@ namespace png
       ///
       const Scanline &operator[](std::size_t index) const;
 
+   protected:
+      /// @brief Find the offset at which a new chunk with the given tag belongs.
+      ///
+      /// `IHDR` goes first and `IEND` goes last. Chunks which the PNG specification requires to precede the image data
+      /// go before the first `IDAT` chunk, new `IDAT` chunks go after the existing ones, and everything else goes
+      /// before `IEND`.
+      ///
+      std::size_t insertion_offset(std::uint32_t tag) const;
+      /// @brief Insert a chunk at the given offset, keeping facade::png::Image::chunk_index up to date.
+      ///
+      ChunkVec &insert_chunk(std::size_t offset, const ChunkVec &chunk);
+      /// @brief Erase the chunk at the given offset, keeping facade::png::Image::chunk_index up to date.
+      ///
+      void erase_chunk(std::size_t offset);
+      /// @brief Erase every chunk with the given tag.
+      ///
+      void erase_chunks(std::uint32_t tag);
+      /// @brief Move the indexed offset of a chunk, keeping both indexes sorted.
+      ///
+      void reoffset_chunk(const ChunkVec &chunk, std::size_t from, std::size_t to);
+      /// @brief Rebuild facade::png::Image::chunk_index and facade::png::Image::keyword_index from facade::png::Image::chunks.
+      ///
+      void reindex();
+      /// @brief Rebuild facade::png::Image::keyword_index from facade::png::Image::chunks.
+      ///
+      /// The caller either has facade::png::Image::keyword_index_mutex held or is the only one with access to the image.
+      ///
+      void reindex_keywords() const;
+      /// @brief Move the chunk in facade::png::Image::keyword_pending to the index entry of its current keyword.
+      ///
+      /// The caller either has facade::png::Image::keyword_index_mutex held or is the only one with access to the image.
+      ///
+      void rekey_pending_chunk() const;
+      /// @brief Get the keyword of a chunk for facade::png::Image::keyword_index.
+      /// @return std::nullopt if the chunk isn't a keyword chunk or has no keyword.
+      ///
+      static std::optional<std::string_view> indexed_keyword(const ChunkVec &chunk);
+      /// @brief Get the offsets of the chunks with the given tag and keyword, re-keying the most recently added chunk
+      ///        first.
+      /// @return A null pointer if no such chunks exist.
+      ///
+      const std::vector<std::size_t> *keyword_offsets(std::uint32_t tag, const std::string &keyword) const;
+      /// @brief Find the offset of the first chunk equal to the given chunk.
+      /// @return std::nullopt if no such chunk is present, the offset into facade::png::Image::chunks otherwise.
+      ///
+      std::optional<std::size_t> find_chunk(const ChunkVec &chunk) const;
+      /// @brief Get the offsets of the image data chunks of the given frame, the `IDAT` or `fdAT` chunks between its
+      ///        frame control and the next.
+      /// @throws facade::exception::OutOfBounds
+      ///
+      std::vector<std::size_t> frame_data_offsets(std::size_t index) const;
+      /// @brief Number every `fcTL` and `fdAT` chunk in file order, starting from 0.
+      ///
+      void renumber_frames();
+
+   public:
       /// @brief Check for the presence of a given chunk tag.
       /// @return True if one or more chunks with that chunk tag were found, false otherwise.
       ///
       bool has_chunk(const std::string &tag) const;
-      /// @brief Get the chunk data for the corresponding tag.
-      /// @return A vector of one or more chunks corresponding to the given chunk tag.
+      /// @brief Check for the presence of a given chunk tag by its FourCC value.
+      /// @sa facade::png::fourcc
+      ///
+      bool has_chunk(std::uint32_t tag) const;
+      /// @brief Get the chunks for the corresponding tag.
+      /// @return A view of one or more chunks corresponding to the given chunk tag, in file order.
       /// @throws facade::exception::ChunkNotFound
       ///
-      std::vector<ChunkVec> get_chunks(const std::string &tag) const;
+      ChunkView<> get_chunks(const std::string &tag) const;
+      /// @brief Get the chunks for the corresponding tag by its FourCC value.
+      /// @sa facade::png::fourcc
+      /// @throws facade::exception::ChunkNotFound
+      ///
+      ChunkView<> get_chunks(std::uint32_t tag) const;
+      /// @brief Get every chunk in the image, in file order.
+      ///
+      const std::vector<ChunkVec> &get_all_chunks() const;
       /// @brief Add a given chunk to the underlying image.
       ///
-      void add_chunk(const ChunkVec &chunk);
+      /// The chunk is placed where the PNG specification expects it relative to the chunks already present, otherwise
+      /// the original chunk order is kept.
+      ///
+      /// @return A reference to the chunk within the image, valid until chunks are added to or removed from the image.
+      ///         A keyword changed through the reference is seen by the next keyword lookup, such as
+      ///         facade::png::Image::get_text.
+      ///
+      ChunkVec &add_chunk(const ChunkVec &chunk);
+
+      /// @brief Get the memory resource this image allocates its scanlines and compression buffers from.
+      ///
+      std::pmr::memory_resource *memory_resource() const;
+      /// @brief Set the memory resource this image allocates from.
+      ///
+      /// This only affects allocations made afterward. Scanlines which are already loaded keep the resource they were
+      /// allocated from.
+      ///
+      void set_memory_resource(std::pmr::memory_resource *resource);
+
+      /// @brief Get the executor this image runs its parallel stages on.
+      ///
+      /// This is facade::default_executor unless one was given with facade::png::Image::set_executor.
+      ///
+      Executor &executor() const;
+      /// @brief Run the parallel stages of this image, such as loading, filtering and compressing, on the given executor,
+      ///        or on facade::default_executor if it's null.
+      ///
+      /// Copies of the image keep the executor. It must outlive its use by the image and its copies.
+      ///
+      void set_executor(Executor *executor);
+
+      /// @brief Start recording the stages of the pipeline run on this image.
+      ///
+      /// If stats are already being recorded, the existing object is kept and returned.
+      ///
+      /// @param trace Whether to keep every run of every stage for facade::Stats::to_chrome_trace.
+      /// @return The stats object the stages are recorded in.
+      /// @sa facade::Stats
+      ///
+      Stats &enable_stats(bool trace=false);
+      /// @brief Stop recording pipeline stages on this image.
+      ///
+      /// Other images sharing the stats object keep recording into it.
+      ///
+      void disable_stats();
+      /// @brief Get the stats object the pipeline stages of this image are recorded in.
+      /// @return A null pointer if stats aren't enabled.
+      ///
+      std::shared_ptr<Stats> stats() const;
+      /// @brief Record the pipeline stages of this image in the given stats object, or stop recording them if it's null.
+      ///
+      /// Sharing one object between several images gives their combined totals.
+      ///
+      void set_stats(std::shared_ptr<Stats> stats);
+
+      /// @brief Get a breakdown of the memory this image holds.
+      ///
+      /// This walks every chunk and scanline, so it's not meant to be called in a tight loop.
+      ///
+      /// @sa facade::png::MemoryUsage
+      ///
+      MemoryUsage memory_usage() const;
 
       /// @brief Return whether or not this PNG image has trailing data.
       ///
@@ -1366,6 +2355,16 @@ namespace png
       /// @brief Clear the trailing data in the PNG image.
       ///
       void clear_trailing_data();
+      /// @brief Find the files embedded in the trailing data by their signatures, such as an appended ZIP archive or
+      ///        executable.
+      ///
+      /// The trailing data is scanned where it lies, on this image's executor.
+      ///
+      /// @return The files found, with offsets relative to the start of the trailing data.
+      /// @throws facade::exception::NoTrailingData
+      /// @sa facade::scan_signatures
+      ///
+      std::vector<EmbeddedFile> scan_trailing_data() const;
 
       /// @brief Parse a given data buffer into its individual chunks for further processing.
       /// @param ptr The data pointer to parse.
@@ -1391,10 +2390,21 @@ namespace png
       ///
       /// This decompresses and reconstructs the image data in the parsed file or stream.
       ///
+      /// @param native_endian If true, 16-bit samples are converted to native byte order once reconstructed.
       /// @sa facade::png::Image::decompress
       /// @sa facade::png::Image::reconstruct
+      /// @sa facade::png::Image::to_native_endian
       ///
-      void load();
+      void load(bool native_endian=false);
+      /// @brief Load the image data from the `IDAT` chunks and convert it to the given pixel type.
+      ///
+      /// This lets any image be read in one form, such as 8-bit true color with alpha, no matter how it was saved.
+      ///
+      /// @param pixel_type The pixel type to convert the image data to.
+      /// @param native_endian If true, 16-bit samples are converted to native byte order once converted.
+      /// @sa facade::png::Image::convert
+      ///
+      void load(PixelEnum pixel_type, bool native_endian=false);
 
       /// @brief Get the scanline at the given y index.
       /// @return The scanline at the given Y index.
@@ -1445,10 +2455,23 @@ namespace png
       bool is_loaded() const;
 
       /// @brief Decompress the `IDAT` chunks in the image.
+      ///
+      /// Adam7-interlaced images are unfiltered pass by pass, with the seven passes running in parallel, and then laid out
+      /// as full-resolution scanlines. Their scanlines are therefore already reconstructed once this returns, and pixels
+      /// can be read and written by their image coordinates just like a non-interlaced image.
+      ///
       /// @throws facade::exception::ZLibError
+      /// @throws facade::exception::InvalidInterlaceMethod
+      /// @throws facade::exception::PixelMismatch
       /// 
       void decompress();
       /// @brief Compress the image data into `IDAT` chunks.
+      ///
+      /// If the header says the image is Adam7-interlaced, the scanlines are split back into the seven passes, each pass
+      /// is filtered in parallel and the passes are written in order. This happens whether or not
+      /// facade::png::Image::filter was called, and requires the scanlines to be unfiltered.
+      /// Call facade::png::Image::deinterlace first to write the image without interlacing.
+      ///
       /// @param chunk_size The optional chunk size of the fully compressed image data. If present, it splits
       ///                   the image data into as many data chunks as necessary at the given boundary.
       ///                   If set to std::nullopt, the compressed data will be present in one single chunk.
@@ -1460,12 +2483,88 @@ namespace png
       ///
       void compress(std::optional<std::size_t> chunk_size=8192, int level=-1);
 
+      /// @brief Return whether the image header specifies Adam7 interlacing.
+      /// @throws facade::exception::NoHeaderChunk
+      ///
+      bool is_interlaced() const;
+      /// @brief Drop Adam7 interlacing from the image.
+      ///
+      /// If the image data is loaded, this only updates the header, and the next call to facade::png::Image::compress
+      /// writes the image without interlacing. Otherwise the image data is loaded, filtered and recompressed without
+      /// interlacing right away. Images which aren't interlaced are left as they are.
+      ///
+      /// @throws facade::exception::NoHeaderChunk
+      ///
+      void deinterlace();
+
       /// @brief Reconstruct the filtered image data into their raw, unfiltered form.
       /// @throws facade::exception::NoImageData
       /// @sa facade::png::ScanlineBase::reconstruct
       ///
       void reconstruct();
+      /// @brief Check whether the 16-bit samples of the loaded image data are in native byte order.
+      /// @sa facade::png::Image::to_native_endian
+      ///
+      bool is_native_endian() const;
+      /// @brief Convert the 16-bit samples of the loaded image data from PNG's big-endian order to native order.
+      ///
+      /// Every row is byte-swapped in bulk, so the samples can then be read and written directly through
+      /// facade::png::ScanlineBase::samples_16 without a swap per access. On big-endian machines PNG order already is
+      /// native order, so the image is only marked as converted. While the image is in native order, the
+      /// facade::png::Pixel accessors of its 16-bit scanlines return byte-swapped values. facade::png::Image::filter
+      /// and facade::png::Image::compress convert the image back to PNG order first. Images with 8-bit or smaller
+      /// samples are only marked as converted.
+      ///
+      /// @throws facade::exception::NoImageData
+      ///
+      void to_native_endian();
+      /// @brief Convert the 16-bit samples of the loaded image data back to PNG's big-endian order.
+      /// @throws facade::exception::NoImageData
+      /// @sa facade::png::Image::to_native_endian
+      ///
+      void to_png_endian();
+
+      /// @brief Get the palette and color key of the image from its `PLTE` and `tRNS` chunks.
+      /// @throws facade::exception::NoHeaderChunk
+      ///
+      ColorTable color_table() const;
+      /// @brief Convert the loaded image data to the given pixel type.
+      ///
+      /// Rows are converted in parallel with facade::png::convert_row. Converting to a palette type builds a palette out
+      /// of the colors in the image, in the order they first appear. The header is updated to match, `PLTE` and `tRNS`
+      /// are rewritten for the new type, and `sBIT`, `bKGD` and `hIST`, which only make sense for the old type, are
+      /// removed. A color key survives conversion to another type without alpha, and becomes the alpha channel of a type
+      /// with one. Scanlines are left unfiltered, ready for facade::png::Image::filter.
+      ///
+      /// @throws facade::exception::NoImageData
+      /// @throws facade::exception::UnsupportedPixelType
+      /// @throws facade::exception::TooManyColors if converting to a palette type and the image has more colors than
+      ///                                         the bit depth allows.
+      ///
+      void convert(PixelEnum pixel_type);
+      /// @brief Find the smallest pixel type which holds the loaded image data without losing anything.
+      ///
+      /// Grayscale types are chosen at the lowest bit depth that keeps every sample, palette types when the image has
+      /// 256 colors or fewer, and 16-bit types only when some sample doesn't fit in 8 bits. Alpha is kept only if some
+      /// pixel isn't opaque.
+      ///
+      /// @throws facade::exception::NoImageData
+      ///
+      PixelEnum smallest_pixel_type() const;
+      /// @brief Convert the loaded image data to facade::png::Image::smallest_pixel_type.
+      ///
+      /// This is meant for right before saving, such as bringing an image loaded as 8-bit true color back down to a
+      /// palette.
+      ///
+      /// @throws facade::exception::NoImageData
+      ///
+      void reduce();
+
       /// @brief Filter the image data to prepare it for compression.
+      ///
+      /// Interlaced images are filtered pass by pass by facade::png::Image::compress instead, so this leaves their
+      /// scanlines as they are.
+      ///
       /// @throws facade::exception::NoImageData
       /// @sa facade::png::ScanlineBase::filter
       ///
@@ -1484,6 +2583,56 @@ namespace png
       ///
       void save(const std::string &filename) const;
 
+      /// @brief Check whether the image is an animated PNG, which is whether it has an `acTL` chunk.
+      ///
+      bool is_animated() const;
+      /// @brief Get the animation control chunk of the image.
+      /// @throws facade::exception::ChunkNotFound
+      ///
+      const AnimationControl &animation_control() const;
+      /// @brief Get the number of frames in the image, which is the number of `fcTL` chunks.
+      ///
+      std::size_t frame_count() const;
+      /// @brief Get the frame control of the given frame.
+      /// @throws facade::exception::OutOfBounds
+      ///
+      const FrameControl &frame_control(std::size_t index) const;
+      /// @brief Check whether the default image, the one held in the `IDAT` chunks, is the first frame of the animation.
+      ///
+      bool default_image_is_frame() const;
+      /// @brief Get the given frame of the animation as an image of its own.
+      ///
+      /// The frame gets a copy of the header with the width and height of its frame control, the `PLTE` and `tRNS`
+      /// chunks of the image, and its own compressed stream moved into `IDAT` chunks, with the sequence numbers of its
+      /// `fdAT` chunks stripped. It can be loaded, edited and compressed like any other image, and shares the memory
+      /// resource, stats and executor of this image. Nothing is decompressed, so this is cheap.
+      ///
+      /// @throws facade::exception::OutOfBounds
+      /// @throws facade::exception::InvalidFrame if the frame has no image data.
+      ///
+      Image frame(std::size_t index) const;
+      /// @brief Get every frame of the animation as images of their own, split out concurrently.
+      ///
+      /// Each frame is its own zlib stream, so with @p load set, the frames are decompressed and reconstructed in
+      /// parallel on the executor of this image.
+      ///
+      /// @param load Whether to load the image data of each frame as well.
+      /// @throws facade::exception::Exception The first exception thrown while splitting or loading a frame.
+      /// @sa facade::png::Image::frame
+      ///
+      std::vector<Image> frames(bool load=false) const;
+      /// @brief Replace the image data of the given frame with the compressed image data of the given image.
+      ///
+      /// The image's `IDAT` chunks become the `IDAT` chunks of the default image if the frame is the default image,
+      /// otherwise `fdAT` chunks. Every `fcTL` and `fdAT` chunk is then renumbered, so frames can be replaced in any
+      /// order. Replacing the default image drops the loaded image data of this image, which no longer matches it.
+      ///
+      /// @throws facade::exception::OutOfBounds
+      /// @throws facade::exception::NoImageDataChunks
+      /// @throws facade::exception::InvalidFrame if the image's size, pixel type or interlacing don't match the frame.
+      ///
+      void set_frame(std::size_t index, const Image &frame);
+
       /// @brief Return whether or not the image contains a `tEXt` chunk.
       ///
       bool has_text() const;
@@ -1503,9 +2652,14 @@ namespace png
       ///
       void remove_text(const std::string &keyword, const std::string &text);
       /// @brief Get the `tEXt` sections with the following keyword.
-      /// @return A vector of returned results. An empty vector means the keyword wasn't found.
       ///
-      std::vector<Text> get_text(const std::string &keyword) const;
+      /// Lookups go through a keyword index, so this doesn't scan every `tEXt` chunk. Changing the keyword of a chunk through
+      /// the reference returned by add_text isn't seen by the index; remove the chunk and add it again instead.
+      ///
+      /// @return A view of the matching chunks, in file order. An empty view means the keyword wasn't found.
+      /// @sa facade::png::ChunkView
+      ///
+      ChunkView<Text> get_text(const std::string &keyword) const;
 
       /// @brief Return whether or not the image contains a `zTXt` chunk.
       ///
@@ -1526,9 +2680,36 @@ namespace png
       ///
       void remove_ztext(const std::string &keyword, const std::string &text);
       /// @brief Get the `zTXt` sections with the following keyword.
-      /// @return A vector of returned results. An empty vector means the keyword wasn't found.
+      /// @return A view of the matching chunks, in file order. An empty view means the keyword wasn't found.
+      /// @sa facade::png::Image::get_text
+      ///
+      ChunkView<ZText> get_ztext(const std::string &keyword) const;
+
+      /// @brief Return whether or not the image contains a `faCd` chunk.
+      ///
+      bool has_binary() const;
+      /// @brief Add a `faCd` binary data chunk to the PNG image.
+      /// @param keyword The keyword to give the `faCd` chunk.
+      /// @param ptr The data to store in the chunk.
+      /// @param size The size, in bytes, of the data.
+      /// @param codec The facade::png::BinaryCodec to store the data with. Default is facade::png::BINARY_RAW.
+      /// @return A facade::png::BinaryData chunk reference of the newly added `faCd` section.
+      /// @sa facade::png::BinaryData
+      ///
+      BinaryData &add_binary(const std::string &keyword, const void *ptr, std::size_t size, std::uint8_t codec=BINARY_RAW);
+      /// @brief Add a `faCd` binary data chunk to the PNG image.
+      /// @sa facade::png::Image::add_binary(const std::string &, const void *, std::size_t, std::uint8_t)
+      ///
+      BinaryData &add_binary(const std::string &keyword, const std::vector<std::uint8_t> &data, std::uint8_t codec=BINARY_RAW);
+      /// @brief Remove the given `faCd` section from the image.
+      /// @throws facade::exception::BinaryDataNotFound
+      ///
+      void remove_binary(const BinaryData &binary);
+      /// @brief Get the `faCd` sections with the following keyword.
+      /// @return A view of the matching chunks, in file order. An empty view means the keyword wasn't found.
+      /// @sa facade::png::Image::get_text
       ///
-      std::vector<ZText> get_ztext(const std::string &keyword) const;
+      ChunkView<BinaryData> get_binary(const std::string &keyword) const;
    };
 }}
 
@@ -0,0 +1,101 @@
+#ifndef __FACADE_SIGNATURES_HPP
+#define __FACADE_SIGNATURES_HPP
+
+//! @file signatures.hpp
+//! @brief Finding the files embedded in a buffer, such as the trailing data of an image, by their signatures.
+//!
+//! facade::scan_signatures looks for the magic numbers of every format in facade::FileFormat at once, with an
+//! Aho-Corasick automaton. Bytes which can't start a signature are skipped 16 at a time with SIMD, and large
+//! buffers are split across an executor, so a multi-gigabyte blob takes a single pass. Each match is then checked
+//! against the structure of its format, and measured where the format records its own size, which weeds out most
+//! false positives and lets embedded files be carved back out.
+//!
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <facade/platform.hpp>
+#include <facade/executor.hpp>
+
+namespace facade
+{
+   /// @brief The formats recognized by facade::scan_signatures.
+   ///
+   enum FileFormat
+   {
+      /// @brief A PNG image.
+      FORMAT_PNG = 0,
+      /// @brief A JPEG image.
+      FORMAT_JPEG,
+      /// @brief A GIF image.
+      FORMAT_GIF,
+      /// @brief A PDF document.
+      FORMAT_PDF,
+      /// @brief A ZIP archive, which includes formats built on it such as JAR, DOCX and APK.
+      FORMAT_ZIP,
+      /// @brief A 7-Zip archive.
+      FORMAT_7Z,
+      /// @brief A RAR archive.
+      FORMAT_RAR,
+      /// @brief A gzip stream.
+      FORMAT_GZIP,
+      /// @brief A bzip2 stream.
+      FORMAT_BZIP2,
+      /// @brief An xz stream.
+      FORMAT_XZ,
+      /// @brief A Windows PE executable or library.
+      FORMAT_PE,
+      /// @brief An ELF executable or library.
+      FORMAT_ELF,
+      /// @brief The number of formats.
+      FORMAT_COUNT
+   };
+
+   /// @brief Get the lowercase name of a format, as used in reports.
+   ///
+   EXPORT const char *format_name(FileFormat format);
+   /// @brief Get the usual file extension of a format, without the leading dot.
+   ///
+   EXPORT const char *format_extension(FileFormat format);
+
+   /// @brief A file found in a buffer by facade::scan_signatures.
+   ///
+   struct EmbeddedFile
+   {
+      /// @brief The format of the file.
+      FileFormat format;
+      /// @brief The offset of the file in the buffer that was scanned.
+      std::size_t offset;
+      /// @brief The size of the file.
+      ///
+      /// See facade::EmbeddedFile::exact_size for where this comes from.
+      ///
+      std::size_t size;
+      /// @brief Whether the size was read from the structure of the file.
+      ///
+      /// Formats which don't record their own size, such as JPEG and gzip, run up to the next file found or the end
+      /// of the buffer instead.
+      ///
+      bool exact_size;
+   };
+
+   /// @brief Find the files embedded in a buffer by their signatures.
+   ///
+   /// Files are returned in order of their offset. Signatures found inside a file whose size is exact, such as the
+   /// local headers of a ZIP archive or a PNG stored within one, belong to that file and aren't reported.
+   ///
+   /// @param ptr The buffer to scan.
+   /// @param size The size of the buffer.
+   /// @param executor The executor to split large buffers across.
+   /// @return The files found in the buffer.
+   /// @throws facade::exception::NullPointer
+   ///
+   EXPORT std::vector<EmbeddedFile> scan_signatures(const void *ptr, std::size_t size, Executor &executor=default_executor());
+   /// @brief Find the files embedded in a vector of bytes by their signatures.
+   /// @sa facade::scan_signatures
+   ///
+   EXPORT std::vector<EmbeddedFile> scan_signatures(const std::vector<std::uint8_t> &data, Executor &executor=default_executor());
+}
+
+#endif
@@ -0,0 +1,266 @@
+#ifndef __FACADE_STATS_HPP
+#define __FACADE_STATS_HPP
+
+//! @file stats.hpp
+//! @brief Opt-in instrumentation of the image pipeline.
+//!
+//! A facade::Stats object attached to a facade::png::Image records how long each stage of the pipeline took and how
+//! many bytes went in and out of it, along with chunk counts and the filter types chosen for each row. Images without
+//! one attached skip the instrumentation entirely, at the cost of a single null check per stage.
+//!
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <facade/platform.hpp>
+#include <facade/utility.hpp>
+
+namespace facade
+{
+   /// @brief The stages of the image pipeline recorded by facade::Stats.
+   ///
+   enum Stage
+   {
+      /// @brief Reading a file from disk.
+      STAGE_READ = 0,
+      /// @brief Splitting a PNG buffer into its chunks, including the CRC checks.
+      STAGE_PARSE,
+      /// @brief Checking the CRCs of parsed chunks. This is a part of facade::STAGE_PARSE.
+      STAGE_CRC,
+      /// @brief Inflating the `IDAT` chunks, or a compressed payload, and splitting image data into scanlines.
+      STAGE_INFLATE,
+      /// @brief Reversing the filters on the image data. For interlaced images, this includes laying out the passes.
+      STAGE_RECONSTRUCT,
+      /// @brief Writing a steganographic payload into the image data.
+      STAGE_EMBED,
+      /// @brief Reading a steganographic payload out of the image data.
+      STAGE_EXTRACT,
+      /// @brief Gathering the statistics of the image data for facade::analyze_lsb.
+      STAGE_ANALYZE,
+      /// @brief Filtering the image data before compression.
+      STAGE_FILTER,
+      /// @brief Deflating the image data, or a payload, into compressed data.
+      STAGE_DEFLATE,
+      /// @brief Serializing the chunks into a file and writing it to disk.
+      STAGE_WRITE,
+      /// @brief The number of stages.
+      STAGE_COUNT
+   };
+
+   /// @brief Get the lowercase name of a stage, as used in reports.
+   ///
+   EXPORT const char *stage_name(Stage stage);
+
+   /// @brief The totals recorded for one stage.
+   ///
+   struct StageStats
+   {
+      /// @brief The number of times the stage ran.
+      std::size_t calls = 0;
+      /// @brief The total wall time spent in the stage, in nanoseconds.
+      std::uint64_t nanoseconds = 0;
+      /// @brief The total number of bytes given to the stage.
+      std::uint64_t bytes_in = 0;
+      /// @brief The total number of bytes produced by the stage.
+      std::uint64_t bytes_out = 0;
+      /// @brief The number of allocations made by the stage, if a facade::TrackingResource is attached.
+      std::size_t allocations = 0;
+      /// @brief The most bytes the stage had allocated at once beyond what was allocated when it began, over every run,
+      ///        if a facade::TrackingResource is attached.
+      std::size_t peak_bytes = 0;
+
+      /// @brief The total wall time spent in the stage, in seconds.
+      double seconds() const { return this->nanoseconds / 1e9; }
+      /// @brief The ratio of bytes in to bytes out.
+      ///
+      /// For facade::STAGE_DEFLATE this is the compression ratio, and for facade::STAGE_INFLATE it's the
+      /// compression ratio of what was inflated, inverted. This is 0 if the stage produced nothing.
+      ///
+      double ratio() const { return (this->bytes_out == 0) ? 0.0 : static_cast<double>(this->bytes_in) / this->bytes_out; }
+   };
+
+   /// @brief A single run of a stage, as kept for the Chrome trace.
+   ///
+   struct TraceEvent
+   {
+      Stage stage;
+      /// @brief When the stage started, in nanoseconds since the facade::Stats object was created.
+      std::uint64_t start;
+      /// @brief How long the stage took, in nanoseconds.
+      std::uint64_t duration;
+      std::uint64_t bytes_in;
+      std::uint64_t bytes_out;
+      /// @brief A small number identifying the thread the stage ran on.
+      std::size_t thread;
+   };
+
+   /// @brief Per-stage timings and counters for the image pipeline.
+   ///
+   /// Attach one to an image with facade::png::Image::enable_stats or facade::png::Image::set_stats. Copies of an image
+   /// share its stats object, so the stages run on a copy, such as the one made by
+   /// facade::PNGPayload::create_stego_payload, are added to the same totals. Recording is thread-safe.
+   ///
+   /// With tracing enabled, every run of a stage is kept as well, and can be written out in the
+   /// [Chrome trace event format](https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU)
+   /// for `chrome://tracing` or [Perfetto](https://ui.perfetto.dev).
+   ///
+   class
+   EXPORT
+   Stats
+   {
+      mutable std::mutex mutex;
+      std::array<StageStats, STAGE_COUNT> stages;
+      std::size_t parsed_chunks = 0;
+      std::size_t written_chunks = 0;
+      std::array<std::size_t, 5> filter_types = { 0, 0, 0, 0, 0 };
+      bool tracing;
+      std::uint64_t epoch;
+      std::vector<TraceEvent> events;
+      std::unordered_map<std::thread::id, std::size_t> threads;
+      TrackingResource *tracker = nullptr;
+
+   public:
+      /// @param trace Whether to keep every run of every stage for facade::Stats::to_chrome_trace.
+      ///
+      Stats(bool trace=false) : tracing(trace), epoch(Stats::now()) {}
+      Stats(const Stats &other) = delete;
+
+      /// @brief The current time of the clock used for stage timings, in nanoseconds.
+      ///
+      static std::uint64_t now() {
+         return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+      }
+
+      /// @brief Add a run of a stage to the totals.
+      /// @param stage The stage which ran.
+      /// @param start When the stage started, from facade::Stats::now.
+      /// @param duration How long the stage took, in nanoseconds.
+      /// @param bytes_in The number of bytes given to the stage.
+      /// @param bytes_out The number of bytes the stage produced.
+      ///
+      void record(Stage stage, std::uint64_t start, std::uint64_t duration, std::uint64_t bytes_in, std::uint64_t bytes_out);
+      /// @brief Add the memory use of a run of a stage to the totals.
+      /// @param stage The stage which ran.
+      /// @param allocations The number of allocations made by the stage.
+      /// @param peak_bytes The most bytes the stage had allocated at once.
+      ///
+      void record_memory(Stage stage, std::size_t allocations, std::size_t peak_bytes);
+      /// @brief Count chunks read out of a file.
+      ///
+      void add_parsed_chunks(std::size_t count);
+      /// @brief Count chunks written to a file.
+      ///
+      void add_written_chunks(std::size_t count);
+      /// @brief Add to the histogram of the filter types chosen for each row.
+      /// @param counts The number of rows filtered with each facade::png::FilterType, indexed by filter type.
+      ///
+      void add_filter_types(const std::array<std::size_t, 5> &counts);
+      /// @brief Record the allocations and peak memory of every stage from now on through the given resource.
+      ///
+      /// The resource only sees what's allocated from it, so it should also be the memory resource of the images
+      /// being measured. Pass a null pointer to stop measuring memory. The resource must outlive its use here.
+      ///
+      void set_memory_tracker(TrackingResource *tracker);
+      /// @brief Get the resource stage memory is measured through, or a null pointer if it isn't measured.
+      ///
+      TrackingResource *memory_tracker() const;
+      /// @brief Clear every total and trace event.
+      ///
+      void reset();
+
+      /// @brief Get the totals of the given stage.
+      ///
+      StageStats stage(Stage stage) const;
+      /// @brief The number of chunks read out of files.
+      ///
+      std::size_t chunks_parsed() const;
+      /// @brief The number of chunks written to files.
+      ///
+      std::size_t chunks_written() const;
+      /// @brief The number of rows filtered with each filter type, indexed by facade::png::FilterType.
+      ///
+      std::array<std::size_t, 5> filter_histogram() const;
+      /// @brief Whether every run of a stage is being kept.
+      ///
+      bool is_tracing() const;
+      /// @brief Get every run of every stage recorded so far, in the order they finished.
+      ///
+      /// This is empty unless tracing is enabled.
+      ///
+      std::vector<TraceEvent> trace_events() const;
+
+      /// @brief Format the totals as a table for people to read.
+      ///
+      std::string to_string() const;
+      /// @brief Format the totals as a JSON object.
+      ///
+      std::string to_json() const;
+      /// @brief Format the trace events as a Chrome trace event JSON document.
+      ///
+      std::string to_chrome_trace() const;
+      /// @brief Write facade::Stats::to_chrome_trace to the given file.
+      /// @throws facade::exception::OpenFileFailure
+      ///
+      void save_chrome_trace(const std::string &filename) const;
+   };
+
+   /// @brief Times a stage from construction to destruction and records it in a facade::Stats object.
+   ///
+   /// With a null stats pointer, this does nothing, not even read the clock. That's what keeps instrumentation free
+   /// for images without stats attached.
+   ///
+   class StageTimer
+   {
+      Stats *stats;
+      Stage stage;
+      TrackingResource *tracker = nullptr;
+      TrackingResource::Mark mark;
+      std::uint64_t start = 0;
+      std::uint64_t bytes_in = 0;
+      std::uint64_t bytes_out = 0;
+
+   public:
+      StageTimer(Stats *stats, Stage stage) : stats(stats), stage(stage) {
+         if (this->stats == nullptr) { return; }
+
+         this->tracker = this->stats->memory_tracker();
+         if (this->tracker != nullptr) { this->mark = this->tracker->begin_stage(); }
+
+         this->start = Stats::now();
+      }
+      StageTimer(const StageTimer &other) = delete;
+      ~StageTimer() { this->stop(); }
+
+      /// @brief Set the bytes in and out of the stage, to be recorded when it stops.
+      ///
+      void set_bytes(std::uint64_t bytes_in, std::uint64_t bytes_out) {
+         this->bytes_in = bytes_in;
+         this->bytes_out = bytes_out;
+      }
+
+      /// @brief Record the stage now rather than on destruction. Further calls do nothing.
+      ///
+      void stop() {
+         if (this->stats == nullptr) { return; }
+
+         this->stats->record(this->stage, this->start, Stats::now() - this->start, this->bytes_in, this->bytes_out);
+
+         if (this->tracker != nullptr)
+         {
+            auto usage = this->tracker->end_stage(this->mark);
+            this->stats->record_memory(this->stage, usage.first, usage.second);
+         }
+
+         this->stats = nullptr;
+      }
+   };
+}
+
+#endif
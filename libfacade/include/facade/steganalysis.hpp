@@ -0,0 +1,99 @@
+#ifndef __FACADE_STEGANALYSIS_HPP
+#define __FACADE_STEGANALYSIS_HPP
+
+//! @file steganalysis.hpp
+//! @brief Statistical detection of least-significant-bit steganography.
+//!
+//! facade::analyze_lsb looks for payloads hidden in the lowest bits of an image's samples without knowing how they
+//! were framed, using three of the classic detectors: the chi-square attack on pairs of values, RS analysis and
+//! sample pair analysis. It reads the scanlines of an already loaded image, so it costs a pass over the pixels
+//! rather than a second decode, and the rows are split across the image's executor.
+//!
+//! The detectors only look at the lowest bit of a sample, so each of the lowest facade::LSB_PLANES bit planes is
+//! analyzed as the lowest bit of the samples shifted down to it. This catches tools which replace more than one bit,
+//! such as facade's own stego payloads, which replace the lowest four bits of each color sample.
+//!
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <facade/platform.hpp>
+#include <facade/png.hpp>
+
+namespace facade
+{
+   /// @brief The number of bit planes, starting from the lowest, analyzed by facade::analyze_lsb.
+   ///
+   constexpr std::size_t LSB_PLANES = 4;
+
+   /// @brief The estimates made by each detector in facade::analyze_lsb for a single bit plane.
+   ///
+   struct LSBEstimate
+   {
+      /// @brief The probability that the lowest bits were overwritten, from a chi-square test of how evenly each pair
+      ///        of values differing only in their lowest bit is populated.
+      double chi_square = 0.0;
+      /// @brief The fraction of samples estimated to carry a payload, from RS analysis.
+      double rs = 0.0;
+      /// @brief The fraction of samples estimated to carry a payload, from sample pair analysis.
+      double sample_pairs = 0.0;
+
+      /// @brief The chi-square probability or the mean of the two length estimates, whichever is larger, each clamped
+      ///        to the range 0 to 1.
+      ///
+      /// Clean images tend to score close to 0 and images with their lowest bits replaced outright close to 1. This is
+      /// only meant for ranking images against each other, not as a probability in its own right.
+      ///
+      double score() const;
+   };
+
+   /// @brief The statistics of a single color channel gathered by facade::analyze_lsb.
+   ///
+   struct ChannelAnalysis
+   {
+      /// @brief The number of samples in the channel.
+      std::uint64_t samples = 0;
+      /// @brief How many times each sample value occurs.
+      std::array<std::uint64_t, 256> histogram = {};
+      /// @brief How many samples have each bit set, from the lowest bit to the highest.
+      std::array<std::uint64_t, 8> ones = {};
+      /// @brief The estimates for this channel alone, from the lowest bit plane up.
+      std::array<LSBEstimate, LSB_PLANES> planes;
+   };
+
+   /// @brief The result of facade::analyze_lsb.
+   ///
+   struct LSBAnalysis
+   {
+      /// @brief The color channels of the image in order, such as red, green and blue. Alpha isn't analyzed.
+      std::vector<ChannelAnalysis> channels;
+      /// @brief The estimates for the whole image from the lowest bit plane up, from the statistics of every channel
+      ///        together.
+      std::array<LSBEstimate, LSB_PLANES> planes;
+
+      /// @brief The suspicion score of the whole image, which is the highest score of its bit planes.
+      /// @sa facade::LSBEstimate::score
+      ///
+      double score() const;
+   };
+
+   /// @brief Run statistical LSB steganalysis over the loaded image data.
+   ///
+   /// Horizontally adjacent samples of each channel are compared for sample pair analysis, and RS analysis splits
+   /// rows into groups of four samples, flipping the middle two. Each statistic is gathered for each of the lowest
+   /// facade::LSB_PLANES bit planes. This requires 8-bit grayscale or true color
+   /// image data, with or without alpha, which has been loaded and reconstructed. The time taken is recorded as
+   /// facade::STAGE_ANALYZE if the image has stats attached.
+   ///
+   /// @param image The image to analyze.
+   /// @return The statistics and estimates of each channel and of the whole image.
+   /// @throws facade::exception::NoImageData
+   /// @throws facade::exception::UnsupportedPixelType
+   /// @throws facade::exception::AlreadyFiltered
+   ///
+   EXPORT LSBAnalysis analyze_lsb(const png::Image &image);
+}
+
+#endif
@@ -9,10 +9,16 @@
 //!
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstddef>
+#include <cstdlib>
 #include <cstdint>
 #include <cctype>
+#include <memory_resource>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <vector>
 
 #include <zlib.h>
@@ -96,12 +102,19 @@ namespace facade
 
    /// @brief Swap the endianness of a 16-bit value.
    ///
-   /// This converts big endian to little endian, or little endian to big endian.
+   /// This converts big endian to little endian, or little endian to big endian. It's defined inline on top of the
+   /// compiler's byte-swap intrinsic so that per-sample accessors compile down to a single instruction.
    ///
    /// @param value The value whose endianness needs to be swapped.
    /// @return The 16-bit endian-swapped value.
    ///
-   EXPORT std::uint16_t endian_swap_16(std::uint16_t value);
+   inline std::uint16_t endian_swap_16(std::uint16_t value) {
+#if defined(LIBFACADE_WIN32)
+      return _byteswap_ushort(value);
+#else
+      return __builtin_bswap16(value);
+#endif
+   }
 
    /// @brief Swap the endianness of a 32-bit value.
    ///
@@ -110,7 +123,23 @@ namespace facade
    /// @param value The value whose endianness needs to be swapped.
    /// @return The 32-bit endian-swapped value.
    ///
-   EXPORT std::uint32_t endian_swap_32(std::uint32_t value);
+   inline std::uint32_t endian_swap_32(std::uint32_t value) {
+#if defined(LIBFACADE_WIN32)
+      return _byteswap_ulong(value);
+#else
+      return __builtin_bswap32(value);
+#endif
+   }
+
+   /// @brief Swap the endianness of every 16-bit value in a buffer, in place.
+   ///
+   /// This is the bulk form of facade::endian_swap_16, with SSSE3 and AVX2 paths selected at runtime. It's what turns
+   /// whole rows of 16-bit samples between PNG's big-endian order and the native order of the machine.
+   ///
+   /// @param ptr The buffer of 16-bit values. This need not be aligned.
+   /// @param count The number of 16-bit values in the buffer.
+   ///
+   EXPORT void endian_swap_16(void *ptr, std::size_t count);
 
    /// @brief Calculate the CRC32 value of a given buffer.
    ///
@@ -141,6 +170,20 @@ namespace facade
    /// @sa The root compression function: compress(const void *, std::size_t, int)
    ///
    EXPORT std::vector<std::uint8_t> compress(const std::vector<std::uint8_t> &vec, int level);
+   /// @brief Compress the given data buffer into a vector allocated from the given memory resource.
+   ///
+   /// *zlib*'s own compression state is allocated from the resource as well, so a monotonic arena can absorb the whole
+   /// operation.
+   ///
+   /// @param ptr The given data pointer to compress.
+   /// @param size The size, in bytes, of the given data pointer.
+   /// @param level The compression level to pass to *deflate*.
+   /// @param resource The memory resource to allocate from.
+   /// @return The compressed buffer.
+   /// @throws facade::exception::ZLibError
+   /// @sa The root compression function: compress(const void *, std::size_t, int)
+   ///
+   EXPORT std::pmr::vector<std::uint8_t> compress(const void *ptr, std::size_t size, int level, std::pmr::memory_resource *resource);
    /// @brief Decompress the given data buffer with [zlib](https://zlib.net)'s inflate algorithm.
    /// @param ptr The compressed data pointer to decompress.
    /// @param size The size, in bytes, of the data pointer.
@@ -155,13 +198,42 @@ namespace facade
    /// @sa The root decompress function: decompress(const void *, std::size_t)
    ///
    EXPORT std::vector<std::uint8_t> decompress(const std::vector<std::uint8_t> &vec);
+   /// @brief Decompress the given data buffer into a vector allocated from the given memory resource.
+   ///
+   /// *zlib*'s own decompression state is allocated from the resource as well.
+   ///
+   /// @param ptr The compressed data pointer to decompress.
+   /// @param size The size, in bytes, of the data pointer.
+   /// @param resource The memory resource to allocate from.
+   /// @param size_hint The expected size of the decompressed data, if known. Reserving it up front keeps the output
+   ///                  from being reallocated as it grows, which matters for arenas that never reuse freed memory.
+   /// @return The decompressed buffer.
+   /// @throws facade::exception::ZLibError
+   /// @sa The root decompress function: decompress(const void *, std::size_t)
+   ///
+   EXPORT std::pmr::vector<std::uint8_t> decompress(const void *ptr, std::size_t size, std::pmr::memory_resource *resource, std::size_t size_hint=0);
+
+   /// @brief Determine if the running processor supports the SSSE3 instruction set.
+   ///
+   /// The answer is computed once and cached. On non-x86 targets this is always false.
+   ///
+   EXPORT bool cpu_has_ssse3();
+   /// @brief Determine if the running processor supports the AVX2 instruction set.
+   ///
+   /// The answer is computed once and cached. On non-x86 targets this is always false.
+   ///
+   EXPORT bool cpu_has_avx2();
 
    /// @brief Determine if the string is a base64 string.
    /// @param base64 The string of (alleged) base64 data.
    /// @return Whether or not this string is base64 data.
    ///
-   EXPORT bool is_base64_string(const std::string &base64);
+   EXPORT bool is_base64_string(std::string_view base64);
    /// @brief Base64 encode the given buffer data.
+   ///
+   /// The output is written into a pre-sized string, using AVX2 or SSSE3 for the bulk of the input when the
+   /// processor supports it.
+   ///
    /// @param ptr The data buffer to encode.
    /// @param size The size, in bytes, of the given pointer.
    /// @return A base64-encoded string.
@@ -172,12 +244,41 @@ namespace facade
    /// @return A base64-encoded string.
    ///
    EXPORT std::string base64_encode(const std::vector<std::uint8_t> &data);
+   /// @brief Base64 encode the given buffer data into a string allocated from the given memory resource.
+   /// @param ptr The data buffer to encode.
+   /// @param size The size, in bytes, of the given pointer.
+   /// @param resource The memory resource to allocate from.
+   /// @return A base64-encoded string.
+   /// @sa The root encode function: base64_encode(const void *, std::size_t)
+   ///
+   EXPORT std::pmr::string base64_encode(const void *ptr, std::size_t size, std::pmr::memory_resource *resource);
+   /// @brief Base64-decode the given character buffer into a byte vector.
+   ///
+   /// Validation and conversion happen in the same pass, so there is no need to call facade::is_base64_string
+   /// beforehand. Trailing `=` padding is optional, but once padding begins only padding may follow it.
+   ///
+   /// @param ptr The base64-encoded character buffer.
+   /// @param size The size, in bytes, of the character buffer.
+   /// @return The decoded byte buffer.
+   /// @throws facade::exception::InvalidBase64Character with the offset of the first invalid character.
+   ///
+   EXPORT std::vector<std::uint8_t> base64_decode(const void *ptr, std::size_t size);
    /// @brief Base64-decode the given string into a byte vector.
    /// @param data The base64-encoded string.
    /// @return The decoded byte buffer.
    /// @throws facade::exception::InvalidBase64Character
+   /// @sa The root decode function: base64_decode(const void *, std::size_t)
    ///
    EXPORT std::vector<std::uint8_t> base64_decode(const std::string &data);
+   /// @brief Base64-decode the given character buffer into a vector allocated from the given memory resource.
+   /// @param ptr The base64-encoded character buffer.
+   /// @param size The size, in bytes, of the character buffer.
+   /// @param resource The memory resource to allocate from.
+   /// @return The decoded byte buffer.
+   /// @throws facade::exception::InvalidBase64Character
+   /// @sa The root decode function: base64_decode(const void *, std::size_t)
+   ///
+   EXPORT std::pmr::vector<std::uint8_t> base64_decode(const void *ptr, std::size_t size, std::pmr::memory_resource *resource);
 
    /// @brief Read a file into a byte vector.
    /// @param filename The given filename to read.
@@ -198,6 +299,136 @@ namespace facade
    /// @throws facade::exception::OpenFileFailure
    ///
    EXPORT void write_file(const std::string &filename, const std::vector<std::uint8_t> &vec);
+
+   /// @brief A memory resource which backs large allocations with huge pages where the platform supports them.
+   ///
+   /// Allocations of at least facade::HugePageResource::threshold bytes are mapped directly and, on Linux, advised
+   /// to use transparent huge pages, which cuts TLB misses when walking large pixel buffers. Smaller allocations,
+   /// and every allocation on platforms without huge page support, are passed to the upstream resource.
+   ///
+   /// This pairs well with `std::pmr::monotonic_buffer_resource`: give the arena a facade::HugePageResource as its
+   /// upstream and its large blocks land on huge pages.
+   ///
+   class
+   EXPORT
+   HugePageResource : public std::pmr::memory_resource
+   {
+   public:
+      /// @brief The default size at which allocations are moved onto huge pages, matching the usual x86-64 huge page size.
+      static const std::size_t DefaultThreshold = 2 * 1024 * 1024;
+
+   private:
+      std::size_t _threshold;
+      std::pmr::memory_resource *_upstream;
+
+   public:
+      HugePageResource(std::size_t threshold=DefaultThreshold, std::pmr::memory_resource *upstream=std::pmr::get_default_resource())
+         : _threshold(threshold), _upstream(upstream) {}
+
+      /// @brief The size, in bytes, at which allocations are moved onto huge pages.
+      ///
+      std::size_t threshold() const;
+      /// @brief The resource which receives allocations below the threshold.
+      ///
+      std::pmr::memory_resource *upstream() const;
+
+   protected:
+      void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+      void do_deallocate(void *ptr, std::size_t bytes, std::size_t alignment) override;
+      bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+   private:
+      bool use_huge_pages(std::size_t bytes, std::size_t alignment) const;
+   };
+
+   /// @brief A memory resource which counts the allocations passed through it and tracks their high-water mark.
+   ///
+   /// Give one to an image as its memory resource to see how much its scanlines, compression buffers and *zlib* state
+   /// take at their peak. Attached to a facade::Stats object with facade::Stats::set_memory_tracker, it also records
+   /// the allocations and peak of every pipeline stage. With a limit set, allocations that would take the live total
+   /// past it throw instead, which enforces a memory budget per job.
+   ///
+   /// Counting is thread-safe. Allocations made outside the resource, such as the chunk data of an image, aren't seen.
+   ///
+   class
+   EXPORT
+   TrackingResource : public std::pmr::memory_resource
+   {
+   public:
+      /// @brief The most stages which can be measured at once. Stages past this still count their allocations, but
+      ///        report no peak.
+      static constexpr std::size_t MaxOpenStages = 64;
+
+      /// @brief The state of the counters when a stage began, as returned by facade::TrackingResource::begin_stage.
+      struct Mark
+      {
+         std::size_t start_bytes;
+         std::size_t start_allocations;
+         /// @brief The high-water mark slot of the stage, or facade::TrackingResource::MaxOpenStages if none was free.
+         std::size_t slot;
+      };
+
+   private:
+      std::pmr::memory_resource *_upstream;
+      std::size_t _limit;
+      std::atomic<std::size_t> _allocations;
+      std::atomic<std::size_t> _live_bytes;
+      std::atomic<std::size_t> _peak_bytes;
+      /// @brief A bit for each slot of facade::TrackingResource::_stage_peaks held by a stage that's running.
+      std::atomic<std::uint64_t> _open_stages;
+      /// @brief The high-water mark of each running stage, so stages on different threads don't share one.
+      std::array<std::atomic<std::size_t>, MaxOpenStages> _stage_peaks;
+
+   public:
+      /// @param limit The most bytes which may be allocated at once, or 0 for no limit.
+      /// @param upstream The resource which actually makes the allocations.
+      ///
+      TrackingResource(std::size_t limit=0, std::pmr::memory_resource *upstream=std::pmr::get_default_resource())
+         : _upstream(upstream), _limit(limit), _allocations(0), _live_bytes(0), _peak_bytes(0), _open_stages(0) {}
+      TrackingResource(const TrackingResource &other) = delete;
+
+      /// @brief The resource which actually makes the allocations.
+      ///
+      std::pmr::memory_resource *upstream() const;
+      /// @brief The most bytes which may be allocated at once, or 0 for no limit.
+      ///
+      std::size_t limit() const;
+      /// @brief Set the most bytes which may be allocated at once, or 0 for no limit.
+      ///
+      void set_limit(std::size_t limit);
+      /// @brief The number of allocations made so far.
+      ///
+      std::size_t allocations() const;
+      /// @brief The number of bytes currently allocated.
+      ///
+      std::size_t live_bytes() const;
+      /// @brief The most bytes allocated at once so far.
+      ///
+      std::size_t peak_bytes() const;
+      /// @brief Reset the peak to the number of bytes currently allocated.
+      ///
+      void reset_peak();
+
+      /// @brief Start measuring a stage, making the peak relative to what's allocated now.
+      ///
+      /// Each stage keeps its own high-water mark, so stages may nest or run at the same time on different threads,
+      /// and facade::TrackingResource::peak_bytes isn't disturbed. The live total is shared, though, so the peak of a
+      /// stage includes whatever stages running alongside it allocated in the meantime.
+      ///
+      Mark begin_stage();
+      /// @brief Finish measuring a stage.
+      /// @return The number of allocations made during the stage, and the most bytes allocated at once during the
+      ///         stage beyond what was allocated when it began.
+      ///
+      std::pair<std::size_t, std::size_t> end_stage(const Mark &mark);
+
+   protected:
+      /// @throws facade::exception::MemoryLimitExceeded
+      ///
+      void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+      void do_deallocate(void *ptr, std::size_t bytes, std::size_t alignment) override;
+      bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+   };
 }
 
 #endif
@@ -0,0 +1,580 @@
+#include <facade.hpp>
+
+#if defined(LIBFACADE_X86)
+#if defined(LIBFACADE_WIN32)
+#include <intrin.h>
+#endif
+#include <immintrin.h>
+#endif
+
+using namespace facade;
+using namespace facade::png;
+
+/* the shape of each pixel type, indexed by facade::png::PixelEnum. */
+struct PixelLayout
+{
+   std::uint8_t bits;
+   std::uint8_t channels;
+   bool palette;
+   bool alpha;
+   bool color;
+};
+
+static const PixelLayout LAYOUTS[] = {
+   { 1, 1, false, false, false },
+   { 2, 1, false, false, false },
+   { 4, 1, false, false, false },
+   { 8, 1, false, false, false },
+   { 16, 1, false, false, false },
+   { 8, 3, false, false, true },
+   { 16, 3, false, false, true },
+   { 1, 1, true, false, true },
+   { 2, 1, true, false, true },
+   { 4, 1, true, false, true },
+   { 8, 1, true, false, true },
+   { 8, 2, false, true, false },
+   { 16, 2, false, true, false },
+   { 8, 4, false, true, true },
+   { 16, 4, false, true, true },
+};
+
+static const PixelLayout &pixel_layout(PixelEnum pixel_type) {
+   if (static_cast<std::size_t>(pixel_type) >= sizeof(LAYOUTS) / sizeof(LAYOUTS[0]))
+      throw exception::UnsupportedPixelType(pixel_type);
+
+   return LAYOUTS[pixel_type];
+}
+
+std::size_t ColorTable::palette_size() const {
+   return this->entries.size();
+}
+
+std::array<std::uint8_t, 4> ColorTable::color(std::size_t index) const {
+   if (index >= this->entries.size()) { throw exception::OutOfBounds(index, this->entries.size()); }
+
+   std::array<std::uint8_t, 4> result;
+   std::memcpy(result.data(), &this->entries[index], result.size());
+
+   return result;
+}
+
+std::optional<std::size_t> ColorTable::find_color(const std::uint8_t *rgba) const {
+   std::uint32_t key;
+   std::memcpy(&key, rgba, sizeof(key));
+
+   auto entry = this->index.find(key);
+   if (entry == this->index.end()) { return std::nullopt; }
+
+   return entry->second;
+}
+
+std::size_t ColorTable::add_color(const std::uint8_t *rgba) {
+   std::uint32_t key;
+   std::memcpy(&key, rgba, sizeof(key));
+
+   /* a palette can repeat a color, in which case lookups find the first index it appears at */
+   this->index.insert(std::make_pair(key, this->entries.size()));
+   this->entries.push_back(key);
+
+   return this->entries.size()-1;
+}
+
+bool ColorTable::has_transparency() const {
+   if (this->color_key.has_value()) { return true; }
+
+   for (auto entry : this->entries)
+      if (reinterpret_cast<const std::uint8_t *>(&entry)[3] != 0xFF) { return true; }
+
+   return false;
+}
+
+std::size_t facade::png::row_size(PixelEnum pixel_type, std::size_t width) {
+   auto &shape = pixel_layout(pixel_type);
+
+   return (width * shape.bits * shape.channels + 7) / 8;
+}
+
+/* the itu-r bt.601 weights, scaled to sum to 256 and 65536 so that gray colors come back unchanged. */
+static std::uint8_t luma_8(std::uint32_t red, std::uint32_t green, std::uint32_t blue) {
+   return static_cast<std::uint8_t>((red * 77 + green * 150 + blue * 29 + 128) >> 8);
+}
+
+static std::uint16_t luma_16(std::uint32_t red, std::uint32_t green, std::uint32_t blue) {
+   return static_cast<std::uint16_t>((red * 19595 + green * 38470 + blue * 7471 + 32768) >> 16);
+}
+
+static std::uint16_t read_16(const std::uint8_t *ptr) {
+   return static_cast<std::uint16_t>((ptr[0] << 8) | ptr[1]);
+}
+
+static void write_16(std::uint8_t *ptr, std::uint16_t value) {
+   ptr[0] = static_cast<std::uint8_t>(value >> 8);
+   ptr[1] = static_cast<std::uint8_t>(value & 0xFF);
+}
+
+#if defined(LIBFACADE_X86)
+/* each of these returns the number of pixels or samples it converted, leaving the rest of the row to the scalar loop.
+   loads and stores of rgb rows cover 16 bytes to use 12, so they stop while a whole vector still fits in the row. */
+LIBFACADE_TARGET("ssse3")
+static std::size_t rgb8_to_rgba8_ssse3(const std::uint8_t *src, std::size_t width, std::uint8_t *dst) {
+   const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+   const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+   std::size_t i = 0;
+
+   for (; i+6 <= width; i += 4)
+   {
+      auto block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 3));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4), _mm_or_si128(_mm_shuffle_epi8(block, shuffle), alpha));
+   }
+
+   return i;
+}
+
+LIBFACADE_TARGET("ssse3")
+static std::size_t rgba8_to_rgb8_ssse3(const std::uint8_t *src, std::size_t width, std::uint8_t *dst) {
+   const __m128i shuffle = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+   std::size_t i = 0;
+
+   for (; i+6 <= width; i += 4)
+   {
+      auto block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 3), _mm_shuffle_epi8(block, shuffle));
+   }
+
+   return i;
+}
+
+LIBFACADE_TARGET("ssse3")
+static std::size_t strip_16_ssse3(const std::uint8_t *src, std::size_t samples, std::uint8_t *dst) {
+   const __m128i high_bytes = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, -1, -1, -1, -1, -1, -1, -1, -1);
+   std::size_t i = 0;
+
+   for (; i+16 <= samples; i += 16)
+   {
+      auto low = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 2)), high_bytes);
+      auto high = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 2 + 16)), high_bytes);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_unpacklo_epi64(low, high));
+   }
+
+   return i;
+}
+#endif
+
+static void rgb8_to_rgba8(const std::uint8_t *src, std::size_t width, std::uint8_t *dst) {
+   std::size_t i = 0;
+
+#if defined(LIBFACADE_X86)
+   if (facade::cpu_has_ssse3())
+      i = rgb8_to_rgba8_ssse3(src, width, dst);
+#endif
+
+   for (; i<width; ++i)
+   {
+      std::memcpy(&dst[i*4], &src[i*3], 3);
+      dst[i*4+3] = 0xFF;
+   }
+}
+
+static void rgba8_to_rgb8(const std::uint8_t *src, std::size_t width, std::uint8_t *dst) {
+   std::size_t i = 0;
+
+#if defined(LIBFACADE_X86)
+   if (facade::cpu_has_ssse3())
+      i = rgba8_to_rgb8_ssse3(src, width, dst);
+#endif
+
+   for (; i<width; ++i)
+      std::memcpy(&dst[i*3], &src[i*4], 3);
+}
+
+/* reduce big-endian 16-bit samples to their high byte. */
+static void strip_16(const std::uint8_t *src, std::size_t samples, std::uint8_t *dst) {
+   std::size_t i = 0;
+
+#if defined(LIBFACADE_X86)
+   if (facade::cpu_has_ssse3())
+      i = strip_16_ssse3(src, samples, dst);
+#endif
+
+   for (; i<samples; ++i)
+      dst[i] = src[i*2];
+}
+
+/* widen 8-bit samples to 16 bits, so that 0xFF becomes 0xFFFF. */
+static void widen_8(const std::uint8_t *src, std::size_t samples, std::uint8_t *dst) {
+   for (std::size_t i=0; i<samples; ++i)
+   {
+      dst[i*2] = src[i];
+      dst[i*2+1] = src[i];
+   }
+}
+
+/* expand a row to 8-bit rgba. sub-byte and palette samples are unpacked into the last quarter of the output first.
+   pixel i is read from byte 3w+i and written to bytes 4i through 4i+3, so no sample is overwritten before it's read. */
+static void decode_rgba8(PixelEnum from, const std::uint8_t *src, std::size_t width, const ColorTable &colors, std::uint8_t *out) {
+   auto &shape = pixel_layout(from);
+   auto &key = colors.color_key;
+
+   if (shape.palette)
+   {
+      std::uint8_t lut[256][4];
+
+      for (std::size_t i=0; i<256; ++i)
+      {
+         if (i < colors.palette_size())
+            std::memcpy(lut[i], colors.color(i).data(), 4);
+         else
+         {
+            /* indexes past the end of the palette are invalid, so just make them opaque black */
+            lut[i][0] = lut[i][1] = lut[i][2] = 0;
+            lut[i][3] = 0xFF;
+         }
+      }
+
+      auto samples = &out[width*3];
+      unpack_samples(src, width, shape.bits, samples);
+
+      for (std::size_t i=0; i<width; ++i)
+         std::memcpy(&out[i*4], lut[samples[i]], 4);
+
+      return;
+   }
+
+   switch (from)
+   {
+   case PixelEnum::GRAYSCALE_PIXEL_1BIT:
+   case PixelEnum::GRAYSCALE_PIXEL_2BIT:
+   case PixelEnum::GRAYSCALE_PIXEL_4BIT:
+   case PixelEnum::GRAYSCALE_PIXEL_8BIT:
+   {
+      auto scale = 255 / ((1 << shape.bits) - 1);
+      auto samples = &out[width*3];
+      unpack_samples(src, width, shape.bits, samples);
+
+      for (std::size_t i=0; i<width; ++i)
+      {
+         auto value = samples[i];
+         auto gray = static_cast<std::uint8_t>(value * scale);
+
+         out[i*4] = out[i*4+1] = out[i*4+2] = gray;
+         out[i*4+3] = (key.has_value() && value == (*key)[0]) ? 0 : 0xFF;
+      }
+
+      break;
+   }
+   case PixelEnum::GRAYSCALE_PIXEL_16BIT:
+   {
+      for (std::size_t i=0; i<width; ++i)
+      {
+         out[i*4] = out[i*4+1] = out[i*4+2] = src[i*2];
+         out[i*4+3] = (key.has_value() && read_16(&src[i*2]) == (*key)[0]) ? 0 : 0xFF;
+      }
+
+      break;
+   }
+   case PixelEnum::TRUE_COLOR_PIXEL_8BIT:
+   {
+      if (!key.has_value())
+      {
+         rgb8_to_rgba8(src, width, out);
+         break;
+      }
+
+      for (std::size_t i=0; i<width; ++i)
+      {
+         auto pixel = &src[i*3];
+
+         std::memcpy(&out[i*4], pixel, 3);
+         out[i*4+3] = (pixel[0] == (*key)[0] && pixel[1] == (*key)[1] && pixel[2] == (*key)[2]) ? 0 : 0xFF;
+      }
+
+      break;
+   }
+   case PixelEnum::TRUE_COLOR_PIXEL_16BIT:
+   {
+      for (std::size_t i=0; i<width; ++i)
+      {
+         auto pixel = &src[i*6];
+         bool transparent = key.has_value()
+            && read_16(&pixel[0]) == (*key)[0] && read_16(&pixel[2]) == (*key)[1] && read_16(&pixel[4]) == (*key)[2];
+
+         out[i*4] = pixel[0];
+         out[i*4+1] = pixel[2];
+         out[i*4+2] = pixel[4];
+         out[i*4+3] = transparent ? 0 : 0xFF;
+      }
+
+      break;
+   }
+   case PixelEnum::ALPHA_GRAYSCALE_PIXEL_8BIT:
+   {
+      for (std::size_t i=0; i<width; ++i)
+      {
+         out[i*4] = out[i*4+1] = out[i*4+2] = src[i*2];
+         out[i*4+3] = src[i*2+1];
+      }
+
+      break;
+   }
+   case PixelEnum::ALPHA_GRAYSCALE_PIXEL_16BIT:
+   {
+      for (std::size_t i=0; i<width; ++i)
+      {
+         out[i*4] = out[i*4+1] = out[i*4+2] = src[i*4];
+         out[i*4+3] = src[i*4+2];
+      }
+
+      break;
+   }
+   case PixelEnum::ALPHA_TRUE_COLOR_PIXEL_8BIT:
+      std::memcpy(out, src, width*4);
+      break;
+
+   case PixelEnum::ALPHA_TRUE_COLOR_PIXEL_16BIT:
+      strip_16(src, width*4, out);
+      break;
+
+   default:
+      throw exception::UnsupportedPixelType(from);
+   }
+}
+
+/* expand a row of a 16-bit type to 16-bit rgba, in native byte order. */
+static void decode_rgba16(PixelEnum from, const std::uint8_t *src, std::size_t width, const ColorTable &colors, std::uint16_t *out) {
+   auto &key = colors.color_key;
+
+   switch (from)
+   {
+   case PixelEnum::GRAYSCALE_PIXEL_16BIT:
+   {
+      for (std::size_t i=0; i<width; ++i)
+      {
+         auto gray = read_16(&src[i*2]);
+
+         out[i*4] = out[i*4+1] = out[i*4+2] = gray;
+         out[i*4+3] = (key.has_value() && gray == (*key)[0]) ? 0 : 0xFFFF;
+      }
+
+      break;
+   }
+   case PixelEnum::TRUE_COLOR_PIXEL_16BIT:
+   {
+      for (std::size_t i=0; i<width; ++i)
+      {
+         out[i*4] = read_16(&src[i*6]);
+         out[i*4+1] = read_16(&src[i*6+2]);
+         out[i*4+2] = read_16(&src[i*6+4]);
+
+         bool transparent = key.has_value() && out[i*4] == (*key)[0] && out[i*4+1] == (*key)[1] && out[i*4+2] == (*key)[2];
+         out[i*4+3] = transparent ? 0 : 0xFFFF;
+      }
+
+      break;
+   }
+   case PixelEnum::ALPHA_GRAYSCALE_PIXEL_16BIT:
+   {
+      for (std::size_t i=0; i<width; ++i)
+      {
+         out[i*4] = out[i*4+1] = out[i*4+2] = read_16(&src[i*4]);
+         out[i*4+3] = read_16(&src[i*4+2]);
+      }
+
+      break;
+   }
+   case PixelEnum::ALPHA_TRUE_COLOR_PIXEL_16BIT:
+   {
+      for (std::size_t i=0; i<width*4; ++i)
+         out[i] = read_16(&src[i*2]);
+
+      break;
+   }
+   default:
+      throw exception::UnsupportedPixelType(from);
+   }
+}
+
+/* write an 8-bit rgba row out as a pixel type of 8 bits or less. gray and palette rows reuse the front of the rgba
+   row for their unpacked samples, which is safe since sample i is written after pixel i, at byte 4i, has been read. */
+static void encode_rgba8(PixelEnum to, std::uint8_t *rgba, std::size_t width, const ColorTable &colors, std::uint8_t *dst) {
+   auto &shape = pixel_layout(to);
+
+   if (shape.palette)
+   {
+      std::size_t limit = 1 << shape.bits;
+      std::uint32_t last_color = 0;
+      std::size_t last_index = limit;
+
+      for (std::size_t i=0; i<width; ++i)
+      {
+         std::uint32_t color;
+         std::memcpy(&color, &rgba[i*4], sizeof(color));
+
+         /* runs of one color are common enough to be worth skipping the lookup */
+         if (last_index == limit || color != last_color)
+         {
+            auto index = colors.find_color(&rgba[i*4]);
+            if (!index.has_value() || *index >= limit) { throw exception::TooManyColors(limit); }
+
+            last_color = color;
+            last_index = *index;
+         }
+
+         rgba[i] = static_cast<std::uint8_t>(last_index);
+      }
+
+      dst[row_size(to, width)-1] = 0;
+      pack_samples(rgba, width, shape.bits, dst);
+
+      return;
+   }
+
+   switch (to)
+   {
+   case PixelEnum::GRAYSCALE_PIXEL_1BIT:
+   case PixelEnum::GRAYSCALE_PIXEL_2BIT:
+   case PixelEnum::GRAYSCALE_PIXEL_4BIT:
+   case PixelEnum::GRAYSCALE_PIXEL_8BIT:
+   {
+      std::uint32_t max = (1 << shape.bits) - 1;
+
+      for (std::size_t i=0; i<width; ++i)
+      {
+         auto gray = luma_8(rgba[i*4], rgba[i*4+1], rgba[i*4+2]);
+         rgba[i] = static_cast<std::uint8_t>((gray * max + 127) / 255);
+      }
+
+      dst[row_size(to, width)-1] = 0;
+      pack_samples(rgba, width, shape.bits, dst);
+
+      break;
+   }
+   case PixelEnum::TRUE_COLOR_PIXEL_8BIT:
+      rgba8_to_rgb8(rgba, width, dst);
+      break;
+
+   case PixelEnum::ALPHA_GRAYSCALE_PIXEL_8BIT:
+   {
+      for (std::size_t i=0; i<width; ++i)
+      {
+         dst[i*2] = luma_8(rgba[i*4], rgba[i*4+1], rgba[i*4+2]);
+         dst[i*2+1] = rgba[i*4+3];
+      }
+
+      break;
+   }
+   case PixelEnum::ALPHA_TRUE_COLOR_PIXEL_8BIT:
+      std::memcpy(dst, rgba, width*4);
+      break;
+
+   default:
+      throw exception::UnsupportedPixelType(to);
+   }
+}
+
+/* write a native 16-bit rgba row out as a 16-bit pixel type. */
+static void encode_rgba16(PixelEnum to, const std::uint16_t *rgba, std::size_t width, std::uint8_t *dst) {
+   switch (to)
+   {
+   case PixelEnum::GRAYSCALE_PIXEL_16BIT:
+   {
+      for (std::size_t i=0; i<width; ++i)
+         write_16(&dst[i*2], luma_16(rgba[i*4], rgba[i*4+1], rgba[i*4+2]));
+
+      break;
+   }
+   case PixelEnum::TRUE_COLOR_PIXEL_16BIT:
+   {
+      for (std::size_t i=0; i<width; ++i)
+         for (std::size_t c=0; c<3; ++c)
+            write_16(&dst[i*6+c*2], rgba[i*4+c]);
+
+      break;
+   }
+   case PixelEnum::ALPHA_GRAYSCALE_PIXEL_16BIT:
+   {
+      for (std::size_t i=0; i<width; ++i)
+      {
+         write_16(&dst[i*4], luma_16(rgba[i*4], rgba[i*4+1], rgba[i*4+2]));
+         write_16(&dst[i*4+2], rgba[i*4+3]);
+      }
+
+      break;
+   }
+   case PixelEnum::ALPHA_TRUE_COLOR_PIXEL_16BIT:
+   {
+      for (std::size_t i=0; i<width*4; ++i)
+         write_16(&dst[i*2], rgba[i]);
+
+      break;
+   }
+   default:
+      throw exception::UnsupportedPixelType(to);
+   }
+}
+
+void facade::png::convert_row(PixelEnum from, const std::uint8_t *src, PixelEnum to, std::uint8_t *dst, std::size_t width,
+                              const ColorTable &colors)
+{
+   auto &source = pixel_layout(from);
+   auto &target = pixel_layout(to);
+
+   if (width == 0) { return; }
+
+   if (from == to)
+   {
+      std::memcpy(dst, src, row_size(from, width));
+      return;
+   }
+
+   /* a 16-bit type and its 8-bit form differ only in the size of their samples */
+   if (!source.palette && !target.palette && source.channels == target.channels)
+   {
+      if (source.bits == 16 && target.bits == 8)
+      {
+         strip_16(src, width * source.channels, dst);
+         return;
+      }
+      else if (source.bits == 8 && target.bits == 16)
+      {
+         widen_8(src, width * source.channels, dst);
+         return;
+      }
+   }
+
+   if (from == PixelEnum::ALPHA_TRUE_COLOR_PIXEL_8BIT && to == PixelEnum::TRUE_COLOR_PIXEL_8BIT)
+   {
+      rgba8_to_rgb8(src, width, dst);
+      return;
+   }
+
+   /* going up to 16 bits adds no precision, so convert to the 8-bit form of the target and widen that */
+   if (target.bits == 16 && source.bits < 16)
+   {
+      auto narrow = static_cast<PixelEnum>(to - 1);
+      std::vector<std::uint8_t> row(row_size(narrow, width));
+
+      convert_row(from, src, narrow, row.data(), width, colors);
+      widen_8(row.data(), width * target.channels, dst);
+
+      return;
+   }
+
+   if (target.bits == 16)
+   {
+      std::vector<std::uint16_t> rgba(width*4);
+      decode_rgba16(from, src, width, colors, rgba.data());
+      encode_rgba16(to, rgba.data(), width, dst);
+
+      return;
+   }
+
+   if (to == PixelEnum::ALPHA_TRUE_COLOR_PIXEL_8BIT)
+   {
+      decode_rgba8(from, src, width, colors, dst);
+      return;
+   }
+
+   std::vector<std::uint8_t> rgba(width*4);
+   decode_rgba8(from, src, width, colors, rgba.data());
+   encode_rgba8(to, rgba.data(), width, colors, dst);
+}
@@ -0,0 +1,200 @@
+#include <facade.hpp>
+
+#include <chrono>
+
+using namespace facade;
+
+/* the pool the current thread works for, if any, and the index of its deque in that pool */
+static thread_local const ThreadPool *current_pool = nullptr;
+static thread_local std::size_t current_worker = 0;
+
+static std::atomic<Executor *> default_override(nullptr);
+
+TaskGroup::~TaskGroup() {
+   try {
+      this->wait();
+   }
+   catch (...) {}
+}
+
+void TaskGroup::wait() {
+   for (;;)
+   {
+      {
+         std::lock_guard<std::mutex> lock(this->mutex);
+         if (this->pending == 0) { break; }
+      }
+
+      if (this->executor.run_pending()) { continue; }
+
+      /* nothing left to help with, so the rest of the group is running elsewhere. check back now and then in case
+         one of those tasks queues more work */
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->done.wait_for(lock, std::chrono::microseconds(100), [this]() { return this->pending == 0; });
+   }
+
+   std::exception_ptr error;
+
+   {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      std::swap(error, this->error);
+   }
+
+   if (error != nullptr) { std::rethrow_exception(error); }
+}
+
+void TaskGroup::fail(std::exception_ptr exception) {
+   std::lock_guard<std::mutex> lock(this->mutex);
+   if (this->error == nullptr) { this->error = exception; }
+}
+
+void TaskGroup::finish() {
+   /* notify while holding the lock, since the group can be destroyed as soon as a waiter sees it finished */
+   std::lock_guard<std::mutex> lock(this->mutex);
+   if (--this->pending == 0) { this->done.notify_all(); }
+}
+
+ThreadPool::ThreadPool(std::size_t threads) : queued(0), stopping(false) {
+   if (threads == 0) { threads = std::max<std::size_t>(1, std::thread::hardware_concurrency()); }
+
+   this->threads = threads;
+
+   for (std::size_t i=0; i<threads; ++i)
+      this->queues.push_back(std::make_unique<Queue>());
+
+   for (std::size_t i=0; i<threads-1; ++i)
+      this->workers.emplace_back([this, i]() { this->work(i); });
+}
+
+ThreadPool::~ThreadPool() {
+   {
+      std::lock_guard<std::mutex> lock(this->sleep_mutex);
+      this->stopping = true;
+   }
+
+   this->wake.notify_all();
+
+   for (auto &worker : this->workers)
+      worker.join();
+}
+
+std::size_t ThreadPool::concurrency() const { return this->threads; }
+
+void ThreadPool::submit(Task task) {
+   if (this->workers.empty())
+   {
+      try {
+         task();
+      }
+      catch (...) {}
+
+      return;
+   }
+
+   /* count the task before queueing it, so a worker never takes a task it hasn't been told about */
+   {
+      std::lock_guard<std::mutex> lock(this->sleep_mutex);
+      ++this->queued;
+   }
+
+   auto &queue = *this->queues[this->queue_index()];
+
+   {
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.tasks.push_back(std::move(task));
+   }
+
+   this->wake.notify_one();
+}
+
+bool ThreadPool::run_pending() {
+   Task task;
+   if (!this->take(this->queue_index(), task)) { return false; }
+
+   try {
+      task();
+   }
+   catch (...) {}
+
+   return true;
+}
+
+std::size_t ThreadPool::queue_index() const {
+   return (current_pool == this) ? current_worker : this->threads - 1;
+}
+
+bool ThreadPool::take(std::size_t index, Task &task) {
+   auto external = this->threads - 1;
+
+   /* a worker takes the newest task off its own deque first, since its data is most likely still in cache */
+   if (index != external)
+   {
+      auto &queue = *this->queues[index];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+
+      if (!queue.tasks.empty())
+      {
+         task = std::move(queue.tasks.back());
+         queue.tasks.pop_back();
+         --this->queued;
+         return true;
+      }
+   }
+
+   /* then steals the oldest task from everyone else, which tends to be the biggest piece of what's left */
+   for (std::size_t i=1; i<=this->threads; ++i)
+   {
+      auto victim = (index + i) % this->threads;
+      if (victim == index && index != external) { continue; }
+
+      auto &queue = *this->queues[victim];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+
+      if (!queue.tasks.empty())
+      {
+         task = std::move(queue.tasks.front());
+         queue.tasks.pop_front();
+         --this->queued;
+         return true;
+      }
+   }
+
+   return false;
+}
+
+void ThreadPool::work(std::size_t index) {
+   current_pool = this;
+   current_worker = index;
+
+   for (;;)
+   {
+      Task task;
+
+      if (this->take(index, task))
+      {
+         try {
+            task();
+         }
+         catch (...) {}
+
+         continue;
+      }
+
+      std::unique_lock<std::mutex> lock(this->sleep_mutex);
+      if (this->stopping && this->queued == 0) { return; }
+
+      this->wake.wait(lock, [this]() { return this->stopping || this->queued > 0; });
+   }
+}
+
+Executor &facade::default_executor() {
+   auto executor = default_override.load();
+   if (executor != nullptr) { return *executor; }
+
+   static ThreadPool pool;
+   return pool;
+}
+
+void facade::set_default_executor(Executor *executor) {
+   default_override.store(executor);
+}
@@ -3,46 +3,102 @@
 using namespace facade;
 using namespace facade::ico;
 
+IconEntry::IconEntry(const IconDirEntry &dir_entry, std::shared_ptr<const std::vector<std::uint8_t>> buffer, std::size_t offset, std::size_t size)
+   : _buffer(buffer), _offset(offset), _size(size), dir_entry(dir_entry)
+{
+   if (this->_buffer == nullptr || offset + size > this->_buffer->size())
+      throw exception::OutOfBounds(offset + size, (this->_buffer == nullptr) ? 0 : this->_buffer->size());
+}
+
+const std::uint8_t *IconEntry::data() const {
+   if (this->_buffer == nullptr) { return nullptr; }
+
+   return this->_buffer->data() + this->_offset;
+}
+
+std::size_t IconEntry::size() const { return this->_size; }
+
+std::vector<std::uint8_t> IconEntry::to_vector() const {
+   if (this->_size == 0) { return std::vector<std::uint8_t>(); }
+
+   return std::vector<std::uint8_t>(this->data(), this->data() + this->_size);
+}
+
+void IconEntry::set_data(const std::vector<std::uint8_t> &data) {
+   this->_buffer = std::make_shared<const std::vector<std::uint8_t>>(data);
+   this->_offset = 0;
+   this->_size = data.size();
+}
+
+bool IconEntry::views(const std::shared_ptr<const std::vector<std::uint8_t>> &buffer, std::size_t offset, std::size_t size) const {
+   return this->_buffer == buffer && this->_offset == offset && this->_size == size;
+}
+
+/* the size of an icon directory with the given number of entries. */
+static std::size_t dir_size(std::size_t count) {
+   return sizeof(IconDir) - sizeof(IconDirEntry) + (sizeof(IconDirEntry) * count);
+}
+
+/* read a directory entry out of an icon file, which may not be aligned for it. */
+static IconDirEntry read_dir_entry(const std::uint8_t *file, std::size_t index) {
+   IconDirEntry entry;
+   std::memcpy(&entry, file + dir_size(index), sizeof(IconDirEntry));
+
+   return entry;
+}
+
 std::size_t Icon::size(void) const { return this->_entries.size(); }
 
+std::pmr::memory_resource *Icon::memory_resource(void) const { return this->_resource; }
+
+void Icon::set_memory_resource(std::pmr::memory_resource *resource) { this->_resource = resource; }
+
 void Icon::parse(const void *ptr, std::size_t size) {
+   auto u8_ptr = reinterpret_cast<const std::uint8_t *>(ptr);
+   this->parse(std::make_shared<const std::vector<std::uint8_t>>(u8_ptr, u8_ptr+size));
+}
+
+void Icon::parse(const std::vector<std::uint8_t> &vec) {
+   this->parse(std::make_shared<const std::vector<std::uint8_t>>(vec));
+}
+
+void Icon::parse(std::shared_ptr<const std::vector<std::uint8_t>> buffer) {
+   auto size = buffer->size();
+
    if (size < sizeof(IconDir))
       throw exception::InsufficientSize(size, sizeof(IconDir));
 
-   auto u8_ptr = reinterpret_cast<const std::uint8_t *>(ptr);
-   auto dir = reinterpret_cast<const IconDir *>(u8_ptr);
+   auto u8_ptr = buffer->data();
+   std::uint16_t reserved, type, count;
+   std::memcpy(&reserved, u8_ptr, sizeof(std::uint16_t));
+   std::memcpy(&type, u8_ptr+2, sizeof(std::uint16_t));
+   std::memcpy(&count, u8_ptr+4, sizeof(std::uint16_t));
 
-   if (dir->reserved != 0 || dir->type != 1)
+   if (reserved != 0 || type != 1)
       throw exception::InvalidIconHeader();
 
-   auto dir_size = sizeof(IconDir) - sizeof(IconDirEntry) + (sizeof(IconDirEntry) * dir->count);
-
-   if (dir_size > size)
-      throw exception::OutOfBounds(dir_size, size);
+   if (dir_size(count) > size)
+      throw exception::OutOfBounds(dir_size(count), size);
 
    std::vector<Entry> entries;
 
-   for (std::uint16_t i=0; i<dir->count; ++i)
+   for (std::uint16_t i=0; i<count; ++i)
    {
-      auto entry = dir->entries[i];
+      auto entry = read_dir_entry(u8_ptr, i);
+      auto entry_end = static_cast<std::size_t>(entry.offset) + entry.bytes;
 
-      if (entry.offset+entry.bytes > size)
-         throw exception::OutOfBounds(entry.offset+entry.bytes, size);
+      if (entry_end > size)
+         throw exception::OutOfBounds(entry_end, size);
 
-      auto data = u8_ptr+entry.offset;
-      auto data_end = data+entry.bytes;
-      entries.push_back(std::make_pair(entry, std::vector<uint8_t>(data, data_end)));
+      entries.push_back(Entry(entry, buffer, entry.offset, entry.bytes));
    }
 
    this->_entries = entries;
-}
-
-void Icon::parse(const std::vector<std::uint8_t> &vec) {
-   this->parse(vec.data(), vec.size());
+   this->_source = buffer;
 }
 
 void Icon::parse(const std::string &filename) {
-   this->parse(read_file(filename));
+   this->parse(std::make_shared<const std::vector<std::uint8_t>>(read_file(filename)));
 }
 
 Icon::Entry &Icon::get_entry(std::size_t index) {
@@ -67,41 +123,132 @@ void Icon::set_entry(std::size_t index, const Icon::Entry &entry) {
 }
 
 void Icon::set_entry(std::size_t index, const IconDirEntry &entry, const std::vector<std::uint8_t> &data) {
-   this->set_entry(index, std::make_pair(entry, data));
+   this->set_entry(index, Entry(entry, data));
 }
 
 Icon::EntryType Icon::entry_type(std::size_t index) const {
-   auto entry = this->get_entry(index);
+   auto &entry = this->get_entry(index);
 
-   if (entry.second.size() >= 8 && std::memcmp(entry.second.data(), png::Image::Signature, sizeof(png::Image::Signature)) == 0)
+   if (entry.size() >= 8 && std::memcmp(entry.data(), png::Image::Signature, sizeof(png::Image::Signature)) == 0)
       return Icon::EntryType::ENTRY_PNG;
    else
       return Icon::EntryType::ENTRY_BMP;
 }
 
+bool Icon::is_modified(std::size_t index) const {
+   auto &entry = this->get_entry(index);
+
+   if (this->_source == nullptr) { return true; }
+
+   auto source = this->_source->data();
+   std::uint16_t count;
+   std::memcpy(&count, source+4, sizeof(std::uint16_t));
+
+   if (index >= count) { return true; }
+
+   auto original = read_dir_entry(source, index);
+
+   return !entry.views(this->_source, original.offset, original.bytes);
+}
+
 std::vector<std::uint8_t> Icon::to_file(void) const {
    if (this->size() == 0)
       throw exception::NoIconData();
-   
-   std::size_t buffer_size = sizeof(IconDir) - sizeof(IconDirEntry) + (sizeof(IconDirEntry) * this->size());
+
+   if (this->can_splice())
+      return this->splice();
+   else
+      return this->rebuild();
+}
+
+bool Icon::can_splice() const {
+   if (this->_source == nullptr) { return false; }
+
+   auto source = this->_source->data();
+   std::uint16_t count;
+   std::memcpy(&count, source+4, sizeof(std::uint16_t));
+
+   if (count != this->size()) { return false; }
+
+   /* the original entries have to sit after the directory without overlapping, or there's no layout to keep */
+   std::vector<std::pair<std::size_t, std::size_t>> ranges;
+
+   for (std::uint16_t i=0; i<count; ++i)
+   {
+      auto original = read_dir_entry(source, i);
+      ranges.push_back(std::make_pair(static_cast<std::size_t>(original.offset), original.offset + static_cast<std::size_t>(original.bytes)));
+   }
+
+   std::sort(ranges.begin(), ranges.end());
+   std::size_t previous_end = dir_size(count);
+
+   for (auto &range : ranges)
+   {
+      if (range.first < previous_end) { return false; }
+
+      previous_end = range.second;
+   }
+
+   return true;
+}
+
+std::vector<std::uint8_t> Icon::splice() const {
+   auto &source = *this->_source;
+   auto count = this->size();
+   std::vector<std::pair<IconDirEntry, std::size_t>> originals;
+
+   for (std::size_t i=0; i<count; ++i)
+      originals.push_back(std::make_pair(read_dir_entry(source.data(), i), i));
+
+   std::sort(originals.begin(), originals.end(), [](const auto &left, const auto &right) {
+      return left.first.offset < right.first.offset;
+   });
+
+   /* copy the directory as it was, then walk the file in offset order, swapping in the data of each entry. unmodified
+      entries copy the same bytes back, while modified ones shift everything after them */
+   std::vector<std::uint8_t> buffer(source.begin(), source.begin() + dir_size(count));
+   std::vector<IconDirEntry> dir_entries(count);
+   std::size_t cursor = dir_size(count);
+
+   for (auto &original : originals)
+   {
+      auto &entry = this->get_entry(original.second);
+
+      buffer.insert(buffer.end(), source.begin() + cursor, source.begin() + original.first.offset);
+
+      auto &dir_entry = dir_entries[original.second];
+      dir_entry = entry.dir_entry;
+      dir_entry.bytes = static_cast<std::uint32_t>(entry.size());
+      dir_entry.offset = static_cast<std::uint32_t>(buffer.size());
+
+      buffer.insert(buffer.end(), entry.data(), entry.data() + entry.size());
+      cursor = original.first.offset + static_cast<std::size_t>(original.first.bytes);
+   }
+
+   buffer.insert(buffer.end(), source.begin() + cursor, source.end());
+
+   for (std::size_t i=0; i<count; ++i)
+      std::memcpy(buffer.data() + dir_size(i), &dir_entries[i], sizeof(IconDirEntry));
+
+   return buffer;
+}
+
+std::vector<std::uint8_t> Icon::rebuild() const {
+   std::size_t buffer_size = dir_size(this->size());
    auto buffer = std::vector<std::uint8_t>(buffer_size);
 
-   auto dir = reinterpret_cast<IconDir *>(buffer.data());
-   dir->reserved = 0;
-   dir->type = 1;
-   dir->count = static_cast<std::uint16_t>(this->size());
+   std::uint16_t header[3] = { 0, 1, static_cast<std::uint16_t>(this->size()) };
+   std::memcpy(buffer.data(), header, sizeof(header));
 
-   for (std::uint16_t i=0; i<dir->count; ++i)
+   for (std::size_t i=0; i<this->size(); ++i)
    {
       auto &entry_ref = this->get_entry(i);
-      std::memcpy(&dir->entries[i], &entry_ref.first, sizeof(IconDirEntry));
-
-      auto entry_data = &dir->entries[i];
-      entry_data->bytes = static_cast<std::uint32_t>(entry_ref.second.size());
-      entry_data->offset = static_cast<std::uint32_t>(buffer.size());
-      buffer.insert(buffer.end(), entry_ref.second.begin(), entry_ref.second.end());
-      
-      dir = reinterpret_cast<IconDir *>(buffer.data());
+      auto dir_entry = entry_ref.dir_entry;
+      dir_entry.bytes = static_cast<std::uint32_t>(entry_ref.size());
+      dir_entry.offset = static_cast<std::uint32_t>(buffer.size());
+
+      std::memcpy(buffer.data() + dir_size(i), &dir_entry, sizeof(IconDirEntry));
+      buffer.insert(buffer.end(), entry_ref.data(), entry_ref.data() + entry_ref.size());
    }
 
    return buffer;
@@ -124,7 +271,7 @@ Icon::Entry &Icon::insert_entry(std::size_t index, const Entry &entry) {
 
 Icon::Entry &Icon::insert_entry(std::size_t index, const IconDirEntry &entry, const std::vector<std::uint8_t> &data)
 {
-   return this->insert_entry(index, std::make_pair(entry, data));
+   return this->insert_entry(index, Entry(entry, data));
 }
 
 Icon::Entry &Icon::append_entry(const Entry &entry)
@@ -134,7 +281,7 @@ Icon::Entry &Icon::append_entry(const Entry &entry)
 
 Icon::Entry &Icon::append_entry(const IconDirEntry &entry, const std::vector<std::uint8_t> &data)
 {
-   return this->append_entry(std::make_pair(entry, data));
+   return this->append_entry(Entry(entry, data));
 }
 
 void Icon::remove_entry(std::size_t index) {
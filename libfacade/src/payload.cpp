@@ -1,7 +1,567 @@
 #include <facade.hpp>
 
+#include <cmath>
+#include <cstring>
+#include <functional>
+
 using namespace facade;
 
+/* the header of one segment of a segmented zTXt payload, parsed from its "sequence/total:" text prefix. */
+struct ZTextSegment
+{
+   std::size_t sequence;
+   std::size_t total;
+   std::size_t data_offset;
+};
+
+static std::optional<ZTextSegment> parse_ztext_segment(std::string_view text) {
+   /* base64 never contains a colon, so plain payloads can't be mistaken for a segment */
+   auto colon = text.find(':');
+   if (colon == std::string::npos) { return std::nullopt; }
+
+   auto slash = text.find('/');
+   if (slash == std::string::npos || slash == 0 || slash > colon || colon - slash == 1) { return std::nullopt; }
+   if (slash > 19 || colon - slash - 1 > 19) { return std::nullopt; }
+
+   for (std::size_t i=0; i<colon; ++i)
+      if (i != slash && !std::isdigit(static_cast<unsigned char>(text[i])))
+         return std::nullopt;
+
+   ZTextSegment segment;
+   segment.sequence = std::stoull(std::string(text.substr(0, slash)));
+   segment.total = std::stoull(std::string(text.substr(slash+1, colon-slash-1)));
+   segment.data_offset = colon+1;
+
+   if (segment.total == 0 || segment.sequence >= segment.total) { return std::nullopt; }
+
+   return segment;
+}
+
+/* one stripe of a striped stego payload, as recorded in the header written ahead of its data in an icon entry: "FCS",
+   the stripe's index and the stripe count as u16s, then the size of the whole compressed payload and the offset and
+   size of this stripe within it as u32s. the stripe data is followed by "SCF". */
+struct StegoStripe
+{
+   std::uint16_t index;
+   std::uint16_t count;
+   std::uint32_t total;
+   std::uint32_t offset;
+   std::uint32_t size;
+};
+
+static const std::size_t STRIPE_HEADER_SIZE = 3 + 2 + 2 + 4 + 4 + 4;
+static const std::size_t STRIPE_FOOTER_SIZE = 3;
+
+/* the 8-bit true color type an image is converted to before a stego payload is written into it. images with any
+   transparency keep it as an alpha channel, which the payload doesn't touch. */
+static png::PixelEnum stego_carrier_type(const png::Image &image) {
+   auto pixel_type = image.header().pixel_type();
+
+   if (pixel_type == png::PixelEnum::TRUE_COLOR_PIXEL_8BIT || pixel_type == png::PixelEnum::ALPHA_TRUE_COLOR_PIXEL_8BIT)
+      return pixel_type;
+
+   auto color_type = image.header().color_type();
+
+   if (color_type == png::ColorType::ALPHA_GRAYSCALE || color_type == png::ColorType::ALPHA_TRUE_COLOR || image.color_table().has_transparency())
+      return png::PixelEnum::ALPHA_TRUE_COLOR_PIXEL_8BIT;
+
+   return png::PixelEnum::TRUE_COLOR_PIXEL_8BIT;
+}
+
+/* stripes are only read out of 8-bit true color images, but any image can be converted to hold one. */
+static std::size_t stripe_capacity(const png::Image &image, bool any_pixel_type=false) {
+   auto &header = image.header();
+   auto pixel_type = header.pixel_type();
+
+   if (!any_pixel_type && pixel_type != png::PixelEnum::TRUE_COLOR_PIXEL_8BIT && pixel_type != png::PixelEnum::ALPHA_TRUE_COLOR_PIXEL_8BIT)
+      return 0;
+
+   auto storage = (static_cast<std::size_t>(header.width()) * header.height() * 3 * 4) / 8;
+   if (storage <= STRIPE_HEADER_SIZE + STRIPE_FOOTER_SIZE) { return 0; }
+
+   return storage - STRIPE_HEADER_SIZE - STRIPE_FOOTER_SIZE;
+}
+
+static std::optional<StegoStripe> read_stego_stripe(const PNGPayload &image) {
+   auto capacity = stripe_capacity(image);
+   if (capacity == 0) { return std::nullopt; }
+
+   auto header = image.read_stego_data(0, STRIPE_HEADER_SIZE);
+   if (std::memcmp(header.data(), "FCS", 3) != 0) { return std::nullopt; }
+
+   StegoStripe stripe;
+   std::memcpy(&stripe.index, &header[3], sizeof(stripe.index));
+   std::memcpy(&stripe.count, &header[5], sizeof(stripe.count));
+   std::memcpy(&stripe.total, &header[7], sizeof(stripe.total));
+   std::memcpy(&stripe.offset, &header[11], sizeof(stripe.offset));
+   std::memcpy(&stripe.size, &header[15], sizeof(stripe.size));
+
+   if (stripe.count == 0 || stripe.index >= stripe.count) { return std::nullopt; }
+   if (stripe.size > capacity || static_cast<std::size_t>(stripe.offset) + stripe.size > stripe.total) { return std::nullopt; }
+
+   auto footer = image.read_stego_data((STRIPE_HEADER_SIZE + stripe.size) * 8, STRIPE_FOOTER_SIZE);
+   if (std::memcmp(footer.data(), "SCF", 3) != 0) { return std::nullopt; }
+
+   return stripe;
+}
+
+/* read the stripe headers of every entry concurrently and put the stripes in order, paired with the entry each came
+   from. returns the first stripe which doesn't fit the layout the others describe, if there is one. */
+static std::optional<StegoStripe> find_stego_stripes(const std::vector<PNGPayload> &images,
+                                                     std::vector<std::pair<StegoStripe, std::size_t>> &stripes,
+                                                     Executor &executor)
+{
+   std::vector<std::optional<StegoStripe>> found(images.size());
+
+   executor.parallel_for(images.size(), [&](std::size_t i) {
+      found[i] = read_stego_stripe(images[i]);
+   });
+
+   stripes.clear();
+
+   for (std::size_t i=0; i<found.size(); ++i)
+      if (found[i].has_value()) { stripes.push_back(std::make_pair(*found[i], i)); }
+
+   std::sort(stripes.begin(), stripes.end(), [](const auto &left, const auto &right) {
+      return left.first.index < right.first.index;
+   });
+
+   std::size_t offset = 0;
+
+   for (std::size_t i=0; i<stripes.size(); ++i)
+   {
+      auto &stripe = stripes[i].first;
+
+      if (stripe.index != i
+          || stripe.count != stripes.size()
+          || stripe.total != stripes.front().first.total
+          || stripe.offset != offset)
+         return stripe;
+
+      offset += stripe.size;
+   }
+
+   if (!stripes.empty() && offset != stripes.front().first.total) { return stripes.back().first; }
+
+   return std::nullopt;
+}
+
+/* split a compressed payload of the given size into stripes across images of the given capacities, pairing each stripe
+   with the image it goes in. each image gets a share of what's left in proportion to its share of the capacity that's
+   left, rounding up, so the images are encoded with about the same effort and whatever's left always fits in the
+   images after. */
+static std::vector<std::pair<StegoStripe, std::size_t>> plan_stego_stripes(std::size_t size, const std::vector<std::size_t> &capacities) {
+   std::size_t capacity = 0;
+
+   for (auto image_capacity : capacities)
+      capacity += image_capacity;
+
+   if (size > capacity || size > std::numeric_limits<std::uint32_t>::max())
+      throw exception::ImageTooSmall(capacity, size);
+
+   std::vector<std::pair<StegoStripe, std::size_t>> stripes;
+   std::size_t offset = 0;
+   std::size_t capacity_left = capacity;
+
+   for (std::size_t i=0; i<capacities.size() && offset < size; ++i)
+   {
+      if (capacities[i] == 0) { continue; }
+
+      auto remaining = size - offset;
+      auto share = static_cast<std::size_t>(std::ceil(static_cast<double>(remaining) * capacities[i] / capacity_left));
+      share = std::min(std::min(share, capacities[i]), remaining);
+
+      StegoStripe stripe;
+      stripe.index = static_cast<std::uint16_t>(stripes.size());
+      stripe.total = static_cast<std::uint32_t>(size);
+      stripe.offset = static_cast<std::uint32_t>(offset);
+      stripe.size = static_cast<std::uint32_t>(share);
+      stripes.push_back(std::make_pair(stripe, i));
+
+      offset += share;
+      capacity_left -= capacities[i];
+   }
+
+   if (offset != size) { throw exception::ImageTooSmall(capacity, size); }
+
+   for (auto &stripe : stripes)
+      stripe.first.count = static_cast<std::uint16_t>(stripes.size());
+
+   return stripes;
+}
+
+/* wrap one stripe of a compressed payload in its "FCS" header and "SCF" footer. */
+static std::pmr::vector<std::uint8_t> stripe_block(const StegoStripe &stripe, const std::pmr::vector<std::uint8_t> &compressed, std::pmr::memory_resource *resource) {
+   std::uint8_t header[STRIPE_HEADER_SIZE];
+
+   std::memcpy(&header[0], "FCS", 3);
+   std::memcpy(&header[3], &stripe.index, sizeof(stripe.index));
+   std::memcpy(&header[5], &stripe.count, sizeof(stripe.count));
+   std::memcpy(&header[7], &stripe.total, sizeof(stripe.total));
+   std::memcpy(&header[11], &stripe.offset, sizeof(stripe.offset));
+   std::memcpy(&header[15], &stripe.size, sizeof(stripe.size));
+
+   std::pmr::vector<std::uint8_t> block(resource);
+   block.reserve(STRIPE_HEADER_SIZE + stripe.size + STRIPE_FOOTER_SIZE);
+   block.insert(block.end(), &header[0], &header[STRIPE_HEADER_SIZE]);
+   block.insert(block.end(), compressed.begin() + stripe.offset, compressed.begin() + stripe.offset + stripe.size);
+   block.insert(block.end(), "SCF", "SCF" + STRIPE_FOOTER_SIZE);
+
+   return block;
+}
+
+/* read the stripes out of the given loaded images concurrently and decompress the payload they make up. */
+static std::vector<std::uint8_t> join_stego_stripes(const std::vector<PNGPayload> &images, Executor &executor) {
+   std::vector<std::pair<StegoStripe, std::size_t>> stripes;
+   auto bad_stripe = find_stego_stripes(images, stripes, executor);
+
+   if (stripes.empty()) { throw exception::NoStegoData(); }
+   if (bad_stripe.has_value()) { throw exception::InvalidSegment(bad_stripe->index, bad_stripe->count); }
+
+   std::vector<std::uint8_t> compressed(stripes.front().first.total);
+
+   executor.parallel_for(stripes.size(), [&](std::size_t s) {
+      auto &stripe = stripes[s].first;
+      if (stripe.size == 0) { return; }
+
+      auto data = images[stripes[s].second].read_stego_data(STRIPE_HEADER_SIZE * 8, stripe.size);
+
+      std::memcpy(compressed.data() + stripe.offset, data.data(), data.size());
+   });
+
+   return facade::decompress(compressed);
+}
+
+/* the frames of an animated image, split out as payloads of their own. */
+static std::vector<PNGPayload> frame_payloads(const PNGPayload &image, bool load) {
+   auto frames = image.frames(load);
+   std::vector<PNGPayload> result;
+   result.reserve(frames.size());
+
+   for (auto &frame : frames)
+      result.push_back(PNGPayload(frame));
+
+   return result;
+}
+
+/* how many bits of stego data an image holds, four in each color channel. */
+static std::size_t stego_storage_bits(const png::Image &image) {
+   auto &header = image.header();
+
+   return static_cast<std::size_t>(header.width()) * header.height() * 3 * 4;
+}
+
+/* the v2 stego stream: "FC2", the u32 size of the uncompressed blocks and the u64 size of the whole payload, then each
+   block as its u32 compressed size, the u32 CRC of the compressed data and the data itself, then "2CF". every block is
+   compressed on its own, so a payload is embedded and extracted a block at a time rather than all at once. */
+static const std::size_t STREAM_HEADER_SIZE = 3 + 4 + 8;
+static const std::size_t STREAM_BLOCK_HEADER_SIZE = 4 + 4;
+static const std::size_t STREAM_FOOTER_SIZE = 3;
+
+struct StreamBlock
+{
+   std::size_t bit_offset;
+   std::uint32_t size;
+   std::uint32_t crc;
+};
+
+struct StegoStream
+{
+   std::uint32_t block_size;
+   std::uint64_t size;
+   std::vector<StreamBlock> blocks;
+};
+
+/* reads up to the given number of payload bytes into the buffer, returning how many were read, or 0 at the end. */
+using PayloadReader = std::function<std::size_t(std::uint8_t *, std::size_t)>;
+/* takes the next run of extracted payload bytes. */
+using PayloadWriter = std::function<void(const std::uint8_t *, std::size_t)>;
+
+static std::optional<StegoStream> read_stego_stream(const PNGPayload &image) {
+   auto storage = stego_storage_bits(image);
+   if (storage < (STREAM_HEADER_SIZE + STREAM_FOOTER_SIZE) * 8) { return std::nullopt; }
+
+   auto header = image.read_stego_data(0, STREAM_HEADER_SIZE);
+   if (std::memcmp(header.data(), "FC2", 3) != 0) { return std::nullopt; }
+
+   StegoStream stream;
+   std::memcpy(&stream.block_size, &header[3], sizeof(stream.block_size));
+   std::memcpy(&stream.size, &header[7], sizeof(stream.size));
+   if (stream.block_size == 0) { return std::nullopt; }
+
+   auto count = stream.size / stream.block_size + ((stream.size % stream.block_size != 0) ? 1 : 0);
+   std::size_t bit_offset = STREAM_HEADER_SIZE * 8;
+
+   /* every block takes up at least its own header, which bounds how far a bogus size can send us */
+   if (count > (storage - bit_offset) / (STREAM_BLOCK_HEADER_SIZE * 8)) { return std::nullopt; }
+
+   stream.blocks.reserve(count);
+
+   for (std::uint64_t i=0; i<count; ++i)
+   {
+      if (storage - bit_offset < STREAM_BLOCK_HEADER_SIZE * 8) { return std::nullopt; }
+
+      auto block_header = image.read_stego_data(bit_offset, STREAM_BLOCK_HEADER_SIZE);
+      StreamBlock block;
+      std::memcpy(&block.size, &block_header[0], sizeof(block.size));
+      std::memcpy(&block.crc, &block_header[4], sizeof(block.crc));
+      block.bit_offset = bit_offset + STREAM_BLOCK_HEADER_SIZE * 8;
+
+      if ((storage - block.bit_offset) / 8 < block.size) { return std::nullopt; }
+
+      bit_offset = block.bit_offset + static_cast<std::size_t>(block.size) * 8;
+      stream.blocks.push_back(block);
+   }
+
+   if (storage - bit_offset < STREAM_FOOTER_SIZE * 8) { return std::nullopt; }
+
+   auto footer = image.read_stego_data(bit_offset, STREAM_FOOTER_SIZE);
+   if (std::memcmp(footer.data(), "2CF", 3) != 0) { return std::nullopt; }
+
+   return stream;
+}
+
+/* compress and embed a payload a batch of blocks at a time. only as many blocks as there are workers to compress them
+   are held in memory at once, and the header goes in last, once the size of the payload is known. */
+static void write_stego_stream(PNGPayload &image, const PayloadReader &read, std::size_t block_size) {
+   if (block_size == 0) { throw exception::NoData(); }
+   if (block_size > std::numeric_limits<std::uint32_t>::max()) { throw exception::IntegerOverflow(block_size, std::numeric_limits<std::uint32_t>::max()); }
+
+   auto storage = stego_storage_bits(image) / 8;
+   if (storage < STREAM_HEADER_SIZE + STREAM_FOOTER_SIZE) { throw exception::ImageTooSmall(storage, STREAM_HEADER_SIZE + STREAM_FOOTER_SIZE); }
+
+   auto stats = image.stats();
+   auto batch = std::max<std::size_t>(1, image.executor().concurrency());
+   std::vector<std::vector<std::uint8_t>> raw(batch);
+   std::vector<std::pmr::vector<std::uint8_t>> compressed(batch);
+   std::uint64_t total = 0;
+   std::size_t offset = STREAM_HEADER_SIZE;
+   bool done = false;
+
+   while (!done)
+   {
+      std::size_t count = 0;
+      std::size_t batch_bytes = 0;
+
+      while (count < batch && !done)
+      {
+         auto &block = raw[count];
+         std::size_t filled = 0;
+         block.resize(block_size);
+
+         while (filled < block_size)
+         {
+            auto got = read(block.data() + filled, block_size - filled);
+            if (got == 0) { break; }
+
+            filled += got;
+         }
+
+         block.resize(filled);
+         total += filled;
+         batch_bytes += filled;
+
+         if (filled > 0) { ++count; }
+         if (filled < block_size) { done = true; }
+      }
+
+      StageTimer timer(stats.get(), STAGE_DEFLATE);
+
+      image.executor().parallel_for(count, [&](std::size_t i) {
+         compressed[i] = facade::compress(raw[i].data(), raw[i].size(), 9, image.memory_resource());
+      });
+
+      if (stats != nullptr)
+      {
+         std::size_t compressed_bytes = 0;
+
+         for (std::size_t i=0; i<count; ++i)
+            compressed_bytes += compressed[i].size();
+
+         timer.set_bytes(batch_bytes, compressed_bytes);
+      }
+
+      timer.stop();
+
+      for (std::size_t i=0; i<count; ++i)
+      {
+         auto &block = compressed[i];
+         auto needed = offset + STREAM_BLOCK_HEADER_SIZE + block.size() + STREAM_FOOTER_SIZE;
+         if (needed > storage || block.size() > std::numeric_limits<std::uint32_t>::max()) { throw exception::ImageTooSmall(storage, needed); }
+
+         auto block_length = static_cast<std::uint32_t>(block.size());
+         auto block_crc = facade::crc32(block.data(), block.size());
+         std::uint8_t block_header[STREAM_BLOCK_HEADER_SIZE];
+         std::memcpy(&block_header[0], &block_length, sizeof(block_length));
+         std::memcpy(&block_header[4], &block_crc, sizeof(block_crc));
+
+         image.write_stego_data(block_header, sizeof(block_header), offset * 8);
+         image.write_stego_data(block.data(), block.size(), (offset + STREAM_BLOCK_HEADER_SIZE) * 8);
+         offset += STREAM_BLOCK_HEADER_SIZE + block.size();
+      }
+   }
+
+   auto u32_block_size = static_cast<std::uint32_t>(block_size);
+   std::uint8_t header[STREAM_HEADER_SIZE];
+   std::memcpy(&header[0], "FC2", 3);
+   std::memcpy(&header[3], &u32_block_size, sizeof(u32_block_size));
+   std::memcpy(&header[7], &total, sizeof(total));
+
+   image.write_stego_data("2CF", STREAM_FOOTER_SIZE, offset * 8);
+   image.write_stego_data(header, sizeof(header), 0);
+}
+
+/* check, inflate and hand over the blocks of a stream a batch at a time, in order. */
+static std::uint64_t read_stego_stream_data(const PNGPayload &image, const StegoStream &stream, const PayloadWriter &write) {
+   auto stats = image.stats();
+   auto batch = std::max<std::size_t>(1, image.executor().concurrency());
+   std::vector<std::pmr::vector<std::uint8_t>> blocks(batch);
+   std::uint64_t written = 0;
+
+   for (std::size_t start=0; start<stream.blocks.size(); start+=batch)
+   {
+      auto count = std::min(batch, stream.blocks.size() - start);
+
+      StageTimer timer(stats.get(), STAGE_INFLATE);
+
+      image.executor().parallel_for(count, [&](std::size_t i) {
+         auto index = start + i;
+         auto &block = stream.blocks[index];
+         auto data = image.read_stego_data(block.bit_offset, block.size);
+         auto crc = facade::crc32(data.data(), data.size());
+         if (crc != block.crc) { throw exception::BadCRC(crc, block.crc); }
+
+         auto expected = std::min<std::uint64_t>(stream.block_size, stream.size - static_cast<std::uint64_t>(index) * stream.block_size);
+         blocks[i] = facade::decompress(data.data(), data.size(), image.memory_resource(), static_cast<std::size_t>(expected));
+         if (blocks[i].size() != expected) { throw exception::InvalidSegment(index, stream.blocks.size()); }
+      });
+
+      timer.stop();
+
+      for (std::size_t i=0; i<count; ++i)
+      {
+         write(blocks[i].data(), blocks[i].size());
+         written += blocks[i].size();
+      }
+   }
+
+   return written;
+}
+
+/* wrap a compressed stego payload in its "FCD", u32 size and "DCF" framing. */
+static std::pmr::vector<std::uint8_t> stego_block(const std::pmr::vector<std::uint8_t> &compressed, std::pmr::memory_resource *resource) {
+   if (compressed.size() > std::numeric_limits<std::uint32_t>::max()) { throw exception::IntegerOverflow(compressed.size(), std::numeric_limits<std::uint32_t>::max()); }
+
+   auto stego_header = "FCD";
+   auto u32_size = static_cast<std::uint32_t>(compressed.size());
+   auto u8_size_ptr = reinterpret_cast<std::uint8_t *>(&u32_size);
+   auto stego_footer = "DCF";
+
+   std::pmr::vector<std::uint8_t> result(resource);
+   result.reserve(3 + 4 + compressed.size() + 3);
+   result.insert(result.end(), &stego_header[0], &stego_header[3]);
+   result.insert(result.end(), &u8_size_ptr[0], &u8_size_ptr[4]);
+   result.insert(result.end(), compressed.begin(), compressed.end());
+   result.insert(result.end(), &stego_footer[0], &stego_footer[3]);
+
+   return result;
+}
+
+/* where the color pixels of an uncompressed 24- or 32-bit icon bitmap are. an icon bitmap's height covers the color
+   pixels and the AND mask after them, so the image is half as tall as the header says. */
+struct BitmapLayout
+{
+   std::size_t pixels;
+   std::size_t width;
+   std::size_t height;
+   std::size_t stride;
+   std::size_t pixel_size;
+   bool bottom_up;
+};
+
+static std::optional<BitmapLayout> bitmap_layout(const ico::IconEntry &entry) {
+   if (entry.size() < sizeof(ico::BitmapInfoHeader)) { return std::nullopt; }
+
+   ico::BitmapInfoHeader header;
+   std::memcpy(&header, entry.data(), sizeof(header));
+
+   /* BI_RGB, the only compression which leaves the pixels raw */
+   if (header.size < sizeof(header) || header.compression != 0) { return std::nullopt; }
+   if (header.bit_count != 24 && header.bit_count != 32) { return std::nullopt; }
+   if (header.width <= 0 || header.height == 0 || header.color_used > 256) { return std::nullopt; }
+
+   BitmapLayout layout;
+   auto height = static_cast<std::size_t>(std::abs(static_cast<std::int64_t>(header.height)));
+   layout.width = static_cast<std::size_t>(header.width);
+   layout.height = height / 2;
+   layout.stride = ((layout.width * header.bit_count + 31) / 32) * 4;
+   layout.pixel_size = header.bit_count / 8;
+   layout.pixels = header.size + header.color_used * sizeof(ico::RGBQuad);
+   layout.bottom_up = header.height > 0;
+
+   auto mask_stride = ((layout.width + 31) / 32) * 4;
+
+   if (layout.height == 0) { return std::nullopt; }
+   if (layout.pixels > entry.size() || (entry.size() - layout.pixels) / layout.height < layout.stride + mask_stride) { return std::nullopt; }
+
+   return layout;
+}
+
+/* the offset of the color channel carrying the given nibble of a bitmap stego payload. nibbles go into the blue, green
+   and red channels of each pixel, in the order they're stored, with the pixels taken top row first. */
+static std::size_t bitmap_nibble_offset(const BitmapLayout &layout, std::size_t nibble) {
+   auto pixel = nibble / 3;
+   auto row = pixel / layout.width;
+   auto column = pixel % layout.width;
+   auto stored_row = (layout.bottom_up) ? layout.height - 1 - row : row;
+
+   return layout.pixels + stored_row * layout.stride + column * layout.pixel_size + nibble % 3;
+}
+
+static std::vector<std::uint8_t> read_bitmap_stego_data(const std::uint8_t *data, const BitmapLayout &layout, std::size_t offset, std::size_t size) {
+   auto max_size = (layout.width * layout.height * 3) / 2;
+   if (offset + size > max_size) { throw exception::OutOfBounds(offset + size, max_size); }
+
+   std::vector<std::uint8_t> result(size);
+
+   for (std::size_t i=0; i<size; ++i)
+   {
+      auto nibble = (offset + i) * 2;
+      result[i] = (data[bitmap_nibble_offset(layout, nibble)] & 0xF) | ((data[bitmap_nibble_offset(layout, nibble+1)] & 0xF) << 4);
+   }
+
+   return result;
+}
+
+static void write_bitmap_stego_data(std::uint8_t *data, const BitmapLayout &layout, const std::uint8_t *ptr, std::size_t size) {
+   for (std::size_t i=0; i<size; ++i)
+   {
+      auto &low = data[bitmap_nibble_offset(layout, i*2)];
+      auto &high = data[bitmap_nibble_offset(layout, i*2+1)];
+
+      low = (low & 0xF0) | (ptr[i] & 0xF);
+      high = (high & 0xF0) | (ptr[i] >> 4);
+   }
+}
+
+/* the size of the compressed stego payload in the given bitmap, or nothing if it doesn't have one. */
+static std::optional<std::uint32_t> bitmap_stego_size(const std::uint8_t *data, const BitmapLayout &layout) {
+   auto max_size = (layout.width * layout.height * 3) / 2;
+   if (max_size < 3 + 4 + 3) { return std::nullopt; }
+
+   auto header = read_bitmap_stego_data(data, layout, 0, 3 + 4);
+   if (std::memcmp(header.data(), "FCD", 3) != 0) { return std::nullopt; }
+
+   std::uint32_t size;
+   std::memcpy(&size, &header[3], sizeof(size));
+   if (static_cast<std::size_t>(size) > max_size - (3 + 4 + 3)) { return std::nullopt; }
+
+   auto footer = read_bitmap_stego_data(data, layout, 3 + 4 + size, 3);
+   if (std::memcmp(footer.data(), "DCF", 3) != 0) { return std::nullopt; }
+
+   return size;
+}
+
 png::Text &PNGPayload::add_text_payload(const std::string &keyword, const void *ptr, std::size_t size) {
    return this->add_text(keyword, facade::base64_encode(ptr, size));
 }
@@ -14,25 +574,35 @@ void PNGPayload::remove_text_payload(const png::Text &text) {
    this->remove_text(text);
 }
 
-std::vector<png::Text> PNGPayload::get_text_payloads(const std::string &keyword) const {
-   auto potential_payloads = this->get_text(keyword);
-   std::vector<png::Text> result;
+png::ChunkView<png::Text> PNGPayload::get_text_payloads(const std::string &keyword) const {
+   auto offsets = this->keyword_offsets(png::fourcc("tEXt"), keyword);
+   if (offsets == nullptr) { return png::ChunkView<png::Text>(); }
 
-   for (auto &text : potential_payloads)
-   {
-      if (!facade::is_base64_string(text.text())) { throw exception::InvalidBase64String(text.text()); }
-      result.push_back(text);
-   }
+   /* a keyword can be shared with ordinary text, which isn't a payload */
+   std::vector<std::size_t> payloads;
 
-   return result;
+   for (auto offset : *offsets)
+      if (facade::is_base64_string(this->chunks[offset].upcast<png::Text>().text_view()))
+         payloads.push_back(offset);
+
+   return png::ChunkView<png::Text>(this->chunks, std::move(payloads));
 }
 
 std::vector<std::vector<std::uint8_t>> PNGPayload::extract_text_payloads(const std::string &keyword) const {
-   auto payloads = this->get_text_payloads(keyword);
+   auto payloads = this->get_text(keyword);
    std::vector<std::vector<std::uint8_t>> result;
 
+   /* base64_decode validates as it decodes, so there's no need for a separate get_text_payloads pass */
    for (auto &payload : payloads)
-      result.push_back(facade::base64_decode(payload.text()));
+   {
+      auto text = payload.text_view();
+
+      /* a keyword can be shared with ordinary text, which isn't a payload */
+      try {
+         result.push_back(facade::base64_decode(text.data(), text.size()));
+      }
+      catch (exception::InvalidBase64Character &) {}
+   }
 
    return result;
 }
@@ -49,25 +619,140 @@ void PNGPayload::remove_ztext_payload(const png::ZText &ztext) {
    this->remove_ztext(ztext);
 }
 
-std::vector<png::ZText> PNGPayload::get_ztext_payloads(const std::string &keyword) const {
-   auto potential_payloads = this->get_ztext(keyword);
-   std::vector<png::ZText> result;
+std::size_t PNGPayload::add_segmented_ztext_payload(const std::string &keyword, const void *ptr, std::size_t size, std::size_t segment_size) {
+   if (keyword.size() > 79) { throw exception::KeywordTooLong(); }
+   if (segment_size == 0) { segment_size = PNGPayload::ZTextSegmentSize; }
+   
+   auto u8_ptr = reinterpret_cast<const std::uint8_t *>(ptr);
+   auto total = std::max<std::size_t>(1, (size + segment_size - 1) / segment_size);
+   std::vector<png::ZText> segments(total);
+
+   this->executor().parallel_for(total, [&](std::size_t i) {
+      auto offset = i * segment_size;
+      auto length = std::min(segment_size, size - offset);
+      auto text = std::to_string(i) + "/" + std::to_string(total) + ":" + facade::base64_encode(&u8_ptr[offset], length);
+
+      segments[i] = png::ZText(keyword, text);
+   });
+
+   /* no reference to the segments is handed out, so they're inserted without leaving one to be re-keyed */
+   for (auto &segment : segments)
+      this->insert_chunk(this->insertion_offset(png::fourcc("zTXt")), segment.as_chunk_vec());
+
+   return total;
+}
+
+std::size_t PNGPayload::add_segmented_ztext_payload(const std::string &keyword, const std::vector<std::uint8_t> &data, std::size_t segment_size) {
+   return this->add_segmented_ztext_payload(keyword, data.data(), data.size(), segment_size);
+}
+
+bool PNGPayload::is_ztext_segment(std::string_view text) {
+   auto segment = parse_ztext_segment(text);
 
-   for (auto &ztext : potential_payloads)
+   return segment.has_value() && facade::is_base64_string(text.substr(segment->data_offset));
+}
+
+png::ChunkView<png::ZText> PNGPayload::get_ztext_payloads(const std::string &keyword) const {
+   auto offsets = this->keyword_offsets(png::fourcc("zTXt"), keyword);
+   if (offsets == nullptr) { return png::ChunkView<png::ZText>(); }
+
+   /* a keyword can be shared with ordinary text, which isn't a payload, but a broken segment is still an error */
+   std::vector<std::size_t> payloads;
+
+   for (auto offset : *offsets)
    {
-      if (!facade::is_base64_string(ztext.text())) { throw exception::InvalidBase64String(ztext.text()); }
-      result.push_back(ztext);
+      auto text = this->chunks[offset].upcast<png::ZText>().text_view();
+      auto segment = parse_ztext_segment(text);
+      auto data = segment.has_value() ? text.substr(segment->data_offset) : text;
+
+      if (facade::is_base64_string(data)) { payloads.push_back(offset); }
+      else if (segment.has_value()) { throw exception::InvalidBase64String(std::string(text)); }
    }
 
-   return result;
+   return png::ChunkView<png::ZText>(this->chunks, std::move(payloads));
 }
 
 std::vector<std::vector<std::uint8_t>> PNGPayload::extract_ztext_payloads(const std::string &keyword) const {
-   auto payloads = this->get_ztext_payloads(keyword);
+   auto payloads = this->get_ztext(keyword);
+   std::vector<std::optional<ZTextSegment>> segments(payloads.size());
+   std::vector<std::optional<std::vector<std::uint8_t>>> decoded(payloads.size());
+
+   /* base64_decode validates as it decodes, so there's no need for a separate get_ztext_payloads pass */
+   this->executor().parallel_for(payloads.size(), [&](std::size_t i) {
+      auto text = payloads[i].text_view();
+      auto offset = std::size_t(0);
+
+      segments[i] = parse_ztext_segment(text);
+      if (segments[i].has_value()) { offset = segments[i]->data_offset; }
+
+      /* a keyword can be shared with ordinary text, which isn't a payload, but a broken segment is still an error */
+      try {
+         decoded[i] = facade::base64_decode(text.data() + offset, text.size() - offset);
+      }
+      catch (exception::InvalidBase64Character &) {
+         if (segments[i].has_value()) { throw; }
+      }
+   });
+
+   std::vector<std::vector<std::uint8_t>> result;
+   std::size_t next_sequence = 0;
+   std::size_t total = 0;
+
+   /* segments of one payload must appear as an unbroken run in file order, starting at sequence 0 */
+   for (std::size_t i=0; i<payloads.size(); ++i)
+   {
+      if (!segments[i].has_value())
+      {
+         if (next_sequence != 0) { throw exception::InvalidSegment(next_sequence, total); }
+         if (decoded[i].has_value()) { result.push_back(std::move(*decoded[i])); }
+
+         continue;
+      }
+
+      auto &segment = *segments[i];
+
+      if (segment.sequence == 0)
+      {
+         if (next_sequence != 0) { throw exception::InvalidSegment(next_sequence, total); }
+
+         total = segment.total;
+         result.push_back(std::vector<std::uint8_t>());
+      }
+      else if (segment.sequence != next_sequence || segment.total != total) {
+         throw exception::InvalidSegment(segment.sequence, segment.total);
+      }
+
+      result.back().insert(result.back().end(), decoded[i]->begin(), decoded[i]->end());
+      next_sequence = (segment.sequence + 1 == total) ? 0 : segment.sequence + 1;
+   }
+
+   if (next_sequence != 0) { throw exception::InvalidSegment(next_sequence, total); }
+
+   return result;
+}
+
+png::BinaryData &PNGPayload::add_binary_payload(const std::string &keyword, const void *ptr, std::size_t size, std::uint8_t codec) {
+   return this->add_binary(keyword, ptr, size, codec);
+}
+
+png::BinaryData &PNGPayload::add_binary_payload(const std::string &keyword, const std::vector<std::uint8_t> &data, std::uint8_t codec) {
+   return this->add_binary_payload(keyword, data.data(), data.size(), codec);
+}
+
+void PNGPayload::remove_binary_payload(const png::BinaryData &binary) {
+   this->remove_binary(binary);
+}
+
+png::ChunkView<png::BinaryData> PNGPayload::get_binary_payloads(const std::string &keyword) const {
+   return this->get_binary(keyword);
+}
+
+std::vector<std::vector<std::uint8_t>> PNGPayload::extract_binary_payloads(const std::string &keyword) const {
+   auto payloads = this->get_binary_payloads(keyword);
    std::vector<std::vector<std::uint8_t>> result;
 
    for (auto &payload : payloads)
-      result.push_back(facade::base64_decode(payload.text()));
+      result.push_back(payload.payload());
 
    return result;
 }
@@ -77,10 +762,13 @@ std::vector<std::uint8_t> PNGPayload::read_stego_data(std::size_t bit_offset, st
    if (bit_offset % 4 != 0) { throw exception::InvalidBitOffset(bit_offset); }
 
    auto &header = this->header();
-   auto max_size = (header.width() * header.height() * 3 * 4);
+   auto max_size = stego_storage_bits(*this);
    auto checked_size = bit_offset + size * 8;
    if (checked_size > max_size) { throw exception::OutOfBounds(checked_size, max_size); }
 
+   StageTimer timer(this->statistics.get(), STAGE_EXTRACT);
+   timer.set_bytes(size, size);
+
    std::vector<std::uint8_t> result;
 
    for (auto bits=bit_offset; bits<checked_size; bits+=4)
@@ -145,10 +833,13 @@ void PNGPayload::write_stego_data(const void *ptr, std::size_t size, std::size_t
    if (bit_offset % 4 != 0) { throw exception::InvalidBitOffset(bit_offset); }
 
    auto &header = this->header();
-   auto max_size = (header.width() * header.height() * 3 * 4);
+   auto max_size = stego_storage_bits(*this);
    auto checked_size = bit_offset + size * 8;
    if (checked_size > max_size) { throw exception::OutOfBounds(checked_size, max_size); }
 
+   StageTimer timer(this->statistics.get(), STAGE_EMBED);
+   timer.set_bytes(size, size);
+
    auto u8_ptr = reinterpret_cast<const std::uint8_t *>(ptr);
 
    for (std::size_t bits=bit_offset; bits<checked_size; bits+=4)
@@ -202,8 +893,7 @@ void PNGPayload::write_stego_data(const std::vector<std::uint8_t> &data, std::si
 
 bool PNGPayload::has_stego_payload() const {
    if (!this->is_loaded()) { throw exception::NoImageData(); }
-
-   auto &header = this->header();
+   if (read_stego_stream(*this).has_value()) { return true; }
 
    auto stego_header = this->read_stego_data(0, 3);
    auto header_expected = std::vector<std::uint8_t>({ 'F', 'C', 'D' });
@@ -211,42 +901,61 @@ bool PNGPayload::has_stego_payload() const {
 
    auto data_size = this->read_stego_data(3*8, 4);
    auto size_val = *reinterpret_cast<std::uint32_t *>(data_size.data());
-   auto max_val = (header.width() * header.height() * 3 * 4);
-   if (7*8+size_val*8+3*8 > max_val) { return false; }
+   auto max_val = stego_storage_bits(*this);
+   if (7*8+static_cast<std::size_t>(size_val)*8+3*8 > max_val) { return false; }
 
-   auto stego_footer = this->read_stego_data(7*8+size_val*8, 3);
+   auto stego_footer = this->read_stego_data(7*8+static_cast<std::size_t>(size_val)*8, 3);
    auto footer_expected = std::vector<std::uint8_t>({ 'D', 'C', 'F' });
    if (stego_footer != footer_expected) { return false; }
 
    return true;
 }
 
+/* hand the stego payload of an image to the writer, a block at a time if it's a stream. */
+static std::uint64_t extract_stego_data(const PNGPayload &image, const PayloadWriter &write) {
+   if (!image.is_loaded()) { throw exception::NoImageData(); }
+
+   auto stream = read_stego_stream(image);
+   if (stream.has_value()) { return read_stego_stream_data(image, *stream, write); }
+   if (!image.has_stego_payload()) { throw exception::NoStegoData(); }
+
+   auto data_size = image.read_stego_data(3*8, 4);
+   auto size_val = *reinterpret_cast<std::uint32_t *>(data_size.data());
+
+   auto compressed = image.read_stego_data(7*8, size_val);
+
+   StageTimer timer(image.stats().get(), STAGE_INFLATE);
+   auto result = facade::decompress(compressed);
+   timer.set_bytes(compressed.size(), result.size());
+   timer.stop();
+
+   write(result.data(), result.size());
+
+   return result.size();
+}
+
 PNGPayload PNGPayload::create_stego_payload(const void *ptr, std::size_t size) const {
+   /* the original layout records the compressed size in 32 bits, so anything that might not fit goes in a stream */
+   if (size > std::numeric_limits<std::uint32_t>::max()) { return this->create_stego_stream_payload(ptr, size); }
+
    auto result = *this;
-   auto &header = result.header();
-   auto pixel_type = header.pixel_type();
 
-   if (pixel_type != png::PixelEnum::TRUE_COLOR_PIXEL_8BIT && pixel_type != png::PixelEnum::ALPHA_TRUE_COLOR_PIXEL_8BIT)
-      throw exception::UnsupportedPixelType(pixel_type);
+   StageTimer timer(result.statistics.get(), STAGE_DEFLATE);
+   auto compressed = facade::compress(ptr, size, 9, result.memory_resource());
+   timer.set_bytes(size, compressed.size());
+   timer.stop();
 
-   auto compressed = facade::compress(ptr, size, 9);
-   auto stego_header = "FCD";
-   auto u32_size = static_cast<std::uint32_t>(compressed.size());
-   auto u8_size_ptr = reinterpret_cast<std::uint8_t *>(&u32_size);
-   auto stego_footer = "DCF";
+   /* incompressible data just under 4 GiB can still deflate past what 32 bits can record */
+   if (compressed.size() > std::numeric_limits<std::uint32_t>::max()) { return this->create_stego_stream_payload(ptr, size); }
 
-   std::vector<std::uint8_t> payload;
-   payload.insert(payload.end(), &stego_header[0], &stego_header[3]);
-   payload.insert(payload.end(), &u8_size_ptr[0], &u8_size_ptr[4]);
-   payload.insert(payload.end(), compressed.begin(), compressed.end());
-   payload.insert(payload.end(), &stego_footer[0], &stego_footer[3]);
+   auto payload = stego_block(compressed, result.memory_resource());
 
-   auto max_storage = (header.width() * header.height() * 3 * 4) / 8;
+   auto max_storage = stego_storage_bits(result) / 8;
    if (payload.size() > max_storage) { throw exception::ImageTooSmall(max_storage, payload.size()); }
 
-   result.load();
+   result.load(stego_carrier_type(result));
    //std::cout << "Encoding" << std::endl;
-   result.write_stego_data(payload, 0);
+   result.write_stego_data(payload.data(), payload.size(), 0);
    //std::cout << "Filtering" << std::endl;
    result.filter();
    //std::cout << "Compressing" << std::endl;
@@ -260,18 +969,162 @@ PNGPayload PNGPayload::create_stego_payload(const std::vector<std::uint8_t> &dat
 }
 
 std::vector<std::uint8_t> PNGPayload::extract_stego_payload() const {
-   if (!this->is_loaded()) { throw exception::NoImageData(); }
-   if (!this->has_stego_payload()) { throw exception::NoStegoData(); }
+   std::vector<std::uint8_t> result;
 
-   auto data_size = this->read_stego_data(3*8, 4);
-   auto size_val = *reinterpret_cast<std::uint32_t *>(data_size.data());
+   extract_stego_data(*this, [&](const std::uint8_t *ptr, std::size_t size) {
+      result.insert(result.end(), ptr, ptr+size);
+   });
+
+   return result;
+}
+
+std::uint64_t PNGPayload::extract_stego_payload(std::ostream &stream) const {
+   return extract_stego_data(*this, [&](const std::uint8_t *ptr, std::size_t size) {
+      stream.write(reinterpret_cast<const char *>(ptr), size);
+      if (!stream) { throw exception::StreamFailure(); }
+   });
+}
+
+PNGPayload PNGPayload::create_stego_stream_payload(const void *ptr, std::size_t size, std::size_t block_size) const {
+   if (ptr == nullptr && size > 0) { throw exception::NullPointer(); }
+
+   auto result = *this;
+   auto u8_ptr = reinterpret_cast<const std::uint8_t *>(ptr);
+   std::size_t offset = 0;
+
+   result.load(stego_carrier_type(result));
+   write_stego_stream(result, [&](std::uint8_t *buffer, std::size_t wanted) {
+      auto got = std::min(wanted, size - offset);
+      if (got > 0) { std::memcpy(buffer, u8_ptr + offset, got); }
+
+      offset += got;
+      return got;
+   }, block_size);
+   result.filter();
+   result.compress();
+
+   return result;
+}
+
+PNGPayload PNGPayload::create_stego_stream_payload(const std::vector<std::uint8_t> &data, std::size_t block_size) const {
+   return this->create_stego_stream_payload(data.data(), data.size(), block_size);
+}
+
+PNGPayload PNGPayload::create_stego_stream_payload(std::istream &stream, std::size_t block_size) const {
+   auto result = *this;
+
+   result.load(stego_carrier_type(result));
+   write_stego_stream(result, [&](std::uint8_t *buffer, std::size_t wanted) {
+      stream.read(reinterpret_cast<char *>(buffer), wanted);
+      if (stream.bad()) { throw exception::StreamFailure(); }
+
+      return static_cast<std::size_t>(stream.gcount());
+   }, block_size);
+   result.filter();
+   result.compress();
+
+   return result;
+}
+
+std::size_t PNGPayload::frame_stego_capacity() const {
+   std::size_t result = 0;
+
+   for (auto &frame : this->frames())
+      result += stripe_capacity(frame, true);
+
+   return result;
+}
+
+bool PNGPayload::has_frame_stego_payload() const {
+   std::vector<std::pair<StegoStripe, std::size_t>> stripes;
+   auto bad_stripe = find_stego_stripes(frame_payloads(*this, true), stripes, this->executor());
+
+   return !stripes.empty() && !bad_stripe.has_value();
+}
+
+PNGPayload PNGPayload::create_frame_stego_payload(const void *ptr, std::size_t size) const {
+   if (this->frame_count() == 0) { throw exception::ChunkNotFound("fcTL"); }
+
+   auto frames = frame_payloads(*this, false);
+   auto carrier = stego_carrier_type(*this);
+   auto converting = carrier != this->header().pixel_type();
+   std::vector<std::size_t> capacities(frames.size());
+
+   for (std::size_t i=0; i<frames.size(); ++i)
+      capacities[i] = stripe_capacity(frames[i], true);
+
+   StageTimer timer(this->statistics.get(), STAGE_DEFLATE);
+   auto compressed = facade::compress(ptr, size, 9, this->memory_resource());
+   timer.set_bytes(size, compressed.size());
+   timer.stop();
+
+   std::vector<std::optional<StegoStripe>> frame_stripes(frames.size());
+
+   for (auto &stripe : plan_stego_stripes(compressed.size(), capacities))
+      frame_stripes[stripe.second] = stripe.first;
+
+   /* every frame is its own zlib stream, so each is inflated, embedded, filtered and deflated on its own worker. frames
+      without a stripe are only touched if the pixel type changes, since they have to change with it. */
+   this->executor().parallel_for(frames.size(), [&](std::size_t i) {
+      if (!frame_stripes[i].has_value() && !converting) { return; }
+
+      auto &frame = frames[i];
+      frame.load(carrier);
+
+      if (frame_stripes[i].has_value())
+      {
+         auto block = stripe_block(*frame_stripes[i], compressed, frame.memory_resource());
+         frame.write_stego_data(block.data(), block.size(), 0);
+      }
+
+      frame.filter();
+      frame.compress();
+   });
+
+   auto result = *this;
+
+   if (converting)
+   {
+      if (result.default_image_is_frame())
+      {
+         /* the default image is replaced by the first frame below, so only the pixel format has to follow it */
+         auto &converted = frames.front();
+
+         result.header().set_bit_depth(converted.header().bit_depth());
+         result.header().set_color_type(converted.header().color_type());
+
+         for (auto tag : { png::fourcc("PLTE"), png::fourcc("tRNS"), png::fourcc("sBIT"), png::fourcc("bKGD"), png::fourcc("hIST") })
+            result.erase_chunks(tag);
+
+         for (auto tag : { png::fourcc("PLTE"), png::fourcc("tRNS") })
+            if (converted.has_chunk(tag)) { result.add_chunk(converted.get_chunks(tag).front()); }
+      }
+      else
+      {
+         result.load(carrier);
+         result.filter();
+         result.compress();
+      }
+   }
+
+   for (std::size_t i=0; i<frames.size(); ++i)
+      if (frame_stripes[i].has_value() || converting) { result.set_frame(i, frames[i]); }
+
+   return result;
+}
+
+PNGPayload PNGPayload::create_frame_stego_payload(const std::vector<std::uint8_t> &data) const {
+   return this->create_frame_stego_payload(data.data(), data.size());
+}
 
-   return facade::decompress(this->read_stego_data(7*8, size_val));
+std::vector<std::uint8_t> PNGPayload::extract_frame_stego_payload() const {
+   return join_stego_stripes(frame_payloads(*this, true), this->executor());
 }
 
 ICOPayload &ICOPayload::operator=(const ICOPayload &other) {
    this->_index = other._index;
    this->_payload = other._payload;
+   this->workers = other.workers;
    ico::Icon::operator=(other);
 
    return *this;
@@ -285,6 +1138,10 @@ PNGPayload &ICOPayload::operator*(void) {
    return this->png_payload();
 }
 
+bool ICOPayload::has_png(void) const {
+   return this->_payload.has_value();
+}
+
 PNGPayload &ICOPayload::png_payload(void) {
    if (!this->_payload.has_value())
       throw exception::NoPNGIcon();
@@ -299,27 +1156,215 @@ const PNGPayload &ICOPayload::png_payload(void) const {
    return *this->_payload;
 }
 
-void ICOPayload::find_png(void) {
+std::size_t ICOPayload::png_index(void) const {
+   if (!this->_index.has_value())
+      throw exception::NoPNGIcon();
+
+   return *this->_index;
+}
+
+Executor &ICOPayload::executor(void) const {
+   return (this->workers == nullptr) ? facade::default_executor() : *this->workers;
+}
+
+void ICOPayload::set_executor(Executor *executor) {
+   this->workers = executor;
+   if (this->_payload.has_value()) { this->_payload->set_executor(executor); }
+}
+
+std::vector<std::size_t> ICOPayload::png_indexes(void) const {
+   std::vector<std::size_t> result;
+
    for (std::size_t i=0; i<this->size(); ++i)
-   {
-      if (this->entry_type(i) != ico::Icon::EntryType::ENTRY_PNG)
-         continue;
-      
-      this->_index = i;
-      this->_payload = PNGPayload(this->get_entry(i).second);
-      return;
-   }
+      if (this->entry_type(i) == ico::Icon::EntryType::ENTRY_PNG) { result.push_back(i); }
 
-   throw exception::NoPNGIcon();
+   return result;
+}
+
+std::vector<PNGPayload> ICOPayload::png_payloads(bool load) const {
+   auto indexes = this->png_indexes();
+   std::vector<PNGPayload> result(indexes.size());
+
+   this->executor().parallel_for(indexes.size(), [&](std::size_t i) {
+      if (this->_payload.has_value() && this->_index == indexes[i])
+         result[i] = *this->_payload;
+      else
+      {
+         auto &entry = this->get_entry(indexes[i]);
+         result[i] = PNGPayload(entry.data(), entry.size(), this->memory_resource());
+         result[i].set_executor(this->workers);
+      }
+
+      if (load && !result[i].is_loaded()) { result[i].load(); }
+   });
+
+   return result;
+}
+
+void ICOPayload::select_first_png(void) {
+   auto indexes = this->png_indexes();
+   if (!indexes.empty()) { this->select_png(indexes.front()); }
+}
+
+void ICOPayload::find_png(void) {
+   auto indexes = this->png_indexes();
+
+   if (indexes.empty())
+      throw exception::NoPNGIcon();
+
+   this->select_png(indexes.front());
+}
+
+void ICOPayload::select_png(std::size_t index) {
+   if (this->entry_type(index) != ico::Icon::EntryType::ENTRY_PNG)
+      throw exception::NoPNGIcon();
+
+   auto &entry = this->get_entry(index);
+   this->_payload = PNGPayload(entry.data(), entry.size(), this->memory_resource());
+   this->_payload->set_executor(this->workers);
+   this->_index = index;
 }
 
 void ICOPayload::reset_png(void) {
-   this->_payload = PNGPayload(this->get_entry(*this->_index).second);
+   this->select_png(this->png_index());
 }
 
 void ICOPayload::set_png(void) {
    if (!this->_index.has_value() || !this->_payload.has_value())
       throw exception::NoPNGIcon();
    
-   this->set_entry(*this->_index, this->get_entry(*this->_index).first, this->_payload->to_file());
+   this->set_entry(*this->_index, this->get_entry(*this->_index).dir_entry, this->_payload->to_file());
+}
+
+std::size_t ICOPayload::striped_stego_capacity(void) const {
+   std::size_t result = 0;
+
+   for (auto &image : this->png_payloads())
+      result += stripe_capacity(image, true);
+
+   return result;
+}
+
+bool ICOPayload::has_striped_stego_payload(void) const {
+   std::vector<std::pair<StegoStripe, std::size_t>> stripes;
+   auto bad_stripe = find_stego_stripes(this->png_payloads(true), stripes, this->executor());
+
+   return !stripes.empty() && !bad_stripe.has_value();
+}
+
+ICOPayload ICOPayload::create_striped_stego_payload(const void *ptr, std::size_t size) const {
+   auto indexes = this->png_indexes();
+   if (indexes.empty()) { throw exception::NoPNGIcon(); }
+
+   auto images = this->png_payloads();
+   std::vector<std::size_t> capacities(images.size());
+
+   for (std::size_t i=0; i<images.size(); ++i)
+      capacities[i] = stripe_capacity(images[i], true);
+
+   auto compressed = facade::compress(ptr, size, 9, this->memory_resource());
+   auto stripes = plan_stego_stripes(compressed.size(), capacities);
+   std::vector<std::vector<std::uint8_t>> encoded(stripes.size());
+
+   this->executor().parallel_for(stripes.size(), [&](std::size_t s) {
+      auto &image = images[stripes[s].second];
+      auto block = stripe_block(stripes[s].first, compressed, image.memory_resource());
+
+      if (!image.is_loaded()) { image.load(); }
+
+      image.convert(stego_carrier_type(image));
+      image.write_stego_data(block.data(), block.size(), 0);
+      image.filter();
+      image.compress();
+      encoded[s] = image.to_file();
+   });
+
+   auto result = *this;
+   bool primary_striped = false;
+
+   for (std::size_t s=0; s<stripes.size(); ++s)
+   {
+      auto index = indexes[stripes[s].second];
+
+      result.set_entry(index, result.get_entry(index).dir_entry, encoded[s]);
+      if (result._index == index) { primary_striped = true; }
+   }
+
+   if (primary_striped) { result.reset_png(); }
+
+   return result;
+}
+
+ICOPayload ICOPayload::create_striped_stego_payload(const std::vector<std::uint8_t> &data) const {
+   return this->create_striped_stego_payload(data.data(), data.size());
+}
+
+std::vector<std::uint8_t> ICOPayload::extract_striped_stego_payload(void) const {
+   return join_stego_stripes(this->png_payloads(true), this->executor());
+}
+
+std::vector<std::size_t> ICOPayload::bmp_indexes(void) const {
+   std::vector<std::size_t> result;
+
+   for (std::size_t i=0; i<this->size(); ++i)
+      if (this->entry_type(i) == ico::Icon::EntryType::ENTRY_BMP && bitmap_layout(this->get_entry(i)).has_value())
+         result.push_back(i);
+
+   return result;
+}
+
+std::size_t ICOPayload::bmp_stego_capacity(std::size_t index) const {
+   if (this->entry_type(index) != ico::Icon::EntryType::ENTRY_BMP) { throw exception::NoBMPIcon(index); }
+
+   auto layout = bitmap_layout(this->get_entry(index));
+   if (!layout.has_value()) { throw exception::NoBMPIcon(index); }
+
+   auto max_size = (layout->width * layout->height * 3) / 2;
+
+   return (max_size > 3 + 4 + 3) ? max_size - (3 + 4 + 3) : 0;
+}
+
+bool ICOPayload::has_bmp_stego_payload(std::size_t index) const {
+   if (this->entry_type(index) != ico::Icon::EntryType::ENTRY_BMP) { throw exception::NoBMPIcon(index); }
+
+   auto &entry = this->get_entry(index);
+   auto layout = bitmap_layout(entry);
+   if (!layout.has_value()) { throw exception::NoBMPIcon(index); }
+
+   return bitmap_stego_size(entry.data(), *layout).has_value();
+}
+
+ICOPayload ICOPayload::create_bmp_stego_payload(std::size_t index, const void *ptr, std::size_t size) const {
+   auto capacity = this->bmp_stego_capacity(index);
+   auto &entry = this->get_entry(index);
+   auto layout = bitmap_layout(entry);
+
+   auto compressed = facade::compress(ptr, size, 9, this->memory_resource());
+   if (compressed.size() > capacity) { throw exception::ImageTooSmall(capacity, compressed.size()); }
+
+   auto block = stego_block(compressed, this->memory_resource());
+   auto data = entry.to_vector();
+   write_bitmap_stego_data(data.data(), *layout, block.data(), block.size());
+
+   auto result = *this;
+   result.set_entry(index, entry.dir_entry, data);
+
+   return result;
+}
+
+ICOPayload ICOPayload::create_bmp_stego_payload(std::size_t index, const std::vector<std::uint8_t> &data) const {
+   return this->create_bmp_stego_payload(index, data.data(), data.size());
+}
+
+std::vector<std::uint8_t> ICOPayload::extract_bmp_stego_payload(std::size_t index) const {
+   if (this->entry_type(index) != ico::Icon::EntryType::ENTRY_BMP) { throw exception::NoBMPIcon(index); }
+
+   auto &entry = this->get_entry(index);
+   auto layout = bitmap_layout(entry);
+   if (!layout.has_value()) { throw exception::NoBMPIcon(index); }
+
+   auto size = bitmap_stego_size(entry.data(), *layout);
+   if (!size.has_value()) { throw exception::NoStegoData(); }
+
+   return facade::decompress(read_bitmap_stego_data(entry.data(), *layout, 3 + 4, *size));
 }
@@ -1,12 +1,21 @@
 #include <facade.hpp>
 
+#include <unordered_set>
+
+#if defined(LIBFACADE_X86)
+#if defined(LIBFACADE_WIN32)
+#include <intrin.h>
+#endif
+#include <immintrin.h>
+#endif
+
 using namespace facade;
 using namespace facade::png;
 
 const std::uint8_t Image::Signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
 
 bool ChunkTag::operator==(const ChunkTag &other) const {
-   return this->tag() == other.tag();
+   return std::memcmp(this->tag(), other.tag(), 4) == 0;
 }
 
 void ChunkTag::set_tag(const std::string tag) {
@@ -26,12 +35,22 @@ const std::uint8_t *ChunkTag::tag() const { return &this->_tag[0]; }
          
 std::string ChunkTag::to_string() const { return std::string(&this->_tag[0], &this->_tag[4]); }
 
+std::uint32_t ChunkTag::fourcc() const {
+   return (static_cast<std::uint32_t>(this->_tag[0]) << 24)
+      | (static_cast<std::uint32_t>(this->_tag[1]) << 16)
+      | (static_cast<std::uint32_t>(this->_tag[2]) << 8)
+      | static_cast<std::uint32_t>(this->_tag[3]);
+}
+
 bool ChunkVec::operator==(const ChunkVec &other) const {
-   return this->tag() == other.tag() && this->data() == other.data();
+   if (!(this->tag() == other.tag())) { return false; }
+
+   /* copies sharing a buffer are trivially equal */
+   return this->_data == other._data || this->data() == other.data();
 }
 
 std::size_t ChunkVec::length() const {
-   return this->_data.size();
+   return this->_data->size();
 }
 
 ChunkTag &ChunkVec::tag() {
@@ -42,16 +61,46 @@ const ChunkTag &ChunkVec::tag() const {
    return this->_tag;
 }
 
+ChunkVec &ChunkVec::operator=(const ChunkVec &other) {
+   if (this == &other) { return *this; }
+
+   this->_tag = other._tag;
+   this->_data = other._data;
+
+   std::scoped_lock lock(this->_cache_mutex, other._cache_mutex);
+   this->_cache = other._cache;
+
+   return *this;
+}
+
+void ChunkVec::invalidate_cache() const {
+   std::lock_guard<std::mutex> lock(this->_cache_mutex);
+   this->_cache = Cache();
+}
+
 std::vector<std::uint8_t> &ChunkVec::data() {
-   return this->_data;
+   this->invalidate_cache();
+
+   if (this->_data.use_count() > 1)
+      this->_data = std::make_shared<std::vector<std::uint8_t>>(*this->_data);
+   else
+      /* pairs with the release of the last other owner, so its reads finish before we write */
+      std::atomic_thread_fence(std::memory_order_acquire);
+   
+   return *this->_data;
 }
 
 const std::vector<std::uint8_t> &ChunkVec::data() const {
-   return this->_data;
+   return *this->_data;
 }
 
 void ChunkVec::set_data(std::vector<std::uint8_t> &vec) {
-   this->_data = vec;
+   this->_data = std::make_shared<std::vector<std::uint8_t>>(vec);
+   this->invalidate_cache();
+}
+
+bool ChunkVec::is_shared() const {
+   return this->_data.use_count() > 1;
 }
 
 std::uint32_t ChunkVec::crc() const {
@@ -90,6 +139,13 @@ const ChunkVec &ChunkVec::as_chunk_vec() const {
    return *static_cast<const ChunkVec *>(this);
 }
 
+/* chunk fields sit at arbitrary offsets in the file buffer, so they're copied out rather than dereferenced. */
+static std::uint32_t read_u32(const void *ptr) {
+   std::uint32_t value;
+   std::memcpy(&value, ptr, sizeof(value));
+   return value;
+}
+
 ChunkPtr ChunkPtr::parse(const void *ptr, std::size_t size, std::size_t offset) {
    if (ptr == nullptr) { throw exception::NullPointer(); }
    if (size == 0) { throw exception::NoData(); }
@@ -105,7 +161,7 @@ ChunkPtr ChunkPtr::parse(const void *ptr, std::size_t size, std::size_t offset)
    offset += sizeof(ChunkTag);
 
    auto data_ptr = &u8_ptr[offset];
-   auto length = endian_swap_32(*reinterpret_cast<const std::uint32_t *>(length_ptr));
+   auto length = endian_swap_32(read_u32(length_ptr));
    offset += length;
    if (offset >= size) { throw exception::OutOfBounds(offset, size); }
    if (offset+sizeof(std::uint32_t) > size) { throw exception::OutOfBounds(offset+sizeof(std::uint32_t), size); }
@@ -124,7 +180,7 @@ ChunkPtr ChunkPtr::parse(const std::vector<std::uint8_t> &vec, std::size_t offse
 std::size_t ChunkPtr::length() const {
    if (this->_length == nullptr) { throw exception::NullPointer(); }
 
-   return endian_swap_32(*this->_length);
+   return endian_swap_32(read_u32(this->_length));
 }
 
 ChunkTag ChunkPtr::tag() const {
@@ -145,7 +201,7 @@ std::vector<std::uint8_t> ChunkPtr::data() const {
 std::uint32_t ChunkPtr::crc() const {
    if (this->_crc == nullptr) { throw exception::NullPointer(); }
 
-   return endian_swap_32(*this->_crc);
+   return endian_swap_32(read_u32(this->_crc));
 }
 
 bool ChunkPtr::validate() const {
@@ -407,6 +463,23 @@ std::size_t Header::pixel_size() const {
 }
 
 std::size_t Header::buffer_size() const {
+   if (this->interlace_method() == 1)
+   {
+      std::size_t result = 0;
+
+      /* passes with no pixels in them have no scanlines, not even a filter byte */
+      for (auto &pass : ADAM7_PASSES)
+      {
+         auto pass_width = pass.width(this->width());
+         auto pass_height = pass.height(this->height());
+         if (pass_width == 0 || pass_height == 0) { continue; }
+
+         result += pass_height * ((pass_width * this->pixel_size() + 7) / 8 + 1);
+      }
+
+      return result;
+   }
+   
    auto scanline = this->width() * this->pixel_size();
    auto padded_scanline = scanline + ((scanline % 8 != 0) ? 8 - scanline % 8 : 0);
       
@@ -414,21 +487,17 @@ std::size_t Header::buffer_size() const {
 }
 
 std::optional<std::size_t> Text::null_terminator() const {
-   if (this->data().size() == 0) { return std::nullopt; }
-
-   std::size_t zero = 0;
+   std::lock_guard<std::mutex> lock(this->_cache_mutex);
+   if (this->_cache.has_null_terminator) { return this->_cache.null_terminator; }
 
-   while (zero < this->data().size())
-   {
-      if (this->data()[zero] == 0)
-         break;
+   auto zero = std::find(this->data().begin(), this->data().end(), 0);
 
-      ++zero;
-   }
+   this->_cache.has_null_terminator = true;
+   this->_cache.null_terminator = std::nullopt;
 
-   if (zero >= this->data().size()) { return std::nullopt; }
+   if (zero != this->data().end()) { this->_cache.null_terminator = std::distance(this->data().begin(), zero); }
 
-   return zero;
+   return this->_cache.null_terminator;
 }
 
 std::size_t Text::text_offset() const {
@@ -441,11 +510,15 @@ std::size_t Text::text_offset() const {
 bool Text::has_keyword() const { return this->null_terminator().has_value(); }
 
 std::string Text::keyword() const {
-   if (!this->has_keyword()) { throw exception::NoKeyword(); }
+   return std::string(this->keyword_view());
+}
 
+std::string_view Text::keyword_view() const {
    auto zero = this->null_terminator();
+   
+   if (!zero.has_value()) { throw exception::NoKeyword(); }
 
-   return std::string(&this->data()[0], &this->data()[*zero]);
+   return std::string_view(reinterpret_cast<const char *>(this->data().data()), *zero);
 }
 
 void Text::set_keyword(std::string keyword, bool validate) {
@@ -458,6 +531,7 @@ void Text::set_keyword(std::string keyword, bool validate) {
    }
    
    this->data().insert(this->data().begin(), &keyword.c_str()[0], &keyword.c_str()[keyword.size()+1]);
+   this->invalidate_cache();
 }
 
 bool Text::has_text() const {
@@ -467,32 +541,40 @@ bool Text::has_text() const {
 }
 
 std::string Text::text() const {
-   return std::string(&this->data().at(this->text_offset()), &this->data().at(this->data().size()-1)+1);
+   return std::string(this->text_view());
+}
+
+std::string_view Text::text_view() const {
+   auto offset = this->text_offset();
+
+   if (offset >= this->data().size()) { return std::string_view(); }
+
+   return std::string_view(reinterpret_cast<const char *>(&this->data()[offset]), this->data().size() - offset);
 }
 
 void Text::set_text(std::string text) {
    if (this->has_text())
-      this->data().erase(std::next(this->data().begin(), this->text_offset()), this->data().end());
+   {
+      auto offset = this->text_offset();
+      this->data().erase(std::next(this->data().begin(), offset), this->data().end());
+   }
 
    this->data().insert(this->data().end(), text.begin(), text.end());
+   this->invalidate_cache();
 }
 
 std::optional<std::size_t> ZText::null_terminator() const {
-   if (this->data().size() == 0) { return std::nullopt; }
-
-   std::size_t zero = 0;
+   std::lock_guard<std::mutex> lock(this->_cache_mutex);
+   if (this->_cache.has_null_terminator) { return this->_cache.null_terminator; }
 
-   while (zero < this->data().size())
-   {
-      if (this->data()[zero] == 0)
-         break;
+   auto zero = std::find(this->data().begin(), this->data().end(), 0);
 
-      ++zero;
-   }
+   this->_cache.has_null_terminator = true;
+   this->_cache.null_terminator = std::nullopt;
 
-   if (zero >= this->data().size() || zero == 0) { return std::nullopt; }
+   if (zero != this->data().end() && zero != this->data().begin()) { this->_cache.null_terminator = std::distance(this->data().begin(), zero); }
 
-   return zero;
+   return this->_cache.null_terminator;
 }
 
 std::size_t ZText::text_offset() const {
@@ -505,11 +587,15 @@ std::size_t ZText::text_offset() const {
 bool ZText::has_keyword() const { return this->null_terminator().has_value(); }
 
 std::string ZText::keyword() const {
-   if (!this->has_keyword()) { throw exception::NoKeyword(); }
+   return std::string(this->keyword_view());
+}
 
+std::string_view ZText::keyword_view() const {
    auto zero = this->null_terminator();
+   
+   if (!zero.has_value()) { throw exception::NoKeyword(); }
 
-   return std::string(&this->data()[0], &this->data()[*zero]);
+   return std::string_view(reinterpret_cast<const char *>(this->data().data()), *zero);
 }
 
 void ZText::set_keyword(std::string keyword, bool validate) {
@@ -522,6 +608,7 @@ void ZText::set_keyword(std::string keyword, bool validate) {
    }
    
    this->data().insert(this->data().begin(), &keyword.c_str()[0], &keyword.c_str()[keyword.size()+1]);
+   this->invalidate_cache();
 }
 
 std::uint8_t ZText::compression_method() const {
@@ -541,6 +628,8 @@ void ZText::set_compression_method(std::uint8_t compression_method) {
 
    if (*zero+1 == this->data().size()) { this->data().push_back(compression_method); }
    else { this->data()[*zero+1] = compression_method; }
+
+   this->invalidate_cache();
 }
 
 bool ZText::has_text() const {
@@ -550,14 +639,32 @@ bool ZText::has_text() const {
 }
 
 std::string ZText::text() const {
-   auto data = std::vector<std::uint8_t>(&this->data().at(this->text_offset()), &this->data().at(this->data().size()-1)+1);
-   auto decompressed = facade::decompress(data);
-   return std::string(decompressed.begin(), decompressed.end());
+   return std::string(this->text_view());
+}
+
+std::string_view ZText::text_view() const {
+   /* text_offset takes the cache lock itself */
+   auto offset = this->text_offset();
+   std::lock_guard<std::mutex> lock(this->_cache_mutex);
+
+   /* the inflated text is only dropped by mutable accessors, so the view outlives the lock */
+   if (this->_cache.inflated == nullptr)
+   {
+      if (offset >= this->data().size()) { throw exception::OutOfBounds(offset, this->data().size()); }
+      
+      auto decompressed = facade::decompress(&this->data()[offset], this->data().size() - offset);
+      this->_cache.inflated = std::make_shared<const std::string>(decompressed.begin(), decompressed.end());
+   }
+
+   return *this->_cache.inflated;
 }
 
 void ZText::set_text(std::string text) {
    if (this->has_text())
-      this->data().erase(std::next(this->data().begin(), this->text_offset()), this->data().end());
+   {
+      auto offset = this->text_offset();
+      this->data().erase(std::next(this->data().begin(), offset), this->data().end());
+   }
 
    if (this->data().size() == 0 || (this->has_keyword() && this->data().size() == this->keyword().size()+1)) { this->data().push_back(0); }
 
@@ -565,38 +672,326 @@ void ZText::set_text(std::string text) {
    auto compressed = facade::compress(vec_data, 9);
 
    this->data().insert(this->data().end(), compressed.begin(), compressed.end());
+   this->invalidate_cache();
+}
+
+std::optional<std::size_t> BinaryData::null_terminator() const {
+   if (this->data().size() == 0) { return std::nullopt; }
+
+   auto zero = std::find(this->data().begin(), this->data().end(), 0);
+
+   if (zero == this->data().end() || zero == this->data().begin()) { return std::nullopt; }
+
+   return std::distance(this->data().begin(), zero);
+}
+
+std::size_t BinaryData::payload_offset() const {
+   auto zero = this->null_terminator();
+
+   if (zero.has_value()) { return *zero+2; }
+   else { return 1; }
+}
+
+bool BinaryData::has_keyword() const { return this->null_terminator().has_value(); }
+
+std::string BinaryData::keyword() const {
+   return std::string(this->keyword_view());
+}
+
+std::string_view BinaryData::keyword_view() const {
+   auto zero = this->null_terminator();
+   
+   if (!zero.has_value()) { throw exception::NoKeyword(); }
+
+   return std::string_view(reinterpret_cast<const char *>(this->data().data()), *zero);
+}
+
+void BinaryData::set_keyword(std::string keyword, bool validate) {
+   if (validate && keyword.size() > 79) { throw exception::KeywordTooLong(); }
+
+   if (this->has_keyword())
+   {
+      auto zero = this->null_terminator();
+      this->data().erase(this->data().begin(), std::next(this->data().begin(), *zero+1));
+   }
+   
+   this->data().insert(this->data().begin(), &keyword.c_str()[0], &keyword.c_str()[keyword.size()+1]);
+}
+
+std::uint8_t BinaryData::codec() const {
+   if (!this->has_keyword()) { throw exception::NoKeyword(); }
+   
+   auto zero = this->null_terminator();
+
+   if (*zero+1 == this->data().size()) { throw exception::OutOfBounds(*zero+1, this->data().size()); }
+
+   return this->data()[*zero+1];
+}
+
+bool BinaryData::has_payload() const {
+   return this->has_keyword() && this->data().size() > this->payload_offset();
+}
+
+std::vector<std::uint8_t> BinaryData::payload() const {
+   if (!this->has_payload()) { return std::vector<std::uint8_t>(); }
+
+   auto offset = this->payload_offset();
+   auto size = this->data().size() - offset;
+
+   switch (this->codec())
+   {
+   case BINARY_RAW:
+      return std::vector<std::uint8_t>(std::next(this->data().begin(), offset), this->data().end());
+
+   case BINARY_ZLIB:
+      return facade::decompress(&this->data()[offset], size);
+
+   default:
+      throw exception::UnsupportedBinaryCodec(this->codec());
+   }
+}
+
+void BinaryData::set_payload(const void *ptr, std::size_t size, std::uint8_t codec) {
+   if (!this->has_keyword()) { throw exception::NoKeyword(); }
+   if (codec != BINARY_RAW && codec != BINARY_ZLIB) { throw exception::UnsupportedBinaryCodec(codec); }
+
+   auto zero = this->null_terminator();
+   auto u8_ptr = reinterpret_cast<const std::uint8_t *>(ptr);
+
+   this->data().resize(*zero+1);
+   this->data().push_back(codec);
+
+   if (codec == BINARY_ZLIB)
+   {
+      auto compressed = facade::compress(ptr, size, 9);
+      this->data().insert(this->data().end(), compressed.begin(), compressed.end());
+   }
+   else
+      this->data().insert(this->data().end(), &u8_ptr[0], &u8_ptr[size]);
+}
+
+void BinaryData::set_payload(const std::vector<std::uint8_t> &data, std::uint8_t codec) {
+   this->set_payload(data.data(), data.size(), codec);
+}
+
+/* big-endian fields of the fixed-size animation chunks, checked against the size the chunk is meant to have. */
+static std::uint32_t get_field_32(const ChunkVec &chunk, std::size_t size, std::size_t offset) {
+   if (chunk.length() != size) { throw exception::InsufficientSize(chunk.length(), size); }
+   return endian_swap_32(read_u32(&chunk.data()[offset]));
+}
+
+static void set_field_32(ChunkVec &chunk, std::size_t size, std::size_t offset, std::uint32_t value) {
+   if (chunk.length() != size) { throw exception::InsufficientSize(chunk.length(), size); }
+   value = endian_swap_32(value);
+   std::memcpy(&chunk.data()[offset], &value, sizeof(value));
+}
+
+static std::uint16_t get_field_16(const ChunkVec &chunk, std::size_t size, std::size_t offset) {
+   if (chunk.length() != size) { throw exception::InsufficientSize(chunk.length(), size); }
+   return static_cast<std::uint16_t>((chunk.data()[offset] << 8) | chunk.data()[offset+1]);
+}
+
+static void set_field_16(ChunkVec &chunk, std::size_t size, std::size_t offset, std::uint16_t value) {
+   if (chunk.length() != size) { throw exception::InsufficientSize(chunk.length(), size); }
+   chunk.data()[offset] = static_cast<std::uint8_t>(value >> 8);
+   chunk.data()[offset+1] = static_cast<std::uint8_t>(value & 0xFF);
+}
+
+static std::uint8_t get_field_8(const ChunkVec &chunk, std::size_t size, std::size_t offset) {
+   if (chunk.length() != size) { throw exception::InsufficientSize(chunk.length(), size); }
+   return chunk.data()[offset];
+}
+
+static void set_field_8(ChunkVec &chunk, std::size_t size, std::size_t offset, std::uint8_t value) {
+   if (chunk.length() != size) { throw exception::InsufficientSize(chunk.length(), size); }
+   chunk.data()[offset] = value;
+}
+
+std::uint32_t AnimationControl::frames() const { return get_field_32(*this, 8, 0); }
+void AnimationControl::set_frames(std::uint32_t frames) { set_field_32(*this, 8, 0, frames); }
+std::uint32_t AnimationControl::plays() const { return get_field_32(*this, 8, 4); }
+void AnimationControl::set_plays(std::uint32_t plays) { set_field_32(*this, 8, 4, plays); }
+
+std::uint32_t FrameControl::sequence_number() const { return get_field_32(*this, 26, 0); }
+void FrameControl::set_sequence_number(std::uint32_t sequence_number) { set_field_32(*this, 26, 0, sequence_number); }
+std::uint32_t FrameControl::width() const { return get_field_32(*this, 26, 4); }
+void FrameControl::set_width(std::uint32_t width) { set_field_32(*this, 26, 4, width); }
+std::uint32_t FrameControl::height() const { return get_field_32(*this, 26, 8); }
+void FrameControl::set_height(std::uint32_t height) { set_field_32(*this, 26, 8, height); }
+std::uint32_t FrameControl::x_offset() const { return get_field_32(*this, 26, 12); }
+void FrameControl::set_x_offset(std::uint32_t x_offset) { set_field_32(*this, 26, 12, x_offset); }
+std::uint32_t FrameControl::y_offset() const { return get_field_32(*this, 26, 16); }
+void FrameControl::set_y_offset(std::uint32_t y_offset) { set_field_32(*this, 26, 16, y_offset); }
+std::uint16_t FrameControl::delay_numerator() const { return get_field_16(*this, 26, 20); }
+void FrameControl::set_delay_numerator(std::uint16_t delay_numerator) { set_field_16(*this, 26, 20, delay_numerator); }
+std::uint16_t FrameControl::delay_denominator() const { return get_field_16(*this, 26, 22); }
+void FrameControl::set_delay_denominator(std::uint16_t delay_denominator) { set_field_16(*this, 26, 22, delay_denominator); }
+std::uint8_t FrameControl::dispose_op() const { return get_field_8(*this, 26, 24); }
+void FrameControl::set_dispose_op(std::uint8_t dispose_op) { set_field_8(*this, 26, 24, dispose_op); }
+std::uint8_t FrameControl::blend_op() const { return get_field_8(*this, 26, 25); }
+void FrameControl::set_blend_op(std::uint8_t blend_op) { set_field_8(*this, 26, 25, blend_op); }
+
+/* expands each possible byte of packed samples into its 8, 4 or 2 samples, most significant bits first. */
+template <std::size_t Bits>
+struct SampleTable
+{
+   std::uint8_t samples[256][8/Bits];
+
+   constexpr SampleTable() : samples() {
+      for (std::size_t byte=0; byte<256; ++byte)
+         for (std::size_t i=0; i<8/Bits; ++i)
+            this->samples[byte][i] = static_cast<std::uint8_t>((byte >> (8 - Bits - i * Bits)) & ((1 << Bits) - 1));
+   }
+};
+
+template <std::size_t Bits>
+static void unpack_samples_table(const std::uint8_t *packed, std::size_t count, std::uint8_t *unpacked) {
+   static constexpr SampleTable<Bits> table;
+   constexpr std::size_t per_byte = 8 / Bits;
+   auto full = count / per_byte;
+
+   for (std::size_t i=0; i<full; ++i)
+      std::memcpy(&unpacked[i * per_byte], table.samples[packed[i]], per_byte);
+
+   if (count % per_byte != 0)
+      std::memcpy(&unpacked[full * per_byte], table.samples[packed[full]], count % per_byte);
+}
+
+#if defined(LIBFACADE_X86)
+/* each block packs 16 samples into 2, 4 or 8 bytes. 1-bit samples are reversed within each half so that movemask
+   puts the first sample in the top bit, 2- and 4-bit samples are combined pairwise with multiply-adds. returns the
+   number of packed bytes written. */
+template <std::size_t Bits>
+LIBFACADE_TARGET("ssse3")
+static std::size_t pack_samples_ssse3(const std::uint8_t *in, std::size_t bytes, std::uint8_t *out) {
+   constexpr std::size_t per_block = 16 * Bits / 8;
+   const __m128i mask = _mm_set1_epi8((1 << Bits) - 1);
+   std::size_t o = 0;
+
+   for (; o+per_block <= bytes; o += per_block)
+   {
+      __m128i block = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + o * 8 / Bits)), mask);
+
+      if constexpr (Bits == 1)
+      {
+         block = _mm_shuffle_epi8(block, _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8));
+         auto bits = _mm_movemask_epi8(_mm_slli_epi64(block, 7));
+         out[o] = static_cast<std::uint8_t>(bits & 0xFF);
+         out[o+1] = static_cast<std::uint8_t>(bits >> 8);
+      }
+      else if constexpr (Bits == 2)
+      {
+         block = _mm_maddubs_epi16(block, _mm_set1_epi16(0x0104));
+         block = _mm_madd_epi16(block, _mm_set1_epi32(0x00010010));
+         block = _mm_packus_epi16(_mm_packs_epi32(block, block), block);
+         auto packed = _mm_cvtsi128_si32(block);
+         std::memcpy(&out[o], &packed, 4);
+      }
+      else
+      {
+         block = _mm_maddubs_epi16(block, _mm_set1_epi16(0x0110));
+         _mm_storel_epi64(reinterpret_cast<__m128i *>(out + o), _mm_packus_epi16(block, block));
+      }
+   }
+
+   return o;
+}
+#endif
+
+template <std::size_t Bits>
+static void pack_samples_bits(const std::uint8_t *unpacked, std::size_t count, std::uint8_t *packed) {
+   constexpr std::size_t per_byte = 8 / Bits;
+   constexpr std::uint8_t mask = (1 << Bits) - 1;
+   auto full = count / per_byte;
+   std::size_t i = 0;
+
+#if defined(LIBFACADE_X86)
+   if (facade::cpu_has_ssse3())
+      i = pack_samples_ssse3<Bits>(unpacked, full, packed);
+#endif
+
+   for (; i<full; ++i)
+   {
+      std::uint8_t byte = 0;
+
+      for (std::size_t j=0; j<per_byte; ++j)
+         byte = (byte << Bits) | (unpacked[i * per_byte + j] & mask);
+
+      packed[i] = byte;
+   }
+
+   /* merge the trailing samples into whatever the final byte already holds */
+   for (std::size_t j=0; j<count % per_byte; ++j)
+   {
+      auto shift = 8 - Bits - j * Bits;
+      packed[full] = (packed[full] & ~(mask << shift)) | ((unpacked[full * per_byte + j] & mask) << shift);
+   }
+}
+
+void facade::png::unpack_samples(const std::uint8_t *packed, std::size_t count, std::size_t bits, std::uint8_t *unpacked) {
+   switch (bits)
+   {
+   case 1: unpack_samples_table<1>(packed, count, unpacked); break;
+   case 2: unpack_samples_table<2>(packed, count, unpacked); break;
+   case 4: unpack_samples_table<4>(packed, count, unpacked); break;
+   case 8: if (count > 0) { std::memcpy(unpacked, packed, count); } break;
+   default: throw exception::InvalidBitDepth(static_cast<std::uint8_t>(bits));
+   }
+}
+
+void facade::png::pack_samples(const std::uint8_t *unpacked, std::size_t count, std::size_t bits, std::uint8_t *packed) {
+   switch (bits)
+   {
+   case 1: pack_samples_bits<1>(unpacked, count, packed); break;
+   case 2: pack_samples_bits<2>(unpacked, count, packed); break;
+   case 4: pack_samples_bits<4>(unpacked, count, packed); break;
+   case 8: if (count > 0) { std::memcpy(packed, unpacked, count); } break;
+   default: throw exception::InvalidBitDepth(static_cast<std::uint8_t>(bits));
+   }
 }
 
 template <typename PixelType>
 ScanlineBase<PixelType> ScanlineBase<PixelType>::read_line(const std::vector<std::uint8_t> &raw_data, std::size_t offset, std::size_t width) {
-   if (offset >= raw_data.size()) { throw exception::OutOfBounds(offset, raw_data.size()); }
+   return ScanlineBase<PixelType>::read_line(raw_data.data(), raw_data.size(), offset, width);
+}
+
+template <typename PixelType>
+ScanlineBase<PixelType> ScanlineBase<PixelType>::read_line(const std::uint8_t *raw_data, std::size_t size, std::size_t offset, std::size_t width,
+                                                           std::pmr::memory_resource *resource)
+{
+   if (offset >= size) { throw exception::OutOfBounds(offset, size); }
    
    auto filter_type = raw_data[offset];
    auto bit_width = PixelType::Bits * width;
    auto byte_width = bit_width / 8 + static_cast<int>(bit_width % 8 != 0);
-   if (offset+1+byte_width > raw_data.size()) { throw exception::OutOfBounds(offset+1+byte_width, raw_data.size()); }
+   if (offset+1+byte_width > size) { throw exception::OutOfBounds(offset+1+byte_width, size); }
 
    auto sample_width = (width / Span::Samples) + static_cast<int>(width % Span::Samples != 0);
    auto span_ptr = reinterpret_cast<const Span *>(&raw_data[offset+1]);
-   auto span_vec = std::vector<Span>(&span_ptr[0], &span_ptr[sample_width]);
 
-   return ScanlineBase<PixelType>(filter_type, span_vec);
+   return ScanlineBase<PixelType>(filter_type, span_ptr, sample_width, resource);
+}
+
+template <typename PixelType>
+std::vector<ScanlineBase<PixelType>> ScanlineBase<PixelType>::from_raw(const Header &header, const std::vector<std::uint8_t> &raw_data) {
+   return ScanlineBase<PixelType>::from_raw(header, raw_data.data(), raw_data.size());
 }
 
 template <typename PixelType>
-std::vector<ScanlineBase<PixelType>> ScanlineBase<PixelType>::from_raw(const Header &header, const std::vector<std::uint8_t> &raw_data)
+std::vector<ScanlineBase<PixelType>> ScanlineBase<PixelType>::from_raw(const Header &header, const std::uint8_t *raw_data, std::size_t size,
+                                                                       std::pmr::memory_resource *resource)
 {
    auto width = header.width();
-   auto pixel_size = header.pixel_size();
    auto buffer_size = header.buffer_size();
-   if (raw_data.size() != buffer_size) { throw exception::PixelMismatch(); }
+   if (size != buffer_size) { throw exception::PixelMismatch(); }
 
    auto bit_width = PixelType::Bits * width;
    auto byte_width = bit_width / 8 + static_cast<int>(bit_width % 8 != 0);
    std::vector<ScanlineBase<PixelType>> result;
+   result.reserve(header.height());
 
    for (std::size_t i=0; i<buffer_size; i+=byte_width+1)
-      result.push_back(ScanlineBase<PixelType>::read_line(raw_data, i, width));
+      result.push_back(ScanlineBase<PixelType>::read_line(raw_data, size, i, width, resource));
 
    return result;
 }
@@ -616,13 +1011,35 @@ template <typename PixelType>
 #if !defined(LIBFACADE_WIN32)
 __attribute__((used)) // on gcc with optimization and shared objects compiled this function disappears, so tell gcc not to do that
 #endif
-const std::vector<typename ScanlineBase<PixelType>::Span> &ScanlineBase<PixelType>::pixel_data() const {
-   return this->_pixel_data;
+const PixelRow<PixelType> &ScanlineBase<PixelType>::pixel_data() const {
+   return *this->_pixel_data;
+
+}
+
+template <typename PixelType>
+std::pmr::memory_resource *ScanlineBase<PixelType>::memory_resource() const {
+   return this->_pixel_data->get_allocator().resource();
+}
+
+template <typename PixelType>
+bool ScanlineBase<PixelType>::is_shared() const {
+   return this->_pixel_data.use_count() > 1;
+}
+
+template <typename PixelType>
+PixelRow<PixelType> &ScanlineBase<PixelType>::mutable_pixel_data() {
+   if (this->_pixel_data.use_count() > 1)
+      /* the private copy comes from the same resource as the row it was copied from */
+      this->_pixel_data = make_pixel_data(this->memory_resource(), *this->_pixel_data);
+   else
+      /* pairs with the release of the last other owner, so its reads finish before we write */
+      std::atomic_thread_fence(std::memory_order_acquire);
 
+   return *this->_pixel_data;
 }
 
 template <typename PixelType>
-std::size_t ScanlineBase<PixelType>::pixel_span() const { return this->_pixel_data.size(); }
+std::size_t ScanlineBase<PixelType>::pixel_span() const { return this->_pixel_data->size(); }
 
 template <typename PixelType>
 std::size_t ScanlineBase<PixelType>::pixel_width() const { return this->pixel_span() * Span::Samples; }
@@ -631,21 +1048,21 @@ template <typename PixelType>
 typename ScanlineBase<PixelType>::Span &ScanlineBase<PixelType>::get_span(std::size_t index) {
    if (index > this->pixel_span()) { throw exception::OutOfBounds(index, this->pixel_span()); }
 
-   return this->_pixel_data[index];
+   return this->mutable_pixel_data()[index];
 }
 
 template <typename PixelType>
 const typename ScanlineBase<PixelType>::Span &ScanlineBase<PixelType>::get_span(std::size_t index) const {
    if (index > this->pixel_span()) { throw exception::OutOfBounds(index, this->pixel_span()); }
 
-   return this->_pixel_data[index];
+   return (*this->_pixel_data)[index];
 }
 
 template <typename PixelType>
 void ScanlineBase<PixelType>::set_span(const typename ScanlineBase<PixelType>::Span &span, std::size_t index) {
    if (index > this->pixel_span()) { throw exception::OutOfBounds(index, this->pixel_span()); }
 
-   this->_pixel_data[index] = span;
+   this->mutable_pixel_data()[index] = span;
 }
 
 template <typename PixelType>
@@ -663,6 +1080,68 @@ void ScanlineBase<PixelType>::set_pixel(const Pixel &pixel, std::size_t index)
    this->get_span(index / Span::Samples).set(pixel, index % Span::Samples);
 }
 
+template <typename PixelType>
+void ScanlineBase<PixelType>::unpack_samples(std::uint8_t *samples, std::size_t count) const {
+   if constexpr (PixelType::Bits > 8) { throw exception::PixelMismatch(); }
+   else {
+      if (count > this->pixel_width()) { throw exception::OutOfBounds(count, this->pixel_width()); }
+
+      png::unpack_samples(reinterpret_cast<const std::uint8_t *>(this->_pixel_data->data()), count, PixelType::Bits, samples);
+   }
+}
+
+template <typename PixelType>
+std::vector<std::uint8_t> ScanlineBase<PixelType>::unpack_samples() const {
+   std::vector<std::uint8_t> result(this->pixel_width());
+   this->unpack_samples(result.data(), result.size());
+
+   return result;
+}
+
+template <typename PixelType>
+void ScanlineBase<PixelType>::pack_samples(const std::uint8_t *samples, std::size_t count) {
+   if constexpr (PixelType::Bits > 8) { throw exception::PixelMismatch(); }
+   else {
+      if (count > this->pixel_width()) { throw exception::OutOfBounds(count, this->pixel_width()); }
+
+      png::pack_samples(samples, count, PixelType::Bits, reinterpret_cast<std::uint8_t *>(this->mutable_pixel_data().data()));
+   }
+}
+
+template <typename PixelType>
+void ScanlineBase<PixelType>::pack_samples(const std::vector<std::uint8_t> &samples) {
+   this->pack_samples(samples.data(), samples.size());
+}
+
+template <typename PixelType>
+SampleView<std::uint16_t> ScanlineBase<PixelType>::samples_16() {
+   if constexpr (!std::is_same<typename PixelType::Base, std::uint16_t>::value) { throw exception::PixelMismatch(); }
+   else {
+      auto &pixel_data = this->mutable_pixel_data();
+
+      return SampleView<std::uint16_t>(reinterpret_cast<std::uint8_t *>(pixel_data.data()),
+                                       pixel_data.size() * PixelType::Bits / 16);
+   }
+}
+
+template <typename PixelType>
+SampleView<const std::uint16_t> ScanlineBase<PixelType>::samples_16() const {
+   if constexpr (!std::is_same<typename PixelType::Base, std::uint16_t>::value) { throw exception::PixelMismatch(); }
+   else {
+      return SampleView<const std::uint16_t>(reinterpret_cast<const std::uint8_t *>(this->_pixel_data->data()),
+                                             this->_pixel_data->size() * PixelType::Bits / 16);
+   }
+}
+
+template <typename PixelType>
+void ScanlineBase<PixelType>::swap_endian() {
+   if constexpr (std::is_same<typename PixelType::Base, std::uint16_t>::value)
+   {
+      auto samples = this->samples_16();
+      facade::endian_swap_16(samples.data(), samples.size());
+   }
+}
+
 template <typename PixelType>
 std::vector<std::uint8_t> ScanlineBase<PixelType>::to_raw() const {
    std::vector<std::uint8_t> result;
@@ -670,19 +1149,28 @@ std::vector<std::uint8_t> ScanlineBase<PixelType>::to_raw() const {
    result.push_back(this->filter_type());
 
    //auto raw_pixels = pixels_to_raw<PixelType>(this->_pixel_data);
-   auto raw_pixels = reinterpret_cast<const std::uint8_t *>(this->_pixel_data.data());
-   auto raw_pixel_size = this->_pixel_data.size() * sizeof(PixelType);
+   auto raw_pixels = reinterpret_cast<const std::uint8_t *>(this->_pixel_data->data());
+   auto raw_pixel_size = this->_pixel_data->size() * sizeof(PixelType);
    result.insert(result.end(), &raw_pixels[0], &raw_pixels[raw_pixel_size]);
 
    return result;
 }
 
+template <typename PixelType>
+void ScanlineBase<PixelType>::to_raw(std::pmr::vector<std::uint8_t> &buffer) const {
+   auto raw_pixels = reinterpret_cast<const std::uint8_t *>(this->_pixel_data->data());
+   auto raw_pixel_size = this->_pixel_data->size() * sizeof(PixelType);
+
+   buffer.push_back(this->filter_type());
+   buffer.insert(buffer.end(), &raw_pixels[0], &raw_pixels[raw_pixel_size]);
+}
+
 template <typename PixelType>
 ScanlineBase<PixelType> ScanlineBase<PixelType>::reconstruct(std::optional<ScanlineBase<PixelType>> previous) const
 {
    if (this->filter_type() == 0) { return *this; }
    if (previous.has_value() && previous->pixel_span() != this->pixel_span()) { throw exception::ScanlineMismatch(); }
-   if (this->_pixel_data.size() == 0) { throw exception::NoPixels(); }
+   if (this->_pixel_data->size() == 0) { throw exception::NoPixels(); }
 
    auto result = *this;
    std::size_t pixel_size = sizeof(Span);
@@ -782,8 +1270,8 @@ template <typename PixelType>
 ScanlineBase<PixelType> ScanlineBase<PixelType>::filter(FilterType filter_type, std::optional<ScanlineBase<PixelType>> previous) const
 {
    if (this->filter_type() != 0) { throw exception::AlreadyFiltered(); }
-   if (previous.has_value() && previous->_pixel_data.size() != this->_pixel_data.size()) { throw exception::ScanlineMismatch(); }
-   if (this->_pixel_data.size() == 0) { throw exception::NoPixels(); }
+   if (previous.has_value() && previous->_pixel_data->size() != this->_pixel_data->size()) { throw exception::ScanlineMismatch(); }
+   if (this->_pixel_data->size() == 0) { throw exception::NoPixels(); }
    if (filter_type == FilterType::NONE) { return *this; }
 
    auto result = *this;
@@ -854,6 +1342,24 @@ ScanlineBase<PixelType> ScanlineBase<PixelType>::filter(FilterType filter_type,
    return result;
 }
 
+/* the raw-buffer and memory resource overloads aren't reached through the Scanline variant, so make sure every
+   scanline type is compiled in full */
+template class facade::png::ScanlineBase<GrayscalePixel1Bit>;
+template class facade::png::ScanlineBase<GrayscalePixel2Bit>;
+template class facade::png::ScanlineBase<GrayscalePixel4Bit>;
+template class facade::png::ScanlineBase<GrayscalePixel8Bit>;
+template class facade::png::ScanlineBase<GrayscalePixel16Bit>;
+template class facade::png::ScanlineBase<TrueColorPixel8Bit>;
+template class facade::png::ScanlineBase<TrueColorPixel16Bit>;
+template class facade::png::ScanlineBase<PalettePixel1Bit>;
+template class facade::png::ScanlineBase<PalettePixel2Bit>;
+template class facade::png::ScanlineBase<PalettePixel4Bit>;
+template class facade::png::ScanlineBase<PalettePixel8Bit>;
+template class facade::png::ScanlineBase<AlphaGrayscalePixel8Bit>;
+template class facade::png::ScanlineBase<AlphaGrayscalePixel16Bit>;
+template class facade::png::ScanlineBase<AlphaTrueColorPixel8Bit>;
+template class facade::png::ScanlineBase<AlphaTrueColorPixel16Bit>;
+
 Pixel Scanline::operator[](std::size_t index) const { return this->get_pixel(index); }
 
 std::uint8_t Scanline::filter_type() const {
@@ -880,14 +1386,43 @@ void Scanline::set_pixel(const Pixel &pixel, std::size_t index) {
    std::visit([&pixel, &index](auto &p) { p.set_pixel(pixel, index); }, *static_cast<ScanlineVariant *>(this));
 }
 
+std::vector<std::uint8_t> Scanline::unpack_samples() const {
+   return std::visit([](auto &p) -> std::vector<std::uint8_t> { return p.unpack_samples(); }, *static_cast<const ScanlineVariant *>(this));
+}
+
+void Scanline::pack_samples(const std::vector<std::uint8_t> &samples) {
+   std::visit([&samples](auto &p) { p.pack_samples(samples); }, *static_cast<ScanlineVariant *>(this));
+}
+
+void Scanline::swap_endian() {
+   std::visit([](auto &p) { p.swap_endian(); }, *static_cast<ScanlineVariant *>(this));
+}
+
 std::vector<std::uint8_t> Scanline::to_raw() const {
    return std::visit([](auto &p) -> std::vector<std::uint8_t> { return p.to_raw(); }, *static_cast<const ScanlineVariant *>(this));
 }
 
+void Scanline::to_raw(std::pmr::vector<std::uint8_t> &buffer) const {
+   std::visit([&buffer](auto &p) { p.to_raw(buffer); }, *static_cast<const ScanlineVariant *>(this));
+}
+
 Image &Image::operator=(const Image &other) {
-   this->chunk_map = other.chunk_map;
+   this->chunks = other.chunks;
+   this->chunk_index = other.chunk_index;
+
+   if (this != &other)
+   {
+      std::scoped_lock lock(this->keyword_index_mutex, other.keyword_index_mutex);
+      this->keyword_index = other.keyword_index;
+      this->keyword_pending = other.keyword_pending;
+   }
+
    this->trailing_data = other.trailing_data;
    this->image_data = other.image_data;
+   this->native_endian = other.native_endian;
+   this->resource = other.resource;
+   this->statistics = other.statistics;
+   this->workers = other.workers;
 
    return *this;
 }
@@ -900,44 +1435,403 @@ const Scanline &Image::operator[](std::size_t index) const {
    return this->scanline(index);
 }
 
-bool Image::has_chunk(const std::string &tag) const {
-   return this->chunk_map.find(tag) != this->chunk_map.end();
-}
+std::size_t Image::insertion_offset(std::uint32_t tag) const {
+   /* chunks which the specification requires to come before the image data */
+   static const std::uint32_t before_idat[] = {
+      fourcc("PLTE"), fourcc("tRNS"), fourcc("cHRM"), fourcc("gAMA"), fourcc("iCCP"), fourcc("sBIT"), fourcc("sRGB"),
+      fourcc("cICP"), fourcc("bKGD"), fourcc("hIST"), fourcc("pHYs"), fourcc("sPLT"), fourcc("acTL"),
+   };
+   
+   if (tag == fourcc("IHDR")) { return 0; }
+   if (tag == fourcc("IEND")) { return this->chunks.size(); }
 
-std::vector<ChunkVec> Image::get_chunks(const std::string &tag) const {
-   if (!this->has_chunk(tag)) { throw exception::ChunkNotFound(tag); }
-   return this->chunk_map.at(tag);
+   auto end = this->chunks.size();
+   auto iend = this->chunk_index.find(fourcc("IEND"));
+   if (iend != this->chunk_index.end()) { end = iend->second.front(); }
+
+   auto idat = this->chunk_index.find(fourcc("IDAT"));
+   if (idat == this->chunk_index.end()) { return end; }
+
+   /* keep IDAT chunks consecutive */
+   if (tag == fourcc("IDAT")) { return idat->second.back()+1; }
+
+   if (std::find(std::begin(before_idat), std::end(before_idat), tag) != std::end(before_idat))
+      return std::min(end, idat->second.front());
+
+   return end;
+}
+
+ChunkVec &Image::insert_chunk(std::size_t offset, const ChunkVec &chunk) {
+   if (offset > this->chunks.size()) { throw exception::OutOfBounds(offset, this->chunks.size()); }
+
+   /* the reference handed out for the pending chunk is invalidated from here on */
+   this->rekey_pending_chunk();
+
+   /* shift the indexed offsets of everything after the insertion point, back to front so offsets stay unique */
+   for (auto i=this->chunks.size(); i>offset; --i)
+      this->reoffset_chunk(this->chunks[i-1], i-1, i);
+
+   this->chunks.insert(std::next(this->chunks.begin(), offset), chunk);
+
+   auto tag = chunk.tag().fourcc();
+   auto &offsets = this->chunk_index[tag];
+   offsets.insert(std::upper_bound(offsets.begin(), offsets.end(), offset), offset);
+
+   auto keyword = Image::indexed_keyword(chunk);
+
+   if (keyword.has_value())
+   {
+      auto &keyword_offsets = this->keyword_index[tag][std::string(*keyword)];
+      keyword_offsets.insert(std::upper_bound(keyword_offsets.begin(), keyword_offsets.end(), offset), offset);
+   }
+
+   return this->chunks[offset];
+}
+
+void Image::erase_chunk(std::size_t offset) {
+   if (offset >= this->chunks.size()) { throw exception::OutOfBounds(offset, this->chunks.size()); }
+
+   this->rekey_pending_chunk();
+
+   auto tag = this->chunks[offset].tag().fourcc();
+   auto &offsets = this->chunk_index[tag];
+   offsets.erase(std::lower_bound(offsets.begin(), offsets.end(), offset));
+   if (offsets.size() == 0) { this->chunk_index.erase(tag); }
+
+   auto keyword = Image::indexed_keyword(this->chunks[offset]);
+
+   if (keyword.has_value())
+   {
+      auto &keywords = this->keyword_index[tag];
+      auto entry = keywords.find(std::string(*keyword));
+      auto &keyword_offsets = entry->second;
+      
+      keyword_offsets.erase(std::lower_bound(keyword_offsets.begin(), keyword_offsets.end(), offset));
+      if (keyword_offsets.size() == 0) { keywords.erase(entry); }
+   }
+
+   this->chunks.erase(std::next(this->chunks.begin(), offset));
+
+   for (auto i=offset; i<this->chunks.size(); ++i)
+      this->reoffset_chunk(this->chunks[i], i+1, i);
+}
+
+void Image::reoffset_chunk(const ChunkVec &chunk, std::size_t from, std::size_t to) {
+   auto tag = chunk.tag().fourcc();
+   auto &offsets = this->chunk_index[tag];
+   *std::lower_bound(offsets.begin(), offsets.end(), from) = to;
+
+   auto keyword = Image::indexed_keyword(chunk);
+   if (!keyword.has_value()) { return; }
+
+   auto &keyword_offsets = this->keyword_index[tag][std::string(*keyword)];
+   *std::lower_bound(keyword_offsets.begin(), keyword_offsets.end(), from) = to;
+}
+
+void Image::erase_chunks(std::uint32_t tag) {
+   if (!this->has_chunk(tag)) { return; }
+   
+   this->chunks.erase(std::remove_if(this->chunks.begin(),
+                                     this->chunks.end(),
+                                     [tag](const ChunkVec &chunk) { return chunk.tag().fourcc() == tag; }),
+                      this->chunks.end());
+   this->reindex();
+}
+
+std::optional<std::size_t> Image::find_chunk(const ChunkVec &chunk) const {
+   const std::vector<std::size_t> *offsets = nullptr;
+   auto tag = chunk.tag().fourcc();
+   auto keyword = Image::indexed_keyword(chunk);
+
+   /* keyword chunks only need to be compared against chunks sharing their keyword */
+   if (keyword.has_value())
+      offsets = this->keyword_offsets(tag, std::string(*keyword));
+   else
+   {
+      auto entry = this->chunk_index.find(tag);
+      if (entry != this->chunk_index.end()) { offsets = &entry->second; }
+   }
+
+   if (offsets == nullptr) { return std::nullopt; }
+
+   for (auto offset : *offsets)
+      if (this->chunks[offset] == chunk)
+         return offset;
+
+   return std::nullopt;
+}
+
+void Image::reindex() {
+   this->chunk_index.clear();
+
+   for (std::size_t i=0; i<this->chunks.size(); ++i)
+      this->chunk_index[this->chunks[i].tag().fourcc()].push_back(i);
+
+   this->reindex_keywords();
+}
+
+void Image::reindex_keywords() const {
+   this->keyword_index.clear();
+   this->keyword_pending = std::nullopt;
+
+   for (std::size_t i=0; i<this->chunks.size(); ++i)
+   {
+      auto keyword = Image::indexed_keyword(this->chunks[i]);
+      if (!keyword.has_value()) { continue; }
+
+      this->keyword_index[this->chunks[i].tag().fourcc()][std::string(*keyword)].push_back(i);
+   }
+}
+
+void Image::rekey_pending_chunk() const {
+   if (!this->keyword_pending.has_value()) { return; }
+
+   auto [offset, indexed] = *this->keyword_pending;
+   this->keyword_pending = std::nullopt;
+
+   auto &chunk = this->chunks[offset];
+   auto keyword = Image::indexed_keyword(chunk);
+   if (keyword == indexed) { return; }
+
+   auto tag = chunk.tag().fourcc();
+   auto &keywords = this->keyword_index[tag];
+
+   if (indexed.has_value())
+   {
+      auto entry = keywords.find(*indexed);
+      auto &keyword_offsets = entry->second;
+
+      keyword_offsets.erase(std::lower_bound(keyword_offsets.begin(), keyword_offsets.end(), offset));
+      if (keyword_offsets.size() == 0) { keywords.erase(entry); }
+   }
+
+   if (keyword.has_value())
+   {
+      auto &keyword_offsets = keywords[std::string(*keyword)];
+      keyword_offsets.insert(std::upper_bound(keyword_offsets.begin(), keyword_offsets.end(), offset), offset);
+   }
+}
+
+std::optional<std::string_view> Image::indexed_keyword(const ChunkVec &chunk) {
+   switch (chunk.tag().fourcc())
+   {
+   case fourcc("tEXt"):
+   {
+      auto &text = chunk.upcast<Text>();
+      if (text.has_keyword()) { return text.keyword_view(); }
+      break;
+   }
+   case fourcc("zTXt"):
+   {
+      auto &ztext = chunk.upcast<ZText>();
+      if (ztext.has_keyword()) { return ztext.keyword_view(); }
+      break;
+   }
+   case fourcc("faCd"):
+   {
+      auto &binary = chunk.upcast<BinaryData>();
+      if (binary.has_keyword()) { return binary.keyword_view(); }
+      break;
+   }
+   }
+
+   return std::nullopt;
+}
+
+const std::vector<std::size_t> *Image::keyword_offsets(std::uint32_t tag, const std::string &keyword) const {
+   std::lock_guard<std::mutex> lock(this->keyword_index_mutex);
+   this->rekey_pending_chunk();
+
+   /* the offsets stay put until the image is changed, which already invalidates the views made from them */
+   auto keywords = this->keyword_index.find(tag);
+   if (keywords == this->keyword_index.end()) { return nullptr; }
+
+   auto entry = keywords->second.find(keyword);
+   if (entry == keywords->second.end()) { return nullptr; }
+
+   return &entry->second;
+}
+
+bool Image::has_chunk(const std::string &tag) const {
+   if (tag.size() != 4) { return false; }
+
+   return this->has_chunk(ChunkTag(tag).fourcc());
 }
 
-void Image::add_chunk(const ChunkVec &chunk) {
-   auto tag = chunk.tag().to_string();
-   this->chunk_map[tag].push_back(chunk);
+bool Image::has_chunk(std::uint32_t tag) const {
+   return this->chunk_index.find(tag) != this->chunk_index.end();
+}
+
+ChunkView<> Image::get_chunks(const std::string &tag) const {
+   if (!this->has_chunk(tag)) { throw exception::ChunkNotFound(tag); }
+
+   return this->get_chunks(ChunkTag(tag).fourcc());
 }
 
-bool Image::has_trailing_data() const { return this->trailing_data.has_value(); }
+ChunkView<> Image::get_chunks(std::uint32_t tag) const {
+   auto entry = this->chunk_index.find(tag);
+
+   if (entry == this->chunk_index.end())
+   {
+      std::uint8_t tag_data[4] = {
+         static_cast<std::uint8_t>(tag >> 24),
+         static_cast<std::uint8_t>(tag >> 16),
+         static_cast<std::uint8_t>(tag >> 8),
+         static_cast<std::uint8_t>(tag)
+      };
+
+      throw exception::ChunkNotFound(ChunkTag(tag_data, 4).to_string());
+   }
+
+   return ChunkView<>(this->chunks, entry->second);
+}
+
+const std::vector<ChunkVec> &Image::get_all_chunks() const {
+   return this->chunks;
+}
+
+ChunkVec &Image::add_chunk(const ChunkVec &chunk) {
+   auto offset = this->insertion_offset(chunk.tag().fourcc());
+   auto &result = this->insert_chunk(offset, chunk);
+
+   /* the keyword can be changed through the returned reference until the image is next changed */
+   auto keyword = Image::indexed_keyword(result);
+   this->keyword_pending.emplace(offset, keyword.has_value() ? std::optional<std::string>(*keyword) : std::nullopt);
+
+   return result;
+}
+
+std::pmr::memory_resource *Image::memory_resource() const { return this->resource; }
+
+void Image::set_memory_resource(std::pmr::memory_resource *resource) { this->resource = resource; }
+
+Executor &Image::executor() const {
+   return (this->workers == nullptr) ? facade::default_executor() : *this->workers;
+}
+
+void Image::set_executor(Executor *executor) { this->workers = executor; }
+
+Stats &Image::enable_stats(bool trace) {
+   if (this->statistics == nullptr) { this->statistics = std::make_shared<Stats>(trace); }
+
+   return *this->statistics;
+}
+
+void Image::disable_stats() { this->statistics = nullptr; }
+
+std::shared_ptr<Stats> Image::stats() const { return this->statistics; }
+
+void Image::set_stats(std::shared_ptr<Stats> stats) { this->statistics = stats; }
+
+MemoryUsage Image::memory_usage() const {
+   MemoryUsage usage;
+
+   /* a shared_ptr control block made by make_shared holds the object and two counts */
+   const std::size_t control_block = sizeof(std::vector<std::uint8_t>) + 2 * sizeof(long);
+
+   /* copies of a chunk within one image can share a buffer too, so only count each buffer once */
+   std::unordered_set<const void *> seen;
+   usage.overhead += this->chunks.capacity() * sizeof(ChunkVec);
+
+   for (auto &chunk : this->chunks)
+   {
+      auto &data = chunk.data();
+      if (!seen.insert(&data).second) { continue; }
+
+      usage.chunk_data += data.capacity();
+      usage.overhead += control_block;
+
+      if (chunk.is_shared()) { usage.shared += data.capacity(); }
+   }
+
+   /* each node of the indexes holds a key, an offset vector and a next pointer */
+   for (auto &entry : this->chunk_index)
+      usage.overhead += sizeof(entry) + sizeof(void *) + entry.second.capacity() * sizeof(std::size_t);
+
+   {
+      std::lock_guard<std::mutex> lock(this->keyword_index_mutex);
+
+      for (auto &tag : this->keyword_index)
+      {
+         usage.overhead += sizeof(tag) + sizeof(void *);
+
+         for (auto &entry : tag.second)
+            usage.overhead += sizeof(entry) + sizeof(void *) + entry.first.capacity() + entry.second.capacity() * sizeof(std::size_t);
+      }
+   }
+
+   if (this->trailing_data != nullptr)
+   {
+      usage.trailing_data = this->trailing_data->capacity();
+      usage.overhead += control_block;
+
+      if (this->trailing_data.use_count() > 1) { usage.shared += usage.trailing_data; }
+   }
+
+   if (this->image_data.has_value())
+   {
+      usage.overhead += this->image_data->capacity() * sizeof(Scanline);
+
+      for (auto &scanline : *this->image_data)
+      {
+         std::visit([&usage, &control_block](auto &line) {
+            using Span = typename std::remove_reference_t<decltype(line.pixel_data())>::value_type;
+            auto bytes = line.pixel_data().capacity() * sizeof(Span);
+
+            usage.pixel_data += bytes;
+            usage.overhead += control_block;
+
+            if (line.is_shared()) { usage.shared += bytes; }
+         }, *static_cast<const ScanlineVariant *>(&scanline));
+      }
+   }
+
+   return usage;
+}
+
+bool Image::has_trailing_data() const { return this->trailing_data != nullptr; }
 
 std::vector<std::uint8_t> &Image::get_trailing_data() {
-   if (!this->trailing_data.has_value()) { throw exception::NoTrailingData(); }
+   if (this->trailing_data == nullptr) { throw exception::NoTrailingData(); }
+
+   if (this->trailing_data.use_count() > 1)
+      this->trailing_data = std::make_shared<std::vector<std::uint8_t>>(*this->trailing_data);
+   else
+      /* pairs with the release of the last other owner, so its reads finish before we write */
+      std::atomic_thread_fence(std::memory_order_acquire);
+   
    return *this->trailing_data;
 }
 
 const std::vector<std::uint8_t> &Image::get_trailing_data() const {
-   if (!this->trailing_data.has_value()) { throw exception::NoTrailingData(); }
+   if (this->trailing_data == nullptr) { throw exception::NoTrailingData(); }
    return *this->trailing_data;
 }
 
 void Image::set_trailing_data(const std::vector<std::uint8_t> &data) {
-   this->trailing_data = data;
+   this->trailing_data = std::make_shared<std::vector<std::uint8_t>>(data);
 }
 
-void Image::clear_trailing_data() { this->trailing_data = std::nullopt; }
+void Image::clear_trailing_data() { this->trailing_data = nullptr; }
+
+std::vector<EmbeddedFile> Image::scan_trailing_data() const {
+   if (this->trailing_data == nullptr) { throw exception::NoTrailingData(); }
+   return scan_signatures(*this->trailing_data, this->executor());
+}
 
 void Image::parse(const void *ptr, std::size_t size, bool validate) {
    if (size < 8) { throw exception::InsufficientSize(size, 8); }
    if (std::memcmp(ptr, this->Signature, 8) != 0) { throw exception::BadPNGSignature(); }
+
+   auto stats = this->statistics.get();
+   StageTimer timer(stats, STAGE_PARSE);
+   std::uint64_t crc_start = 0, crc_time = 0, crc_bytes = 0;
    
-   this->chunk_map.clear();
-   this->trailing_data = std::nullopt;
+   this->chunks.clear();
+   this->chunk_index.clear();
+   this->keyword_index.clear();
+   this->keyword_pending = std::nullopt;
+   this->trailing_data = nullptr;
    // this->image_data = std::nullopt;
    
    std::size_t offset = 8;
@@ -953,14 +1847,41 @@ void Image::parse(const void *ptr, std::size_t size, bool validate) {
       //std::cout << std::endl;
       
       auto chunk_vec = current_chunk.to_chunk_vec();
-      if (validate && !current_chunk.validate()) { throw exception::BadCRC(current_chunk.crc(), chunk_vec.crc()); }
+
+      if (validate)
+      {
+         /* CRC checks are summed up and recorded once, rather than flooding the trace with an event per chunk */
+         auto start = (stats != nullptr) ? Stats::now() : 0;
+         auto valid = current_chunk.validate();
+
+         if (stats != nullptr)
+         {
+            if (crc_start == 0) { crc_start = start; }
+            crc_time += Stats::now() - start;
+            crc_bytes += current_chunk.length() + sizeof(ChunkTag);
+         }
+
+         if (!valid) { throw exception::BadCRC(current_chunk.crc(), chunk_vec.crc()); }
+      }
       
-      this->chunk_map[chunk_vec.tag().to_string()].push_back(chunk_vec);
-   } while (current_chunk.tag().to_string() != "IEND");
+      /* parsed chunks keep their file order */
+      this->chunk_index[chunk_vec.tag().fourcc()].push_back(this->chunks.size());
+      this->chunks.push_back(chunk_vec);
+   } while (current_chunk.tag().fourcc() != fourcc("IEND"));
+
+   this->reindex_keywords();
 
    if (offset < size) {
       auto u8_ptr = reinterpret_cast<const std::uint8_t *>(ptr);
-      this->trailing_data = std::vector<std::uint8_t>(&u8_ptr[offset], &u8_ptr[size]);
+      this->trailing_data = std::make_shared<std::vector<std::uint8_t>>(&u8_ptr[offset], &u8_ptr[size]);
+   }
+
+   if (stats != nullptr)
+   {
+      if (validate) { stats->record(STAGE_CRC, crc_start, crc_time, crc_bytes, crc_bytes); }
+
+      stats->add_parsed_chunks(this->chunks.size());
+      timer.set_bytes(size, offset - 8);
    }
 }
 
@@ -969,13 +1890,54 @@ void Image::parse(const std::vector<std::uint8_t> &data, bool validate) {
 }
 
 void Image::parse(const std::string &filename, bool validate) {
+   StageTimer timer(this->statistics.get(), STAGE_READ);
    auto file_data = read_file(filename);
+   timer.set_bytes(file_data.size(), file_data.size());
+   timer.stop();
+
    this->parse(file_data, validate);
 }
 
-void Image::load() {
+void Image::load(bool native_endian) {
    this->decompress();
    this->reconstruct();
+
+   if (native_endian) { this->to_native_endian(); }
+}
+
+bool Image::is_native_endian() const {
+   return this->native_endian;
+}
+
+void Image::to_native_endian() {
+   if (!this->image_data.has_value()) { throw exception::NoImageData(); }
+   if (this->native_endian) { return; }
+
+   /* png order is big-endian, so there's only anything to swap on little-endian machines */
+#if !defined(LIBFACADE_BIG_ENDIAN)
+   if (this->header().bit_depth() == 16)
+   {
+      auto &image_data = *this->image_data;
+      this->executor().parallel_for(image_data.size(), [&image_data](std::size_t y) { image_data[y].swap_endian(); });
+   }
+#endif
+
+   this->native_endian = true;
+}
+
+void Image::to_png_endian() {
+   if (!this->image_data.has_value()) { throw exception::NoImageData(); }
+   if (!this->native_endian) { return; }
+
+#if !defined(LIBFACADE_BIG_ENDIAN)
+   if (this->header().bit_depth() == 16)
+   {
+      auto &image_data = *this->image_data;
+      this->executor().parallel_for(image_data.size(), [&image_data](std::size_t y) { image_data[y].swap_endian(); });
+   }
+#endif
+
+   this->native_endian = false;
 }
 
 Scanline &Image::scanline(std::size_t index) {
@@ -993,147 +1955,703 @@ const Scanline &Image::scanline(std::size_t index) const {
 }
    
 bool Image::has_header() const {
-   return this->has_chunk("IHDR");
+   return this->has_chunk(fourcc("IHDR"));
 }
 
 Header &Image::header() {
-   if (!this->has_header()) { throw exception::NoHeaderChunk(); }
+   auto entry = this->chunk_index.find(fourcc("IHDR"));
+   if (entry == this->chunk_index.end()) { throw exception::NoHeaderChunk(); }
 
-   return this->chunk_map["IHDR"][0].upcast<Header>();
+   return this->chunks[entry->second.front()].upcast<Header>();
 }
 
 const Header &Image::header() const {
-   if (!this->has_header()) { throw exception::NoHeaderChunk(); }
+   auto entry = this->chunk_index.find(fourcc("IHDR"));
+   if (entry == this->chunk_index.end()) { throw exception::NoHeaderChunk(); }
+
+   return this->chunks[entry->second.front()].upcast<Header>();
+}
+
+Header &Image::new_header() {
+   this->erase_chunks(fourcc("IHDR"));
+
+   return this->add_chunk(Header().as_chunk_vec()).upcast<Header>();
+}
+
+std::size_t Image::width() const {
+   auto &hdr = this->header();
+
+   return hdr.width();
+}
+
+std::size_t Image::height() const {
+   auto &hdr = this->header();
+
+   return hdr.height();
+}
+
+bool Image::has_image_data() const {
+   return this->has_chunk(fourcc("IDAT"));
+}
+
+bool Image::is_loaded() const {
+   return this->image_data.has_value();
+}
+
+/* call the visitor with a null pointer of the scanline type which holds the given pixel type. */
+template <typename Visitor>
+static void visit_scanline_type(PixelEnum pixel_type, Visitor &&visitor) {
+   switch (pixel_type)
+   {
+   case PixelEnum::GRAYSCALE_PIXEL_1BIT: visitor(static_cast<GrayscaleScanline1Bit *>(nullptr)); break;
+   case PixelEnum::GRAYSCALE_PIXEL_2BIT: visitor(static_cast<GrayscaleScanline2Bit *>(nullptr)); break;
+   case PixelEnum::GRAYSCALE_PIXEL_4BIT: visitor(static_cast<GrayscaleScanline4Bit *>(nullptr)); break;
+   case PixelEnum::GRAYSCALE_PIXEL_8BIT: visitor(static_cast<GrayscaleScanline8Bit *>(nullptr)); break;
+   case PixelEnum::GRAYSCALE_PIXEL_16BIT: visitor(static_cast<GrayscaleScanline16Bit *>(nullptr)); break;
+   case PixelEnum::TRUE_COLOR_PIXEL_8BIT: visitor(static_cast<TrueColorScanline8Bit *>(nullptr)); break;
+   case PixelEnum::TRUE_COLOR_PIXEL_16BIT: visitor(static_cast<TrueColorScanline16Bit *>(nullptr)); break;
+   case PixelEnum::PALETTE_PIXEL_1BIT: visitor(static_cast<PaletteScanline1Bit *>(nullptr)); break;
+   case PixelEnum::PALETTE_PIXEL_2BIT: visitor(static_cast<PaletteScanline2Bit *>(nullptr)); break;
+   case PixelEnum::PALETTE_PIXEL_4BIT: visitor(static_cast<PaletteScanline4Bit *>(nullptr)); break;
+   case PixelEnum::PALETTE_PIXEL_8BIT: visitor(static_cast<PaletteScanline8Bit *>(nullptr)); break;
+   case PixelEnum::ALPHA_GRAYSCALE_PIXEL_8BIT: visitor(static_cast<AlphaGrayscaleScanline8Bit *>(nullptr)); break;
+   case PixelEnum::ALPHA_GRAYSCALE_PIXEL_16BIT: visitor(static_cast<AlphaGrayscaleScanline16Bit *>(nullptr)); break;
+   case PixelEnum::ALPHA_TRUE_COLOR_PIXEL_8BIT: visitor(static_cast<AlphaTrueColorScanline8Bit *>(nullptr)); break;
+   case PixelEnum::ALPHA_TRUE_COLOR_PIXEL_16BIT: visitor(static_cast<AlphaTrueColorScanline16Bit *>(nullptr)); break;
+   }
+}
+
+/* the bit depth and color type of each pixel type, indexed by facade::png::PixelEnum. */
+static const std::uint8_t PIXEL_FORMATS[][2] = {
+   { 1, ColorType::GRAYSCALE },
+   { 2, ColorType::GRAYSCALE },
+   { 4, ColorType::GRAYSCALE },
+   { 8, ColorType::GRAYSCALE },
+   { 16, ColorType::GRAYSCALE },
+   { 8, ColorType::TRUE_COLOR },
+   { 16, ColorType::TRUE_COLOR },
+   { 1, ColorType::PALETTE },
+   { 2, ColorType::PALETTE },
+   { 4, ColorType::PALETTE },
+   { 8, ColorType::PALETTE },
+   { 8, ColorType::ALPHA_GRAYSCALE },
+   { 16, ColorType::ALPHA_GRAYSCALE },
+   { 8, ColorType::ALPHA_TRUE_COLOR },
+   { 16, ColorType::ALPHA_TRUE_COLOR },
+};
+
+/* get the pixels of a scanline in png byte order, without the filter byte. */
+static std::vector<std::uint8_t> png_order_row(const Scanline &scanline, bool native_endian, bool wide) {
+   auto raw = scanline.to_raw();
+   raw.erase(raw.begin());
+
+#if defined(LIBFACADE_BIG_ENDIAN)
+   static_cast<void>(native_endian);
+   static_cast<void>(wide);
+#else
+   if (native_endian && wide)
+      for (std::size_t i=0; i+1<raw.size(); i+=2)
+         std::swap(raw[i], raw[i+1]);
+#endif
+
+   return raw;
+}
+
+/* write a color key out as a one-pixel row of the given grayscale or true color type, or read it back. this lets the
+   key take the same path through facade::png::convert_row as the pixels it matches. */
+static std::vector<std::uint8_t> color_key_row(PixelEnum pixel_type, const std::array<std::uint16_t, 3> &key) {
+   auto bits = PIXEL_FORMATS[pixel_type][0];
+   std::size_t samples = (PIXEL_FORMATS[pixel_type][1] == ColorType::GRAYSCALE) ? 1 : 3;
+   std::vector<std::uint8_t> result;
+
+   for (std::size_t i=0; i<samples; ++i)
+   {
+      if (bits == 16)
+      {
+         result.push_back(static_cast<std::uint8_t>(key[i] >> 8));
+         result.push_back(static_cast<std::uint8_t>(key[i] & 0xFF));
+      }
+      else
+         result.push_back(static_cast<std::uint8_t>(key[i] << (8 - bits)));
+   }
+
+   return result;
+}
+
+static std::array<std::uint16_t, 3> color_key_value(PixelEnum pixel_type, const std::vector<std::uint8_t> &row) {
+   auto bits = PIXEL_FORMATS[pixel_type][0];
+   std::size_t samples = (PIXEL_FORMATS[pixel_type][1] == ColorType::GRAYSCALE) ? 1 : 3;
+   std::array<std::uint16_t, 3> result = { 0, 0, 0 };
+
+   for (std::size_t i=0; i<samples; ++i)
+   {
+      if (bits == 16)
+         result[i] = static_cast<std::uint16_t>((row[i*2] << 8) | row[i*2+1]);
+      else
+         result[i] = static_cast<std::uint16_t>(row[i] >> (8 - bits));
+   }
+
+   return result;
+}
+
+void Image::load(PixelEnum pixel_type, bool native_endian) {
+   this->decompress();
+   this->reconstruct();
+   this->convert(pixel_type);
+
+   if (native_endian) { this->to_native_endian(); }
+}
+
+ColorTable Image::color_table() const {
+   ColorTable result;
+   auto color_type = this->header().color_type();
+   const std::vector<std::uint8_t> *transparency = nullptr;
+
+   if (this->has_chunk(fourcc("tRNS"))) { transparency = &this->get_chunks(fourcc("tRNS")).front().data(); }
+
+   if (color_type == ColorType::PALETTE && this->has_chunk(fourcc("PLTE")))
+   {
+      auto &palette = this->get_chunks(fourcc("PLTE")).front().data();
+
+      for (std::size_t i=0; i+3<=palette.size(); i+=3)
+      {
+         auto entry = i / 3;
+         std::uint8_t alpha = (transparency != nullptr && entry < transparency->size()) ? (*transparency)[entry] : 0xFF;
+         std::uint8_t rgba[4] = { palette[i], palette[i+1], palette[i+2], alpha };
+
+         result.add_color(rgba);
+      }
+   }
+   else if (transparency != nullptr && color_type == ColorType::GRAYSCALE && transparency->size() >= 2)
+   {
+      auto &key = *transparency;
+      result.color_key = std::array<std::uint16_t, 3>({ static_cast<std::uint16_t>((key[0] << 8) | key[1]), 0, 0 });
+   }
+   else if (transparency != nullptr && color_type == ColorType::TRUE_COLOR && transparency->size() >= 6)
+   {
+      auto &key = *transparency;
+      result.color_key = std::array<std::uint16_t, 3>({ static_cast<std::uint16_t>((key[0] << 8) | key[1]),
+                                                        static_cast<std::uint16_t>((key[2] << 8) | key[3]),
+                                                        static_cast<std::uint16_t>((key[4] << 8) | key[5]) });
+   }
+
+   return result;
+}
+
+void Image::convert(PixelEnum pixel_type) {
+   if (!this->image_data.has_value()) { throw exception::NoImageData(); }
+
+   auto width = this->header().width();
+   auto target_size = row_size(pixel_type, width);
+   auto from = this->header().pixel_type();
+   if (from == pixel_type) { return; }
+
+   bool native = this->native_endian;
+   this->to_png_endian();
+
+   auto colors = this->color_table();
+   auto &image_data = *this->image_data;
+   std::vector<Scanline> converted(image_data.size());
+   auto target_format = PIXEL_FORMATS[pixel_type];
+   bool to_palette = target_format[1] == ColorType::PALETTE;
+   ColorTable target_colors;
+
+   auto store_row = [&](std::size_t y, const std::uint8_t *src, PixelEnum src_type, const ColorTable &table) {
+      std::vector<std::uint8_t> row(target_size+1, 0);
+      convert_row(src_type, src, pixel_type, &row[1], width, table);
+
+      visit_scanline_type(pixel_type, [&](auto *type) {
+         using ScanlineType = std::remove_pointer_t<decltype(type)>;
+         converted[y] = ScanlineType::read_line(row.data(), row.size(), 0, width, this->resource);
+      });
+   };
+
+   if (to_palette)
+   {
+      /* expand everything to rgba first, then gather the palette in the order colors first appear */
+      std::size_t limit = 1 << target_format[0];
+      std::vector<std::uint8_t> rgba(image_data.size() * width * 4);
+
+      this->executor().parallel_for(image_data.size(), [&](std::size_t y) {
+         auto raw = png_order_row(image_data[y], false, false);
+         convert_row(from, raw.data(), PixelEnum::ALPHA_TRUE_COLOR_PIXEL_8BIT, &rgba[y * width * 4], width, colors);
+      });
+
+      std::uint32_t last_color = 0;
+
+      for (std::size_t i=0; i<rgba.size(); i+=4)
+      {
+         std::uint32_t color;
+         std::memcpy(&color, &rgba[i], sizeof(color));
+         if (i > 0 && color == last_color) { continue; }
+
+         last_color = color;
+         if (target_colors.find_color(&rgba[i]).has_value()) { continue; }
+         if (target_colors.palette_size() == limit) { throw exception::TooManyColors(limit); }
+
+         target_colors.add_color(&rgba[i]);
+      }
+
+      this->executor().parallel_for(image_data.size(), [&](std::size_t y) {
+         store_row(y, &rgba[y * width * 4], PixelEnum::ALPHA_TRUE_COLOR_PIXEL_8BIT, target_colors);
+      });
+   }
+   else
+   {
+      this->executor().parallel_for(image_data.size(), [&](std::size_t y) {
+         auto raw = png_order_row(image_data[y], false, false);
+         store_row(y, raw.data(), from, colors);
+      });
+   }
+
+   this->image_data = std::move(converted);
+
+   auto &header = this->header();
+   header.set_bit_depth(target_format[0]);
+   header.set_color_type(target_format[1]);
+
+   for (auto tag : { fourcc("PLTE"), fourcc("tRNS"), fourcc("sBIT"), fourcc("bKGD"), fourcc("hIST") })
+      this->erase_chunks(tag);
+
+   if (to_palette)
+   {
+      std::vector<std::uint8_t> palette;
+      std::vector<std::uint8_t> alpha;
+
+      for (std::size_t i=0; i<target_colors.palette_size(); ++i)
+      {
+         auto color = target_colors.color(i);
+
+         palette.insert(palette.end(), color.begin(), color.begin()+3);
+         alpha.push_back(color[3]);
+      }
+
+      /* entries past the end of tRNS are opaque, so it only needs to reach the last transparent one */
+      while (!alpha.empty() && alpha.back() == 0xFF)
+         alpha.pop_back();
+
+      this->add_chunk(ChunkVec(std::string("PLTE"), palette));
+      if (!alpha.empty()) { this->add_chunk(ChunkVec(std::string("tRNS"), alpha)); }
+   }
+   else if (colors.color_key.has_value() && target_format[1] != ColorType::ALPHA_GRAYSCALE && target_format[1] != ColorType::ALPHA_TRUE_COLOR)
+   {
+      auto key_row = color_key_row(from, *colors.color_key);
+      std::vector<std::uint8_t> converted_key(row_size(pixel_type, 1));
+      convert_row(from, key_row.data(), pixel_type, converted_key.data(), 1);
+
+      auto key = color_key_value(pixel_type, converted_key);
+      std::vector<std::uint8_t> transparency;
+
+      for (std::size_t i=0; i<((target_format[1] == ColorType::GRAYSCALE) ? 1 : 3); ++i)
+      {
+         transparency.push_back(static_cast<std::uint8_t>(key[i] >> 8));
+         transparency.push_back(static_cast<std::uint8_t>(key[i] & 0xFF));
+      }
+
+      this->add_chunk(ChunkVec(std::string("tRNS"), transparency));
+   }
+
+   if (native) { this->to_native_endian(); }
+}
+
+PixelEnum Image::smallest_pixel_type() const {
+   if (!this->image_data.has_value()) { throw exception::NoImageData(); }
+
+   /* what each row needs to be stored without loss, merged once every row has been looked at */
+   struct RowNeeds
+   {
+      bool gray = true;
+      bool opaque = true;
+      bool fits_8 = true;
+      std::size_t gray_bits = 1;
+      std::unordered_set<std::uint32_t> colors;
+   };
+
+   auto &header = this->header();
+   auto from = header.pixel_type();
+   auto width = header.width();
+   bool wide = header.bit_depth() == 16;
+   auto rgba_type = wide ? PixelEnum::ALPHA_TRUE_COLOR_PIXEL_16BIT : PixelEnum::ALPHA_TRUE_COLOR_PIXEL_8BIT;
+   auto colors = this->color_table();
+   auto &image_data = *this->image_data;
+   std::vector<RowNeeds> rows(image_data.size());
+
+   this->executor().parallel_for(image_data.size(), [&](std::size_t y) {
+      auto raw = png_order_row(image_data[y], this->native_endian, wide);
+      std::vector<std::uint8_t> rgba(row_size(rgba_type, width));
+      convert_row(from, raw.data(), rgba_type, rgba.data(), width, colors);
+
+      auto &needs = rows[y];
+      std::size_t stride = wide ? 2 : 1;
+
+      if (wide)
+         for (std::size_t i=0; i<rgba.size() && needs.fits_8; i+=2)
+            needs.fits_8 = rgba[i] == rgba[i+1];
+
+      for (std::size_t x=0; x<width; ++x)
+      {
+         auto pixel = &rgba[x * 4 * stride];
+         std::uint8_t color[4] = { pixel[0], pixel[stride], pixel[stride*2], pixel[stride*3] };
+
+         needs.gray = needs.gray && color[0] == color[1] && color[1] == color[2];
+         needs.opaque = needs.opaque && color[3] == 0xFF && (!wide || pixel[stride*3+1] == 0xFF);
+
+         if (needs.gray && needs.gray_bits < 8)
+         {
+            if (color[0] % 17 != 0) { needs.gray_bits = 8; }
+            else if (color[0] % 85 != 0) { needs.gray_bits = std::max<std::size_t>(needs.gray_bits, 4); }
+            else if (color[0] % 255 != 0) { needs.gray_bits = std::max<std::size_t>(needs.gray_bits, 2); }
+         }
+
+         /* a palette holds 256 colors at most, so stop counting past that */
+         if (needs.colors.size() <= 256)
+         {
+            std::uint32_t packed;
+            std::memcpy(&packed, color, sizeof(packed));
+            needs.colors.insert(packed);
+         }
+      }
+   });
+
+   RowNeeds image;
+
+   for (auto &needs : rows)
+   {
+      image.gray = image.gray && needs.gray;
+      image.opaque = image.opaque && needs.opaque;
+      image.fits_8 = image.fits_8 && needs.fits_8;
+      image.gray_bits = std::max(image.gray_bits, needs.gray_bits);
+
+      if (image.colors.size() <= 256)
+         image.colors.insert(needs.colors.begin(), needs.colors.end());
+   }
+
+   if (!image.fits_8)
+   {
+      if (image.gray) { return image.opaque ? PixelEnum::GRAYSCALE_PIXEL_16BIT : PixelEnum::ALPHA_GRAYSCALE_PIXEL_16BIT; }
+
+      return image.opaque ? PixelEnum::TRUE_COLOR_PIXEL_16BIT : PixelEnum::ALPHA_TRUE_COLOR_PIXEL_16BIT;
+   }
+
+   PixelEnum best;
+   std::size_t best_bits;
+
+   if (image.gray && image.opaque)
+   {
+      best_bits = image.gray_bits;
+      best = (best_bits == 1) ? PixelEnum::GRAYSCALE_PIXEL_1BIT
+         : (best_bits == 2) ? PixelEnum::GRAYSCALE_PIXEL_2BIT
+         : (best_bits == 4) ? PixelEnum::GRAYSCALE_PIXEL_4BIT
+         : PixelEnum::GRAYSCALE_PIXEL_8BIT;
+   }
+   else if (image.gray)
+   {
+      best_bits = 16;
+      best = PixelEnum::ALPHA_GRAYSCALE_PIXEL_8BIT;
+   }
+   else if (image.opaque)
+   {
+      best_bits = 24;
+      best = PixelEnum::TRUE_COLOR_PIXEL_8BIT;
+   }
+   else
+   {
+      best_bits = 32;
+      best = PixelEnum::ALPHA_TRUE_COLOR_PIXEL_8BIT;
+   }
+
+   /* a palette costs a PLTE chunk, so only prefer one when it makes the pixels themselves smaller */
+   auto count = image.colors.size();
+
+   if (count <= 2 && best_bits > 1) { return PixelEnum::PALETTE_PIXEL_1BIT; }
+   if (count <= 4 && best_bits > 2) { return PixelEnum::PALETTE_PIXEL_2BIT; }
+   if (count <= 16 && best_bits > 4) { return PixelEnum::PALETTE_PIXEL_4BIT; }
+   if (count <= 256 && best_bits > 8) { return PixelEnum::PALETTE_PIXEL_8BIT; }
+
+   return best;
+}
+
+void Image::reduce() {
+   this->convert(this->smallest_pixel_type());
+}
+
+/* unfilter the seven passes of Adam7 image data in parallel, then scatter them into full-resolution scanlines. */
+template <typename ScanlineType>
+static std::vector<Scanline> adam7_decode(const Header &header, const std::uint8_t *raw_data, std::size_t size, std::pmr::memory_resource *resource,
+                                          Executor &executor)
+{
+   if (size != header.buffer_size()) { throw exception::PixelMismatch(); }
+
+   auto width = header.width();
+   auto height = header.height();
+   auto pixel_size = header.pixel_size();
+   std::size_t offsets[7];
+   std::size_t offset = 0;
+
+   for (std::size_t p=0; p<7; ++p)
+   {
+      auto pass_width = ADAM7_PASSES[p].width(width);
+      auto pass_height = ADAM7_PASSES[p].height(height);
+      offsets[p] = offset;
+
+      if (pass_width != 0 && pass_height != 0)
+         offset += pass_height * ((pass_width * pixel_size + 7) / 8 + 1);
+   }
+
+   std::vector<std::vector<ScanlineType>> passes(7);
+
+   executor.parallel_for(7, [&](std::size_t p) {
+      auto pass_width = ADAM7_PASSES[p].width(width);
+      auto pass_height = ADAM7_PASSES[p].height(height);
+      if (pass_width == 0 || pass_height == 0) { return; }
+
+      auto row_size = (pass_width * pixel_size + 7) / 8 + 1;
+      auto &rows = passes[p];
+      rows.reserve(pass_height);
+
+      for (std::size_t y=0; y<pass_height; ++y)
+      {
+         auto line = ScanlineType::read_line(raw_data, size, offsets[p] + y * row_size, pass_width, resource);
+         auto previous = (y == 0) ? std::optional<ScanlineType>(std::nullopt) : std::optional<ScanlineType>(rows.back());
+         rows.push_back(line.reconstruct(previous));
+      }
+   });
+
+   /* each row is gathered by one task, so sub-byte pixels sharing a byte never race */
+   std::vector<ScanlineType> lines(height);
+
+   executor.parallel_for(height, [&](std::size_t y) {
+      ScanlineType line(FilterType::NONE, width, resource);
+      /* sub-byte rows are scattered a byte per sample and packed once at the end */
+      std::vector<std::uint8_t> samples;
+
+      if constexpr (ScanlineType::Span::Samples > 1)
+         samples.resize(line.pixel_width());
+
+      for (std::size_t p=0; p<7; ++p)
+      {
+         auto &pass = ADAM7_PASSES[p];
+         if (passes[p].empty() || y < pass.y || (y - pass.y) % pass.dy != 0) { continue; }
+
+         auto &source = passes[p][(y - pass.y) / pass.dy];
+         auto pass_width = pass.width(width);
+
+         if constexpr (ScanlineType::Span::Samples == 1)
+         {
+            for (std::size_t x=0; x<pass_width; ++x)
+               line.set_span(source.get_span(x), pass.x + x * pass.dx);
+         }
+         else
+         {
+            auto pass_samples = source.unpack_samples();
+
+            for (std::size_t x=0; x<pass_width; ++x)
+               samples[pass.x + x * pass.dx] = pass_samples[x];
+         }
+      }
+
+      if constexpr (ScanlineType::Span::Samples > 1)
+         line.pack_samples(samples);
+
+      lines[y] = line;
+   });
+
+   return std::vector<Scanline>(lines.begin(), lines.end());
+}
+
+/* gather the seven passes out of unfiltered full-resolution scanlines, filter them in parallel and append them in order. */
+template <typename ScanlineType>
+static void adam7_encode(const Header &header, const std::vector<Scanline> &image_data, std::pmr::vector<std::uint8_t> &buffer,
+                         std::pmr::memory_resource *resource, std::array<std::size_t, 5> &filter_types, Executor &executor)
+{
+   auto width = header.width();
+   auto height = header.height();
+   if (image_data.size() != height) { throw exception::PixelMismatch(); }
+
+   std::vector<std::pmr::vector<std::uint8_t>> pass_data;
+   std::array<std::array<std::size_t, 5>, 7> pass_filter_types = {};
+
+   for (std::size_t p=0; p<7; ++p)
+      pass_data.emplace_back(resource);
+
+   executor.parallel_for(7, [&](std::size_t p) {
+      auto &pass = ADAM7_PASSES[p];
+      auto pass_width = pass.width(width);
+      auto pass_height = pass.height(height);
+      if (pass_width == 0 || pass_height == 0) { return; }
 
-   return this->chunk_map.at("IHDR")[0].upcast<Header>();
-}
+      std::optional<ScanlineType> previous;
 
-Header &Image::new_header() {
-   this->chunk_map["IHDR"].clear();
-   this->add_chunk(Header().as_chunk_vec());
+      for (std::size_t y=0; y<pass_height; ++y)
+      {
+         auto &source = std::get<ScanlineType>(image_data[pass.y + y * pass.dy]);
+         if (source.filter_type() != FilterType::NONE) { throw exception::AlreadyFiltered(); }
 
-   return this->header();
-}
+         ScanlineType line(FilterType::NONE, pass_width, resource);
 
-std::size_t Image::width() const {
-   auto &hdr = this->header();
+         if constexpr (ScanlineType::Span::Samples == 1)
+         {
+            for (std::size_t x=0; x<pass_width; ++x)
+               line.set_span(source.get_span(pass.x + x * pass.dx), x);
+         }
+         else
+         {
+            auto source_samples = source.unpack_samples();
+            std::vector<std::uint8_t> samples(pass_width);
 
-   return hdr.width();
-}
+            for (std::size_t x=0; x<pass_width; ++x)
+               samples[x] = source_samples[pass.x + x * pass.dx];
 
-std::size_t Image::height() const {
-   auto &hdr = this->header();
+            line.pack_samples(samples);
+         }
 
-   return hdr.height();
-}
+         auto filtered = line.filter(previous);
+         ++pass_filter_types[p][filtered.filter_type()];
+         filtered.to_raw(pass_data[p]);
+         previous = line;
+      }
+   });
 
-bool Image::has_image_data() const {
-   return this->has_chunk("IDAT");
-}
+   for (auto &data : pass_data)
+      buffer.insert(buffer.end(), data.begin(), data.end());
 
-bool Image::is_loaded() const {
-   return this->image_data.has_value();
+   for (auto &counts : pass_filter_types)
+      for (std::size_t f=0; f<filter_types.size(); ++f)
+         filter_types[f] += counts[f];
 }
 
 void Image::decompress() {
    if (!this->has_image_data()) { throw exception::NoImageDataChunks(); }
+
+   this->native_endian = false;
+
+   auto interlace_method = this->header().interlace_method();
+   if (interlace_method > 1) { throw exception::InvalidInterlaceMethod(interlace_method); }
+
+   StageTimer timer(this->statistics.get(), STAGE_INFLATE);
    
-   std::vector<std::uint8_t> combined;
+   auto idat_chunks = this->get_chunks(fourcc("IDAT"));
+   std::size_t combined_size = 0;
 
-   for (auto &chunk : this->chunk_map["IDAT"])
+   for (auto &chunk : idat_chunks)
+      combined_size += chunk.length();
+
+   std::pmr::vector<std::uint8_t> combined(this->resource);
+   combined.reserve(combined_size);
+
+   for (auto &chunk : idat_chunks)
       combined.insert(combined.end(), chunk.data().begin(), chunk.data().end());
 
-   auto decompressed = facade::decompress(combined);
+   /* deflate can't expand data by more than about 1032:1, so a bogus header can't make us reserve more than that */
+   auto expected_size = std::min<std::size_t>(this->header().buffer_size(), combined.size() * 1032);
+   auto decompressed = facade::decompress(combined.data(), combined.size(), this->resource, expected_size);
+   timer.set_bytes(combined.size(), decompressed.size());
+
+   if (interlace_method == 1)
+   {
+      timer.stop();
+
+      StageTimer reconstruct_timer(this->statistics.get(), STAGE_RECONSTRUCT);
+      reconstruct_timer.set_bytes(decompressed.size(), decompressed.size());
+
+      visit_scanline_type(this->header().pixel_type(), [&](auto *type) {
+         using ScanlineType = std::remove_pointer_t<decltype(type)>;
+         this->image_data = adam7_decode<ScanlineType>(this->header(), decompressed.data(), decompressed.size(), this->resource,
+                                                          this->executor());
+      });
+
+      return;
+   }
 
    switch (this->header().pixel_type())
    {
    case PixelEnum::GRAYSCALE_PIXEL_1BIT:
    {
-      auto scanlines = GrayscaleScanline1Bit::from_raw(this->header(), decompressed);
+      auto scanlines = GrayscaleScanline1Bit::from_raw(this->header(), decompressed.data(), decompressed.size(), this->resource);
       this->image_data = std::vector<Scanline>(scanlines.begin(), scanlines.end());
       break;
    }
    case PixelEnum::GRAYSCALE_PIXEL_2BIT:
    {
-      auto scanlines = GrayscaleScanline2Bit::from_raw(this->header(), decompressed);
+      auto scanlines = GrayscaleScanline2Bit::from_raw(this->header(), decompressed.data(), decompressed.size(), this->resource);
       this->image_data = std::vector<Scanline>(scanlines.begin(), scanlines.end());
       break;
    }
    case PixelEnum::GRAYSCALE_PIXEL_4BIT:
    {
-      auto scanlines = GrayscaleScanline4Bit::from_raw(this->header(), decompressed);
+      auto scanlines = GrayscaleScanline4Bit::from_raw(this->header(), decompressed.data(), decompressed.size(), this->resource);
       this->image_data = std::vector<Scanline>(scanlines.begin(), scanlines.end());
       break;
    }
    case PixelEnum::GRAYSCALE_PIXEL_8BIT:
    {
-      auto scanlines = GrayscaleScanline8Bit::from_raw(this->header(), decompressed);
+      auto scanlines = GrayscaleScanline8Bit::from_raw(this->header(), decompressed.data(), decompressed.size(), this->resource);
       this->image_data = std::vector<Scanline>(scanlines.begin(), scanlines.end());
       break;
    }
    case PixelEnum::GRAYSCALE_PIXEL_16BIT:
    {
-      auto scanlines = GrayscaleScanline16Bit::from_raw(this->header(), decompressed);
+      auto scanlines = GrayscaleScanline16Bit::from_raw(this->header(), decompressed.data(), decompressed.size(), this->resource);
       this->image_data = std::vector<Scanline>(scanlines.begin(), scanlines.end());
       break;
    }
    case PixelEnum::TRUE_COLOR_PIXEL_8BIT:
    {
-      auto scanlines = TrueColorScanline8Bit::from_raw(this->header(), decompressed);
+      auto scanlines = TrueColorScanline8Bit::from_raw(this->header(), decompressed.data(), decompressed.size(), this->resource);
       this->image_data = std::vector<Scanline>(scanlines.begin(), scanlines.end());
       break;
    }
    case PixelEnum::TRUE_COLOR_PIXEL_16BIT:
    {
-      auto scanlines = TrueColorScanline16Bit::from_raw(this->header(), decompressed);
+      auto scanlines = TrueColorScanline16Bit::from_raw(this->header(), decompressed.data(), decompressed.size(), this->resource);
       this->image_data = std::vector<Scanline>(scanlines.begin(), scanlines.end());
       break;
    }
    case PixelEnum::PALETTE_PIXEL_1BIT:
    {
-      auto scanlines = PaletteScanline1Bit::from_raw(this->header(), decompressed);
+      auto scanlines = PaletteScanline1Bit::from_raw(this->header(), decompressed.data(), decompressed.size(), this->resource);
       this->image_data = std::vector<Scanline>(scanlines.begin(), scanlines.end());
       break;
    }
    case PixelEnum::PALETTE_PIXEL_2BIT:
    {
-      auto scanlines = PaletteScanline2Bit::from_raw(this->header(), decompressed);
+      auto scanlines = PaletteScanline2Bit::from_raw(this->header(), decompressed.data(), decompressed.size(), this->resource);
       this->image_data = std::vector<Scanline>(scanlines.begin(), scanlines.end());
       break;
    }
    case PixelEnum::PALETTE_PIXEL_4BIT:
    {
-      auto scanlines = PaletteScanline4Bit::from_raw(this->header(), decompressed);
+      auto scanlines = PaletteScanline4Bit::from_raw(this->header(), decompressed.data(), decompressed.size(), this->resource);
       this->image_data = std::vector<Scanline>(scanlines.begin(), scanlines.end());
       break;
    }
    case PixelEnum::PALETTE_PIXEL_8BIT:
    {
-      auto scanlines = PaletteScanline8Bit::from_raw(this->header(), decompressed);
+      auto scanlines = PaletteScanline8Bit::from_raw(this->header(), decompressed.data(), decompressed.size(), this->resource);
       this->image_data = std::vector<Scanline>(scanlines.begin(), scanlines.end());
       break;
    }
    case PixelEnum::ALPHA_GRAYSCALE_PIXEL_8BIT:
    {
-      auto scanlines = AlphaGrayscaleScanline8Bit::from_raw(this->header(), decompressed);
+      auto scanlines = AlphaGrayscaleScanline8Bit::from_raw(this->header(), decompressed.data(), decompressed.size(), this->resource);
       this->image_data = std::vector<Scanline>(scanlines.begin(), scanlines.end());
       break;
    }
    case PixelEnum::ALPHA_GRAYSCALE_PIXEL_16BIT:
    {
-      auto scanlines = AlphaGrayscaleScanline16Bit::from_raw(this->header(), decompressed);
+      auto scanlines = AlphaGrayscaleScanline16Bit::from_raw(this->header(), decompressed.data(), decompressed.size(), this->resource);
       this->image_data = std::vector<Scanline>(scanlines.begin(), scanlines.end());
       break;
    }
    case PixelEnum::ALPHA_TRUE_COLOR_PIXEL_8BIT:
    {
-      auto scanlines = AlphaTrueColorScanline8Bit::from_raw(this->header(), decompressed);
+      auto scanlines = AlphaTrueColorScanline8Bit::from_raw(this->header(), decompressed.data(), decompressed.size(), this->resource);
       this->image_data = std::vector<Scanline>(scanlines.begin(), scanlines.end());
       break;
    }
    case PixelEnum::ALPHA_TRUE_COLOR_PIXEL_16BIT:
    {
-      auto scanlines = AlphaTrueColorScanline16Bit::from_raw(this->header(), decompressed);
+      auto scanlines = AlphaTrueColorScanline16Bit::from_raw(this->header(), decompressed.data(), decompressed.size(), this->resource);
       this->image_data = std::vector<Scanline>(scanlines.begin(), scanlines.end());
       break;
    }
@@ -1143,14 +2661,39 @@ void Image::decompress() {
 void Image::compress(std::optional<std::size_t> chunk_size, int level) {
    if (!this->image_data.has_value()) { throw exception::NoImageData(); }
 
-   std::vector<std::uint8_t> combined;
+   this->to_png_endian();
 
-   for (auto &scanline : *this->image_data) {
-      auto raw = scanline.to_raw();
-      combined.insert(combined.end(), raw.begin(), raw.end());
+   auto stats = this->statistics.get();
+   std::pmr::vector<std::uint8_t> combined(this->resource);
+   combined.reserve(this->header().buffer_size());
+
+   if (this->is_interlaced())
+   {
+      StageTimer timer(stats, STAGE_FILTER);
+      std::array<std::size_t, 5> filter_types = { 0, 0, 0, 0, 0 };
+
+      visit_scanline_type(this->header().pixel_type(), [&](auto *type) {
+         using ScanlineType = std::remove_pointer_t<decltype(type)>;
+         adam7_encode<ScanlineType>(this->header(), *this->image_data, combined, this->resource, filter_types, this->executor());
+      });
+
+      if (stats != nullptr)
+      {
+         stats->add_filter_types(filter_types);
+         timer.set_bytes(combined.size(), combined.size());
+      }
+   }
+   else
+   {
+      for (auto &scanline : *this->image_data)
+         scanline.to_raw(combined);
    }
 
-   auto compressed = facade::compress(combined.data(), combined.size(), level);
+   StageTimer timer(stats, STAGE_DEFLATE);
+   auto compressed = facade::compress(combined.data(), combined.size(), level, this->resource);
+   timer.set_bytes(combined.size(), compressed.size());
+   timer.stop();
+
    std::vector<ChunkVec> idat_chunks;
 
    if (!chunk_size.has_value())
@@ -1166,12 +2709,42 @@ void Image::compress(std::optional<std::size_t> chunk_size, int level) {
       }
    }
 
-   this->chunk_map["IDAT"] = idat_chunks;
+   /* put the new image data where the old image data was */
+   std::optional<std::size_t> offset;
+   if (this->has_image_data()) { offset = this->chunk_index.at(fourcc("IDAT")).front(); }
+
+   this->erase_chunks(fourcc("IDAT"));
+   if (!offset.has_value()) { offset = this->insertion_offset(fourcc("IDAT")); }
+   
+   this->chunks.insert(std::next(this->chunks.begin(), *offset), idat_chunks.begin(), idat_chunks.end());
+   this->reindex();
+}
+
+bool Image::is_interlaced() const {
+   return this->header().interlace_method() == 1;
+}
+
+void Image::deinterlace() {
+   if (!this->is_interlaced()) { return; }
+
+   if (this->is_loaded())
+   {
+      this->header().set_interlace_method(0);
+      return;
+   }
+
+   this->load();
+   this->header().set_interlace_method(0);
+   this->filter();
+   this->compress();
 }
 
 void Image::reconstruct() {
    if (!this->image_data.has_value()) { throw exception::NoImageData(); }
 
+   StageTimer timer(this->statistics.get(), STAGE_RECONSTRUCT);
+   if (this->statistics != nullptr) { timer.set_bytes(this->header().buffer_size(), this->header().buffer_size()); }
+
    auto &image_data = *this->image_data;
    
    for (std::size_t i=0; i<this->image_data->size(); ++i)
@@ -1305,270 +2878,328 @@ void Image::reconstruct() {
 void Image::filter() {
    if (!this->image_data.has_value()) { throw exception::NoImageData(); }
 
+   this->to_png_endian();
+   if (this->is_interlaced()) { return; }
+
+   StageTimer timer(this->statistics.get(), STAGE_FILTER);
+
    auto &current_data = *this->image_data;
    auto new_data = *this->image_data;
 
-   for (std::size_t i=0; i<current_data.size(); ++i)
-   {
-      switch (this->header().pixel_type())
-      {
-      case PixelEnum::GRAYSCALE_PIXEL_1BIT:
-      {
-         std::optional<GrayscaleScanline1Bit> previous = (i == 0)
-            ? std::optional<GrayscaleScanline1Bit>(std::nullopt)
-            : std::get<GrayscaleScanline1Bit>(current_data[i-1]);
-         new_data[i] = std::get<GrayscaleScanline1Bit>(new_data[i]).filter(previous);
-         break;
-      }
-      case PixelEnum::GRAYSCALE_PIXEL_2BIT:
-      {
-         std::optional<GrayscaleScanline2Bit> previous = (i == 0)
-            ? std::optional<GrayscaleScanline2Bit>(std::nullopt)
-            : std::get<GrayscaleScanline2Bit>(current_data[i-1]);
-         new_data[i] = std::get<GrayscaleScanline2Bit>(new_data[i]).filter(previous);
-         break;
-      }
-      case PixelEnum::GRAYSCALE_PIXEL_4BIT:
-      {
-         std::optional<GrayscaleScanline4Bit> previous = (i == 0)
-            ? std::optional<GrayscaleScanline4Bit>(std::nullopt)
-            : std::get<GrayscaleScanline4Bit>(current_data[i-1]);
-         new_data[i] = std::get<GrayscaleScanline4Bit>(new_data[i]).filter(previous);
-         break;
-      }
-      case PixelEnum::GRAYSCALE_PIXEL_8BIT:
-      {
-         std::optional<GrayscaleScanline8Bit> previous = (i == 0)
-            ? std::optional<GrayscaleScanline8Bit>(std::nullopt)
-            : std::get<GrayscaleScanline8Bit>(current_data[i-1]);
-         new_data[i] = std::get<GrayscaleScanline8Bit>(new_data[i]).filter(previous);
-         break;
-      }
-      case PixelEnum::GRAYSCALE_PIXEL_16BIT:
-      {
-         std::optional<GrayscaleScanline16Bit> previous = (i == 0)
-            ? std::optional<GrayscaleScanline16Bit>(std::nullopt)
-            : std::get<GrayscaleScanline16Bit>(current_data[i-1]);
-         new_data[i] = std::get<GrayscaleScanline16Bit>(new_data[i]).filter(previous);
-         break;
-      }
-      case PixelEnum::TRUE_COLOR_PIXEL_8BIT:
-      {
-         std::optional<TrueColorScanline8Bit> previous = (i == 0)
-            ? std::optional<TrueColorScanline8Bit>(std::nullopt)
-            : std::get<TrueColorScanline8Bit>(current_data[i-1]);
-         new_data[i] = std::get<TrueColorScanline8Bit>(new_data[i]).filter(previous);
-         break;
-      }
-      case PixelEnum::TRUE_COLOR_PIXEL_16BIT:
-      {
-         std::optional<TrueColorScanline16Bit> previous = (i == 0)
-            ? std::optional<TrueColorScanline16Bit>(std::nullopt)
-            : std::get<TrueColorScanline16Bit>(current_data[i-1]);
-         new_data[i] = std::get<TrueColorScanline16Bit>(new_data[i]).filter(previous);
-         break;
-      }
-      case PixelEnum::PALETTE_PIXEL_1BIT:
-      {
-         std::optional<PaletteScanline1Bit> previous = (i == 0)
-            ? std::optional<PaletteScanline1Bit>(std::nullopt)
-            : std::get<PaletteScanline1Bit>(current_data[i-1]);
-         new_data[i] = std::get<PaletteScanline1Bit>(new_data[i]).filter(previous);
-         break;
-      }
-      case PixelEnum::PALETTE_PIXEL_2BIT:
-      {
-         std::optional<PaletteScanline2Bit> previous = (i == 0)
-            ? std::optional<PaletteScanline2Bit>(std::nullopt)
-            : std::get<PaletteScanline2Bit>(current_data[i-1]);
-         new_data[i] = std::get<PaletteScanline2Bit>(new_data[i]).filter(previous);
-         break;
-      }
-      case PixelEnum::PALETTE_PIXEL_4BIT:
-      {
-         std::optional<PaletteScanline4Bit> previous = (i == 0)
-            ? std::optional<PaletteScanline4Bit>(std::nullopt)
-            : std::get<PaletteScanline4Bit>(current_data[i-1]);
-         new_data[i] = std::get<PaletteScanline4Bit>(new_data[i]).filter(previous);
-         break;
-      }
-      case PixelEnum::PALETTE_PIXEL_8BIT:
-      {
-         std::optional<PaletteScanline8Bit> previous = (i == 0)
-            ? std::optional<PaletteScanline8Bit>(std::nullopt)
-            : std::get<PaletteScanline8Bit>(current_data[i-1]);
-         new_data[i] = std::get<PaletteScanline8Bit>(new_data[i]).filter(previous);
-         break;
-      }
-      case PixelEnum::ALPHA_GRAYSCALE_PIXEL_8BIT:
-      {
-         std::optional<AlphaGrayscaleScanline8Bit> previous = (i == 0)
-            ? std::optional<AlphaGrayscaleScanline8Bit>(std::nullopt)
-            : std::get<AlphaGrayscaleScanline8Bit>(current_data[i-1]);
-         new_data[i] = std::get<AlphaGrayscaleScanline8Bit>(new_data[i]).filter(previous);
-         break;
-      }
-      case PixelEnum::ALPHA_GRAYSCALE_PIXEL_16BIT:
-      {
-         std::optional<AlphaGrayscaleScanline16Bit> previous = (i == 0)
-            ? std::optional<AlphaGrayscaleScanline16Bit>(std::nullopt)
-            : std::get<AlphaGrayscaleScanline16Bit>(current_data[i-1]);
-         new_data[i] = std::get<AlphaGrayscaleScanline16Bit>(new_data[i]).filter(previous);
-         break;
-      }
-      case PixelEnum::ALPHA_TRUE_COLOR_PIXEL_8BIT:
-      {
-         //std::cout << "Filtering row " << i << std::endl;
-         std::optional<AlphaTrueColorScanline8Bit> previous = (i == 0)
-            ? std::optional<AlphaTrueColorScanline8Bit>(std::nullopt)
-            : std::get<AlphaTrueColorScanline8Bit>(current_data[i-1]);
-         new_data[i] = std::get<AlphaTrueColorScanline8Bit>(new_data[i]).filter(previous);
-         break;
-      }
-      case PixelEnum::ALPHA_TRUE_COLOR_PIXEL_16BIT:
-      {
-         std::optional<AlphaTrueColorScanline16Bit> previous = (i == 0)
-            ? std::optional<AlphaTrueColorScanline16Bit>(std::nullopt)
-            : std::get<AlphaTrueColorScanline16Bit>(current_data[i-1]);
-         new_data[i] = std::get<AlphaTrueColorScanline16Bit>(new_data[i]).filter(previous);
-         break;
-      }
-      }
-   }
+   /* each row is filtered against the unfiltered row above it, which stays untouched in current_data, so rows
+      don't depend on each other and can be filtered in any order with the same result */
+   visit_scanline_type(this->header().pixel_type(), [&](auto *type) {
+      using ScanlineType = std::remove_pointer_t<decltype(type)>;
+
+      this->executor().parallel_for_ranges(current_data.size(), 16, [&](std::size_t begin, std::size_t end) {
+         for (std::size_t i=begin; i<end; ++i)
+         {
+            std::optional<ScanlineType> previous = (i == 0)
+               ? std::optional<ScanlineType>(std::nullopt)
+               : std::get<ScanlineType>(current_data[i-1]);
+            new_data[i] = std::get<ScanlineType>(new_data[i]).filter(previous);
+         }
+      });
+   });
 
    this->image_data = new_data;
+
+   if (this->statistics != nullptr)
+   {
+      std::array<std::size_t, 5> filter_types = { 0, 0, 0, 0, 0 };
+
+      for (auto &scanline : new_data)
+         ++filter_types[scanline.filter_type()];
+
+      this->statistics->add_filter_types(filter_types);
+      timer.set_bytes(this->header().buffer_size(), this->header().buffer_size());
+   }
 }
 
 std::vector<std::uint8_t> Image::to_file() const
 {
-   std::vector<std::string> chunks = {
-      /* critical chunks (except for gama, apparently it just... goes there) */
-      "IHDR", "gAMA", "PLTE", "IDAT",
-
-      /* ancillary chunks */
-      "tRNS", "cHRM", "iCCP", "sBIT", "sRGB", "cICP",
-      "tEXt", "zTXt", "iTXt", "bKGD", "hIST", "pHYs", "sPLT",
-      "eXIf", "tIME", "acTL", "fcTL", "fdAT",
-   };
-
-   /* make sure nonstandard chunks get written too */
-   for (auto pair : this->chunk_map)
-      if (pair.first != "IEND" && std::find(chunks.begin(), chunks.end(), pair.first) == chunks.end())
-         chunks.push_back(pair.first);
+   StageTimer timer(this->statistics.get(), STAGE_WRITE);
+   std::vector<std::uint8_t> file_data;
+   std::size_t file_size = sizeof(this->Signature);
 
-   chunks.push_back("IEND");
+   for (auto &chunk : this->chunks)
+      file_size += sizeof(std::uint32_t) + sizeof(ChunkTag) + chunk.length() + sizeof(std::uint32_t);
 
-   std::vector<std::uint8_t> file_data;
+   file_data.reserve(file_size);
    file_data.insert(file_data.end(), &this->Signature[0], &this->Signature[8]);
 
-   for (auto chunk_label : chunks)
+   /* chunks are already kept in file order by add_chunk */
+   for (auto &chunk : this->chunks)
    {
-      if (this->chunk_map.find(chunk_label) == this->chunk_map.end()) { continue; }
-
-      for (auto &chunk : this->chunk_map.at(chunk_label))
-      {
-         auto ptr = chunk.to_chunk_ptr();
-         auto &data = ptr.first;
-         file_data.insert(file_data.end(), data.begin(), data.end());
-      }
+      auto ptr = chunk.to_chunk_ptr();
+      auto &data = ptr.first;
+      file_data.insert(file_data.end(), data.begin(), data.end());
    }
 
-   if (!this->has_chunk("IEND"))
+   if (!this->has_chunk(fourcc("IEND")))
    {
       auto end = End().to_chunk_ptr();
       file_data.insert(file_data.end(), end.first.begin(), end.first.end());
    }
 
-   if (this->trailing_data.has_value())
+   if (this->trailing_data != nullptr)
       file_data.insert(file_data.end(), this->trailing_data->begin(), this->trailing_data->end());
 
+   if (this->statistics != nullptr)
+   {
+      this->statistics->add_written_chunks(this->chunks.size() + (this->has_chunk(fourcc("IEND")) ? 0 : 1));
+      timer.set_bytes(file_data.size(), file_data.size());
+   }
+
    return file_data;
 }
 
 void Image::save(const std::string &filename) const
 {
    auto data = this->to_file();
+
+   StageTimer timer(this->statistics.get(), STAGE_WRITE);
+   timer.set_bytes(data.size(), data.size());
    write_file(filename, data);
 }
 
-bool Image::has_text() const {
-   return this->has_chunk("tEXt");
-}
+std::vector<std::size_t> Image::frame_data_offsets(std::size_t index) const {
+   auto controls = this->chunk_index.find(fourcc("fcTL"));
+   auto count = (controls == this->chunk_index.end()) ? 0 : controls->second.size();
+   if (index >= count) { throw exception::OutOfBounds(index, count); }
 
-Text &Image::add_text(const std::string &keyword, const std::string &text) {
-   this->add_chunk(Text(keyword, text).as_chunk_vec());
+   /* a frame's data runs from its frame control up to the next one */
+   auto start = controls->second[index] + 1;
+   auto end = (index+1 < count) ? controls->second[index+1] : this->chunks.size();
+   std::vector<std::size_t> result;
 
-   return this->chunk_map["tEXt"].back().upcast<Text>();
+   for (auto offset=start; offset<end; ++offset)
+   {
+      auto tag = this->chunks[offset].tag().fourcc();
+      if (tag == fourcc("IDAT") || tag == fourcc("fdAT")) { result.push_back(offset); }
+   }
+
+   return result;
 }
 
-void Image::remove_text(const Text &text) {
-   for (auto chunk=this->chunk_map["tEXt"].begin(); chunk!=this->chunk_map["tEXt"].end(); ++chunk)
+void Image::renumber_frames() {
+   std::uint32_t sequence = 0;
+
+   for (auto &chunk : this->chunks)
    {
-      if (*chunk == text)
+      auto tag = chunk.tag().fourcc();
+      if (tag != fourcc("fcTL") && tag != fourcc("fdAT")) { continue; }
+      if (chunk.length() < sizeof(sequence)) { continue; }
+
+      /* only touch chunks whose number changes, so the others stay shared with copies of the image */
+      if (endian_swap_32(read_u32(static_cast<const ChunkVec &>(chunk).data().data())) != sequence)
       {
-         this->chunk_map["tEXt"].erase(chunk);
-         return;
+         auto value = endian_swap_32(sequence);
+         std::memcpy(chunk.data().data(), &value, sizeof(value));
       }
+
+      ++sequence;
    }
+}
 
-   throw exception::TextNotFound();
+bool Image::is_animated() const {
+   return this->has_chunk(fourcc("acTL"));
 }
 
-void Image::remove_text(const std::string &keyword, const std::string &text) {
-   this->remove_text(Text(keyword, text));
+const AnimationControl &Image::animation_control() const {
+   return this->get_chunks(fourcc("acTL")).front().upcast<AnimationControl>();
 }
 
-std::vector<Text> Image::get_text(const std::string &keyword) const {
-   std::vector<Text> result;
-   
-   for (auto &text : this->chunk_map.at("tEXt"))
+std::size_t Image::frame_count() const {
+   auto controls = this->chunk_index.find(fourcc("fcTL"));
+   if (controls == this->chunk_index.end()) { return 0; }
+
+   return controls->second.size();
+}
+
+const FrameControl &Image::frame_control(std::size_t index) const {
+   auto count = this->frame_count();
+   if (index >= count) { throw exception::OutOfBounds(index, count); }
+
+   return this->chunks[this->chunk_index.at(fourcc("fcTL"))[index]].upcast<FrameControl>();
+}
+
+bool Image::default_image_is_frame() const {
+   auto controls = this->chunk_index.find(fourcc("fcTL"));
+   auto idat = this->chunk_index.find(fourcc("IDAT"));
+   if (controls == this->chunk_index.end() || idat == this->chunk_index.end()) { return false; }
+
+   return controls->second.front() < idat->second.front();
+}
+
+Image Image::frame(std::size_t index) const {
+   auto &control = this->frame_control(index);
+   auto offsets = this->frame_data_offsets(index);
+   if (offsets.empty()) { throw exception::InvalidFrame(index); }
+
+   Image result(this->resource);
+   result.statistics = this->statistics;
+   result.workers = this->workers;
+
+   Header header(this->header());
+   header.set_width(control.width());
+   header.set_height(control.height());
+   result.chunks.push_back(header);
+
+   for (auto tag : { fourcc("PLTE"), fourcc("tRNS") })
+      if (this->has_chunk(tag)) { result.chunks.push_back(this->get_chunks(tag).front()); }
+
+   for (auto offset : offsets)
    {
-      auto &upcast = text.upcast<Text>();
+      auto &chunk = this->chunks[offset];
+
+      if (chunk.tag().fourcc() == fourcc("IDAT"))
+      {
+         result.chunks.push_back(chunk);
+         continue;
+      }
 
-      if (upcast.keyword() == keyword)
-         result.push_back(upcast);
+      /* fdAT is an IDAT with a sequence number in front */
+      if (chunk.length() < sizeof(std::uint32_t)) { throw exception::InvalidFrame(index); }
+
+      auto &data = chunk.data();
+      result.chunks.push_back(ChunkVec(std::string("IDAT"), std::vector<std::uint8_t>(data.begin() + sizeof(std::uint32_t), data.end())));
    }
 
+   result.chunks.push_back(End());
+   result.reindex();
+
    return result;
 }
 
-bool Image::has_ztext() const {
-   return this->has_chunk("zTXt");
-}
+std::vector<Image> Image::frames(bool load) const {
+   std::vector<Image> result(this->frame_count());
 
-ZText &Image::add_ztext(const std::string &keyword, const std::string &text) {
-   this->add_chunk(ZText(keyword, text).as_chunk_vec());
+   this->executor().parallel_for(result.size(), [&](std::size_t i) {
+      result[i] = this->frame(i);
+      if (load) { result[i].load(); }
+   });
 
-   return this->chunk_map["zTXt"].back().upcast<ZText>();
+   return result;
 }
 
-void Image::remove_ztext(const ZText &text) {
-   for (auto chunk=this->chunk_map["zTXt"].begin(); chunk!=this->chunk_map["zTXt"].end(); ++chunk)
+void Image::set_frame(std::size_t index, const Image &frame) {
+   auto &control = this->frame_control(index);
+   if (!frame.has_image_data()) { throw exception::NoImageDataChunks(); }
+
+   auto &header = this->header();
+   auto &frame_header = frame.header();
+
+   if (frame_header.width() != control.width()
+       || frame_header.height() != control.height()
+       || frame_header.pixel_type() != header.pixel_type()
+       || frame_header.interlace_method() != header.interlace_method())
+      throw exception::InvalidFrame(index);
+
+   auto offsets = this->frame_data_offsets(index);
+   auto is_default = !offsets.empty() && this->chunks[offsets.front()].tag().fourcc() == fourcc("IDAT");
+   auto position = offsets.empty() ? this->chunk_index.at(fourcc("fcTL"))[index] + 1 : offsets.front();
+   std::vector<ChunkVec> data_chunks;
+
+   for (auto &chunk : frame.get_chunks(fourcc("IDAT")))
    {
-      if (*chunk == text)
+      if (is_default)
       {
-         this->chunk_map["zTXt"].erase(chunk);
-         return;
+         data_chunks.push_back(chunk);
+         continue;
       }
+
+      /* the sequence number is filled in by renumber_frames */
+      std::vector<std::uint8_t> data(sizeof(std::uint32_t));
+      data.insert(data.end(), chunk.data().begin(), chunk.data().end());
+      data_chunks.push_back(ChunkVec(std::string("fdAT"), data));
    }
 
-   throw exception::TextNotFound();
+   for (auto offset=offsets.rbegin(); offset!=offsets.rend(); ++offset)
+      this->chunks.erase(std::next(this->chunks.begin(), *offset));
+
+   this->chunks.insert(std::next(this->chunks.begin(), position), data_chunks.begin(), data_chunks.end());
+   this->reindex();
+   this->renumber_frames();
+
+   /* the loaded image data belonged to the default image that was just replaced */
+   if (is_default) { this->image_data = std::nullopt; }
+}
+
+bool Image::has_text() const {
+   return this->has_chunk(fourcc("tEXt"));
+}
+
+Text &Image::add_text(const std::string &keyword, const std::string &text) {
+   return this->add_chunk(Text(keyword, text).as_chunk_vec()).upcast<Text>();
+}
+
+void Image::remove_text(const Text &text) {
+   auto offset = this->find_chunk(text);
+   if (!offset.has_value()) { throw exception::TextNotFound(); }
+
+   this->erase_chunk(*offset);
+}
+
+void Image::remove_text(const std::string &keyword, const std::string &text) {
+   this->remove_text(Text(keyword, text));
+}
+
+ChunkView<Text> Image::get_text(const std::string &keyword) const {
+   auto offsets = this->keyword_offsets(fourcc("tEXt"), keyword);
+   if (offsets == nullptr) { return ChunkView<Text>(); }
+
+   return ChunkView<Text>(this->chunks, *offsets);
+}
+
+bool Image::has_ztext() const {
+   return this->has_chunk(fourcc("zTXt"));
+}
+
+ZText &Image::add_ztext(const std::string &keyword, const std::string &text) {
+   return this->add_chunk(ZText(keyword, text).as_chunk_vec()).upcast<ZText>();
+}
+
+void Image::remove_ztext(const ZText &text) {
+   auto offset = this->find_chunk(text);
+   if (!offset.has_value()) { throw exception::TextNotFound(); }
+
+   this->erase_chunk(*offset);
 }
 
 void Image::remove_ztext(const std::string &keyword, const std::string &text) {
    this->remove_ztext(ZText(keyword, text));
 }
 
-std::vector<ZText> Image::get_ztext(const std::string &keyword) const {
-   std::vector<ZText> result;
-   
-   for (auto &text : this->chunk_map.at("zTXt"))
-   {
-      auto &upcast = text.upcast<ZText>();
+ChunkView<ZText> Image::get_ztext(const std::string &keyword) const {
+   auto offsets = this->keyword_offsets(fourcc("zTXt"), keyword);
+   if (offsets == nullptr) { return ChunkView<ZText>(); }
 
-      if (upcast.keyword() == keyword)
-         result.push_back(upcast);
-   }
+   return ChunkView<ZText>(this->chunks, *offsets);
+}
 
-   return result;
+bool Image::has_binary() const {
+   return this->has_chunk(fourcc("faCd"));
+}
+
+BinaryData &Image::add_binary(const std::string &keyword, const void *ptr, std::size_t size, std::uint8_t codec) {
+   return this->add_chunk(BinaryData(keyword, ptr, size, codec).as_chunk_vec()).upcast<BinaryData>();
+}
+
+BinaryData &Image::add_binary(const std::string &keyword, const std::vector<std::uint8_t> &data, std::uint8_t codec) {
+   return this->add_binary(keyword, data.data(), data.size(), codec);
+}
+
+void Image::remove_binary(const BinaryData &binary) {
+   auto offset = this->find_chunk(binary);
+   if (!offset.has_value()) { throw exception::BinaryDataNotFound(); }
+
+   this->erase_chunk(*offset);
+}
+
+ChunkView<BinaryData> Image::get_binary(const std::string &keyword) const {
+   auto offsets = this->keyword_offsets(fourcc("faCd"), keyword);
+   if (offsets == nullptr) { return ChunkView<BinaryData>(); }
+
+   return ChunkView<BinaryData>(this->chunks, *offsets);
 }
@@ -0,0 +1,542 @@
+#include <facade.hpp>
+
+#include <mutex>
+#include <string_view>
+
+#if defined(LIBFACADE_X86)
+#if defined(LIBFACADE_WIN32)
+#include <intrin.h>
+#endif
+#include <immintrin.h>
+#endif
+
+using namespace facade;
+
+/* the end of central directory record of a zip archive. this isn't reported, it's how zip archives are measured. */
+static const std::size_t ZIP_END = FORMAT_COUNT;
+
+/* buffers are scanned in chunks of this size, each on its own task */
+static const std::size_t CHUNK_SIZE = 4 * 1024 * 1024;
+
+struct Pattern
+{
+   std::size_t format;
+   std::string_view bytes;
+};
+
+static const Pattern PATTERNS[] = {
+   { FORMAT_PNG, std::string_view("\x89PNG\r\n\x1a\n", 8) },
+   { FORMAT_JPEG, std::string_view("\xFF\xD8\xFF", 3) },
+   { FORMAT_GIF, std::string_view("GIF87a", 6) },
+   { FORMAT_GIF, std::string_view("GIF89a", 6) },
+   { FORMAT_PDF, std::string_view("%PDF-", 5) },
+   { FORMAT_ZIP, std::string_view("PK\x03\x04", 4) },
+   { FORMAT_7Z, std::string_view("7z\xBC\xAF\x27\x1C", 6) },
+   { FORMAT_RAR, std::string_view("Rar!\x1A\x07", 6) },
+   { FORMAT_GZIP, std::string_view("\x1F\x8B\x08", 3) },
+   { FORMAT_BZIP2, std::string_view("BZh", 3) },
+   { FORMAT_XZ, std::string_view("\xFD" "7zXZ\x00", 6) },
+   { FORMAT_PE, std::string_view("MZ", 2) },
+   { FORMAT_ELF, std::string_view("\x7F" "ELF", 4) },
+   { ZIP_END, std::string_view("PK\x05\x06", 4) },
+};
+
+static const std::size_t PATTERN_COUNT = sizeof(PATTERNS) / sizeof(Pattern);
+
+/* an aho-corasick automaton over every pattern, with the failure links folded into a full transition table so the
+   scan is a single lookup per byte. bytes which can't start a pattern leave the root where it is, so runs of them
+   are skipped without touching the table at all. */
+struct Automaton
+{
+   std::vector<std::array<std::uint16_t, 256>> next;
+   std::vector<std::vector<std::size_t>> matches;
+   std::array<bool, 256> starts = {};
+   std::size_t longest = 0;
+#if defined(LIBFACADE_X86)
+   /* each pattern sets its bucket bit for the low and high nibbles of its first two bytes. a position can start a
+      pattern only if the bits of all four nibbles overlap, which lets a few shuffles test 16 positions at once. the
+      odd false positive is turned away by the table. */
+   alignas(16) std::array<std::array<std::uint8_t, 16>, 2> low_buckets = {};
+   alignas(16) std::array<std::array<std::uint8_t, 16>, 2> high_buckets = {};
+#endif
+
+   Automaton() {
+      std::vector<std::array<std::int32_t, 256>> trie(1);
+      trie[0].fill(-1);
+      this->matches.resize(1);
+
+      for (std::size_t p=0; p<PATTERN_COUNT; ++p)
+      {
+         std::size_t state = 0;
+
+         for (auto c : PATTERNS[p].bytes)
+         {
+            auto byte = static_cast<std::uint8_t>(c);
+
+            if (trie[state][byte] < 0)
+            {
+               trie[state][byte] = static_cast<std::int32_t>(trie.size());
+               trie.emplace_back();
+               trie.back().fill(-1);
+               this->matches.emplace_back();
+            }
+
+            state = trie[state][byte];
+         }
+
+         this->matches[state].push_back(p);
+         this->starts[static_cast<std::uint8_t>(PATTERNS[p].bytes[0])] = true;
+         this->longest = std::max(this->longest, PATTERNS[p].bytes.size());
+      }
+
+      /* breadth first, so the failure link of every state is finished before its children need it */
+      this->next.resize(trie.size());
+      std::vector<std::size_t> failure(trie.size(), 0);
+      std::vector<std::size_t> queue;
+
+      for (std::size_t c=0; c<256; ++c)
+      {
+         if (trie[0][c] < 0) { this->next[0][c] = 0; continue; }
+
+         this->next[0][c] = static_cast<std::uint16_t>(trie[0][c]);
+         queue.push_back(trie[0][c]);
+      }
+
+      for (std::size_t i=0; i<queue.size(); ++i)
+      {
+         auto state = queue[i];
+         auto &fallback = this->matches[failure[state]];
+         this->matches[state].insert(this->matches[state].end(), fallback.begin(), fallback.end());
+
+         for (std::size_t c=0; c<256; ++c)
+         {
+            if (trie[state][c] < 0)
+            {
+               this->next[state][c] = this->next[failure[state]][c];
+               continue;
+            }
+
+            auto child = static_cast<std::size_t>(trie[state][c]);
+            failure[child] = this->next[failure[state]][c];
+            this->next[state][c] = static_cast<std::uint16_t>(child);
+            queue.push_back(child);
+         }
+      }
+
+#if defined(LIBFACADE_X86)
+      for (std::size_t p=0; p<PATTERN_COUNT; ++p)
+      {
+         auto bit = static_cast<std::uint8_t>(1 << (p % 8));
+
+         for (std::size_t i=0; i<2; ++i)
+         {
+            auto c = static_cast<std::uint8_t>(PATTERNS[p].bytes[i]);
+            this->low_buckets[i][c & 0xF] |= bit;
+            this->high_buckets[i][c >> 4] |= bit;
+         }
+      }
+#endif
+   }
+};
+
+static const Automaton &automaton() {
+   static const Automaton result;
+   return result;
+}
+
+struct Hit
+{
+   std::size_t offset;
+   std::size_t pattern;
+};
+
+#if defined(LIBFACADE_X86)
+LIBFACADE_TARGET("ssse3")
+static __m128i buckets_ssse3(const Automaton &automaton, std::size_t index, __m128i bytes) {
+   const auto nibble = _mm_set1_epi8(0x0F);
+   auto low = _mm_load_si128(reinterpret_cast<const __m128i *>(automaton.low_buckets[index].data()));
+   auto high = _mm_load_si128(reinterpret_cast<const __m128i *>(automaton.high_buckets[index].data()));
+
+   return _mm_and_si128(_mm_shuffle_epi8(low, _mm_and_si128(bytes, nibble)),
+                        _mm_shuffle_epi8(high, _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble)));
+}
+
+/* skip ahead to the next position that might start a pattern, 16 at a time. the second byte of each position is
+   read too, so this stops a byte short of the end of the buffer. */
+LIBFACADE_TARGET("ssse3")
+static std::size_t skip_ssse3(const Automaton &automaton, const std::uint8_t *data, std::size_t size, std::size_t offset,
+                              std::size_t end) {
+   const auto zero = _mm_setzero_si128();
+
+   for (; offset+16<=end && offset+17<=size; offset+=16)
+   {
+      auto first = buckets_ssse3(automaton, 0, _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + offset)));
+      auto second = buckets_ssse3(automaton, 1, _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + offset + 1)));
+      auto candidates = ~_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(first, second), zero)) & 0xFFFF;
+      if (candidates == 0) { continue; }
+
+      while ((candidates & 1) == 0)
+      {
+         candidates >>= 1;
+         ++offset;
+      }
+
+      return offset;
+   }
+
+   return offset;
+}
+#endif
+
+/* skip ahead to the next byte that starts a pattern, or to the end */
+static std::size_t skip(const Automaton &automaton, const std::uint8_t *data, std::size_t size, std::size_t offset,
+                        std::size_t end, bool ssse3) {
+   while (offset < end)
+   {
+#if defined(LIBFACADE_X86)
+      if (ssse3) { offset = skip_ssse3(automaton, data, size, offset, end); }
+#endif
+
+      if (offset >= end || automaton.starts[data[offset]]) { break; }
+      ++offset;
+   }
+
+   return offset;
+}
+
+/* find the patterns starting in [begin, end), reading up to the longest pattern past the end to finish them */
+static void scan_chunk(const std::uint8_t *data, std::size_t size, std::size_t begin, std::size_t end, bool ssse3,
+                       std::vector<Hit> &hits) {
+   auto &automaton = ::automaton();
+   auto limit = std::min(size, end + automaton.longest - 1);
+   std::size_t state = 0;
+   auto offset = begin;
+
+   while (offset < limit)
+   {
+      if (state == 0)
+      {
+         offset = skip(automaton, data, size, offset, end, ssse3);
+
+         /* anything starting from here on belongs to the next chunk */
+         if (offset >= end) { break; }
+      }
+
+      state = automaton.next[state][data[offset]];
+      ++offset;
+
+      for (auto pattern : automaton.matches[state])
+      {
+         auto start = offset - PATTERNS[pattern].bytes.size();
+         if (start < end) { hits.push_back(Hit{start, pattern}); }
+      }
+   }
+}
+
+/* bounds-checked reads of integers in either byte order, relative to the start of a match */
+class FieldReader
+{
+   const std::uint8_t *data;
+   std::size_t size;
+   bool big_endian;
+
+public:
+   FieldReader(const std::uint8_t *data, std::size_t size, bool big_endian=false)
+      : data(data), size(size), big_endian(big_endian) {}
+
+   std::size_t available() const { return this->size; }
+
+   bool read(std::uint64_t offset, std::size_t bytes, std::uint64_t &value) const {
+      if (offset > this->size || bytes > this->size - offset) { return false; }
+
+      value = 0;
+
+      for (std::size_t i=0; i<bytes; ++i)
+      {
+         std::uint64_t byte = this->data[offset + i];
+
+         if (this->big_endian) { value = (value << 8) | byte; }
+         else { value |= byte << (i * 8); }
+      }
+
+      return true;
+   }
+};
+
+/* walk the chunks up to IEND. the first chunk has to be a 13-byte IHDR for the signature to count. */
+static bool measure_png(const FieldReader &reader, EmbeddedFile &file) {
+   std::uint64_t length, tag;
+   if (!reader.read(8, 4, length) || !reader.read(12, 4, tag)) { return false; }
+   if (length != 13 || tag != png::fourcc("IHDR")) { return false; }
+
+   std::uint64_t offset = 8;
+
+   while (reader.read(offset, 4, length) && reader.read(offset + 4, 4, tag))
+   {
+      if (length > 0x7FFFFFFF) { break; }
+
+      offset += 12 + length;
+      if (offset > reader.available()) { break; }
+
+      if (tag == png::fourcc("IEND"))
+      {
+         file.size = offset;
+         file.exact_size = true;
+         break;
+      }
+   }
+
+   return true;
+}
+
+/* an archive runs to the end of its central directory, which is the first one following its first local header */
+static bool measure_zip(const FieldReader &reader, const std::uint8_t *base, std::size_t offset,
+                        const std::vector<std::size_t> &zip_ends, EmbeddedFile &file) {
+   auto end = std::lower_bound(zip_ends.begin(), zip_ends.end(), offset + 4);
+   if (end == zip_ends.end()) { return true; }
+
+   FieldReader record(base + *end, reader.available() - (*end - offset));
+   std::uint64_t comment;
+   if (!record.read(20, 2, comment) || 22 + comment > record.available()) { return true; }
+
+   file.size = *end - offset + 22 + comment;
+   file.exact_size = true;
+
+   return true;
+}
+
+/* the start header holds the offset and size of the header at the end of the archive, relative to its own end */
+static bool measure_7z(const FieldReader &reader, EmbeddedFile &file) {
+   std::uint64_t major, next_offset, next_size;
+   if (!reader.read(6, 1, major) || major != 0) { return false; }
+   if (!reader.read(12, 8, next_offset) || !reader.read(20, 8, next_size)) { return true; }
+
+   if (next_offset > reader.available() || next_size > reader.available() - next_offset
+       || 32 + next_offset + next_size > reader.available())
+      return true;
+
+   file.size = static_cast<std::size_t>(32 + next_offset + next_size);
+   file.exact_size = true;
+
+   return true;
+}
+
+/* the dos header points at the pe header, whose section table says where the raw data of each section lies */
+static bool measure_pe(const FieldReader &reader, EmbeddedFile &file) {
+   std::uint64_t pe_offset, signature;
+   if (!reader.read(0x3C, 4, pe_offset) || pe_offset < 0x40 || pe_offset > 0x1000000) { return false; }
+   if (!reader.read(pe_offset, 4, signature) || signature != 0x4550) { return false; }
+
+   std::uint64_t sections, optional_size;
+   if (!reader.read(pe_offset + 6, 2, sections) || !reader.read(pe_offset + 20, 2, optional_size)) { return true; }
+
+   auto table = pe_offset + 24 + optional_size;
+   auto end = table + sections * 40;
+
+   for (std::uint64_t i=0; i<sections; ++i)
+   {
+      std::uint64_t raw_size, raw_offset;
+      if (!reader.read(table + i * 40 + 16, 4, raw_size) || !reader.read(table + i * 40 + 20, 4, raw_offset)) { return true; }
+      if (raw_size > 0) { end = std::max(end, raw_offset + raw_size); }
+   }
+
+   if (end > reader.available()) { return true; }
+
+   file.size = static_cast<std::size_t>(end);
+   file.exact_size = true;
+
+   return true;
+}
+
+/* an elf file ends at the last of its header tables, sections and segments */
+static bool measure_elf(const FieldReader &ident, const std::uint8_t *base, EmbeddedFile &file) {
+   std::uint64_t elf_class, encoding, version;
+   if (!ident.read(4, 1, elf_class) || (elf_class != 1 && elf_class != 2)) { return false; }
+   if (!ident.read(5, 1, encoding) || (encoding != 1 && encoding != 2)) { return false; }
+   if (!ident.read(6, 1, version) || version != 1) { return false; }
+
+   FieldReader reader(base, ident.available(), encoding == 2);
+   bool wide = (elf_class == 2);
+   std::size_t word = (wide) ? 8 : 4;
+   std::uint64_t ph_offset, sh_offset, ph_size, ph_count, sh_size, sh_count;
+
+   if (!reader.read((wide) ? 0x20 : 0x1C, word, ph_offset) || !reader.read((wide) ? 0x28 : 0x20, word, sh_offset)
+       || !reader.read((wide) ? 0x36 : 0x2A, 2, ph_size) || !reader.read((wide) ? 0x38 : 0x2C, 2, ph_count)
+       || !reader.read((wide) ? 0x3A : 0x2E, 2, sh_size) || !reader.read((wide) ? 0x3C : 0x30, 2, sh_count))
+      return true;
+
+   if (ph_offset > reader.available() || sh_offset > reader.available()) { return true; }
+
+   std::uint64_t end = (wide) ? 64 : 52;
+   end = std::max(end, ph_offset + ph_size * ph_count);
+   end = std::max(end, sh_offset + sh_size * sh_count);
+
+   for (std::uint64_t i=0; i<ph_count; ++i)
+   {
+      auto header = ph_offset + i * ph_size;
+      std::uint64_t offset, size;
+
+      if (!reader.read(header + ((wide) ? 0x08 : 0x04), word, offset)
+          || !reader.read(header + ((wide) ? 0x20 : 0x10), word, size))
+         return true;
+
+      if (offset > reader.available() || size > reader.available()) { return true; }
+      end = std::max(end, offset + size);
+   }
+
+   for (std::uint64_t i=0; i<sh_count; ++i)
+   {
+      auto header = sh_offset + i * sh_size;
+      std::uint64_t type, offset, size;
+
+      if (!reader.read(header + 4, 4, type) || !reader.read(header + ((wide) ? 0x18 : 0x10), word, offset)
+          || !reader.read(header + ((wide) ? 0x20 : 0x14), word, size))
+         return true;
+
+      /* SHT_NOBITS sections, such as .bss, take no room in the file */
+      if (type == 8) { continue; }
+      if (offset > reader.available() || size > reader.available()) { return true; }
+      end = std::max(end, offset + size);
+   }
+
+   if (end > reader.available()) { return true; }
+
+   file.size = static_cast<std::size_t>(end);
+   file.exact_size = true;
+
+   return true;
+}
+
+/* check a match against the structure of its format, and measure it where the format allows. returns false if the
+   match is a false positive. */
+static bool validate(const std::uint8_t *data, std::size_t size, const std::vector<std::size_t> &zip_ends,
+                     EmbeddedFile &file) {
+   FieldReader reader(data + file.offset, size - file.offset);
+   std::uint64_t value;
+
+   switch (file.format)
+   {
+   case FORMAT_PNG: return measure_png(FieldReader(data + file.offset, size - file.offset, true), file);
+   case FORMAT_ZIP: return measure_zip(reader, data, file.offset, zip_ends, file);
+   case FORMAT_7Z: return measure_7z(reader, file);
+   case FORMAT_PE: return measure_pe(reader, file);
+   case FORMAT_ELF: return measure_elf(reader, data + file.offset, file);
+
+   /* the marker after ff d8 ff is one of the segment markers, which all lie between c0 and fe */
+   case FORMAT_JPEG: return reader.read(3, 1, value) && value >= 0xC0 && value != 0xFF;
+
+   /* the top three flag bits are reserved */
+   case FORMAT_GZIP: return reader.read(3, 1, value) && (value & 0xE0) == 0;
+
+   /* a block size from 1 to 9, then the magic of either the first block or the end of an empty stream */
+   case FORMAT_BZIP2:
+   {
+      if (!reader.read(3, 1, value) || value < '1' || value > '9') { return false; }
+      if (reader.available() < 10) { return false; }
+
+      std::string_view magic(reinterpret_cast<const char *>(data + file.offset + 4), 6);
+      return magic == std::string_view("1AY&SY", 6) || magic == std::string_view("\x17rE8P\x90", 6);
+   }
+
+   default: return true;
+   }
+}
+
+const char *facade::format_name(FileFormat format) {
+   switch (format)
+   {
+   case FORMAT_PNG: return "png";
+   case FORMAT_JPEG: return "jpeg";
+   case FORMAT_GIF: return "gif";
+   case FORMAT_PDF: return "pdf";
+   case FORMAT_ZIP: return "zip";
+   case FORMAT_7Z: return "7z";
+   case FORMAT_RAR: return "rar";
+   case FORMAT_GZIP: return "gzip";
+   case FORMAT_BZIP2: return "bzip2";
+   case FORMAT_XZ: return "xz";
+   case FORMAT_PE: return "pe";
+   case FORMAT_ELF: return "elf";
+   default: return "unknown";
+   }
+}
+
+const char *facade::format_extension(FileFormat format) {
+   switch (format)
+   {
+   case FORMAT_PNG: return "png";
+   case FORMAT_JPEG: return "jpg";
+   case FORMAT_GIF: return "gif";
+   case FORMAT_PDF: return "pdf";
+   case FORMAT_ZIP: return "zip";
+   case FORMAT_7Z: return "7z";
+   case FORMAT_RAR: return "rar";
+   case FORMAT_GZIP: return "gz";
+   case FORMAT_BZIP2: return "bz2";
+   case FORMAT_XZ: return "xz";
+   case FORMAT_PE: return "exe";
+   case FORMAT_ELF: return "elf";
+   default: return "bin";
+   }
+}
+
+std::vector<EmbeddedFile> facade::scan_signatures(const void *ptr, std::size_t size, Executor &executor) {
+   if (ptr == nullptr && size > 0) { throw exception::NullPointer(); }
+
+   auto data = reinterpret_cast<const std::uint8_t *>(ptr);
+   bool ssse3 = false;
+
+#if defined(LIBFACADE_X86)
+   ssse3 = cpu_has_ssse3();
+#endif
+
+   std::vector<Hit> hits;
+   std::mutex hits_mutex;
+   auto chunks = (size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+   executor.parallel_for(chunks, [&](std::size_t chunk) {
+      std::vector<Hit> chunk_hits;
+      scan_chunk(data, size, chunk * CHUNK_SIZE, std::min(size, (chunk + 1) * CHUNK_SIZE), ssse3, chunk_hits);
+
+      std::lock_guard<std::mutex> lock(hits_mutex);
+      hits.insert(hits.end(), chunk_hits.begin(), chunk_hits.end());
+   });
+
+   std::sort(hits.begin(), hits.end(), [](const Hit &left, const Hit &right) {
+      return (left.offset != right.offset) ? left.offset < right.offset : left.pattern < right.pattern;
+   });
+
+   std::vector<std::size_t> zip_ends;
+
+   for (auto &hit : hits)
+      if (PATTERNS[hit.pattern].format == ZIP_END) { zip_ends.push_back(hit.offset); }
+
+   std::vector<EmbeddedFile> result;
+   std::size_t covered = 0;
+
+   for (auto &hit : hits)
+   {
+      auto format = PATTERNS[hit.pattern].format;
+      if (format == ZIP_END || hit.offset < covered) { continue; }
+
+      EmbeddedFile file = { static_cast<FileFormat>(format), hit.offset, 0, false };
+      if (!validate(data, size, zip_ends, file)) { continue; }
+
+      /* the rest of an exactly measured file belongs to it, like the local headers of a zip archive */
+      if (file.exact_size) { covered = file.offset + file.size; }
+
+      result.push_back(file);
+   }
+
+   for (std::size_t i=0; i<result.size(); ++i)
+   {
+      if (result[i].exact_size) { continue; }
+      result[i].size = ((i+1 < result.size()) ? result[i+1].offset : size) - result[i].offset;
+   }
+
+   return result;
+}
+
+std::vector<EmbeddedFile> facade::scan_signatures(const std::vector<std::uint8_t> &data, Executor &executor) {
+   return scan_signatures(data.data(), data.size(), executor);
+}
@@ -0,0 +1,244 @@
+#include <facade.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace facade;
+
+static const char *FILTER_NAMES[5] = { "none", "sub", "up", "average", "paeth" };
+
+const char *facade::stage_name(Stage stage) {
+   switch (stage)
+   {
+   case STAGE_READ: return "read";
+   case STAGE_PARSE: return "parse";
+   case STAGE_CRC: return "crc";
+   case STAGE_INFLATE: return "inflate";
+   case STAGE_RECONSTRUCT: return "reconstruct";
+   case STAGE_EMBED: return "embed";
+   case STAGE_EXTRACT: return "extract";
+   case STAGE_ANALYZE: return "analyze";
+   case STAGE_FILTER: return "filter";
+   case STAGE_DEFLATE: return "deflate";
+   case STAGE_WRITE: return "write";
+   default: return "unknown";
+   }
+}
+
+void Stats::record(Stage stage, std::uint64_t start, std::uint64_t duration, std::uint64_t bytes_in, std::uint64_t bytes_out) {
+   std::lock_guard<std::mutex> lock(this->mutex);
+
+   auto &totals = this->stages[stage];
+   ++totals.calls;
+   totals.nanoseconds += duration;
+   totals.bytes_in += bytes_in;
+   totals.bytes_out += bytes_out;
+
+   if (!this->tracing) { return; }
+
+   /* number threads in the order they first show up, which reads better in the trace viewer than hashed ids */
+   auto thread = this->threads.insert(std::make_pair(std::this_thread::get_id(), this->threads.size())).first->second;
+   auto relative_start = (start > this->epoch) ? start - this->epoch : 0;
+
+   this->events.push_back(TraceEvent{ stage, relative_start, duration, bytes_in, bytes_out, thread });
+}
+
+void Stats::record_memory(Stage stage, std::size_t allocations, std::size_t peak_bytes) {
+   std::lock_guard<std::mutex> lock(this->mutex);
+
+   auto &totals = this->stages[stage];
+   totals.allocations += allocations;
+   totals.peak_bytes = std::max(totals.peak_bytes, peak_bytes);
+}
+
+void Stats::add_parsed_chunks(std::size_t count) {
+   std::lock_guard<std::mutex> lock(this->mutex);
+   this->parsed_chunks += count;
+}
+
+void Stats::add_written_chunks(std::size_t count) {
+   std::lock_guard<std::mutex> lock(this->mutex);
+   this->written_chunks += count;
+}
+
+void Stats::add_filter_types(const std::array<std::size_t, 5> &counts) {
+   std::lock_guard<std::mutex> lock(this->mutex);
+
+   for (std::size_t i=0; i<counts.size(); ++i)
+      this->filter_types[i] += counts[i];
+}
+
+void Stats::set_memory_tracker(TrackingResource *tracker) {
+   std::lock_guard<std::mutex> lock(this->mutex);
+   this->tracker = tracker;
+}
+
+TrackingResource *Stats::memory_tracker() const {
+   std::lock_guard<std::mutex> lock(this->mutex);
+   return this->tracker;
+}
+
+void Stats::reset() {
+   std::lock_guard<std::mutex> lock(this->mutex);
+
+   this->stages.fill(StageStats());
+   this->parsed_chunks = 0;
+   this->written_chunks = 0;
+   this->filter_types.fill(0);
+   this->events.clear();
+   this->threads.clear();
+   this->epoch = Stats::now();
+}
+
+StageStats Stats::stage(Stage stage) const {
+   std::lock_guard<std::mutex> lock(this->mutex);
+   return this->stages[stage];
+}
+
+std::size_t Stats::chunks_parsed() const {
+   std::lock_guard<std::mutex> lock(this->mutex);
+   return this->parsed_chunks;
+}
+
+std::size_t Stats::chunks_written() const {
+   std::lock_guard<std::mutex> lock(this->mutex);
+   return this->written_chunks;
+}
+
+std::array<std::size_t, 5> Stats::filter_histogram() const {
+   std::lock_guard<std::mutex> lock(this->mutex);
+   return this->filter_types;
+}
+
+bool Stats::is_tracing() const {
+   return this->tracing;
+}
+
+std::vector<TraceEvent> Stats::trace_events() const {
+   std::lock_guard<std::mutex> lock(this->mutex);
+   return this->events;
+}
+
+std::string Stats::to_string() const {
+   std::lock_guard<std::mutex> lock(this->mutex);
+   std::ostringstream stream;
+   char line[160];
+
+   std::snprintf(line, sizeof(line), "%-12s %7s %13s %15s %15s %8s", "stage", "calls", "time", "bytes in", "bytes out", "ratio");
+   stream << line;
+
+   if (this->tracker != nullptr)
+   {
+      std::snprintf(line, sizeof(line), " %10s %15s", "allocs", "peak bytes");
+      stream << line;
+   }
+
+   stream << "\n";
+
+   for (std::size_t i=0; i<STAGE_COUNT; ++i)
+   {
+      auto &totals = this->stages[i];
+      if (totals.calls == 0) { continue; }
+
+      std::snprintf(line, sizeof(line), "%-12s %7zu %10.3f ms %15llu %15llu %8.3f",
+                    stage_name(static_cast<Stage>(i)),
+                    totals.calls,
+                    totals.nanoseconds / 1e6,
+                    static_cast<unsigned long long>(totals.bytes_in),
+                    static_cast<unsigned long long>(totals.bytes_out),
+                    totals.ratio());
+      stream << line;
+
+      if (this->tracker != nullptr)
+      {
+         std::snprintf(line, sizeof(line), " %10zu %15zu", totals.allocations, totals.peak_bytes);
+         stream << line;
+      }
+
+      stream << "\n";
+   }
+
+   if (this->tracker != nullptr)
+      stream << "memory: " << this->tracker->peak_bytes() << " bytes at peak, " << this->tracker->allocations() << " allocations\n";
+
+   stream << "chunks: " << this->parsed_chunks << " parsed, " << this->written_chunks << " written\n";
+   stream << "filter types:";
+
+   for (std::size_t i=0; i<this->filter_types.size(); ++i)
+      stream << " " << FILTER_NAMES[i] << " " << this->filter_types[i];
+
+   stream << "\n";
+
+   return stream.str();
+}
+
+std::string Stats::to_json() const {
+   std::lock_guard<std::mutex> lock(this->mutex);
+   std::ostringstream stream;
+   stream.precision(10);
+
+   stream << "{\"stages\":{";
+
+   for (std::size_t i=0; i<STAGE_COUNT; ++i)
+   {
+      auto &totals = this->stages[i];
+
+      stream << ((i == 0) ? "" : ",") << "\"" << stage_name(static_cast<Stage>(i)) << "\":{"
+             << "\"calls\":" << totals.calls
+             << ",\"seconds\":" << totals.seconds()
+             << ",\"bytes_in\":" << totals.bytes_in
+             << ",\"bytes_out\":" << totals.bytes_out
+             << ",\"ratio\":" << totals.ratio();
+
+      if (this->tracker != nullptr)
+         stream << ",\"allocations\":" << totals.allocations << ",\"peak_bytes\":" << totals.peak_bytes;
+
+      stream << "}";
+   }
+
+   stream << "}";
+
+   if (this->tracker != nullptr)
+      stream << ",\"memory\":{\"allocations\":" << this->tracker->allocations() << ",\"peak_bytes\":" << this->tracker->peak_bytes() << "}";
+
+   stream << ",\"chunks\":{\"parsed\":" << this->parsed_chunks << ",\"written\":" << this->written_chunks << "}";
+   stream << ",\"filter_types\":{";
+
+   for (std::size_t i=0; i<this->filter_types.size(); ++i)
+      stream << ((i == 0) ? "" : ",") << "\"" << FILTER_NAMES[i] << "\":" << this->filter_types[i];
+
+   stream << "}}";
+
+   return stream.str();
+}
+
+std::string Stats::to_chrome_trace() const {
+   std::lock_guard<std::mutex> lock(this->mutex);
+   std::ostringstream stream;
+   stream.precision(15);
+
+   /* trace event timestamps and durations are in microseconds */
+   stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+   for (std::size_t i=0; i<this->events.size(); ++i)
+   {
+      auto &event = this->events[i];
+
+      stream << ((i == 0) ? "\n" : ",\n")
+             << "{\"name\":\"" << stage_name(event.stage) << "\",\"cat\":\"facade\",\"ph\":\"X\""
+             << ",\"ts\":" << event.start / 1e3
+             << ",\"dur\":" << event.duration / 1e3
+             << ",\"pid\":1,\"tid\":" << event.thread
+             << ",\"args\":{\"bytes_in\":" << event.bytes_in << ",\"bytes_out\":" << event.bytes_out << "}}";
+   }
+
+   stream << "\n]}\n";
+
+   return stream.str();
+}
+
+void Stats::save_chrome_trace(const std::string &filename) const {
+   auto trace = this->to_chrome_trace();
+   write_file(filename, trace.data(), trace.size());
+}
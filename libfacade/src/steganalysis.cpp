@@ -0,0 +1,564 @@
+#include <facade.hpp>
+
+#include <cmath>
+#include <mutex>
+#include <optional>
+
+#if defined(LIBFACADE_X86)
+#if defined(LIBFACADE_WIN32)
+#include <intrin.h>
+#endif
+#include <immintrin.h>
+#endif
+
+using namespace facade;
+
+/* indexes into PlaneCounts::groups. the first four count groups of samples as they are, the last four the same groups
+   with every lowest bit flipped. */
+enum RSGroup
+{
+   REGULAR_M = 0,
+   SINGULAR_M,
+   REGULAR_NEG_M,
+   SINGULAR_NEG_M,
+   FLIPPED_REGULAR_M,
+   FLIPPED_SINGULAR_M,
+   FLIPPED_REGULAR_NEG_M,
+   FLIPPED_SINGULAR_NEG_M,
+   RS_GROUP_COUNT
+};
+
+/* the counts behind the rs and sample pair estimates of one bit plane. these only ever add up, so the counts of
+   separate row ranges, or of separate channels, can be merged with a sum. */
+struct PlaneCounts
+{
+   /* sample pair analysis: horizontally adjacent pairs (u, v) where u and v are ordered the same way as v and its
+      lowest bit flipped (x), the other way (y), equal (z), or differ only in their lowest bit (w) */
+   std::uint64_t x = 0, y = 0, z = 0, w = 0, pairs = 0;
+   std::array<std::uint64_t, RS_GROUP_COUNT> groups = {};
+
+   void merge(const PlaneCounts &other) {
+      this->x += other.x;
+      this->y += other.y;
+      this->z += other.z;
+      this->w += other.w;
+      this->pairs += other.pairs;
+
+      for (std::size_t i=0; i<RS_GROUP_COUNT; ++i)
+         this->groups[i] += other.groups[i];
+   }
+};
+
+/* the counts behind the estimates of a channel, with the bit planes above the lowest analyzed as the lowest bit of
+   the samples shifted down */
+struct LSBCounts
+{
+   /* four interleaved histograms, so runs of equal samples don't stall on incrementing the same counter */
+   std::array<std::uint64_t, 256 * 4> histograms = {};
+   std::array<PlaneCounts, LSB_PLANES> planes;
+
+   void merge(const LSBCounts &other) {
+      for (std::size_t i=0; i<this->histograms.size(); ++i)
+         this->histograms[i] += other.histograms[i];
+
+      for (std::size_t i=0; i<LSB_PLANES; ++i)
+         this->planes[i].merge(other.planes[i]);
+   }
+
+   std::array<std::uint64_t, 256> histogram() const {
+      std::array<std::uint64_t, 256> result;
+
+      for (std::size_t i=0; i<256; ++i)
+         result[i] = this->histograms[i] + this->histograms[256+i] + this->histograms[512+i] + this->histograms[768+i];
+
+      return result;
+   }
+};
+
+static std::size_t popcount16(std::uint32_t bits) {
+   bits = bits - ((bits >> 1) & 0x5555);
+   bits = (bits & 0x3333) + ((bits >> 2) & 0x3333);
+   bits = (bits + (bits >> 4)) & 0x0F0F;
+   return (bits + (bits >> 8)) & 0x1F;
+}
+
+static void count_histogram(const std::uint8_t *samples, std::size_t count, LSBCounts &counts) {
+   auto &tables = counts.histograms;
+   std::size_t i = 0;
+
+   for (; i+4 <= count; i+=4)
+   {
+      ++tables[samples[i]];
+      ++tables[256 + samples[i+1]];
+      ++tables[512 + samples[i+2]];
+      ++tables[768 + samples[i+3]];
+   }
+
+   for (; i<count; ++i)
+      ++tables[samples[i]];
+}
+
+static void count_pairs_from(const std::uint8_t *samples, std::size_t count, std::size_t start, PlaneCounts &counts) {
+   for (auto i=start; i+1<count; ++i)
+   {
+      auto u = samples[i];
+      auto v = samples[i+1];
+
+      if (u == v) { ++counts.z; continue; }
+      if ((u < v) == ((v & 1) == 0)) { ++counts.x; }
+      else { ++counts.y; }
+      if ((u ^ v) == 1) { ++counts.w; }
+   }
+}
+
+static int discrimination(int a, int b, int c, int d) {
+   return std::abs(b - a) + std::abs(c - b) + std::abs(d - c);
+}
+
+static int flip_positive(int value) { return value ^ 1; }
+static int flip_negative(int value) { return ((value + 1) ^ 1) - 1; }
+
+static void count_groups_from(const std::uint8_t *samples, std::size_t count, std::size_t start, PlaneCounts &counts) {
+   auto tally = [&counts](int original, int flipped, std::size_t regular) {
+      if (flipped > original) { ++counts.groups[regular]; }
+      else if (flipped < original) { ++counts.groups[regular+1]; }
+   };
+
+   for (auto i=start; i+4<=count; i+=4)
+   {
+      int x0 = samples[i], x1 = samples[i+1], x2 = samples[i+2], x3 = samples[i+3];
+      auto base = discrimination(x0, x1, x2, x3);
+      tally(base, discrimination(x0, flip_positive(x1), flip_positive(x2), x3), REGULAR_M);
+      tally(base, discrimination(x0, flip_negative(x1), flip_negative(x2), x3), REGULAR_NEG_M);
+
+      int y0 = x0 ^ 1, y1 = x1 ^ 1, y2 = x2 ^ 1, y3 = x3 ^ 1;
+      auto flipped = discrimination(y0, y1, y2, y3);
+      tally(flipped, discrimination(y0, flip_positive(y1), flip_positive(y2), y3), FLIPPED_REGULAR_M);
+      tally(flipped, discrimination(y0, flip_negative(y1), flip_negative(y2), y3), FLIPPED_REGULAR_NEG_M);
+   }
+}
+
+#if defined(LIBFACADE_X86)
+/* split 16 interleaved pixels of the given number of channels into one vector per color channel. alpha, which is
+   always the last channel when present, is left out. */
+template <std::size_t Channels>
+LIBFACADE_TARGET("ssse3")
+static void deinterleave_ssse3(const std::uint8_t *pixels, std::size_t colors, std::uint8_t *const *rows,
+                               std::size_t offset) {
+   /* byte j of channel c comes from byte j * Channels + c, which lives in the input vector of that offset / 16 */
+   static const auto masks = []() {
+      std::array<std::array<std::int8_t, 16>, Channels * Channels> result;
+
+      for (std::size_t c=0; c<Channels; ++c)
+         for (std::size_t k=0; k<Channels; ++k)
+            for (std::size_t j=0; j<16; ++j)
+            {
+               auto source = j * Channels + c;
+               result[c * Channels + k][j] = (source / 16 == k) ? static_cast<std::int8_t>(source % 16) : -1;
+            }
+
+      return result;
+   }();
+
+   __m128i input[Channels];
+
+   for (std::size_t k=0; k<Channels; ++k)
+      input[k] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels + k * 16));
+
+   for (std::size_t c=0; c<colors; ++c)
+   {
+      auto plane = _mm_setzero_si128();
+
+      for (std::size_t k=0; k<Channels; ++k)
+      {
+         auto mask = _mm_loadu_si128(reinterpret_cast<const __m128i *>(masks[c * Channels + k].data()));
+         plane = _mm_or_si128(plane, _mm_shuffle_epi8(input[k], mask));
+      }
+
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(rows[c] + offset), plane);
+   }
+}
+
+/* classify 16 adjacent pairs at a time. unsigned bytes are compared by moving them into signed range first. */
+LIBFACADE_TARGET("sse2")
+static std::size_t count_pairs_sse2(const std::uint8_t *samples, std::size_t count, PlaneCounts &counts) {
+   const auto bias = _mm_set1_epi8(static_cast<char>(0x80));
+   const auto one = _mm_set1_epi8(1);
+   const auto high_bits = _mm_set1_epi8(static_cast<char>(0xFE));
+   const auto zero = _mm_setzero_si128();
+   std::size_t i = 0;
+
+   for (; i+17<=count; i+=16)
+   {
+      auto u = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i));
+      auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i + 1));
+      auto less = _mm_cmpgt_epi8(_mm_xor_si128(v, bias), _mm_xor_si128(u, bias));
+      auto greater = _mm_cmpgt_epi8(_mm_xor_si128(u, bias), _mm_xor_si128(v, bias));
+      auto equal = _mm_cmpeq_epi8(u, v);
+      auto odd = _mm_cmpeq_epi8(_mm_and_si128(v, one), one);
+      auto x = _mm_or_si128(_mm_andnot_si128(odd, less), _mm_and_si128(odd, greater));
+      auto w = _mm_andnot_si128(equal, _mm_cmpeq_epi8(_mm_and_si128(_mm_xor_si128(u, v), high_bits), zero));
+
+      counts.x += popcount16(_mm_movemask_epi8(x));
+      counts.y += popcount16(_mm_movemask_epi8(_mm_or_si128(less, greater))) - popcount16(_mm_movemask_epi8(x));
+      counts.z += popcount16(_mm_movemask_epi8(equal));
+      counts.w += popcount16(_mm_movemask_epi8(w));
+   }
+
+   return i;
+}
+
+LIBFACADE_TARGET("ssse3")
+static __m128i discrimination_ssse3(__m128i a, __m128i b, __m128i c, __m128i d) {
+   return _mm_add_epi16(_mm_add_epi16(_mm_abs_epi16(_mm_sub_epi16(b, a)), _mm_abs_epi16(_mm_sub_epi16(c, b))),
+                        _mm_abs_epi16(_mm_sub_epi16(d, c)));
+}
+
+LIBFACADE_TARGET("sse2")
+static __m128i flip_negative_sse2(__m128i value) {
+   const auto one = _mm_set1_epi16(1);
+   return _mm_sub_epi16(_mm_xor_si128(_mm_add_epi16(value, one), one), one);
+}
+
+/* each 16-bit lane sets two bits of the movemask */
+LIBFACADE_TARGET("sse2")
+static void tally_groups_sse2(__m128i original, __m128i flipped, std::size_t regular, PlaneCounts &counts) {
+   counts.groups[regular] += popcount16(_mm_movemask_epi8(_mm_cmpgt_epi16(flipped, original))) / 2;
+   counts.groups[regular+1] += popcount16(_mm_movemask_epi8(_mm_cmpgt_epi16(original, flipped))) / 2;
+}
+
+/* work on 8 groups at a time, widened to 16-bit lanes so the flips below 0 and above 255 don't wrap */
+LIBFACADE_TARGET("ssse3")
+static std::size_t count_groups_ssse3(const std::uint8_t *samples, std::size_t count, PlaneCounts &counts) {
+   const auto transpose = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+   const auto one = _mm_set1_epi16(1);
+   const auto zero = _mm_setzero_si128();
+   std::size_t i = 0;
+
+   for (; i+32<=count; i+=32)
+   {
+      auto a = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i)), transpose);
+      auto b = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i + 16)), transpose);
+      auto low = _mm_unpacklo_epi32(a, b);
+      auto high = _mm_unpackhi_epi32(a, b);
+      auto x0 = _mm_unpacklo_epi8(low, zero), x1 = _mm_unpackhi_epi8(low, zero);
+      auto x2 = _mm_unpacklo_epi8(high, zero), x3 = _mm_unpackhi_epi8(high, zero);
+
+      auto base = discrimination_ssse3(x0, x1, x2, x3);
+      auto m1 = _mm_xor_si128(x1, one), m2 = _mm_xor_si128(x2, one);
+      tally_groups_sse2(base, discrimination_ssse3(x0, m1, m2, x3), REGULAR_M, counts);
+      tally_groups_sse2(base, discrimination_ssse3(x0, flip_negative_sse2(x1), flip_negative_sse2(x2), x3),
+                        REGULAR_NEG_M, counts);
+
+      /* flipping the lowest bit of a sample twice gives the sample back */
+      auto y0 = _mm_xor_si128(x0, one), y1 = m1, y2 = m2, y3 = _mm_xor_si128(x3, one);
+      auto flipped = discrimination_ssse3(y0, y1, y2, y3);
+      tally_groups_sse2(flipped, discrimination_ssse3(y0, x1, x2, y3), FLIPPED_REGULAR_M, counts);
+      tally_groups_sse2(flipped, discrimination_ssse3(y0, flip_negative_sse2(y1), flip_negative_sse2(y2), y3),
+                        FLIPPED_REGULAR_NEG_M, counts);
+   }
+
+   return i;
+}
+#endif
+
+static void count_plane(const std::uint8_t *samples, std::size_t count, bool ssse3, PlaneCounts &counts) {
+   std::size_t pairs = 0, groups = 0;
+
+#if defined(LIBFACADE_X86)
+   pairs = count_pairs_sse2(samples, count, counts);
+   if (ssse3) { groups = count_groups_ssse3(samples, count, counts); }
+#endif
+
+   count_pairs_from(samples, count, pairs, counts);
+   count_groups_from(samples, count, groups, counts);
+
+   if (count > 0) { counts.pairs += count - 1; }
+}
+
+/* shifted has room for count samples, and holds each bit plane in turn as the lowest bit */
+static void analyze_channel(const std::uint8_t *samples, std::size_t count, bool ssse3, std::uint8_t *shifted,
+                            LSBCounts &counts) {
+   count_histogram(samples, count, counts);
+   count_plane(samples, count, ssse3, counts.planes[0]);
+
+   for (std::size_t plane=1; plane<LSB_PLANES; ++plane)
+   {
+      for (std::size_t i=0; i<count; ++i)
+         shifted[i] = samples[i] >> plane;
+
+      count_plane(shifted, count, ssse3, counts.planes[plane]);
+   }
+}
+
+static void deinterleave(const std::uint8_t *pixels, std::size_t width, std::size_t channels, std::size_t colors,
+                         bool ssse3, std::uint8_t *const *rows) {
+   std::size_t x = 0;
+
+#if defined(LIBFACADE_X86)
+   if (ssse3)
+   {
+      for (; x+16<=width; x+=16)
+      {
+         switch (channels)
+         {
+         case 2: deinterleave_ssse3<2>(&pixels[x * 2], colors, rows, x); break;
+         case 3: deinterleave_ssse3<3>(&pixels[x * 3], colors, rows, x); break;
+         case 4: deinterleave_ssse3<4>(&pixels[x * 4], colors, rows, x); break;
+         }
+      }
+   }
+#endif
+
+   for (; x<width; ++x)
+      for (std::size_t c=0; c<colors; ++c)
+         rows[c][x] = pixels[x * channels + c];
+}
+
+/* the regularized upper incomplete gamma function Q(a, x), by its series below a+1 and its continued fraction above,
+   which is the chance of a chi-square statistic of 2x or more with 2a degrees of freedom */
+static double upper_gamma(double a, double x) {
+   if (x <= 0.0) { return 1.0; }
+
+   auto log_prefix = -x + a * std::log(x) - std::lgamma(a);
+
+   if (x < a + 1.0)
+   {
+      double term = 1.0 / a, sum = term;
+
+      for (std::size_t n=1; n<1000 && std::abs(term) > std::abs(sum) * 1e-15; ++n)
+      {
+         term *= x / (a + n);
+         sum += term;
+      }
+
+      return std::max(0.0, 1.0 - sum * std::exp(log_prefix));
+   }
+
+   const double tiny = 1e-300;
+   double b = x + 1.0 - a, c = 1.0 / tiny, d = 1.0 / b, h = d;
+
+   for (std::size_t n=1; n<1000; ++n)
+   {
+      auto an = -static_cast<double>(n) * (n - a);
+      b += 2.0;
+      d = an * d + b;
+      if (std::abs(d) < tiny) { d = tiny; }
+      c = b + an / c;
+      if (std::abs(c) < tiny) { c = tiny; }
+      d = 1.0 / d;
+      auto delta = d * c;
+      h *= delta;
+      if (std::abs(delta - 1.0) < 1e-15) { break; }
+   }
+
+   return std::exp(log_prefix) * h;
+}
+
+/* if the lowest bits were overwritten with random data, each pair of values 2k and 2k+1 ends up with about as many
+   samples as the other. the closer the histogram is to that, the higher the chance of a payload. */
+static double estimate_chi_square(const std::array<std::uint64_t, 256> &histogram) {
+   double statistic = 0.0;
+   std::size_t categories = 0;
+
+   for (std::size_t k=0; k<128; ++k)
+   {
+      auto expected = (histogram[k*2] + histogram[k*2+1]) / 2.0;
+
+      /* pairs which barely occur say nothing, and would swamp the statistic */
+      if (expected < 5.0) { continue; }
+
+      auto difference = histogram[k*2] - expected;
+      statistic += difference * difference / expected;
+      ++categories;
+   }
+
+   if (categories < 2) { return 0.0; }
+
+   return upper_gamma((categories - 1) / 2.0, statistic / 2.0);
+}
+
+/* the root of a*x^2 + b*x + c closest to zero, or nullopt if there isn't a real one */
+static std::optional<double> smallest_root(double a, double b, double c) {
+   if (a == 0.0)
+   {
+      if (b == 0.0) { return std::nullopt; }
+      return -c / b;
+   }
+
+   auto discriminant = b * b - 4.0 * a * c;
+   if (discriminant < 0.0) { return std::nullopt; }
+
+   auto root = std::sqrt(discriminant);
+   auto first = (-b + root) / (2.0 * a);
+   auto second = (-b - root) / (2.0 * a);
+
+   return (std::abs(first) < std::abs(second)) ? first : second;
+}
+
+/* fridrich, goljan and du: flipping the lowest bits of a clean image makes more groups regular under M than -M, and
+   embedding closes that gap. the gap on the image and on the image with every lowest bit flipped give a quadratic in
+   the payload length. */
+static double estimate_rs(const PlaneCounts &counts) {
+   auto &groups = counts.groups;
+   auto d0 = static_cast<double>(groups[REGULAR_M]) - static_cast<double>(groups[SINGULAR_M]);
+   auto d1 = static_cast<double>(groups[FLIPPED_REGULAR_M]) - static_cast<double>(groups[FLIPPED_SINGULAR_M]);
+   auto n0 = static_cast<double>(groups[REGULAR_NEG_M]) - static_cast<double>(groups[SINGULAR_NEG_M]);
+   auto n1 = static_cast<double>(groups[FLIPPED_REGULAR_NEG_M]) - static_cast<double>(groups[FLIPPED_SINGULAR_NEG_M]);
+
+   auto root = smallest_root(2.0 * (d1 + d0), n0 - n1 - d1 - 3.0 * d0, d0 - n0);
+   if (!root.has_value() || *root == 0.5) { return 0.0; }
+
+   return *root / (*root - 0.5);
+}
+
+/* dumitrescu, wu and wang: in a clean image, pairs ordered the same way as the lowest bit of their second sample
+   (x) are about as common as the rest (y). embedding moves pairs between the two at a rate set by the payload. */
+static double estimate_sample_pairs(const PlaneCounts &counts) {
+   if (counts.pairs == 0) { return 0.0; }
+
+   auto x = static_cast<double>(counts.x), y = static_cast<double>(counts.y);
+   auto z = static_cast<double>(counts.z), w = static_cast<double>(counts.w);
+   auto a = (w + z) / 2.0, b = 2.0 * x - static_cast<double>(counts.pairs), c = y - x;
+
+   if (a == 0.0) { return (b == 0.0) ? 0.0 : -c / b; }
+
+   auto discriminant = b * b - 4.0 * a * c;
+   if (discriminant < 0.0) { return 0.0; }
+
+   auto root = std::sqrt(discriminant);
+
+   return std::min((-b + root) / (2.0 * a), (-b - root) / (2.0 * a));
+}
+
+static std::array<LSBEstimate, LSB_PLANES> estimate(const LSBCounts &counts) {
+   std::array<LSBEstimate, LSB_PLANES> result;
+   auto histogram = counts.histogram();
+
+   for (std::size_t plane=0; plane<LSB_PLANES; ++plane)
+   {
+      /* the histogram of the samples shifted down to this plane */
+      std::array<std::uint64_t, 256> shifted = {};
+
+      for (std::size_t value=0; value<256; ++value)
+         shifted[value >> plane] += histogram[value];
+
+      result[plane].chi_square = estimate_chi_square(shifted);
+      result[plane].rs = estimate_rs(counts.planes[plane]);
+      result[plane].sample_pairs = estimate_sample_pairs(counts.planes[plane]);
+   }
+
+   return result;
+}
+
+double LSBEstimate::score() const {
+   auto clamp = [](double value) { return (std::isnan(value)) ? 0.0 : std::min(1.0, std::max(0.0, value)); };
+
+   /* the length estimates break down once nearly every lowest bit has been replaced, which is where the chi-square
+      test saturates instead */
+   return std::max(clamp(this->chi_square), (clamp(this->rs) + clamp(this->sample_pairs)) / 2.0);
+}
+
+double LSBAnalysis::score() const {
+   double result = 0.0;
+
+   for (auto &plane : this->planes)
+      result = std::max(result, plane.score());
+
+   return result;
+}
+
+LSBAnalysis facade::analyze_lsb(const png::Image &image) {
+   if (!image.is_loaded()) { throw exception::NoImageData(); }
+
+   auto &header = image.header();
+   auto pixel_type = header.pixel_type();
+   std::size_t channels, colors;
+
+   switch (pixel_type)
+   {
+   case png::PixelEnum::GRAYSCALE_PIXEL_8BIT: channels = 1; colors = 1; break;
+   case png::PixelEnum::ALPHA_GRAYSCALE_PIXEL_8BIT: channels = 2; colors = 1; break;
+   case png::PixelEnum::TRUE_COLOR_PIXEL_8BIT: channels = 3; colors = 3; break;
+   case png::PixelEnum::ALPHA_TRUE_COLOR_PIXEL_8BIT: channels = 4; colors = 3; break;
+   default: throw exception::UnsupportedPixelType(pixel_type);
+   }
+
+   auto stats = image.stats();
+   StageTimer timer(stats.get(), STAGE_ANALYZE);
+
+   std::size_t width = header.width();
+   std::size_t height = header.height();
+   bool ssse3 = false;
+
+#if defined(LIBFACADE_X86)
+   ssse3 = cpu_has_ssse3();
+#endif
+
+   std::vector<LSBCounts> totals(colors);
+   std::mutex totals_mutex;
+
+   image.executor().parallel_for_ranges(height, 16, [&](std::size_t begin, std::size_t end) {
+      std::vector<LSBCounts> counts(colors);
+      std::vector<std::vector<std::uint8_t>> row_data(colors + 1, std::vector<std::uint8_t>(width));
+      std::vector<std::uint8_t *> rows;
+
+      for (auto &row : row_data)
+         rows.push_back(row.data());
+
+      /* the last row holds the shifted samples of each bit plane */
+      auto shifted = rows.back();
+
+      for (auto y=begin; y<end; ++y)
+      {
+         auto &scanline = image.scanline(y);
+         if (scanline.filter_type() != 0) { throw exception::AlreadyFiltered(); }
+
+         auto pixels = std::visit([](auto &line) { return reinterpret_cast<const std::uint8_t *>(line.pixel_data().data()); },
+                                  *static_cast<const png::ScanlineVariant *>(&scanline));
+
+         /* grayscale samples are already laid out as a single plane */
+         if (channels == 1)
+         {
+            analyze_channel(pixels, width, ssse3, shifted, counts[0]);
+            continue;
+         }
+
+         deinterleave(pixels, width, channels, colors, ssse3, rows.data());
+
+         for (std::size_t c=0; c<colors; ++c)
+            analyze_channel(rows[c], width, ssse3, shifted, counts[c]);
+      }
+
+      std::lock_guard<std::mutex> lock(totals_mutex);
+
+      for (std::size_t c=0; c<colors; ++c)
+         totals[c].merge(counts[c]);
+   });
+
+   LSBAnalysis result;
+   LSBCounts combined;
+
+   for (auto &counts : totals)
+   {
+      ChannelAnalysis channel;
+      channel.histogram = counts.histogram();
+
+      for (std::size_t value=0; value<256; ++value)
+      {
+         channel.samples += channel.histogram[value];
+
+         for (std::size_t bit=0; bit<8; ++bit)
+            if ((value >> bit) & 1) { channel.ones[bit] += channel.histogram[value]; }
+      }
+
+      channel.planes = estimate(counts);
+      result.channels.push_back(channel);
+      combined.merge(counts);
+   }
+
+   result.planes = estimate(combined);
+   timer.set_bytes(width * height * channels, 0);
+
+   return result;
+}
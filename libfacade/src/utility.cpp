@@ -1,20 +1,62 @@
 #include <facade.hpp>
 
+#if defined(LIBFACADE_X86)
+#if defined(LIBFACADE_WIN32)
+#include <intrin.h>
+#endif
+#include <immintrin.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
 using namespace facade;
 
-std::uint16_t facade::endian_swap_16(std::uint16_t value) {
-   std::uint16_t result = value;
-   std::uint8_t *ptr = reinterpret_cast<std::uint8_t *>(&result);
-   std::swap(ptr[0],ptr[1]);
-   return result;
+#if defined(LIBFACADE_X86)
+LIBFACADE_TARGET("ssse3")
+static std::size_t endian_swap_16_ssse3(std::uint8_t *ptr, std::size_t count) {
+   const __m128i shuffle = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+   std::size_t i = 0;
+
+   for (; i+8 <= count; i += 8)
+   {
+      auto block_ptr = reinterpret_cast<__m128i *>(ptr + i * 2);
+      _mm_storeu_si128(block_ptr, _mm_shuffle_epi8(_mm_loadu_si128(block_ptr), shuffle));
+   }
+
+   return i;
 }
 
-std::uint32_t facade::endian_swap_32(std::uint32_t value) {
-   std::uint32_t result = value;
-   std::uint8_t *ptr = reinterpret_cast<std::uint8_t *>(&result);
-   std::swap(ptr[0],ptr[3]);
-   std::swap(ptr[1],ptr[2]);
-   return result;
+LIBFACADE_TARGET("avx2")
+static std::size_t endian_swap_16_avx2(std::uint8_t *ptr, std::size_t count) {
+   const __m256i shuffle = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                                            1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+   std::size_t i = 0;
+
+   for (; i+16 <= count; i += 16)
+   {
+      auto block_ptr = reinterpret_cast<__m256i *>(ptr + i * 2);
+      _mm256_storeu_si256(block_ptr, _mm256_shuffle_epi8(_mm256_loadu_si256(block_ptr), shuffle));
+   }
+
+   return i;
+}
+#endif
+
+void facade::endian_swap_16(void *ptr, std::size_t count) {
+   auto u8_ptr = reinterpret_cast<std::uint8_t *>(ptr);
+   std::size_t i = 0;
+
+#if defined(LIBFACADE_X86)
+   if (facade::cpu_has_avx2())
+      i = endian_swap_16_avx2(u8_ptr, count);
+   else if (facade::cpu_has_ssse3())
+      i = endian_swap_16_ssse3(u8_ptr, count);
+#endif
+
+   for (; i<count; ++i)
+      std::swap(u8_ptr[i*2], u8_ptr[i*2+1]);
 }
 
 std::uint32_t facade::crc32(const void *ptr, std::size_t size, std::uint32_t init_crc) {
@@ -27,52 +69,87 @@ std::uint32_t facade::crc32(const void *ptr, std::size_t size, std::uint32_t ini
    return crc ^ 0xFFFFFFFF;
 }
 
-std::vector<std::uint8_t> facade::compress(const void *ptr, std::size_t size, int level) {
+/* zlib only hands the pointer back when freeing, so each block remembers its own size in front of it. */
+static constexpr std::size_t ZLIB_BLOCK_HEADER = alignof(std::max_align_t);
+
+static voidpf zlib_resource_alloc(voidpf opaque, uInt items, uInt size) {
+   auto resource = static_cast<std::pmr::memory_resource *>(opaque);
+   std::size_t bytes = static_cast<std::size_t>(items) * size + ZLIB_BLOCK_HEADER;
+
+   try {
+      auto block = static_cast<std::uint8_t *>(resource->allocate(bytes, alignof(std::max_align_t)));
+      *reinterpret_cast<std::size_t *>(block) = bytes;
+
+      return block + ZLIB_BLOCK_HEADER;
+   }
+   catch (std::bad_alloc &) {
+      return Z_NULL;
+   }
+}
+
+static void zlib_resource_free(voidpf opaque, voidpf address) {
+   auto resource = static_cast<std::pmr::memory_resource *>(opaque);
+   auto block = static_cast<std::uint8_t *>(address) - ZLIB_BLOCK_HEADER;
+
+   resource->deallocate(block, *reinterpret_cast<std::size_t *>(block), alignof(std::max_align_t));
+}
+
+/* how much of the result compress_into makes room for ahead of each deflate call. */
+static constexpr std::size_t ZLIB_OUTPUT_WINDOW = 65536;
+
+/* points zlib's internal state at the given resource, or leaves it on zlib's own allocator if there isn't one. */
+static void zlib_use_resource(z_stream &stream, std::pmr::memory_resource *resource) {
+   stream.zalloc = (resource == nullptr) ? Z_NULL : zlib_resource_alloc;
+   stream.zfree = (resource == nullptr) ? Z_NULL : zlib_resource_free;
+   stream.opaque = resource;
+}
+
+template <typename Vector>
+static void compress_into(Vector &result, const void *ptr, std::size_t size, int level, std::pmr::memory_resource *resource) {
    int z_result;
    z_stream stream;
    auto u8_ptr = reinterpret_cast<const std::uint8_t *>(ptr);
-   std::vector<std::uint8_t> result;
 
-   stream.zalloc = Z_NULL;
-   stream.zfree = Z_NULL;
-   stream.opaque = Z_NULL;
+   zlib_use_resource(stream, resource);
    z_result = deflateInit(&stream, level);
    if (z_result != Z_OK) { throw exception::ZLibError(z_result); }
 
    stream.avail_in = static_cast<std::uint32_t>(size);
    stream.next_in = const_cast<std::uint8_t *>(u8_ptr);
 
+   /* reserve the worst case so the result never reallocates, then deflate straight into it a window at a time. only
+      the window ahead of the output is zero-filled, rather than the whole bound. */
+   result.reserve(deflateBound(&stream, stream.avail_in));
+
    do
    {
-      std::uint8_t chunk[8192];
-      std::memset(chunk, 0, sizeof(chunk));
+      /* the last window stops at the reserved capacity, so growing into it never reallocates */
+      auto written = result.size();
+      auto window = (result.capacity() > written) ? std::min(ZLIB_OUTPUT_WINDOW, result.capacity() - written) : ZLIB_OUTPUT_WINDOW;
+      result.resize(written + window);
+      stream.next_out = result.data() + written;
+      stream.avail_out = static_cast<std::uint32_t>(window);
 
-      stream.avail_out = 8192;
-      stream.next_out = &chunk[0];
       z_result = deflate(&stream, Z_FINISH);
-      if (z_result != Z_STREAM_END && z_result != Z_OK) { throw exception::ZLibError(z_result); }
+      if (z_result != Z_OK && z_result != Z_STREAM_END)
+      {
+         deflateEnd(&stream);
+         throw exception::ZLibError(z_result);
+      }
 
-      result.insert(result.end(), &chunk[0], &chunk[8192 - stream.avail_out]);
-   } while (stream.avail_out == 0);
+      result.resize(written + window - stream.avail_out);
+   } while (z_result != Z_STREAM_END);
 
    deflateEnd(&stream);
-
-   return result;
 }
 
-std::vector<std::uint8_t> facade::compress(const std::vector<std::uint8_t> &vec, int level) {
-   return facade::compress(vec.data(), vec.size(), level);
-}
-
-std::vector<std::uint8_t> facade::decompress(const void *ptr, std::size_t size) {
+template <typename Vector>
+static void decompress_into(Vector &result, const void *ptr, std::size_t size, std::pmr::memory_resource *resource, std::size_t size_hint) {
    int z_result;
    z_stream stream;
    auto u8_ptr = reinterpret_cast<const std::uint8_t *>(ptr);
-   std::vector<std::uint8_t> result;
 
-   stream.zalloc = Z_NULL;
-   stream.zfree = Z_NULL;
-   stream.opaque = Z_NULL;
+   zlib_use_resource(stream, resource);
    stream.avail_in = 0;
    stream.next_in = Z_NULL;
    z_result = inflateInit(&stream);
@@ -80,6 +157,7 @@ std::vector<std::uint8_t> facade::decompress(const void *ptr, std::size_t size)
 
    stream.avail_in = static_cast<std::uint32_t>(size);
    stream.next_in = const_cast<std::uint8_t *>(u8_ptr);
+   result.reserve(size_hint);
 
    do
    {
@@ -88,12 +166,39 @@ std::vector<std::uint8_t> facade::decompress(const void *ptr, std::size_t size)
       stream.avail_out = 8192;
       stream.next_out = &chunk[0];
       z_result = inflate(&stream, Z_NO_FLUSH);
-      if (z_result != Z_OK && z_result != Z_STREAM_END) { throw exception::ZLibError(z_result); }
+      if (z_result != Z_OK && z_result != Z_STREAM_END)
+      {
+         inflateEnd(&stream);
+         throw exception::ZLibError(z_result);
+      }
 
       result.insert(result.end(), &chunk[0], &chunk[8192 - stream.avail_out]);
    } while (z_result != Z_STREAM_END);
 
    inflateEnd(&stream);
+}
+
+std::vector<std::uint8_t> facade::compress(const void *ptr, std::size_t size, int level) {
+   std::vector<std::uint8_t> result;
+   compress_into(result, ptr, size, level, nullptr);
+
+   return result;
+}
+
+std::vector<std::uint8_t> facade::compress(const std::vector<std::uint8_t> &vec, int level) {
+   return facade::compress(vec.data(), vec.size(), level);
+}
+
+std::pmr::vector<std::uint8_t> facade::compress(const void *ptr, std::size_t size, int level, std::pmr::memory_resource *resource) {
+   std::pmr::vector<std::uint8_t> result(resource);
+   compress_into(result, ptr, size, level, resource);
+
+   return result;
+}
+
+std::vector<std::uint8_t> facade::decompress(const void *ptr, std::size_t size) {
+   std::vector<std::uint8_t> result;
+   decompress_into(result, ptr, size, nullptr, 0);
 
    return result;
 }
@@ -102,115 +207,378 @@ std::vector<std::uint8_t> facade::decompress(const std::vector<std::uint8_t> &ve
    return facade::decompress(vec.data(), vec.size());
 }
 
-bool facade::is_base64_string(const std::string &base64) {
-   std::size_t i=0;
+std::pmr::vector<std::uint8_t> facade::decompress(const void *ptr, std::size_t size, std::pmr::memory_resource *resource, std::size_t size_hint) {
+   std::pmr::vector<std::uint8_t> result(resource);
+   decompress_into(result, ptr, size, resource, size_hint);
 
-   while (i<base64.size() && base64[i] != '=')
-      if (facade::BASE64_ALPHA.find(base64[i++]) == std::string::npos)
-         return false;
+   return result;
+}
 
-   if (i != base64.size())
-      while (i<base64.size())
-         if (base64[i++] != '=')
-            return false;
+bool facade::cpu_has_ssse3() {
+#if defined(LIBFACADE_X86)
+#if defined(LIBFACADE_WIN32)
+   static const bool result = []() {
+      int info[4];
+      __cpuid(info, 1);
+      return (info[2] & (1 << 9)) != 0;
+   }();
+#else
+   static const bool result = __builtin_cpu_supports("ssse3");
+#endif
+   return result;
+#else
+   return false;
+#endif
+}
 
-   return true;
+bool facade::cpu_has_avx2() {
+#if defined(LIBFACADE_X86)
+#if defined(LIBFACADE_WIN32)
+   static const bool result = []() {
+      int info[4];
+      __cpuid(info, 0);
+      if (info[0] < 7) { return false; }
+
+      __cpuid(info, 1);
+      /* the OS needs to save the YMM registers (OSXSAVE + AVX) or AVX2 is useless to us */
+      if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) { return false; }
+      if ((_xgetbv(0) & 6) != 6) { return false; }
+
+      __cpuidex(info, 7, 0);
+      return (info[1] & (1 << 5)) != 0;
+   }();
+#else
+   static const bool result = __builtin_cpu_supports("avx2");
+#endif
+   return result;
+#else
+   return false;
+#endif
 }
 
-// implementation copped and modified from here: http://www.adp-gmbh.ch/cpp/common/base64.html
-std::string facade::base64_encode(const void *ptr, std::size_t size) {
-   std::string ret;
-   std::size_t i = 0;
-   std::size_t j = 0;
-   std::uint8_t char_array_3[3];
-   std::uint8_t char_array_4[4];
-   auto u8_ptr = reinterpret_cast<const std::uint8_t *>(ptr);
+/* maps every byte to its 6-bit base64 value, or 0xFF if it isn't in the alphabet. */
+struct Base64DecodeTable
+{
+   std::uint8_t values[256];
 
-   while (size--) {
-      char_array_3[i++] = *(u8_ptr++);
+   constexpr Base64DecodeTable() : values() {
+      const char alpha[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
       
-      if (i == 3) {
-         char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-         char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-         char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-         char_array_4[3] = char_array_3[2] & 0x3f;
-
-         for(i = 0; (i <4) ; i++)
-            ret += facade::BASE64_ALPHA[char_array_4[i]];
-         
-         i = 0;
-      }
+      for (std::size_t i=0; i<256; ++i)
+         this->values[i] = 0xFF;
+
+      for (std::size_t i=0; i<64; ++i)
+         this->values[static_cast<std::uint8_t>(alpha[i])] = static_cast<std::uint8_t>(i);
    }
+};
+
+static constexpr Base64DecodeTable BASE64_DECODE_TABLE;
+static constexpr const char BASE64_ENCODE_TABLE[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/* the vectorized decoders store a full register per block, so the output buffer needs this much room past
+   the decoded size. */
+static constexpr std::size_t BASE64_DECODE_SLACK = 32;
+
+#if defined(LIBFACADE_X86)
+/* the SSSE3 and AVX2 codecs follow the approach described by Wojciech Muła and Daniel Lemire in
+   "Faster Base64 Encoding and Decoding Using AVX2 Instructions". each lane turns 12 bytes into 16 characters,
+   or 16 characters into 12 bytes. */
+
+LIBFACADE_TARGET("ssse3")
+static inline __m128i base64_encode_lookup_ssse3(__m128i indices) {
+   const __m128i shift_lut = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                           '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                           '/' - 63, 'A', 0, 0);
+   __m128i result = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+   __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+   result = _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+   result = _mm_shuffle_epi8(shift_lut, result);
+
+   return _mm_add_epi8(result, indices);
+}
+
+LIBFACADE_TARGET("ssse3")
+static std::size_t base64_encode_ssse3(const std::uint8_t *in, std::size_t size, char *out) {
+   const __m128i shuffle = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+   std::size_t i = 0;
 
-   if (i)
+   /* each block reads 16 bytes but only consumes 12 */
+   for (; i+16 <= size; i += 12, out += 16)
    {
-      for(j = i; j < 3; j++)
-         char_array_3[j] = '\0';
+      __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+      block = _mm_shuffle_epi8(block, shuffle);
+
+      __m128i t0 = _mm_and_si128(block, _mm_set1_epi32(0x0FC0FC00));
+      __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+      __m128i t2 = _mm_and_si128(block, _mm_set1_epi32(0x003F03F0));
+      __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out), base64_encode_lookup_ssse3(_mm_or_si128(t1, t3)));
+   }
 
-      char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-      char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-      char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-      char_array_4[3] = char_array_3[2] & 0x3f;
+   return i;
+}
 
-      for (j = 0; (j < i + 1); j++)
-         ret += facade::BASE64_ALPHA[char_array_4[j]];
+LIBFACADE_TARGET("avx2")
+static std::size_t base64_encode_avx2(const std::uint8_t *in, std::size_t size, char *out) {
+   const __m256i shuffle = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                                            1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+   const __m256i shift_lut = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                              '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                              '/' - 63, 'A', 0, 0,
+                                              'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                              '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                              '/' - 63, 'A', 0, 0);
+   std::size_t i = 0;
 
-      while((i++ < 3))
-         ret += '=';
+   /* each block reads 28 bytes but only consumes 24 */
+   for (; i+28 <= size; i += 24, out += 32)
+   {
+      __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+      __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i + 12));
+      __m256i block = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+      block = _mm256_shuffle_epi8(block, shuffle);
+
+      __m256i t0 = _mm256_and_si256(block, _mm256_set1_epi32(0x0FC0FC00));
+      __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+      __m256i t2 = _mm256_and_si256(block, _mm256_set1_epi32(0x003F03F0));
+      __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+      __m256i indices = _mm256_or_si256(t1, t3);
+
+      __m256i result = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+      __m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+      result = _mm256_or_si256(result, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+      result = _mm256_add_epi8(_mm256_shuffle_epi8(shift_lut, result), indices);
+
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), result);
    }
 
-   return ret;
+   return i;
+}
+
+/* both decoders stop at the first block containing anything outside the alphabet (including padding) and leave
+   it to the scalar path, which knows how to report the exact offset. */
+LIBFACADE_TARGET("ssse3")
+static void base64_decode_ssse3(const std::uint8_t *in, std::size_t size, std::uint8_t *out, std::size_t &i, std::size_t &o) {
+   const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+   const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+   const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+   const __m128i mask_2f = _mm_set1_epi8(0x2F);
+   const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+   for (; i+16 <= size; i += 16, o += 12)
+   {
+      __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+      __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(block, 4), mask_2f);
+      __m128i lo_nibbles = _mm_and_si128(block, mask_2f);
+      __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+      __m128i lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+
+      if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0xFFFF)
+         break;
+
+      __m128i eq_2f = _mm_cmpeq_epi8(block, mask_2f);
+      __m128i roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(eq_2f, hi_nibbles));
+      block = _mm_add_epi8(block, roll);
+      block = _mm_maddubs_epi16(block, _mm_set1_epi32(0x01400140));
+      block = _mm_madd_epi16(block, _mm_set1_epi32(0x00011000));
+      block = _mm_shuffle_epi8(block, pack);
+
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + o), block);
+   }
+}
+
+LIBFACADE_TARGET("avx2")
+static void base64_decode_avx2(const std::uint8_t *in, std::size_t size, std::uint8_t *out, std::size_t &i, std::size_t &o) {
+   const __m256i lut_lo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                           0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+                                           0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                           0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+   const __m256i lut_hi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                           0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+                                           0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                           0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+   const __m256i lut_roll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+                                             0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+   const __m256i mask_2f = _mm256_set1_epi8(0x2F);
+   const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                         2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+   const __m256i permute = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+
+   for (; i+32 <= size; i += 32, o += 24)
+   {
+      __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+      __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(block, 4), mask_2f);
+      __m256i lo_nibbles = _mm256_and_si256(block, mask_2f);
+      __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+      __m256i lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+
+      if (!_mm256_testz_si256(lo, hi))
+         break;
+
+      __m256i eq_2f = _mm256_cmpeq_epi8(block, mask_2f);
+      __m256i roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(eq_2f, hi_nibbles));
+      block = _mm256_add_epi8(block, roll);
+      block = _mm256_maddubs_epi16(block, _mm256_set1_epi32(0x01400140));
+      block = _mm256_madd_epi16(block, _mm256_set1_epi32(0x00011000));
+      block = _mm256_shuffle_epi8(block, pack);
+      block = _mm256_permutevar8x32_epi32(block, permute);
+
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + o), block);
+   }
+}
+#endif
+
+bool facade::is_base64_string(std::string_view base64) {
+   auto u8_ptr = reinterpret_cast<const std::uint8_t *>(base64.data());
+   std::size_t i=0;
+
+   while (i<base64.size() && BASE64_DECODE_TABLE.values[u8_ptr[i]] != 0xFF)
+      ++i;
+
+   if (i % 4 == 1)
+      return false;
+
+   while (i<base64.size())
+      if (base64[i++] != '=')
+         return false;
+
+   return true;
+}
+
+template <typename String>
+static void base64_encode_into(String &result, const void *ptr, std::size_t size) {
+   auto u8_ptr = reinterpret_cast<const std::uint8_t *>(ptr);
+   result.assign(((size + 2) / 3) * 4, '=');
+   char *out = result.data();
+   std::size_t i = 0;
+
+#if defined(LIBFACADE_X86)
+   if (facade::cpu_has_avx2())
+      i = base64_encode_avx2(u8_ptr, size, out);
+   else if (facade::cpu_has_ssse3())
+      i = base64_encode_ssse3(u8_ptr, size, out);
+
+   out += (i / 3) * 4;
+#endif
+
+   for (; i+3 <= size; i += 3, out += 4)
+   {
+      std::uint32_t triple = (u8_ptr[i] << 16) | (u8_ptr[i+1] << 8) | u8_ptr[i+2];
+
+      out[0] = BASE64_ENCODE_TABLE[(triple >> 18) & 0x3F];
+      out[1] = BASE64_ENCODE_TABLE[(triple >> 12) & 0x3F];
+      out[2] = BASE64_ENCODE_TABLE[(triple >> 6) & 0x3F];
+      out[3] = BASE64_ENCODE_TABLE[triple & 0x3F];
+   }
+
+   /* the remaining characters were already initialized as padding */
+   if (size - i == 1)
+   {
+      out[0] = BASE64_ENCODE_TABLE[u8_ptr[i] >> 2];
+      out[1] = BASE64_ENCODE_TABLE[(u8_ptr[i] & 0x03) << 4];
+   }
+   else if (size - i == 2)
+   {
+      out[0] = BASE64_ENCODE_TABLE[u8_ptr[i] >> 2];
+      out[1] = BASE64_ENCODE_TABLE[((u8_ptr[i] & 0x03) << 4) | (u8_ptr[i+1] >> 4)];
+      out[2] = BASE64_ENCODE_TABLE[(u8_ptr[i+1] & 0x0F) << 2];
+   }
+}
+
+std::string facade::base64_encode(const void *ptr, std::size_t size) {
+   std::string result;
+   base64_encode_into(result, ptr, size);
+
+   return result;
 }
 
 std::string facade::base64_encode(const std::vector<std::uint8_t> &data) {
    return base64_encode(data.data(), data.size());
 }
 
-std::vector<std::uint8_t> facade::base64_decode(const std::string &data) {
-   std::size_t in_len = data.size();
+std::pmr::string facade::base64_encode(const void *ptr, std::size_t size, std::pmr::memory_resource *resource) {
+   std::pmr::string result(resource);
+   base64_encode_into(result, ptr, size);
+
+   return result;
+}
+
+template <typename Vector>
+static void base64_decode_into(Vector &result, const void *ptr, std::size_t size) {
+   auto u8_ptr = reinterpret_cast<const std::uint8_t *>(ptr);
+   auto &table = BASE64_DECODE_TABLE.values;
+   result.resize((size / 4) * 3 + 3 + BASE64_DECODE_SLACK);
+   auto out = result.data();
    std::size_t i = 0;
-   std::size_t j = 0;
-   std::size_t in_ = 0;
-   std::uint8_t char_array_4[4], char_array_3[3];
-   std::vector<std::uint8_t> ret;
-
-   while (in_len-- && data[in_] != '=') {
-      if (!std::isalnum(data[in_]) && data[in_] != '+' && data[in_] != '/') {
-         throw exception::InvalidBase64Character(data[in_]);
-      }
-      
-      char_array_4[i++] = data[in_]; in_++;
-      
-      if (i ==4) {
-         for (i = 0; i <4; i++)
-            char_array_4[i] = static_cast<std::uint8_t>(facade::BASE64_ALPHA.find(char_array_4[i]));
-
-         char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-         char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-         char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
-
-         for (i = 0; (i < 3); i++)
-            ret.push_back(char_array_3[i]);
-         
-         i = 0;
-      }
+   std::size_t o = 0;
+
+#if defined(LIBFACADE_X86)
+   if (facade::cpu_has_avx2())
+      base64_decode_avx2(u8_ptr, size, out, i, o);
+
+   if (facade::cpu_has_ssse3())
+      base64_decode_ssse3(u8_ptr, size, out, i, o);
+#endif
+
+   for (; i+4 <= size; i += 4, o += 3)
+   {
+      std::uint8_t a = table[u8_ptr[i]];
+      std::uint8_t b = table[u8_ptr[i+1]];
+      std::uint8_t c = table[u8_ptr[i+2]];
+      std::uint8_t d = table[u8_ptr[i+3]];
+
+      /* invalid characters are all 0xFF in the table, so one test covers the whole quad */
+      if ((a | b | c | d) & 0x80)
+         break;
+
+      out[o] = (a << 2) | (b >> 4);
+      out[o+1] = (b << 4) | (c >> 2);
+      out[o+2] = (c << 6) | d;
    }
 
-   if (i) {
-      for (j = i; j <4; j++)
-         char_array_4[j] = 0;
+   /* at most three valid characters remain before either the end of the data or a non-alphabet character */
+   std::uint8_t tail[4] = {0, 0, 0, 0};
+   std::size_t tail_size = 0;
 
-      for (j = 0; j <4; j++)
-         char_array_4[j] = static_cast<std::uint8_t>(facade::BASE64_ALPHA.find(char_array_4[j]));
+   for (; i<size && table[u8_ptr[i]] != 0xFF; ++i)
+      tail[tail_size++] = table[u8_ptr[i]];
 
-      char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-      char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-      char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
+   for (std::size_t j=i; j<size; ++j)
+      if (u8_ptr[j] != '=')
+         throw exception::InvalidBase64Character(static_cast<char>(u8_ptr[j]), j);
 
-      for (j = 0; (j < i - 1); j++) ret.push_back(char_array_3[j]);
-   }
+   /* a single leftover character carries only six bits, which can't form a byte */
+   if (tail_size == 1)
+      throw exception::InvalidBase64Character(static_cast<char>(u8_ptr[i-1]), i-1);
+
+   if (tail_size >= 2)
+      out[o++] = (tail[0] << 2) | (tail[1] >> 4);
 
-   return ret;
+   if (tail_size == 3)
+      out[o++] = (tail[1] << 4) | (tail[2] >> 2);
+
+   result.resize(o);
+}
+
+std::vector<std::uint8_t> facade::base64_decode(const void *ptr, std::size_t size) {
+   std::vector<std::uint8_t> result;
+   base64_decode_into(result, ptr, size);
+
+   return result;
+}
+
+std::vector<std::uint8_t> facade::base64_decode(const std::string &data) {
+   return facade::base64_decode(data.data(), data.size());
+}
+
+std::pmr::vector<std::uint8_t> facade::base64_decode(const void *ptr, std::size_t size, std::pmr::memory_resource *resource) {
+   std::pmr::vector<std::uint8_t> result(resource);
+   base64_decode_into(result, ptr, size);
+
+   return result;
 }
 
 std::vector<std::uint8_t> facade::read_file(const std::string &filename)
@@ -238,3 +606,150 @@ void facade::write_file(const std::string &filename, const void *ptr, std::size_
 void facade::write_file(const std::string &filename, const std::vector<std::uint8_t> &vec) {
    write_file(filename, vec.data(), vec.size());
 }
+
+std::size_t HugePageResource::threshold() const { return this->_threshold; }
+
+std::pmr::memory_resource *HugePageResource::upstream() const { return this->_upstream; }
+
+bool HugePageResource::use_huge_pages(std::size_t bytes, std::size_t alignment) const {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+   return bytes >= this->_threshold && alignment <= HugePageResource::DefaultThreshold;
+#else
+   return false;
+#endif
+}
+
+void *HugePageResource::do_allocate(std::size_t bytes, std::size_t alignment) {
+   if (!this->use_huge_pages(bytes, alignment)) { return this->_upstream->allocate(bytes, alignment); }
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+   /* huge pages only back 2MB-aligned ranges, so over-map and trim down to an aligned window */
+   auto page_bytes = (bytes + DefaultThreshold - 1) & ~(DefaultThreshold - 1);
+   auto mapped_bytes = page_bytes + DefaultThreshold;
+   auto mapped = ::mmap(nullptr, mapped_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if (mapped == MAP_FAILED) { throw std::bad_alloc(); }
+
+   auto base = reinterpret_cast<std::uintptr_t>(mapped);
+   auto aligned = (base + DefaultThreshold - 1) & ~static_cast<std::uintptr_t>(DefaultThreshold - 1);
+
+   if (aligned != base) { ::munmap(mapped, aligned - base); }
+   if (aligned + page_bytes != base + mapped_bytes) { ::munmap(reinterpret_cast<void *>(aligned + page_bytes), base + mapped_bytes - aligned - page_bytes); }
+
+   /* this is advice, so a kernel without transparent huge pages still gives us working memory */
+   ::madvise(reinterpret_cast<void *>(aligned), page_bytes, MADV_HUGEPAGE);
+
+   return reinterpret_cast<void *>(aligned);
+#else
+   return this->_upstream->allocate(bytes, alignment);
+#endif
+}
+
+void HugePageResource::do_deallocate(void *ptr, std::size_t bytes, std::size_t alignment) {
+   if (!this->use_huge_pages(bytes, alignment)) { this->_upstream->deallocate(ptr, bytes, alignment); return; }
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+   ::munmap(ptr, (bytes + DefaultThreshold - 1) & ~(DefaultThreshold - 1));
+#endif
+}
+
+bool HugePageResource::do_is_equal(const std::pmr::memory_resource &other) const noexcept {
+   auto huge = dynamic_cast<const HugePageResource *>(&other);
+
+   return huge != nullptr && huge->_threshold == this->_threshold && huge->_upstream->is_equal(*this->_upstream);
+}
+
+std::pmr::memory_resource *TrackingResource::upstream() const { return this->_upstream; }
+
+std::size_t TrackingResource::limit() const { return this->_limit; }
+
+void TrackingResource::set_limit(std::size_t limit) { this->_limit = limit; }
+
+std::size_t TrackingResource::allocations() const { return this->_allocations.load(); }
+
+std::size_t TrackingResource::live_bytes() const { return this->_live_bytes.load(); }
+
+std::size_t TrackingResource::peak_bytes() const { return this->_peak_bytes.load(); }
+
+void TrackingResource::reset_peak() { this->_peak_bytes.store(this->_live_bytes.load()); }
+
+TrackingResource::Mark TrackingResource::begin_stage() {
+   Mark mark;
+   mark.start_bytes = this->_live_bytes.load();
+   mark.start_allocations = this->_allocations.load();
+   mark.slot = MaxOpenStages;
+
+   /* claim a free slot, then start it at what's live, which every allocation from here on raises */
+   auto open = this->_open_stages.load();
+
+   while (~open != 0)
+   {
+      std::size_t slot = 0;
+      while (open & (std::uint64_t(1) << slot)) { ++slot; }
+
+      if (this->_open_stages.compare_exchange_weak(open, open | (std::uint64_t(1) << slot)))
+      {
+         this->_stage_peaks[slot].store(this->_live_bytes.load());
+         mark.slot = slot;
+         break;
+      }
+   }
+
+   return mark;
+}
+
+std::pair<std::size_t, std::size_t> TrackingResource::end_stage(const Mark &mark) {
+   auto allocations = this->_allocations.load() - mark.start_allocations;
+   if (mark.slot >= MaxOpenStages) { return std::make_pair(allocations, std::size_t(0)); }
+
+   auto peak = this->_stage_peaks[mark.slot].load();
+   this->_open_stages.fetch_and(~(std::uint64_t(1) << mark.slot));
+
+   return std::make_pair(allocations, (peak > mark.start_bytes) ? peak - mark.start_bytes : 0);
+}
+
+void *TrackingResource::do_allocate(std::size_t bytes, std::size_t alignment) {
+   auto live = this->_live_bytes.fetch_add(bytes) + bytes;
+
+   if (this->_limit != 0 && live > this->_limit)
+   {
+      this->_live_bytes.fetch_sub(bytes);
+      throw exception::MemoryLimitExceeded(bytes, live - bytes, this->_limit);
+   }
+
+   void *result;
+
+   try {
+      result = this->_upstream->allocate(bytes, alignment);
+   }
+   catch (...) {
+      this->_live_bytes.fetch_sub(bytes);
+      throw;
+   }
+
+   ++this->_allocations;
+
+   auto peak = this->_peak_bytes.load();
+   while (live > peak && !this->_peak_bytes.compare_exchange_weak(peak, live)) {}
+
+   /* raise the high-water mark of every running stage */
+   auto open = this->_open_stages.load();
+
+   for (std::size_t slot=0; open != 0; ++slot, open >>= 1)
+   {
+      if ((open & 1) == 0) { continue; }
+
+      auto stage_peak = this->_stage_peaks[slot].load();
+      while (live > stage_peak && !this->_stage_peaks[slot].compare_exchange_weak(stage_peak, live)) {}
+   }
+
+   return result;
+}
+
+void TrackingResource::do_deallocate(void *ptr, std::size_t bytes, std::size_t alignment) {
+   this->_upstream->deallocate(ptr, bytes, alignment);
+   this->_live_bytes.fetch_sub(bytes);
+}
+
+bool TrackingResource::do_is_equal(const std::pmr::memory_resource &other) const noexcept {
+   return this == &other;
+}
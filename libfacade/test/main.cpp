@@ -3,6 +3,143 @@
 
 using namespace facade;
 
+int
+test_base64()
+{
+   INIT();
+
+   ASSERT(base64_encode(std::string("").data(), 0) == "");
+   ASSERT(base64_encode(std::string("f").data(), 1) == "Zg==");
+   ASSERT(base64_encode(std::string("fo").data(), 2) == "Zm8=");
+   ASSERT(base64_encode(std::string("foo").data(), 3) == "Zm9v");
+   ASSERT(base64_encode(std::string("foobar").data(), 6) == "Zm9vYmFy");
+
+   auto foob = std::vector<std::uint8_t>({'f','o','o','b'});
+   ASSERT(base64_decode("Zm9vYg==") == foob);
+   ASSERT(base64_decode("Zm9vYg") == foob);
+   ASSERT(is_base64_string("Zm9vYg=="));
+   ASSERT(!is_base64_string("Zm9v=Yg="));
+   ASSERT(!is_base64_string("Zm9vY==="));
+   ASSERT_THROWS(base64_decode("Zm9vY==="), exception::InvalidBase64Character);
+
+   /* large enough to go through the vectorized paths, with every tail length */
+   std::vector<std::uint8_t> test_data;
+   bool round_trip = true;
+
+   for (std::size_t i=0; i<1027; ++i)
+   {
+      test_data.push_back(static_cast<std::uint8_t>((i * 131) ^ (i >> 3)));
+
+      auto encoded = base64_encode(test_data);
+      round_trip &= (encoded.size() == ((test_data.size() + 2) / 3) * 4);
+      round_trip &= (base64_decode(encoded) == test_data);
+   }
+
+   ASSERT(round_trip);
+
+   auto encoded = base64_encode(test_data);
+   encoded[700] = '*';
+   ASSERT_THROWS(base64_decode(encoded), exception::InvalidBase64Character);
+
+   std::size_t bad_offset = 0;
+
+   try {
+      base64_decode(encoded);
+   }
+   catch (exception::InvalidBase64Character &exc) {
+      bad_offset = exc.offset;
+   }
+
+   ASSERT(bad_offset == 700);
+
+   /* the memory resource overloads produce the same bytes, with zlib's state coming from the arena too */
+   std::pmr::monotonic_buffer_resource arena;
+   ASSERT(base64_encode(test_data.data(), test_data.size(), &arena) == base64_encode(test_data).c_str());
+
+   auto arena_decoded = base64_decode(encoded.data(), 700, &arena);
+   ASSERT(arena_decoded.get_allocator().resource() == &arena);
+   ASSERT(std::equal(arena_decoded.begin(), arena_decoded.end(), test_data.begin()));
+
+   auto arena_compressed = compress(test_data.data(), test_data.size(), 9, &arena);
+   ASSERT(std::vector<std::uint8_t>(arena_compressed.begin(), arena_compressed.end()) == compress(test_data, 9));
+
+   auto arena_decompressed = decompress(arena_compressed.data(), arena_compressed.size(), &arena, test_data.size());
+   ASSERT(std::vector<std::uint8_t>(arena_decompressed.begin(), arena_decompressed.end()) == test_data);
+
+   HugePageResource huge_pages;
+   void *huge_block = nullptr;
+   ASSERT_SUCCESS(huge_block = huge_pages.allocate(HugePageResource::DefaultThreshold + 1));
+   ASSERT(reinterpret_cast<std::uintptr_t>(huge_block) % alignof(std::max_align_t) == 0);
+
+   if (huge_block != nullptr)
+   {
+      std::memset(huge_block, 0xFA, HugePageResource::DefaultThreshold + 1);
+      huge_pages.deallocate(huge_block, HugePageResource::DefaultThreshold + 1);
+   }
+
+   COMPLETE();
+}
+
+int
+test_executor()
+{
+   INIT();
+
+   ThreadPool pool(4);
+   ASSERT(pool.concurrency() == 4);
+
+   std::vector<std::uint8_t> visits(10000, 0);
+   ASSERT_SUCCESS(pool.parallel_for(visits.size(), [&visits](std::size_t i) { ++visits[i]; }));
+   ASSERT(std::all_of(visits.begin(), visits.end(), [](std::uint8_t count) { return count == 1; }));
+
+   /* nested loops share the pool's threads rather than starting their own */
+   std::mutex thread_mutex;
+   std::set<std::thread::id> thread_ids;
+   std::atomic<std::size_t> inner_calls(0);
+
+   ASSERT_SUCCESS(pool.parallel_for(16, [&](std::size_t) {
+      pool.parallel_for(64, [&](std::size_t) {
+         ++inner_calls;
+
+         std::lock_guard<std::mutex> lock(thread_mutex);
+         thread_ids.insert(std::this_thread::get_id());
+      });
+   }));
+
+   ASSERT(inner_calls == 16 * 64);
+   ASSERT(thread_ids.size() <= pool.concurrency());
+
+   ASSERT_THROWS(pool.parallel_for(100, [](std::size_t i) { if (i == 50) { throw exception::PixelMismatch(); } }), exception::PixelMismatch);
+
+   std::atomic<std::size_t> group_calls(0);
+   TaskGroup group(pool);
+
+   for (std::size_t i=0; i<32; ++i)
+      group.run([&group_calls]() { ++group_calls; });
+
+   ASSERT_SUCCESS(group.wait());
+   ASSERT(group_calls == 32);
+
+   std::size_t ranges = 0;
+   ThreadPool serial(1);
+   ASSERT_SUCCESS(serial.parallel_for_ranges(1000, 1, [&ranges](std::size_t, std::size_t) { ++ranges; }));
+   ASSERT(ranges == 1);
+
+   ASSERT_SUCCESS(set_default_executor(&serial));
+   ASSERT(&default_executor() == &serial);
+   ASSERT_SUCCESS(set_default_executor(nullptr));
+   ASSERT(&default_executor() != &serial);
+
+   png::Image image;
+   ASSERT(&image.executor() == &default_executor());
+   ASSERT_SUCCESS(image.set_executor(&pool));
+
+   auto image_copy = image;
+   ASSERT(&image_copy.executor() == &pool);
+
+   COMPLETE();
+}
+
 int
 test_pngimage()
 {
@@ -26,6 +163,16 @@ test_pngimage()
       ASSERT(header.pixel_size() == png::AlphaTrueColorPixel8Bit::Bits);
       ASSERT(header.buffer_size() == (256 * 4) * 256 + 256);
    }
+
+   static_assert(png::fourcc("IHDR") == 0x49484452, "FourCC values should match the tag bytes in file order");
+   ASSERT(image.has_chunk(png::fourcc("IDAT")));
+   ASSERT(image.get_chunks("IDAT").size() == image.get_chunks(png::fourcc("IDAT")).size());
+   ASSERT_THROWS(image.get_chunks(png::fourcc("fAKe")), exception::ChunkNotFound);
+   ASSERT(image.get_all_chunks().size() > 0 && image.get_all_chunks().front().tag().fourcc() == png::fourcc("IHDR"));
+   ASSERT(image.get_all_chunks().size() > 0 && image.get_all_chunks().back().tag().fourcc() == png::fourcc("IEND"));
+
+   /* chunks are kept in file order, so an untouched image saves byte-for-byte */
+   ASSERT(image.to_file() == read_file("../test/test.png"));
    
    ASSERT_THROWS(image[0], exception::NoImageData);
    ASSERT(!image.is_loaded());
@@ -34,6 +181,271 @@ test_pngimage()
    
    ASSERT_SUCCESS(image.reconstruct());
 
+   /* copies share chunk and pixel storage until one side writes to it */
+   auto image_copy = image;
+   ASSERT(image_copy.get_all_chunks().front().is_shared());
+
+   auto copy_pixel = image_copy[0][0];
+   std::get<png::AlphaTrueColorPixel8Bit>(copy_pixel).red() = *std::get<png::AlphaTrueColorPixel8Bit>(copy_pixel).red() ^ 0xFF;
+   image_copy[0].set_pixel(copy_pixel, 0);
+   ASSERT(*std::get<png::AlphaTrueColorPixel8Bit>(image_copy[0][0]).red() != *std::get<png::AlphaTrueColorPixel8Bit>(image[0][0]).red());
+
+   auto chunk_copy = image_copy.get_all_chunks().front();
+   ASSERT_SUCCESS(chunk_copy.data().push_back(0));
+   ASSERT(!chunk_copy.is_shared());
+   ASSERT(chunk_copy.length() == image.get_all_chunks().front().length() + 1);
+
+   {
+      /* rows filtered in parallel come out byte for byte the same as rows filtered one at a time */
+      ThreadPool serial(1), parallel(4);
+      auto serial_image = image;
+      auto parallel_image = image;
+      serial_image.set_executor(&serial);
+      parallel_image.set_executor(&parallel);
+      ASSERT_SUCCESS(serial_image.filter());
+      ASSERT_SUCCESS(parallel_image.filter());
+
+      bool filter_match = true;
+
+      for (std::size_t i=0; i<image.height(); ++i)
+         filter_match &= (serial_image[i].to_raw() == parallel_image[i].to_raw());
+
+      ASSERT(filter_match);
+   }
+
+   {
+      /* scanlines, and the private copies a write makes of them, come from the image's memory resource */
+      std::pmr::monotonic_buffer_resource arena;
+      png::Image arena_image("../test/test.png", &arena);
+      ASSERT_SUCCESS(arena_image.load());
+      ASSERT(arena_image.memory_resource() == &arena);
+      
+      if (arena_image.is_loaded())
+      {
+         auto &arena_line = std::get<png::AlphaTrueColorScanline8Bit>(arena_image[0]);
+         ASSERT(arena_line.memory_resource() == &arena);
+         ASSERT(png::pixels_to_raw<png::AlphaTrueColorPixel8Bit>(arena_line.pixel_data())
+                == png::pixels_to_raw<png::AlphaTrueColorPixel8Bit>(std::get<png::AlphaTrueColorScanline8Bit>(image[0]).pixel_data()));
+
+         auto arena_copy = arena_image;
+         ASSERT_SUCCESS(arena_copy[0].set_pixel(arena_copy[0][1], 0));
+         ASSERT(std::get<png::AlphaTrueColorScanline8Bit>(arena_copy[0]).memory_resource() == &arena);
+      }
+   }
+
+   {
+      /* re-encode the image with Adam7 interlacing and make sure every pixel lands back where it started */
+      auto interlaced = image;
+      interlaced.header().set_interlace_method(1);
+      ASSERT(interlaced.is_interlaced());
+      ASSERT_SUCCESS(interlaced.compress());
+
+      png::Image reloaded;
+      ASSERT_SUCCESS(reloaded.parse(interlaced.to_file()));
+      ASSERT_SUCCESS(reloaded.load());
+
+      bool interlaced_match = reloaded.is_loaded();
+
+      for (std::size_t i=0; interlaced_match && i<image.height(); ++i)
+         interlaced_match = (reloaded[i].to_raw() == image[i].to_raw());
+
+      ASSERT(interlaced_match);
+
+      /* unloaded images are decoded and written back out without interlacing */
+      png::Image deinterlaced;
+      ASSERT_SUCCESS(deinterlaced.parse(interlaced.to_file()));
+      ASSERT_SUCCESS(deinterlaced.deinterlace());
+      ASSERT(!deinterlaced.is_interlaced());
+      ASSERT_SUCCESS(reloaded.parse(deinterlaced.to_file()));
+      ASSERT_SUCCESS(reloaded.load());
+      ASSERT(reloaded.is_loaded() && reloaded[255].to_raw() == image[255].to_raw());
+
+      /* sub-byte pixels and a size that leaves some passes empty */
+      std::vector<std::uint8_t> tiny_raw = { 0, 0xB0, 0, 0x58, 0, 0xF8 };
+      png::Image tiny;
+      ASSERT_SUCCESS(tiny.new_header().set(5, 3, 1, png::ColorType::GRAYSCALE));
+      ASSERT_SUCCESS(tiny.add_chunk(png::ChunkVec(std::string("IDAT"), compress(tiny_raw, 9))));
+      ASSERT_SUCCESS(tiny.load());
+      tiny.header().set_interlace_method(1);
+      ASSERT(tiny.header().buffer_size() == 14);
+      ASSERT_SUCCESS(tiny.compress());
+
+      png::Image tiny_reloaded;
+      ASSERT_SUCCESS(tiny_reloaded.parse(tiny.to_file()));
+      ASSERT_SUCCESS(tiny_reloaded.load());
+      ASSERT(tiny_reloaded.is_loaded() && tiny_reloaded[0].to_raw() == std::vector<std::uint8_t>({ 0, 0xB0 }));
+      ASSERT(tiny_reloaded.is_loaded() && tiny_reloaded[2].to_raw() == std::vector<std::uint8_t>({ 0, 0xF8 }));
+   }
+
+   {
+      /* the bulk sample kernels should agree with the per-pixel accessors, including across vectorized blocks */
+      std::vector<std::uint8_t> packed(37);
+
+      for (std::size_t i=0; i<packed.size(); ++i)
+         packed[i] = static_cast<std::uint8_t>(i * 73 + 41);
+
+      std::vector<std::uint8_t> raw_line = { png::FilterType::NONE };
+      raw_line.insert(raw_line.end(), packed.begin(), packed.end());
+      auto line = png::PaletteScanline2Bit::read_line(raw_line, 0, packed.size() * 4);
+
+      auto samples = line.unpack_samples();
+      bool samples_match = (samples.size() == line.pixel_width());
+
+      for (std::size_t i=0; samples_match && i<samples.size(); ++i)
+         samples_match = (std::get<png::PalettePixel2Bit>(line.get_pixel(i)).value() == samples[i]);
+
+      ASSERT(samples_match);
+
+      for (std::size_t bits : { 1, 2, 4, 8 })
+      {
+         auto count = packed.size() * 8 / bits;
+         std::vector<std::uint8_t> unpacked(count);
+         std::vector<std::uint8_t> repacked(packed.size());
+
+         ASSERT_SUCCESS(png::unpack_samples(packed.data(), count, bits, unpacked.data()));
+         ASSERT_SUCCESS(png::pack_samples(unpacked.data(), count, bits, repacked.data()));
+         ASSERT(repacked == packed);
+      }
+
+      /* a partial final byte keeps the bits past the last sample */
+      std::uint8_t tail = 0xFF;
+      std::uint8_t zeros[3] = { 0, 0, 0 };
+      ASSERT_SUCCESS(png::pack_samples(zeros, 3, 1, &tail));
+      ASSERT(tail == 0x1F);
+      ASSERT_THROWS(png::unpack_samples(packed.data(), 1, 3, zeros), exception::InvalidBitDepth);
+      ASSERT_THROWS(png::GrayscaleScanline16Bit(png::FilterType::NONE, 2).unpack_samples(), exception::PixelMismatch);
+   }
+
+   {
+      /* 16-bit rows converted to native order read directly, and go back to PNG order when written out */
+      std::vector<std::uint8_t> wide_raw;
+
+      for (std::size_t y=0; y<3; ++y)
+      {
+         wide_raw.push_back(png::FilterType::NONE);
+
+         for (std::size_t x=0; x<21; ++x)
+         {
+            auto value = static_cast<std::uint16_t>(y * 0x1000 + x * 0x0101);
+            wide_raw.push_back(value >> 8);
+            wide_raw.push_back(value & 0xFF);
+         }
+      }
+
+      png::Image wide;
+      ASSERT_SUCCESS(wide.new_header().set(21, 3, 16, png::ColorType::GRAYSCALE));
+      ASSERT_SUCCESS(wide.add_chunk(png::ChunkVec(std::string("IDAT"), compress(wide_raw, 9))));
+      ASSERT_SUCCESS(wide.load(true));
+      ASSERT(wide.is_native_endian());
+
+      if (wide.is_loaded())
+      {
+         auto samples = std::get<png::GrayscaleScanline16Bit>(wide[2]).samples_16();
+         ASSERT(samples.size() == 21 && samples[20] == 0x2000 + 20 * 0x0101);
+         samples[0] = 0xBEEF;
+         ASSERT_THROWS(samples.at(21), exception::OutOfBounds);
+
+         /* the row has no alignment, so samples go through references rather than std::uint16_t pointers */
+         std::size_t sample_count = 0;
+         bool samples_match = true;
+
+         for (std::uint16_t sample : samples)
+            samples_match = samples_match && (sample == samples[sample_count++]);
+
+         ASSERT(samples_match && sample_count == 21);
+
+         ASSERT_SUCCESS(wide.filter());
+         ASSERT(!wide.is_native_endian());
+         ASSERT_SUCCESS(wide.compress());
+
+         png::Image wide_reloaded;
+         ASSERT_SUCCESS(wide_reloaded.parse(wide.to_file()));
+         ASSERT_SUCCESS(wide_reloaded.load());
+         ASSERT(wide_reloaded.is_loaded() && std::get<png::GrayscalePixel16Bit>(wide_reloaded[2][0]).value() == 0xBEEF);
+         ASSERT(wide_reloaded.is_loaded() && std::get<png::GrayscalePixel16Bit>(wide_reloaded[1][3]).value() == 0x1303);
+      }
+
+      ASSERT_THROWS(std::get<png::AlphaTrueColorScanline8Bit>(image[0]).samples_16(), exception::PixelMismatch);
+
+      std::vector<std::uint16_t> swapped(37);
+      bool swap_match = true;
+
+      for (std::size_t i=0; i<swapped.size(); ++i)
+         swapped[i] = static_cast<std::uint16_t>(i * 0x0301);
+
+      endian_swap_16(swapped.data(), swapped.size());
+
+      for (std::size_t i=0; i<swapped.size(); ++i)
+         swap_match &= (swapped[i] == endian_swap_16(static_cast<std::uint16_t>(i * 0x0301)));
+
+      ASSERT(swap_match);
+   }
+
+   {
+      /* rows convert between every pixel type through the same few paths */
+      std::uint8_t rgb[] = { 10, 20, 30, 40, 50, 60, 70, 80, 90, 100, 110, 120, 130, 140, 150, 160, 170, 180, 190, 200, 210 };
+      std::vector<std::uint8_t> rgba(png::row_size(png::PixelEnum::ALPHA_TRUE_COLOR_PIXEL_8BIT, 7));
+      std::vector<std::uint8_t> rgb_back(sizeof(rgb));
+      ASSERT_SUCCESS(png::convert_row(png::PixelEnum::TRUE_COLOR_PIXEL_8BIT, rgb, png::PixelEnum::ALPHA_TRUE_COLOR_PIXEL_8BIT, rgba.data(), 7));
+      ASSERT(rgba.size() == 28 && rgba[24] == 190 && rgba[26] == 210 && rgba[27] == 0xFF);
+      ASSERT_SUCCESS(png::convert_row(png::PixelEnum::ALPHA_TRUE_COLOR_PIXEL_8BIT, rgba.data(), png::PixelEnum::TRUE_COLOR_PIXEL_8BIT, rgb_back.data(), 7));
+      ASSERT(std::memcmp(rgb_back.data(), rgb, sizeof(rgb)) == 0);
+
+      std::uint8_t gray_16[] = { 0x12, 0x34, 0xAB, 0xCD };
+      std::uint8_t gray_8[2], gray_wide[4];
+      ASSERT_SUCCESS(png::convert_row(png::PixelEnum::GRAYSCALE_PIXEL_16BIT, gray_16, png::PixelEnum::GRAYSCALE_PIXEL_8BIT, gray_8, 2));
+      ASSERT(gray_8[0] == 0x12 && gray_8[1] == 0xAB);
+      ASSERT_SUCCESS(png::convert_row(png::PixelEnum::GRAYSCALE_PIXEL_8BIT, gray_8, png::PixelEnum::GRAYSCALE_PIXEL_16BIT, gray_wide, 2));
+      ASSERT(gray_wide[0] == 0x12 && gray_wide[1] == 0x12 && gray_wide[2] == 0xAB && gray_wide[3] == 0xAB);
+
+      /* samples are scaled up from their bit depth, and the color key becomes transparency */
+      png::ColorTable keyed;
+      keyed.color_key = std::array<std::uint16_t, 3>({ 2, 0, 0 });
+      std::uint8_t gray_2[] = { 0x1B };
+      std::uint8_t keyed_rgba[16];
+      ASSERT_SUCCESS(png::convert_row(png::PixelEnum::GRAYSCALE_PIXEL_2BIT, gray_2, png::PixelEnum::ALPHA_TRUE_COLOR_PIXEL_8BIT, keyed_rgba, 4, keyed));
+      ASSERT(keyed_rgba[3] == 0xFF && keyed_rgba[4] == 85 && keyed_rgba[8] == 170 && keyed_rgba[11] == 0 && keyed_rgba[12] == 255);
+
+      /* a palette image loaded as rgba comes back down to a palette, and the pixels survive the trip */
+      std::uint8_t palette_raw[] = { 0, 0x01, 0x20, 0x10, 0, 0x22, 0x22, 0x20 };
+      std::uint8_t palette_colors[] = { 255, 0, 0, 0, 255, 0, 0, 0, 255 };
+      std::uint8_t palette_alpha[] = { 255, 128 };
+
+      png::Image palette_image;
+      ASSERT_SUCCESS(palette_image.new_header().set(5, 2, 4, png::ColorType::PALETTE));
+      ASSERT_SUCCESS(palette_image.add_chunk(png::ChunkVec(std::string("PLTE"), palette_colors, sizeof(palette_colors))));
+      ASSERT_SUCCESS(palette_image.add_chunk(png::ChunkVec(std::string("tRNS"), palette_alpha, sizeof(palette_alpha))));
+      ASSERT_SUCCESS(palette_image.add_chunk(png::ChunkVec(std::string("IDAT"), compress(std::vector<std::uint8_t>(palette_raw, palette_raw + sizeof(palette_raw)), 9))));
+      ASSERT_SUCCESS(palette_image.load(png::PixelEnum::ALPHA_TRUE_COLOR_PIXEL_8BIT));
+      ASSERT(palette_image.header().pixel_type() == png::PixelEnum::ALPHA_TRUE_COLOR_PIXEL_8BIT);
+      ASSERT(!palette_image.has_chunk(png::fourcc("PLTE")) && !palette_image.has_chunk(png::fourcc("tRNS")));
+
+      if (palette_image.is_loaded())
+      {
+         auto green = std::get<png::AlphaTrueColorPixel8Bit>(palette_image[0][1]);
+         ASSERT(*green.green() == 255 && *green.alpha() == 128);
+         ASSERT(*std::get<png::AlphaTrueColorPixel8Bit>(palette_image[1][4]).blue() == 255);
+
+         auto expanded = palette_image;
+         ASSERT(palette_image.smallest_pixel_type() == png::PixelEnum::PALETTE_PIXEL_2BIT);
+         ASSERT_THROWS(palette_image.convert(png::PixelEnum::PALETTE_PIXEL_1BIT), exception::TooManyColors);
+         ASSERT_SUCCESS(palette_image.reduce());
+         ASSERT(palette_image.header().pixel_type() == png::PixelEnum::PALETTE_PIXEL_2BIT);
+         ASSERT(palette_image.color_table().palette_size() == 3 && palette_image.color_table().has_transparency());
+         ASSERT_SUCCESS(palette_image.filter());
+         ASSERT_SUCCESS(palette_image.compress());
+
+         png::Image reduced;
+         ASSERT_SUCCESS(reduced.parse(palette_image.to_file()));
+         ASSERT_SUCCESS(reduced.load(png::PixelEnum::ALPHA_TRUE_COLOR_PIXEL_8BIT));
+         ASSERT(reduced.is_loaded() && reduced[0].to_raw() == expanded[0].to_raw() && reduced[1].to_raw() == expanded[1].to_raw());
+
+         /* gray images reduce to the lowest bit depth that keeps every sample */
+         ASSERT_SUCCESS(expanded.convert(png::PixelEnum::GRAYSCALE_PIXEL_16BIT));
+         ASSERT(expanded.smallest_pixel_type() != png::PixelEnum::GRAYSCALE_PIXEL_16BIT);
+      }
+   }
+
    std::vector<std::uint8_t> image_raw;
 
    for (std::size_t i=0; i<image.header().height(); ++i)
@@ -119,6 +531,11 @@ test_embedding()
    auto text_load = png::Image("test.text.png");
    ASSERT(text_load.has_text());
 
+   /* added chunks land before IEND instead of after it */
+   auto &text_chunks = text_load.get_all_chunks();
+   ASSERT(text_chunks.size() > 1 && text_chunks.back().tag().fourcc() == png::fourcc("IEND"));
+   ASSERT(text_chunks.size() > 1 && text_chunks[text_chunks.size()-2].tag().fourcc() == png::fourcc("tEXt"));
+
    if (text_load.has_text())
    {
       std::vector<png::Text> facade_text;
@@ -134,10 +551,54 @@ test_embedding()
          {
             auto got_text = facade_text[0].text();
             ASSERT(got_text == "This could also contain some arbitrary data!");
+            ASSERT(facade_text[0].keyword_view() == "FACADE");
+            ASSERT(facade_text[0].text_view() == got_text);
          }
       }
    }
 
+   /* the keyword index has to follow chunks as they're added and removed */
+   auto index_test = image;
+
+   for (std::size_t i=0; i<64; ++i)
+      index_test.add_text("index " + std::to_string(i % 4), std::to_string(i));
+
+   ASSERT(index_test.get_text("index 1").size() == 16);
+   ASSERT(index_test.get_text("index 1")[2].text() == "9");
+   ASSERT(index_test.get_text("missing").empty());
+   ASSERT_SUCCESS(index_test.remove_text("index 1", "5"));
+   ASSERT_THROWS(index_test.remove_text("index 1", "5"), exception::TextNotFound);
+   ASSERT(index_test.get_text("index 1").size() == 15);
+   ASSERT(index_test.get_text("index 1")[1].text() == "9");
+   ASSERT(index_test.get_text("index 2")[1].text() == "6");
+   ASSERT_SUCCESS(index_test.add_text("index 1", "64"));
+   ASSERT(index_test.get_text("index 1").back().text() == "64");
+   ASSERT(index_test.get_chunks("tEXt").size() == 64);
+
+   /* keywords changed through the returned reference are picked up by the next lookup */
+   ASSERT_SUCCESS(index_test.add_text("index 1", "65").set_keyword("renamed"));
+   ASSERT(index_test.get_text("renamed").size() == 1);
+   ASSERT(index_test.get_text("index 1").back().text() == "64");
+   ASSERT_SUCCESS(index_test.remove_text("renamed", "65"));
+
+   /* or by the next change to the image, when that comes first */
+   ASSERT_SUCCESS(index_test.add_text("index 1", "66").set_keyword("renamed"));
+   ASSERT_SUCCESS(index_test.add_text("index 2", "67"));
+   ASSERT(index_test.get_text("renamed").size() == 1);
+   ASSERT(index_test.get_text("index 1").back().text() == "64");
+   ASSERT_SUCCESS(index_test.remove_text("renamed", "66"));
+   ASSERT_SUCCESS(index_test.remove_text("index 2", "67"));
+
+   /* const lookups on one image can run from several threads at once */
+   const auto &shared_index = index_test;
+   std::atomic<std::size_t> found(0);
+   index_test.add_ztext("shared", "compressed");
+   default_executor().parallel_for(64, [&](std::size_t i) {
+      if (shared_index.get_text("index " + std::to_string(i % 4)).size() == 16) { ++found; }
+      if (shared_index.get_ztext("shared").front().text_view() == "compressed") { ++found; }
+   });
+   ASSERT(found == 64 * 2);
+
    auto ztext_test = image;
    ASSERT(!ztext_test.has_ztext());
    ASSERT_SUCCESS(ztext_test.add_ztext("FACADE", "This payload is compressed!"));
@@ -161,6 +622,15 @@ test_embedding()
          {
             auto got_text = facade_text[0].text();
             ASSERT(got_text == "This payload is compressed!");
+            ASSERT(facade_text[0].keyword_view() == "FACADE");
+
+            /* the decompressed text is cached, so repeated views see the same buffer */
+            auto first_view = facade_text[0].text_view();
+            ASSERT(facade_text[0].text_view().data() == first_view.data());
+
+            ASSERT_SUCCESS(facade_text[0].set_text("Modified text!"));
+            ASSERT(facade_text[0].text_view() == "Modified text!");
+            ASSERT(facade_text[0].keyword_view() == "FACADE");
          }
       }
    }
@@ -191,6 +661,22 @@ test_payload()
    ASSERT_SUCCESS(trailing_parsed = PNGPayload("art.trailing.png"));
    ASSERT(trailing_parsed.get_trailing_data() == test_data);
 
+   /* the trailing data is a whole PNG, which is found and measured by walking its chunks */
+   std::vector<EmbeddedFile> embedded;
+   ASSERT_SUCCESS(embedded = trailing_parsed.scan_trailing_data());
+   ASSERT(embedded.size() == 1 && embedded[0].format == FORMAT_PNG && embedded[0].offset == 0);
+   ASSERT(embedded.size() == 1 && embedded[0].size == test_data.size() && embedded[0].exact_size);
+   ASSERT_THROWS(base_payload.scan_trailing_data(), exception::NoTrailingData);
+
+   /* an MZ without a PE header is dropped, and a gzip stream, which doesn't record its size, runs to the next file */
+   std::vector<std::uint8_t> blob = { 'M', 'Z', 0, 0, 0x1F, 0x8B, 0x08, 0x00 };
+   blob.resize(64, 0);
+   blob.insert(blob.end(), test_data.begin(), test_data.end());
+   ASSERT_SUCCESS(embedded = scan_signatures(blob));
+   ASSERT(embedded.size() == 2 && embedded[0].format == FORMAT_GZIP && embedded[0].offset == 4);
+   ASSERT(embedded.size() == 2 && embedded[0].size == 60 && !embedded[0].exact_size);
+   ASSERT(embedded.size() == 2 && embedded[1].format == FORMAT_PNG && embedded[1].offset == 64);
+
    auto text_payload = base_payload;
    ASSERT_SUCCESS(text_payload.add_text_payload("tEXt test", test_data));
    ASSERT_SUCCESS(text_payload.save("art.text.png"));
@@ -207,6 +693,13 @@ test_payload()
       ASSERT(text_payloads[0] == test_data);
    }
 
+   /* ordinary text under the same keyword isn't a payload and doesn't hide the one that is */
+   auto shared_text = text_parsed;
+   ASSERT_SUCCESS(shared_text.add_text("tEXt test", "This is not a payload!"));
+   ASSERT(shared_text.get_text_payloads("tEXt test").size() == 1);
+   ASSERT_SUCCESS(text_payloads = shared_text.extract_text_payloads("tEXt test"));
+   ASSERT(text_payloads.size() == 1 && text_payloads[0] == test_data);
+
    auto ztext_payload = base_payload;
    ASSERT_SUCCESS(ztext_payload.add_ztext_payload("zTXt test", test_data));
    ASSERT_SUCCESS(ztext_payload.save("art.ztext.png"));
@@ -223,6 +716,61 @@ test_payload()
       ASSERT(ztext_payloads[0] == test_data);
    }
 
+   /* ordinary text under the same keyword isn't a payload and doesn't hide the one that is */
+   auto shared_keyword = ztext_parsed;
+   ASSERT_SUCCESS(shared_keyword.add_ztext("zTXt test", "This is not a payload!"));
+   ASSERT(shared_keyword.get_ztext_payloads("zTXt test").size() == 1);
+   ASSERT_SUCCESS(ztext_payloads = shared_keyword.extract_ztext_payloads("zTXt test"));
+   ASSERT(ztext_payloads.size() == 1 && ztext_payloads[0] == test_data);
+
+   auto segmented_payload = base_payload;
+   std::size_t segments = 0;
+   ASSERT_SUCCESS(segments = segmented_payload.add_segmented_ztext_payload("zTXt test", test_data, 4096));
+   ASSERT(segments == (test_data.size() + 4095) / 4096);
+   ASSERT_SUCCESS(segmented_payload.add_ztext_payload("zTXt test", test_data));
+   ASSERT_SUCCESS(segmented_payload.save("art.segmented.png"));
+
+   PNGPayload segmented_parsed;
+   ASSERT_SUCCESS(segmented_parsed = PNGPayload("art.segmented.png"));
+   ASSERT(segmented_parsed.get_ztext_payloads("zTXt test").size() == segments + 1);
+   ASSERT_SUCCESS(ztext_payloads = segmented_parsed.extract_ztext_payloads("zTXt test"));
+   ASSERT(ztext_payloads.size() == 2);
+
+   if (ztext_payloads.size() == 2)
+   {
+      ASSERT(ztext_payloads[0] == test_data);
+      ASSERT(ztext_payloads[1] == test_data);
+   }
+
+   if (segments > 1)
+   {
+      ASSERT_SUCCESS(segmented_parsed.remove_ztext_payload(segmented_parsed.get_ztext("zTXt test")[1]));
+      ASSERT_THROWS(segmented_parsed.extract_ztext_payloads("zTXt test"), exception::InvalidSegment);
+   }
+
+   auto binary_payload = base_payload;
+   ASSERT_SUCCESS(binary_payload.add_binary_payload("faCd test", test_data));
+   ASSERT_SUCCESS(binary_payload.add_binary_payload("faCd test", test_data, png::BINARY_ZLIB));
+   ASSERT_SUCCESS(binary_payload.save("art.binary.png"));
+
+   PNGPayload binary_parsed;
+   ASSERT_SUCCESS(binary_parsed = PNGPayload("art.binary.png"));
+
+   std::vector<png::BinaryData> binary_chunks;
+   ASSERT_SUCCESS(binary_chunks = binary_parsed.get_binary_payloads("faCd test"));
+   ASSERT(binary_chunks.size() == 2 && binary_chunks[0].codec() == png::BINARY_RAW && binary_chunks[1].codec() == png::BINARY_ZLIB);
+   ASSERT(binary_chunks.size() == 2 && binary_chunks[0].length() < text_parsed.get_text("tEXt test")[0].length());
+   
+   std::vector<std::vector<std::uint8_t>> binary_payloads;
+   ASSERT_SUCCESS(binary_payloads = binary_parsed.extract_binary_payloads("faCd test"));
+   ASSERT(binary_payloads.size() == 2);
+
+   if (binary_payloads.size() == 2)
+   {
+      ASSERT(binary_payloads[0] == test_data);
+      ASSERT(binary_payloads[1] == test_data);
+   }
+
    auto stego_payload = base_payload;
    PNGPayload stego_data;
    ASSERT_SUCCESS(stego_data = stego_payload.create_stego_payload(test_data));
@@ -237,6 +785,177 @@ test_payload()
    ASSERT_SUCCESS(stego_extract = stego_parsed.extract_stego_payload());
    ASSERT(stego_extract == test_data);
 
+   /* any pixel type can carry a stego payload, by being converted to true color first */
+   auto gray_payload = base_payload;
+   ASSERT_SUCCESS(gray_payload.load(png::PixelEnum::GRAYSCALE_PIXEL_8BIT));
+   ASSERT_SUCCESS(gray_payload.filter());
+   ASSERT_SUCCESS(gray_payload.compress());
+   ASSERT_SUCCESS(gray_payload = gray_payload.create_stego_payload(test_data));
+   ASSERT(gray_payload.header().pixel_type() == png::PixelEnum::TRUE_COLOR_PIXEL_8BIT);
+
+   PNGPayload gray_parsed;
+   ASSERT_SUCCESS(gray_parsed.parse(gray_payload.to_file()));
+   ASSERT_SUCCESS(gray_parsed.load());
+   ASSERT(gray_parsed.has_stego_payload() && gray_parsed.extract_stego_payload() == test_data);
+
+   /* a stego stream in small blocks, read from and written to streams */
+   PNGPayload stream_carrier;
+   ASSERT_SUCCESS(stream_carrier.parse(std::string("../test/test.png")));
+
+   std::stringstream stream_input(std::string(test_data.begin(), test_data.end()));
+   PNGPayload stream_payload;
+   ASSERT_SUCCESS(stream_payload = stream_carrier.create_stego_stream_payload(stream_input, 4096));
+
+   PNGPayload stream_parsed;
+   ASSERT_SUCCESS(stream_parsed.parse(stream_payload.to_file()));
+   ASSERT_SUCCESS(stream_parsed.load());
+   ASSERT(stream_parsed.has_stego_payload() && stream_parsed.extract_stego_payload() == test_data);
+
+   std::stringstream stream_output;
+   ASSERT(stream_parsed.extract_stego_payload(stream_output) == test_data.size());
+   ASSERT(stream_output.str() == std::string(test_data.begin(), test_data.end()));
+
+   PNGPayload stream_vector;
+   ASSERT_SUCCESS(stream_vector = stream_carrier.create_stego_stream_payload(test_data, 1000));
+   ASSERT_SUCCESS(stream_vector.parse(stream_vector.to_file()));
+   ASSERT_SUCCESS(stream_vector.load());
+   ASSERT(stream_vector.extract_stego_payload() == test_data);
+   ASSERT_THROWS(stream_carrier.create_stego_stream_payload(test_data, 0), exception::NoData);
+
+   /* statistical analysis knows nothing of the framing, but still ranks the stego image above its carrier */
+   PNGPayload clean_carrier;
+   ASSERT_SUCCESS(clean_carrier.parse(std::string("../test/test.png")));
+   ASSERT_THROWS(analyze_lsb(clean_carrier), exception::NoImageData);
+   ASSERT_SUCCESS(clean_carrier.load());
+
+   LSBAnalysis clean_analysis, stego_analysis;
+   ASSERT_SUCCESS(clean_analysis = analyze_lsb(clean_carrier));
+   ASSERT_SUCCESS(stego_analysis = analyze_lsb(stream_vector));
+   ASSERT(clean_analysis.channels.size() == 3 && clean_analysis.channels[0].samples == 256 * 256);
+   ASSERT(clean_analysis.channels[0].ones[0] <= clean_analysis.channels[0].samples);
+   ASSERT(clean_analysis.score() < 0.1);
+   ASSERT(stego_analysis.score() > clean_analysis.score() + 0.1);
+
+   /* the first byte of the first block, right after the stream and block headers */
+   auto corrupt_byte = stream_parsed.read_stego_data((15 + 8) * 8, 1);
+   corrupt_byte[0] ^= 0xFF;
+   ASSERT_SUCCESS(stream_parsed.write_stego_data(corrupt_byte, (15 + 8) * 8));
+   ASSERT_THROWS(stream_parsed.extract_stego_payload(), exception::BadCRC);
+
+   /* an animation of three grayscale frames in fdAT chunks, with a default image that isn't one of them */
+   PNGPayload still;
+   ASSERT_SUCCESS(still.parse(std::string("../test/test.png")));
+   ASSERT_SUCCESS(still.load(png::PixelEnum::GRAYSCALE_PIXEL_8BIT));
+   ASSERT_SUCCESS(still.filter());
+   ASSERT_SUCCESS(still.compress());
+
+   auto animated = still;
+   png::AnimationControl animation_control;
+   ASSERT_SUCCESS(animation_control.set_frames(3));
+   ASSERT_SUCCESS(animated.add_chunk(animation_control));
+
+   for (std::size_t i=0; i<3; ++i)
+   {
+      png::FrameControl frame_control;
+      ASSERT_SUCCESS(frame_control.set_width(static_cast<std::uint32_t>(still.width())));
+      ASSERT_SUCCESS(frame_control.set_height(static_cast<std::uint32_t>(still.height())));
+      ASSERT_SUCCESS(animated.add_chunk(frame_control));
+   }
+
+   ASSERT_THROWS(animated.frame(0), exception::InvalidFrame);
+
+   for (std::size_t i=0; i<3; ++i)
+      ASSERT_SUCCESS(animated.set_frame(i, still));
+
+   ASSERT(animated.is_animated() && animated.animation_control().frames() == 3);
+   ASSERT(animated.frame_count() == 3 && !animated.default_image_is_frame());
+   ASSERT(animated.frame_control(2).sequence_number() > animated.frame_control(1).sequence_number());
+   ASSERT_THROWS(animated.set_frame(3, still), exception::OutOfBounds);
+   ASSERT_THROWS(animated.set_frame(0, base_payload), exception::InvalidFrame);
+
+   std::vector<png::Image> frames;
+   ASSERT_SUCCESS(frames = animated.frames(true));
+   ASSERT(frames.size() == 3 && frames[2].header().pixel_type() == png::PixelEnum::GRAYSCALE_PIXEL_8BIT);
+
+   PNGPayload animated_stego;
+   ASSERT_SUCCESS(animated_stego = animated.create_frame_stego_payload(test_data));
+   ASSERT(animated_stego.header().pixel_type() == png::PixelEnum::TRUE_COLOR_PIXEL_8BIT);
+
+   PNGPayload animated_parsed;
+   ASSERT_SUCCESS(animated_parsed.parse(animated_stego.to_file()));
+   ASSERT(animated_parsed.frame_count() == 3 && animated_parsed.has_frame_stego_payload());
+   ASSERT(animated_parsed.extract_frame_stego_payload() == test_data);
+   ASSERT_THROWS(base_payload.create_frame_stego_payload(test_data), exception::ChunkNotFound);
+
+   auto stats = std::make_shared<Stats>(true);
+   PNGPayload stats_payload;
+   ASSERT_SUCCESS(stats_payload.set_stats(stats));
+   ASSERT_SUCCESS(stats_payload.parse(std::string("../test/art.png")));
+   ASSERT_SUCCESS(stats_payload = stats_payload.create_stego_payload(test_data));
+   ASSERT_SUCCESS(stats_payload.to_file());
+   ASSERT(base_payload.stats() == nullptr);
+   ASSERT(stats_payload.stats() == stats);
+   ASSERT(stats->chunks_parsed() == base_payload.get_all_chunks().size());
+   ASSERT(stats->chunks_written() == stats_payload.get_all_chunks().size());
+   ASSERT(stats->stage(STAGE_READ).calls == 1 && stats->stage(STAGE_PARSE).calls == 1 && stats->stage(STAGE_CRC).calls == 1);
+   ASSERT(stats->stage(STAGE_INFLATE).bytes_out == base_payload.header().buffer_size());
+   ASSERT(stats->stage(STAGE_EMBED).calls == 1 && stats->stage(STAGE_FILTER).calls == 1);
+   /* the payload itself is deflated before the image data is */
+   ASSERT(stats->stage(STAGE_DEFLATE).calls == 2);
+
+   auto histogram = stats->filter_histogram();
+   ASSERT(histogram[0] + histogram[1] + histogram[2] + histogram[3] + histogram[4] == base_payload.height());
+
+   std::size_t calls = 0;
+
+   for (std::size_t i=0; i<STAGE_COUNT; ++i)
+      calls += stats->stage(static_cast<Stage>(i)).calls;
+
+   ASSERT(stats->trace_events().size() == calls);
+   ASSERT(stats->to_chrome_trace().find("\"name\":\"embed\"") != std::string::npos);
+
+   png::MemoryUsage usage;
+   ASSERT_SUCCESS(usage = stats_payload.memory_usage());
+   ASSERT(usage.chunk_data > 0 && usage.overhead > 0);
+   ASSERT(usage.pixel_data >= base_payload.header().buffer_size() - base_payload.height());
+   ASSERT(usage.shared == 0);
+
+   /* a copy shares every buffer with the image it was made from until one of them writes to it */
+   PNGPayload usage_copy = stats_payload;
+   ASSERT_SUCCESS(usage = usage_copy.memory_usage());
+   ASSERT(usage.shared == usage.chunk_data + usage.pixel_data + usage.trailing_data);
+
+   TrackingResource tracker;
+   auto memory_stats = std::make_shared<Stats>();
+   memory_stats->set_memory_tracker(&tracker);
+
+   PNGPayload tracked_payload(&tracker);
+   ASSERT_SUCCESS(tracked_payload.set_stats(memory_stats));
+   ASSERT_SUCCESS(tracked_payload.parse(std::string("../test/art.png")));
+   ASSERT_SUCCESS(tracked_payload.load());
+   ASSERT(tracker.allocations() > 0 && tracker.live_bytes() > 0);
+   ASSERT(tracker.peak_bytes() >= tracker.live_bytes());
+   ASSERT(memory_stats->stage(STAGE_INFLATE).allocations > 0);
+   ASSERT(memory_stats->stage(STAGE_INFLATE).peak_bytes >= base_payload.header().buffer_size() - base_payload.height());
+   ASSERT(memory_stats->to_json().find("\"peak_bytes\":") != std::string::npos);
+
+   /* stages on different threads overlap without ending in order, and each keeps its own peak */
+   TrackingResource overlap_tracker;
+   auto first_stage = overlap_tracker.begin_stage();
+   auto second_stage = overlap_tracker.begin_stage();
+   void *block = overlap_tracker.allocate(1024);
+   overlap_tracker.deallocate(block, 1024);
+   ASSERT(overlap_tracker.end_stage(first_stage).second == 1024);
+   auto third_stage = overlap_tracker.begin_stage();
+   ASSERT(overlap_tracker.end_stage(second_stage).second == 1024);
+   ASSERT(overlap_tracker.end_stage(third_stage).second == 0);
+   ASSERT(overlap_tracker.peak_bytes() == 1024);
+
+   TrackingResource small_tracker(4096);
+   PNGPayload limited_payload(&small_tracker);
+   ASSERT_SUCCESS(limited_payload.parse(std::string("../test/art.png")));
+   ASSERT_THROWS(limited_payload.load(), exception::MemoryLimitExceeded);
+
    //PNGPayload stego_download;
    //ASSERT_SUCCESS(stego_download = PNGPayload("../test/art.stego.png"));
    //ASSERT_SUCCESS(stego_download.load());
@@ -252,14 +971,50 @@ test_ico
 {
    INIT();
 
+   /* build a multi-resolution icon with a bitmap entry between two PNG entries */
+   auto png_data = read_file("../test/test.png");
+   std::vector<std::uint8_t> bmp_data(sizeof(ico::BitmapInfoHeader) + 16 * 16 * 4 + 16 * 4, 0x7F);
+
+   ico::BitmapInfoHeader bmp_header = {};
+   bmp_header.size = sizeof(ico::BitmapInfoHeader);
+   bmp_header.width = 16;
+   bmp_header.height = 32;
+   bmp_header.planes = 1;
+   bmp_header.bit_count = 32;
+   std::memcpy(bmp_data.data(), &bmp_header, sizeof(bmp_header));
+
+   ico::IconDirEntry png_entry = {};
+   png_entry.planes = 1;
+   png_entry.bit_count = 32;
+
+   auto bmp_entry = png_entry;
+   bmp_entry.width = 16;
+   bmp_entry.height = 16;
+
+   ico::Icon built;
+   ASSERT_SUCCESS(built.append_entry(png_entry, png_data));
+   ASSERT_SUCCESS(built.append_entry(bmp_entry, bmp_data));
+   ASSERT_SUCCESS(built.append_entry(png_entry, png_data));
+   ASSERT(built.is_modified(0));
+
+   auto icon_file = built.to_file();
+
    ico::Icon icon;
-   ASSERT_SUCCESS(icon = ico::Icon("../test/test.ico"));
-   ASSERT(icon.size() == 10);
+   ASSERT_SUCCESS(icon = ico::Icon(icon_file));
+   ASSERT(icon.size() == 3);
    ASSERT(icon.entry_type(0) == ico::Icon::EntryType::ENTRY_PNG);
    ASSERT(icon.entry_type(1) == ico::Icon::EntryType::ENTRY_BMP);
+   ASSERT(icon[1].to_vector() == bmp_data);
+   ASSERT(icon[1].dir_entry.width == 16);
+
+   /* parsed entries are views into the file, and an untouched icon is spliced back byte for byte */
+   ASSERT(!icon.is_modified(0) && !icon.is_modified(1) && !icon.is_modified(2));
+   ASSERT(icon.to_file() == icon_file);
 
    ICOPayload payload;
-   ASSERT_SUCCESS(payload = ICOPayload("../test/test.ico"));
+   ASSERT_SUCCESS(payload = ICOPayload(icon_file));
+   ASSERT(payload.png_index() == 0);
+   ASSERT(payload.png_indexes() == std::vector<std::size_t>({ 0, 2 }));
 
    std::string test_string("A small payload to verify payloads can persist in an icon.");
    std::vector<std::uint8_t> test_data(test_string.begin(), test_string.end());
@@ -270,6 +1025,7 @@ test_ico
    ASSERT_SUCCESS(payload->load());
    ASSERT_SUCCESS(payload.png_payload() = payload->create_stego_payload(test_data));
    ASSERT_SUCCESS(payload.set_png());
+   ASSERT(payload.is_modified(0) && !payload.is_modified(1) && !payload.is_modified(2));
    ASSERT_SUCCESS(payload.save("payload.ico"));
 
    ASSERT_SUCCESS(payload = ICOPayload("payload.ico"));
@@ -278,6 +1034,100 @@ test_ico
    ASSERT(payload->extract_ztext_payloads("zTXt test")[0] == test_data);
    ASSERT_SUCCESS(payload->load());
    ASSERT(payload->extract_stego_payload() == test_data);
+
+   /* the entries after the spliced one are moved, not rewritten */
+   ASSERT(payload.size() == 3 && payload[1].to_vector() == bmp_data && payload[2].to_vector() == png_data);
+
+   /* every PNG entry is examined, not just the first */
+   ASSERT_SUCCESS(payload.select_png(2));
+   ASSERT_SUCCESS(payload->load());
+   ASSERT_SUCCESS(payload.png_payload() = payload->create_stego_payload(test_data));
+   ASSERT_SUCCESS(payload.set_png());
+
+   ICOPayload multi;
+   ASSERT_SUCCESS(multi = ICOPayload(payload.to_file()));
+
+   std::vector<PNGPayload> entries;
+   ASSERT_SUCCESS(entries = multi.png_payloads(true));
+   ASSERT(entries.size() == 2);
+   ASSERT(entries.size() == 2 && entries[0].has_stego_payload() && entries[1].has_stego_payload());
+   ASSERT(entries.size() == 2 && !entries[1].has_trailing_data() && entries[1].extract_stego_payload() == test_data);
+   ASSERT_THROWS(multi.select_png(1), exception::NoPNGIcon);
+   ASSERT(!multi.has_striped_stego_payload());
+   ASSERT_THROWS(multi.extract_striped_stego_payload(), exception::NoStegoData);
+
+   /* a striped payload is spread across every PNG entry, so it can be larger than any one of them can hold */
+   ICOPayload striped_source;
+   ASSERT_SUCCESS(striped_source = ICOPayload(icon_file));
+
+   auto striped_capacity = striped_source.striped_stego_capacity();
+   ASSERT(striped_capacity > 0);
+
+   /* noise, so compression doesn't shrink payloads below what one entry could hold */
+   std::vector<std::uint8_t> noise(striped_capacity * 2);
+   std::uint32_t seed = 0x5EED;
+
+   for (auto &byte : noise)
+   {
+      seed = seed * 1664525 + 1013904223;
+      byte = static_cast<std::uint8_t>(seed >> 24);
+   }
+
+   std::vector<std::uint8_t> striped_data(noise.begin(), noise.begin() + striped_capacity * 5 / 8);
+
+   ICOPayload striped;
+   ASSERT_SUCCESS(striped = striped_source.create_striped_stego_payload(striped_data));
+   ASSERT(striped.is_modified(0) && !striped.is_modified(1) && striped.is_modified(2));
+
+   ASSERT_SUCCESS(striped = ICOPayload(striped.to_file()));
+   ASSERT(striped.has_striped_stego_payload());
+   ASSERT(striped.extract_striped_stego_payload() == striped_data);
+
+   /* the icon's executor is used for its own work and handed to the entries it parses */
+   ThreadPool icon_pool(2);
+   ASSERT(&striped.executor() == &default_executor());
+   ASSERT_SUCCESS(striped.set_executor(&icon_pool));
+   ASSERT(&striped->executor() == &icon_pool);
+   auto icon_copy = striped;
+   ASSERT(&icon_copy.executor() == &icon_pool);
+   ASSERT(icon_copy.extract_striped_stego_payload() == striped_data);
+
+   ASSERT_THROWS(striped_source.create_striped_stego_payload(noise), exception::ImageTooSmall);
+
+   /* bitmap entries carry a payload in their raw pixels, leaving the alpha channel and AND mask alone */
+   ASSERT(striped_source.bmp_indexes() == std::vector<std::size_t>({ 1 }));
+   ASSERT(striped_source.bmp_stego_capacity(1) == 16 * 16 * 3 / 2 - 10);
+   ASSERT(!striped_source.has_bmp_stego_payload(1));
+   ASSERT_THROWS(striped_source.bmp_stego_capacity(0), exception::NoBMPIcon);
+   ASSERT_THROWS(striped_source.create_bmp_stego_payload(1, noise), exception::ImageTooSmall);
+
+   ICOPayload bmp_stego;
+   ASSERT_SUCCESS(bmp_stego = striped_source.create_bmp_stego_payload(1, test_data));
+   ASSERT(!bmp_stego.is_modified(0) && bmp_stego.is_modified(1) && !bmp_stego.is_modified(2));
+
+   auto bmp_stego_data = bmp_stego[1].to_vector();
+   bool alpha_kept = true;
+
+   for (std::size_t i=0; i<16*16; ++i)
+      alpha_kept &= bmp_stego_data[sizeof(ico::BitmapInfoHeader) + i*4 + 3] == 0x7F;
+
+   ASSERT(alpha_kept);
+   ASSERT(std::equal(bmp_stego_data.end() - 16 * 4, bmp_stego_data.end(), bmp_data.end() - 16 * 4));
+
+   ASSERT_SUCCESS(bmp_stego = ICOPayload(bmp_stego.to_file()));
+   ASSERT(bmp_stego.has_bmp_stego_payload(1));
+   ASSERT(bmp_stego.extract_bmp_stego_payload(1) == test_data);
+
+   /* an icon of nothing but bitmaps has no PNG to work on, but can still be parsed for one */
+   ico::Icon bitmaps;
+   ASSERT_SUCCESS(bitmaps.append_entry(bmp_entry, bmp_data));
+
+   ICOPayload bmp_only;
+   ASSERT_SUCCESS(bmp_only = ICOPayload(bitmaps.to_file()));
+   ASSERT(!bmp_only.has_png());
+   ASSERT_THROWS(bmp_only.png_payload(), exception::NoPNGIcon);
+   ASSERT_SUCCESS(bmp_only = bmp_only.create_bmp_stego_payload(0, test_data));
+   ASSERT(bmp_only.extract_bmp_stego_payload(0) == test_data);
    
    COMPLETE();
 }
@@ -288,6 +1138,12 @@ main
 {
    INIT();
 
+   LOG_INFO("Testing the base64 codec.");
+   PROCESS_RESULT(test_base64);
+
+   LOG_INFO("Testing the executor.");
+   PROCESS_RESULT(test_executor);
+
    LOG_INFO("Testing png::Image objects.");
    PROCESS_RESULT(test_pngimage);
 
@@ -1,6 +1,9 @@
 #include <iostream>
 #include <fstream>
+#include <iomanip>
+#include <sstream>
 #include <cstdarg>
+#include <utility>
 
 #include <argparse/argparse.hpp>
 #include <facade.hpp>
@@ -78,7 +81,137 @@ void status_error(const Args&... args) {
    status(Status::ERR, args...);
 }
 
-int create_payload(const argparse::ArgumentParser &parser) {
+/* add the threading and instrumentation arguments every subcommand shares. */
+void add_common_arguments(argparse::ArgumentParser &parser) {
+   parser.add_argument("--threads")
+      .help("The number of threads to work with. Defaults to one per core.");
+
+   parser.add_argument("--stats")
+      .help("Report how long each stage of the pipeline took once finished, as \"human\" or \"json\".");
+
+   parser.add_argument("--stats-file")
+      .help("Write the --stats report to the given file rather than the console.");
+
+   parser.add_argument("--trace")
+      .help("Write every pipeline stage to the given file as a Chrome trace, for chrome://tracing or Perfetto.");
+
+   parser.add_argument("--memory-limit")
+      .help("Fail once the images being worked on hold more than the given number of bytes of decoded data at once.");
+}
+
+/* get an argument which should be a whole number, exiting with a parsing failure if it isn't. */
+std::size_t get_number_argument(const argparse::ArgumentParser &parser, const std::string &name, const std::string &units) {
+   auto value = parser.get<std::string>(name);
+
+   try {
+      std::size_t end = 0;
+      auto result = std::stoull(value, &end);
+
+      if (end == value.size()) { return static_cast<std::size_t>(result); }
+   }
+   catch (std::logic_error &) {}
+
+   std::cerr << "Argument parsing failed: " << name << " must be a number of " << units << ", not \"" << value << "\"." << std::endl;
+   std::exit(1);
+}
+
+/* create the stats object for a subcommand, or a null pointer if it didn't ask for one. images parsed with it
+   allocate through the given tracker, which measures the memory of each stage and enforces --memory-limit. */
+std::shared_ptr<Stats> make_stats(const argparse::ArgumentParser &parser, TrackingResource &tracker) {
+   if (!parser.is_used("--stats") && !parser.is_used("--trace") && !parser.is_used("--memory-limit")) { return nullptr; }
+
+   auto result = std::make_shared<Stats>(parser.is_used("--trace"));
+   result->set_memory_tracker(&tracker);
+
+   return result;
+}
+
+/* the memory resource images should be parsed with, which is the tracker if stats are being kept. */
+std::pmr::memory_resource *stats_resource(const std::shared_ptr<Stats> &stats) {
+   if (stats == nullptr || stats->memory_tracker() == nullptr) { return std::pmr::get_default_resource(); }
+
+   return stats->memory_tracker();
+}
+
+/* write the reports asked for by the instrumentation arguments. */
+int report_stats(const argparse::ArgumentParser &parser, const std::shared_ptr<Stats> &stats) {
+   if (stats == nullptr) { return 0; }
+
+   try {
+      if (parser.is_used("--stats"))
+      {
+         auto format = parser.get<std::string>("--stats");
+         auto report = (format == "json") ? stats->to_json() + "\n" : stats->to_string();
+
+         if (parser.is_used("--stats-file"))
+            write_file(parser.get<std::string>("--stats-file"), report.data(), report.size());
+         else
+            std::cout << "\n" << report;
+      }
+
+      if (parser.is_used("--trace"))
+         stats->save_chrome_trace(parser.get<std::string>("--trace"));
+   }
+   catch (exception::Exception &exc)
+   {
+      status_error("Failed to write stats: ", exc.error);
+      return 1;
+   }
+
+   return 0;
+}
+
+/* parse a PNG file with the stats attached first, so that reading and parsing it are recorded too. */
+PNGPayload parse_png(const std::string &filename, const std::shared_ptr<Stats> &stats) {
+   PNGPayload result(stats_resource(stats));
+   result.set_stats(stats);
+   result.parse(filename);
+
+   return result;
+}
+
+/* parse an icon, recording the whole of it as the parse stage, then attach the stats to its PNG, if it has one. */
+ICOPayload parse_ico(const std::string &filename, const std::shared_ptr<Stats> &stats) {
+   StageTimer timer(stats.get(), STAGE_PARSE);
+   ICOPayload result(filename, stats_resource(stats));
+   timer.stop();
+
+   if (result.has_png()) { result->set_stats(stats); }
+
+   return result;
+}
+
+/* get the PNG images of a parsed input to examine, each with a prefix for anything extracted from it. an icon can carry
+   a PNG per resolution and a payload can be in any of them, so every PNG entry is parsed, and loaded if asked,
+   concurrently. the entry a single-image icon would use gets no prefix. */
+std::vector<std::pair<std::string, PNGPayload>> input_images(const std::variant<PNGPayload, ICOPayload> &payload,
+                                                             const std::shared_ptr<Stats> &stats,
+                                                             bool load)
+{
+   std::vector<std::pair<std::string, PNGPayload>> result;
+
+   if (auto png = std::get_if<PNGPayload>(&payload))
+   {
+      result.push_back(std::make_pair(std::string(), *png));
+      return result;
+   }
+
+   auto &ico = std::get<ICOPayload>(payload);
+   auto indexes = ico.png_indexes();
+   auto images = ico.png_payloads(load);
+
+   for (std::size_t i=0; i<images.size(); ++i)
+   {
+      auto prefix = (indexes[i] == ico.png_index()) ? std::string() : "entry" + std::to_string(indexes[i]) + ".";
+
+      images[i].set_stats(stats);
+      result.push_back(std::make_pair(prefix, images[i]));
+   }
+
+   return result;
+}
+
+int create_payload(const argparse::ArgumentParser &parser, const std::shared_ptr<Stats> &stats) {
    std::cout << HEADER << std::endl;
 
    status_normal("Creating a new payload!");
@@ -92,19 +225,38 @@ int create_payload(const argparse::ArgumentParser &parser) {
    if (!parser.is_used("--trailing-data-payload")
        && !parser.is_used("--text-section-payload")
        && !parser.is_used("--ztxt-section-payload")
+       && !parser.is_used("--binary-section-payload")
        && !parser.is_used("--stego-payload"))
    {
       status_error("No payload type specified.");
       return 1;
    }
 
+   /* the stego layouts each fit one kind of input, so a flag which can't apply is an error rather than ignored */
+   std::vector<std::string> stego_layouts;
+
+   for (auto layout : { "--frames", "--stream", "--striped", "--bmp" })
+      if (parser.get<bool>(layout)) { stego_layouts.push_back(layout); }
+
+   if (!stego_layouts.empty() && !parser.is_used("--stego-payload"))
+   {
+      status_error(stego_layouts.front(), " only applies to a stego payload (--stego-payload).");
+      return 1;
+   }
+
+   if (stego_layouts.size() > 1)
+   {
+      status_error(stego_layouts[0], " and ", stego_layouts[1], " can't be used together.");
+      return 1;
+   }
+
    std::variant<PNGPayload, ICOPayload> payload;
 
    status_normal("Parsing ", input, "...");
 
    try
    {
-      payload = PNGPayload(input);
+      payload = parse_png(input, stats);
       status_alert("Image parsed!\n");
    }
    catch (exception::BadPNGSignature &bad_png)
@@ -112,7 +264,7 @@ int create_payload(const argparse::ArgumentParser &parser) {
       try
       {
          status_normal("Not a PNG image. Trying to parse as icon with embedded PNG...");
-         payload = ICOPayload(input);
+         payload = parse_ico(input, stats);
          status_alert("Icon parsed!");
       }
       catch (exception::Exception &exc)
@@ -127,6 +279,60 @@ int create_payload(const argparse::ArgumentParser &parser) {
       return 2;
    }
 
+   if (std::holds_alternative<PNGPayload>(payload) && (parser.get<bool>("--striped") || parser.get<bool>("--bmp")))
+   {
+      status_error(stego_layouts.front(), " only applies to icons.");
+      return 2;
+   }
+
+   if (std::holds_alternative<ICOPayload>(payload) && (parser.get<bool>("--frames") || parser.get<bool>("--stream")))
+   {
+      status_error(stego_layouts.front(), " only applies to PNG images.");
+      return 2;
+   }
+
+   /* an icon of nothing but bitmaps can only take a stego payload in one of its bitmaps */
+   if (auto ico = std::get_if<ICOPayload>(&payload); ico != nullptr && !ico->has_png())
+   {
+      if (parser.is_used("--trailing-data-payload")
+          || parser.is_used("--text-section-payload")
+          || parser.is_used("--ztxt-section-payload")
+          || parser.is_used("--binary-section-payload")
+          || !parser.get<bool>("--bmp"))
+      {
+         status_error("The icon has no PNG entry. Only a stego payload in one of its bitmaps (--bmp) can be added to it.");
+         return 2;
+      }
+   }
+
+   /* whether the parsed PNG entry of an icon input was changed and has to be written back into the icon */
+   bool primary_modified = false;
+
+   if (parser.get<bool>("--deinterlace"))
+   {
+      try {
+         png::Image *image = nullptr;
+
+         if (auto png = std::get_if<PNGPayload>(&payload))
+            image = png;
+         else if (auto ico = std::get_if<ICOPayload>(&payload))
+            image = &ico->png_payload();
+
+         if (image->is_interlaced())
+         {
+            status_normal("Removing Adam7 interlacing from ", input, "...");
+            image->deinterlace();
+            primary_modified = true;
+            status_alert("Image deinterlaced!\n");
+         }
+      }
+      catch (exception::Exception &exc)
+      {
+         status_error("Failed to deinterlace image: ", exc.error);
+         return 12;
+      }
+   }
+
    if (parser.is_used("--trailing-data-payload"))
    {
       status_normal("Adding trailing data payload to ", input, "...");
@@ -149,7 +355,10 @@ int create_payload(const argparse::ArgumentParser &parser) {
       if (auto png = std::get_if<PNGPayload>(&payload))
          png->set_trailing_data(data);
       else if (auto ico = std::get_if<ICOPayload>(&payload))
+      {
          (*ico)->set_trailing_data(data);
+         primary_modified = true;
+      }
       
       status_alert("Trailing data payload set!\n");
    }
@@ -188,7 +397,10 @@ int create_payload(const argparse::ArgumentParser &parser) {
             if (auto png = std::get_if<PNGPayload>(&payload))
                png->add_text_payload(keyword, data);
             else if (auto ico = std::get_if<ICOPayload>(&payload))
+            {
                (*ico)->add_text_payload(keyword, data);
+               primary_modified = true;
+            }
             
             status_normal("---> Payload added!");
          }
@@ -235,10 +447,28 @@ int create_payload(const argparse::ArgumentParser &parser) {
          try {
             status_normal("---> Adding payload to \"", input, "\"...");
 
-            if (auto png = std::get_if<PNGPayload>(&payload))
+            /* payloads too big for one segment are split so they can be compressed in parallel */
+            if (data.size() > PNGPayload::ZTextSegmentSize)
+            {
+               std::size_t segments = 0;
+               
+               if (auto png = std::get_if<PNGPayload>(&payload))
+                  segments = png->add_segmented_ztext_payload(keyword, data);
+               else if (auto ico = std::get_if<ICOPayload>(&payload))
+               {
+                  segments = (*ico)->add_segmented_ztext_payload(keyword, data);
+                  primary_modified = true;
+               }
+
+               status_normal("---> Payload split into ", segments, " segments.");
+            }
+            else if (auto png = std::get_if<PNGPayload>(&payload))
                png->add_ztext_payload(keyword, data);
             else if (auto ico = std::get_if<ICOPayload>(&payload))
+            {
                (*ico)->add_ztext_payload(keyword, data);
+               primary_modified = true;
+            }
             
             status_alert("---> Payload added!");
          }
@@ -254,6 +484,60 @@ int create_payload(const argparse::ArgumentParser &parser) {
       status_alert("zTXt payloads added!\n");
    }
 
+   if (parser.is_used("--binary-section-payload"))
+   {
+      status_normal("Adding faCd payload(s) to ", input, "...");
+
+      auto payloads = parser.get<std::vector<std::string>>("--binary-section-payload");
+      std::uint8_t codec = (parser.get<bool>("--compress-binary")) ? png::BINARY_ZLIB : png::BINARY_RAW;
+
+      for (std::size_t i=0; i<payloads.size(); i+=2)
+      {
+         auto keyword = payloads[i];
+         auto payload_file = payloads[i+1];
+
+         status_normal("-> Processing payload ", (i/2)+1, "...");
+         status_normal("---> Keyword: ", keyword);
+         status_normal("---> Payload: ", payload_file);
+
+         std::vector<std::uint8_t> data;
+         
+         try {
+            status_normal("---> Reading file \"", payload_file, "\"...");
+            data = read_file(payload_file);
+            status_alert("---> Got payload data!");
+         }
+         catch (exception::Exception &exc)
+         {
+            status_error("---> Failed to read payload: ", exc.error);
+            return 10;
+         }
+
+         try {
+            status_normal("---> Adding payload to \"", input, "\"...");
+
+            if (auto png = std::get_if<PNGPayload>(&payload))
+               png->add_binary_payload(keyword, data, codec);
+            else if (auto ico = std::get_if<ICOPayload>(&payload))
+            {
+               (*ico)->add_binary_payload(keyword, data, codec);
+               primary_modified = true;
+            }
+            
+            status_alert("---> Payload added!");
+         }
+         catch (exception::Exception &exc)
+         {
+            status_error("---> Failed to add payload: ", exc.error);
+            return 11;
+         }
+
+         status_alert("-> Payload ", (i/2)+1, " processed.\n");
+      }
+
+      status_alert("faCd payloads added!\n");
+   }
+
    if (parser.is_used("--stego-payload"))
    {
       status_normal("Adding steganographic payload to ", input, "...");
@@ -261,9 +545,21 @@ int create_payload(const argparse::ArgumentParser &parser) {
       auto payload_file = parser.get<std::string>("--stego-payload");
       std::vector<std::uint8_t> data;
 
+      /* a streamed payload is read a block at a time while it's embedded, rather than all at once up front */
+      auto streamed = parser.get<bool>("--stream");
+      std::ifstream payload_stream;
+
       try {
          status_normal("-> Loading file \"", payload_file, "\"...");
-         data = read_file(payload_file);
+
+         if (streamed)
+         {
+            payload_stream.open(payload_file, std::ios::binary);
+            if (!payload_stream) { throw exception::OpenFileFailure(payload_file); }
+         }
+         else
+            data = read_file(payload_file);
+
          status_alert("-> Got payload data!");
       }
       catch (exception::Exception &exc)
@@ -275,10 +571,54 @@ int create_payload(const argparse::ArgumentParser &parser) {
       status_normal("-> Creating stego payload...");
       status_normal("-> This may take a moment, depending on the size of the image in pixels.");
 
-      if (auto png = std::get_if<PNGPayload>(&payload))
-         payload = png->create_stego_payload(data);
-      else if (auto ico = std::get_if<ICOPayload>(&payload))
-         ico->png_payload() = (*ico)->create_stego_payload(data);
+      try {
+         if (auto png = std::get_if<PNGPayload>(&payload))
+         {
+            if (parser.get<bool>("--frames"))
+            {
+               status_normal("-> Spreading the payload across ", png->frame_count(), " animation frames...");
+               payload = png->create_frame_stego_payload(data);
+            }
+            else if (streamed)
+            {
+               status_normal("-> Streaming the payload in blocks of ", PNGPayload::StegoBlockSize, " bytes...");
+               payload = png->create_stego_stream_payload(payload_stream);
+            }
+            else
+               payload = png->create_stego_payload(data);
+         }
+         else if (auto ico = std::get_if<ICOPayload>(&payload))
+         {
+            if (parser.get<bool>("--striped"))
+            {
+               status_normal("-> Striping the payload across ", ico->png_indexes().size(), " PNG entries...");
+               *ico = ico->create_striped_stego_payload(data);
+            }
+            else if (parser.get<bool>("--bmp"))
+            {
+               /* bitmaps need no compression pipeline, so the one with the most room is the only choice to make */
+               auto indexes = ico->bmp_indexes();
+               if (indexes.empty()) { throw exception::NoBMPIcon(ico->size()); }
+
+               auto index = *std::max_element(indexes.begin(), indexes.end(), [&](std::size_t left, std::size_t right) {
+                  return ico->bmp_stego_capacity(left) < ico->bmp_stego_capacity(right);
+               });
+
+               status_normal("-> Encoding the payload in bitmap entry ", index, "...");
+               *ico = ico->create_bmp_stego_payload(index, data);
+            }
+            else
+            {
+               ico->png_payload() = (*ico)->create_stego_payload(data);
+               primary_modified = true;
+            }
+         }
+      }
+      catch (exception::Exception &exc)
+      {
+         status_error("-> Failed to create stego payload: ", exc.error);
+         return 13;
+      }
 
       status_alert("Stego payload created!\n");
    }
@@ -290,7 +630,8 @@ int create_payload(const argparse::ArgumentParser &parser) {
          png->save(output);
       else if (auto ico = std::get_if<ICOPayload>(&payload))
       {
-         ico->set_png();
+         /* an untouched entry keeps its original bytes, so only the entries that changed are spliced into the icon */
+         if (ico->has_png() && primary_modified) { ico->set_png(); }
          ico->save(output);
       }
 
@@ -305,7 +646,7 @@ int create_payload(const argparse::ArgumentParser &parser) {
    return 0;
 }
 
-int extract_payloads(const argparse::ArgumentParser &parser) {
+int extract_payloads(const argparse::ArgumentParser &parser, const std::shared_ptr<Stats> &stats) {
    std::cout << HEADER << std::endl;
       
    status_normal("Attempting to extract payloads!");
@@ -322,7 +663,7 @@ int extract_payloads(const argparse::ArgumentParser &parser) {
 
    try
    {
-      payload = PNGPayload(input);
+      payload = parse_png(input, stats);
       status_alert("Image parsed!\n");
    }
    catch (exception::BadPNGSignature &bad_png)
@@ -330,7 +671,7 @@ int extract_payloads(const argparse::ArgumentParser &parser) {
       try
       {
          status_normal("Not a PNG image. Trying to parse as icon with embedded PNG...");
-         payload = ICOPayload(input);
+         payload = parse_ico(input, stats);
          status_alert("Icon parsed!");
       }
       catch (exception::Exception &exc)
@@ -351,6 +692,7 @@ int extract_payloads(const argparse::ArgumentParser &parser) {
        || (!parser.is_used("--trailing-data-payload")
            && !parser.is_used("--text-section-payload")
            && !parser.is_used("--ztxt-section-payload")
+           && !parser.is_used("--binary-section-payload")
            && !parser.is_used("--stego-payload")))
    {
       status_normal("Attempting to extract all techniques.");
@@ -359,391 +701,600 @@ int extract_payloads(const argparse::ArgumentParser &parser) {
 
    std::size_t payloads_found = 0;
 
-   if (all_techniques || parser.is_used("--trailing-data-payload"))
+   std::map<std::string,std::size_t> found_payloads;
+   std::vector<std::pair<std::string, PNGPayload>> images;
+
+   try {
+      images = input_images(payload, stats, all_techniques || parser.is_used("--stego-payload"));
+   }
+   catch (exception::Exception &exc)
    {
-      status_normal("Searching for trailing data...");
+      status_error("Failed to load input file: ", exc.error);
+      return 1;
+   }
 
-      bool has_trailing = false;
+   /* a striped stego payload belongs to the icon as a whole rather than any one of its entries, and bitmap entries
+      aren't PNG images, so both are looked for apart from the PNG entries */
+   bool found_icon_stego = false;
+   auto ico = std::get_if<ICOPayload>(&payload);
 
-      if (auto png = std::get_if<PNGPayload>(&payload))
-         has_trailing = png->has_trailing_data();
-      else if (auto ico = std::get_if<ICOPayload>(&payload))
-         has_trailing = (*ico)->has_trailing_data();
+   if (ico != nullptr && (all_techniques || parser.is_used("--stego-payload")))
+   {
+      status_normal("Checking the icon for a striped stego payload...");
 
-      if (has_trailing)
+      std::vector<std::uint8_t> striped_data;
+
+      try {
+         striped_data = ico->extract_striped_stego_payload();
+         found_icon_stego = true;
+         status_alert("Striped stego payload extracted!");
+      }
+      catch (exception::NoStegoData &)
       {
-         status_alert("Trailing data found!");
-         std::vector<std::uint8_t> trailing_data;
-         
-         if (auto png = std::get_if<PNGPayload>(&payload))
-            trailing_data = png->get_trailing_data();
-         else if (auto ico = std::get_if<ICOPayload>(&payload))
-            trailing_data = (*ico)->get_trailing_data();
-         
-         status_normal("Trailing data size: ", trailing_data.size());
+         status_normal("No striped stego payload found.\n");
+      }
+      catch (exception::Exception &exc)
+      {
+         status_error("Failed to extract striped stego payload: ", exc.error);
+         return 17;
+      }
+
+      if (found_icon_stego)
+      {
+         std::string striped_filename = output + std::string("/striped_stego_payload.bin");
+
+         try {
+            status_normal("Attempting to save striped stego payload to \"", striped_filename, "\"...");
+            write_file(striped_filename, striped_data);
+            status_alert("Stego data saved!\n");
+         }
+         catch (exception::Exception &exc) {
+            status_error("Failed to save stego data: ", exc.error);
+            return 18;
+         }
+
+         ++payloads_found;
+      }
 
-         std::string trailing_filename = output + std::string("/trailing_data.bin");
+      status_normal("Checking the icon's bitmap entries for stego payloads...");
+
+      for (auto index : ico->bmp_indexes())
+      {
+         if (!ico->has_bmp_stego_payload(index)) { continue; }
+
+         std::vector<std::uint8_t> bmp_data;
 
          try {
-            status_normal("Saving trailing data to ", trailing_filename, "...");
-            write_file(trailing_filename, trailing_data);
-            status_alert("Payload extracted!\n");
+            bmp_data = ico->extract_bmp_stego_payload(index);
+            status_alert("Stego payload extracted from bitmap entry ", index, "!");
          }
          catch (exception::Exception &exc)
          {
-            status_error("Failed to save trailing data: ", exc.error);
-            return 2;
+            status_error("Failed to extract stego payload: ", exc.error);
+            return 17;
+         }
+
+         std::string bmp_filename = output + "/entry" + std::to_string(index) + ".bmp_stego_payload.bin";
+
+         try {
+            status_normal("Attempting to save stego payload to \"", bmp_filename, "\"...");
+            write_file(bmp_filename, bmp_data);
+            status_alert("Stego data saved!\n");
+         }
+         catch (exception::Exception &exc) {
+            status_error("Failed to save stego data: ", exc.error);
+            return 18;
          }
 
+         found_icon_stego = true;
          ++payloads_found;
       }
-      else {
-         if (all_techniques) { status_normal("No trailing data found.\n"); }
-         else { status_error("No trailing data found."); return 3; }
-      }
    }
-      
-   std::map<std::string,std::size_t> found_payloads;
 
-   if (all_techniques || parser.is_used("--text-section-payload"))
+   /* with an icon carrying more than one PNG entry, a technique which finds nothing in one entry might find something
+      in another, so that's only an error if nothing turns up in any of them */
+   bool required = !all_techniques && images.size() == 1 && !found_icon_stego;
+
+   for (auto &image : images)
    {
-      if (all_techniques)
+      auto &prefix = image.first;
+      auto png = &image.second;
+
+      if (images.size() > 1)
+         status_normal("Examining ", (prefix.empty()) ? std::string("primary PNG entry") : prefix.substr(0, prefix.size()-1), "...\n");
+
+      if (all_techniques || parser.is_used("--trailing-data-payload"))
       {
-         bool has_text = false;
+         status_normal("Searching for trailing data...");
 
-         if (auto png = std::get_if<PNGPayload>(&payload))
-            has_text = png->has_chunk("tEXt");
-         else if (auto ico = std::get_if<ICOPayload>(&payload))
-            has_text = (*ico)->has_chunk("tEXt");
-         
-         if (has_text)
+         bool has_trailing = png->has_trailing_data();
+
+         if (has_trailing)
          {
-            status_normal("Scanning tEXt sections for possible payloads...");
+            status_alert("Trailing data found!");
 
-            std::vector<png::ChunkVec> text_chunks;
+            /* read it in place, since a copy of the image shares its trailing data with the input */
+            auto &trailing_data = std::as_const(*png).get_trailing_data();
 
-            if (auto png = std::get_if<PNGPayload>(&payload))
-               text_chunks = png->get_chunks("tEXt");
-            else if (auto ico = std::get_if<ICOPayload>(&payload))
-               text_chunks = (*ico)->get_chunks("tEXt");
-      
-            for (auto &chunk : text_chunks)
+            status_normal("Trailing data size: ", trailing_data.size());
+
+            std::string trailing_filename = output + "/" + prefix + "trailing_data.bin";
+
+            try {
+               status_normal("Saving trailing data to ", trailing_filename, "...");
+               write_file(trailing_filename, trailing_data);
+               status_alert("Payload extracted!\n");
+            }
+            catch (exception::Exception &exc)
+            {
+               status_error("Failed to save trailing data: ", exc.error);
+               return 2;
+            }
+
+            ++payloads_found;
+
+            if (parser.get<bool>("--carve"))
             {
-               auto text = chunk.upcast<png::Text>();
-               auto keyword = text.keyword();
-               auto data = text.text();
+               status_normal("Carving the files found in the trailing data...");
 
-               if (is_base64_string(data))
+               auto files = png->scan_trailing_data();
+
+               for (std::size_t i=0; i<files.size(); ++i)
                {
-                  status_alert("Found payload with keyword \"", keyword, "\"!");
+                  auto &file = files[i];
+                  auto carved_filename = output + "/" + prefix + "trailing_data." + std::to_string(i) + "." + format_extension(file.format);
 
-                  std::vector<std::uint8_t> decoded_data;
-               
                   try {
-                     decoded_data = base64_decode(data);
+                     status_normal("-> Saving ", format_name(file.format), " at offset ", file.offset, " to ", carved_filename, "...");
+                     write_file(carved_filename, trailing_data.data() + file.offset, file.size);
                   }
-                  catch (exception::Exception &exc) {
-                     status_error("Failed to decode payload: ", exc.error);
-                     return 4;
+                  catch (exception::Exception &exc)
+                  {
+                     status_error("Failed to save carved file: ", exc.error);
+                     return 2;
                   }
-
-                  found_payloads[keyword] += 1;
-                  std::stringstream decoded_filename;
-
-                  decoded_filename << output << "/" << keyword << "." << std::setw(4) << std::setfill('0') << found_payloads[keyword] << ".bin";
-                  
-                  try {
-                     status_normal("Saving payload to \"", decoded_filename.str(), "\"...");
-                     write_file(decoded_filename.str(), decoded_data);
-                     status_alert("Payload saved!\n");
-                  }
-                  catch (exception::Exception &exc) {
-                     status_error("Failed to write file: ", exc.error);
-                     return 5;
-                  }
-
-                  ++payloads_found;
                }
-               else { status_normal("Chunk with keyword \"", keyword, "\" is not a payload."); }
-            }
 
-            if (payloads_found > 0) { status_normal("Finished extracting payloads!\n"); }
-            else { status_normal("No payloads found.\n"); }
+               if (files.size() > 0) { status_alert("Carved ", files.size(), " file", (files.size() == 1) ? "." : "s.", "\n"); }
+               else { status_normal("No known file formats found in the trailing data.\n"); }
+            }
+         }
+         else {
+            if (!required) { status_normal("No trailing data found.\n"); }
+            else { status_error("No trailing data found."); return 3; }
          }
-         else { status_normal("No tEXt sections found to scan.\n"); }
       }
-      else {
-         auto keyword = parser.get<std::string>("--text-section-payload");
-         bool has_text = false;
 
-         if (auto png = std::get_if<PNGPayload>(&payload))
-            has_text = png->has_chunk("tEXt");
-         else if (auto ico = std::get_if<ICOPayload>(&payload))
-            has_text = (*ico)->has_chunk("tEXt");
-         
-         if (!has_text)
+      if (all_techniques || parser.is_used("--text-section-payload"))
+      {
+         if (all_techniques)
          {
-            status_error("No tEXt sections found in input.");
-            return 6;
-         }
+            bool has_text = png->has_chunk("tEXt");
 
-         std::vector<std::vector<std::uint8_t>> text_payloads;
-         
-         try {
-            status_normal("Attempting to extract payloads with keyword \"", keyword, "\"...");
+            if (has_text)
+            {
+               status_normal("Scanning tEXt sections for possible payloads...");
 
-            if (auto png = std::get_if<PNGPayload>(&payload))
-               text_payloads = png->extract_text_payloads(keyword);
-            else if (auto ico = std::get_if<ICOPayload>(&payload))
-               text_payloads = (*ico)->extract_text_payloads(keyword);
+               png::ChunkView<> text_chunks;
 
-            if (text_payloads.size() == 0) {
-               status_error("No payloads found.");
-               return 7;
-            }
+               text_chunks = png->get_chunks("tEXt");
 
-            status_alert("Found ", text_payloads.size(), " payload", ((text_payloads.size() == 1) ? "!\n" : "s!\n"));
-         }
-         catch (exception::Exception &exc) {
-            status_error("Failed to extract payloads: ", exc.error);
-            return 8;
+               for (auto &chunk : text_chunks)
+               {
+                  auto &text = chunk.upcast<png::Text>();
+                  auto keyword = text.keyword();
+                  auto data = text.text_view();
+
+                  if (is_base64_string(data))
+                  {
+                     status_alert("Found payload with keyword \"", keyword, "\"!");
+
+                     std::vector<std::uint8_t> decoded_data;
+
+                     try {
+                        decoded_data = base64_decode(data.data(), data.size());
+                     }
+                     catch (exception::Exception &exc) {
+                        status_error("Failed to decode payload: ", exc.error);
+                        return 4;
+                     }
+
+                     found_payloads[keyword] += 1;
+                     std::stringstream decoded_filename;
+
+                     decoded_filename << output << "/" << keyword << "." << std::setw(4) << std::setfill('0') << found_payloads[keyword] << ".bin";
+
+                     try {
+                        status_normal("Saving payload to \"", decoded_filename.str(), "\"...");
+                        write_file(decoded_filename.str(), decoded_data);
+                        status_alert("Payload saved!\n");
+                     }
+                     catch (exception::Exception &exc) {
+                        status_error("Failed to write file: ", exc.error);
+                        return 5;
+                     }
+
+                     ++payloads_found;
+                  }
+                  else { status_normal("Chunk with keyword \"", keyword, "\" is not a payload."); }
+               }
+
+               if (payloads_found > 0) { status_normal("Finished extracting payloads!\n"); }
+               else { status_normal("No payloads found.\n"); }
+            }
+            else { status_normal("No tEXt sections found to scan.\n"); }
          }
+         else {
+            auto keyword = parser.get<std::string>("--text-section-payload");
+            bool has_text = png->has_chunk("tEXt");
 
-         payloads_found += text_payloads.size();
+            if (!has_text && required)
+            {
+               status_error("No tEXt sections found in input.");
+               return 6;
+            }
 
-         for (auto &extracted : text_payloads)
-         {
-            found_payloads[keyword] += 1;
-            std::stringstream decoded_filename;
+            std::vector<std::vector<std::uint8_t>> text_payloads;
 
-            decoded_filename << output << "/" << keyword << "." << std::setw(4) << std::setfill('0') << found_payloads[keyword] << ".bin";
-                  
             try {
-               status_normal("Saving payload to \"", decoded_filename.str(), "\"...");
-               write_file(decoded_filename.str(), extracted);
-               status_alert("Payload saved!");
+               status_normal("Attempting to extract payloads with keyword \"", keyword, "\"...");
+
+               text_payloads = png->extract_text_payloads(keyword);
+
+               if (text_payloads.size() == 0 && required) {
+                  status_error("No payloads found.");
+                  return 7;
+               }
+               else if (text_payloads.size() > 0)
+                  status_alert("Found ", text_payloads.size(), " payload", ((text_payloads.size() == 1) ? "!\n" : "s!\n"));
             }
             catch (exception::Exception &exc) {
-               status_error("Failed to write file: ", exc.error);
-               return 9;
+               status_error("Failed to extract payloads: ", exc.error);
+               return 8;
+            }
+
+            payloads_found += text_payloads.size();
+
+            for (auto &extracted : text_payloads)
+            {
+               found_payloads[keyword] += 1;
+               std::stringstream decoded_filename;
+
+               decoded_filename << output << "/" << keyword << "." << std::setw(4) << std::setfill('0') << found_payloads[keyword] << ".bin";
+
+               try {
+                  status_normal("Saving payload to \"", decoded_filename.str(), "\"...");
+                  write_file(decoded_filename.str(), extracted);
+                  status_alert("Payload saved!");
+               }
+               catch (exception::Exception &exc) {
+                  status_error("Failed to write file: ", exc.error);
+                  return 9;
+               }
             }
+
+            if (payloads_found > 0) { status_normal("Finished extracting payloads!\n"); }
+            else { status_normal("No payloads found.\n"); }
          }
-      
-         if (payloads_found > 0) { status_normal("Finished extracting payloads!\n"); }
-         else { status_normal("No payloads found.\n"); }
       }
-   }
 
-   if (all_techniques || parser.is_used("--ztxt-section-payload"))
-   {
-      if (all_techniques)
+      if (all_techniques || parser.is_used("--ztxt-section-payload"))
       {
-         bool has_text = false;
-
-         if (auto png = std::get_if<PNGPayload>(&payload))
-            has_text = png->has_chunk("zTXt");
-         else if (auto ico = std::get_if<ICOPayload>(&payload))
-            has_text = (*ico)->has_chunk("zTXt");
-         
-         if (has_text)
+         if (all_techniques)
          {
-            status_normal("Scanning zTXt sections for possible payloads...");
+            bool has_text = png->has_chunk("zTXt");
+
+            if (has_text)
+            {
+               status_normal("Scanning zTXt sections for possible payloads...");
 
-            std::vector<png::ChunkVec> text_chunks;
+               png::ChunkView<> text_chunks;
 
-            if (auto png = std::get_if<PNGPayload>(&payload))
                text_chunks = png->get_chunks("zTXt");
-            else if (auto ico = std::get_if<ICOPayload>(&payload))
-               text_chunks = (*ico)->get_chunks("zTXt");
-      
-            for (auto &chunk : text_chunks)
-            {
-               auto text = chunk.upcast<png::ZText>();
-               auto keyword = text.keyword();
-               std::string data;
 
-               try {
-                  status_normal("Attempting to decompress zTXt section...");
-                  data = text.text();
-                  status_alert("Text decompressed!");
-               }
-               catch (exception::Exception &exc)
+               /* extracting by keyword decompresses every chunk concurrently and reassembles segmented payloads */
+               std::vector<std::string> keywords;
+
+               for (auto &chunk : text_chunks)
                {
-                  status_error("Failed to decompress: ", exc.error);
-                  return 10;
+                  auto keyword = chunk.upcast<png::ZText>().keyword_view();
+
+                  if (std::find(keywords.begin(), keywords.end(), keyword) == keywords.end())
+                     keywords.push_back(std::string(keyword));
                }
 
-               if (is_base64_string(data))
+               for (auto &keyword : keywords)
                {
-                  status_alert("Found payload with keyword \"", keyword, "\"!");
+                  std::vector<std::vector<std::uint8_t>> keyword_payloads;
 
-                  std::vector<std::uint8_t> decoded_data;
-               
                   try {
-                     decoded_data = base64_decode(data);
+                     status_normal("Attempting to decompress zTXt sections with keyword \"", keyword, "\"...");
+
+                     /* chunks under the keyword which aren't payloads are skipped, so they can't hide the ones which are */
+                     keyword_payloads = png->extract_ztext_payloads(keyword);
+
+                     if (keyword_payloads.size() == 0)
+                     {
+                        status_normal("Chunks with keyword \"", keyword, "\" are not a payload.");
+                        continue;
+                     }
+
+                     status_alert("Text decompressed!");
+                  }
+                  catch (exception::InvalidBase64Character &exc)
+                  {
+                     status_normal("Chunks with keyword \"", keyword, "\" are not a valid segmented payload: ", exc.error);
+                     continue;
                   }
-                  catch (exception::Exception &exc) {
-                     status_error("Failed to decode payload: ", exc.error);
+                  catch (exception::InvalidSegment &exc)
+                  {
+                     status_normal("Chunks with keyword \"", keyword, "\" are not a complete payload: ", exc.error);
+                     continue;
+                  }
+                  catch (exception::Exception &exc)
+                  {
+                     status_error("Failed to decompress: ", exc.error);
                      return 10;
                   }
 
-                  found_payloads[keyword] += 1;
-                  std::stringstream decoded_filename;
+                  for (auto &decoded_data : keyword_payloads)
+                  {
+                     status_alert("Found payload with keyword \"", keyword, "\"!");
 
-                  decoded_filename << output << "/" << keyword << "." << std::setw(4) << std::setfill('0') << found_payloads[keyword] << ".bin";
-                  
-                  try {
-                     status_normal("Saving payload to \"", decoded_filename.str(), "\"...");
-                     write_file(decoded_filename.str(), decoded_data);
-                     status_alert("Payload saved!\n");
-                  }
-                  catch (exception::Exception &exc) {
-                     status_error("Failed to write file: ", exc.error);
-                     return 11;
+                     found_payloads[keyword] += 1;
+                     std::stringstream decoded_filename;
+
+                     decoded_filename << output << "/" << keyword << "." << std::setw(4) << std::setfill('0') << found_payloads[keyword] << ".bin";
+
+                     try {
+                        status_normal("Saving payload to \"", decoded_filename.str(), "\"...");
+                        write_file(decoded_filename.str(), decoded_data);
+                        status_alert("Payload saved!\n");
+                     }
+                     catch (exception::Exception &exc) {
+                        status_error("Failed to write file: ", exc.error);
+                        return 11;
+                     }
+
+                     ++payloads_found;
                   }
+               }
+
+               if (payloads_found > 0) { status_normal("Finished extracting payloads!\n"); }
+               else { status_normal("No payloads found.\n"); }
+            }
+            else { status_normal("No zTXt sections found to scan.\n"); }
+         }
+         else {
+            auto keyword = parser.get<std::string>("--ztxt-section-payload");
+            bool has_text = png->has_chunk("zTXt");
+
+            if (!has_text && required) {
+               status_error("No zTXt sections found in input.");
+               return 12;
+            }
 
-                  ++payloads_found;
+            std::vector<std::vector<std::uint8_t>> text_payloads;
+
+            try {
+               status_normal("Attempting to extract payloads with keyword \"", keyword, "\"...");
+
+               text_payloads = png->extract_ztext_payloads(keyword);
+
+               if (text_payloads.size() == 0 && required) {
+                  status_error("No payloads found.");
+                  return 13;
                }
-               else { status_normal("Chunk with keyword \"", keyword, "\" is not a payload."); }
+               else if (text_payloads.size() > 0)
+                  status_alert("Found ", text_payloads.size(), " payload", ((text_payloads.size() == 1) ? "!\n" : "s!\n"));
             }
-      
+            catch (exception::Exception &exc) {
+               status_error("Failed to extract payloads: ", exc.error);
+               return 14;
+            }
+
+            payloads_found += text_payloads.size();
+
+            for (auto &extracted : text_payloads)
+            {
+               found_payloads[keyword] += 1;
+               std::stringstream decoded_filename;
+
+               decoded_filename << output << "/" << keyword << "." << std::setw(4) << std::setfill('0') << found_payloads[keyword] << ".bin";
+
+               try {
+                  status_normal("Saving payload to \"", decoded_filename.str(), "\"...");
+                  write_file(decoded_filename.str(), extracted);
+                  status_alert("Payload saved!");
+               }
+               catch (exception::Exception &exc) {
+                  status_error("Failed to write file: ", exc.error);
+                  return 15;
+               }
+            }
+
             if (payloads_found > 0) { status_normal("Finished extracting payloads!\n"); }
             else { status_normal("No payloads found.\n"); }
          }
-         else { status_normal("No zTXt sections found to scan.\n"); }
       }
-      else {
-         auto keyword = parser.get<std::string>("--ztxt-section-payload");
-         bool has_text = false;
 
-         if (auto png = std::get_if<PNGPayload>(&payload))
-            has_text = png->has_chunk("zTXt");
-         else if (auto ico = std::get_if<ICOPayload>(&payload))
-            has_text = (*ico)->has_chunk("zTXt");
+      if (all_techniques || parser.is_used("--binary-section-payload"))
+      {
+         bool has_binary = png->has_binary();
 
-         if (!has_text) {
-            status_error("No zTXt sections found in input.");
-            return 12;
+         if (!has_binary && required)
+         {
+            status_error("No faCd sections found in input.");
+            return 20;
          }
+         else if (!has_binary) { status_normal("No faCd sections found to scan.\n"); }
+         else
+         {
+            png::ChunkView<> binary_chunks;
+            std::optional<std::string> keyword;
 
-         std::vector<std::vector<std::uint8_t>> text_payloads;
-         
-         try {
-            status_normal("Attempting to extract payloads with keyword \"", keyword, "\"...");
+            if (!all_techniques)
+               keyword = parser.get<std::string>("--binary-section-payload");
 
-            if (auto png = std::get_if<PNGPayload>(&payload))
-               text_payloads = png->extract_ztext_payloads(keyword);
-            else if (auto ico = std::get_if<ICOPayload>(&payload))
-               text_payloads = (*ico)->extract_ztext_payloads(keyword);
+            binary_chunks = png->get_chunks("faCd");
+
+            status_normal("Scanning faCd sections for payloads...");
+
+            std::size_t binary_found = 0;
+
+            for (auto &chunk : binary_chunks)
+            {
+               auto &binary = chunk.upcast<png::BinaryData>();
+               if (!binary.has_keyword()) { continue; }
+
+               auto found_keyword = binary.keyword();
+               if (keyword.has_value() && found_keyword != *keyword) { continue; }
+
+               status_alert("Found payload with keyword \"", found_keyword, "\"!");
+
+               std::vector<std::uint8_t> binary_data;
+
+               try {
+                  binary_data = binary.payload();
+               }
+               catch (exception::Exception &exc) {
+                  status_error("Failed to decode payload: ", exc.error);
+                  return 21;
+               }
+
+               found_payloads[found_keyword] += 1;
+               std::stringstream binary_filename;
+
+               binary_filename << output << "/" << found_keyword << "." << std::setw(4) << std::setfill('0') << found_payloads[found_keyword] << ".bin";
 
-            if (text_payloads.size() == 0) {
-               status_error("No payloads found.");
-               return 13;
+               try {
+                  status_normal("Saving payload to \"", binary_filename.str(), "\"...");
+                  write_file(binary_filename.str(), binary_data);
+                  status_alert("Payload saved!\n");
+               }
+               catch (exception::Exception &exc) {
+                  status_error("Failed to write file: ", exc.error);
+                  return 22;
+               }
+
+               ++binary_found;
             }
 
-            status_alert("Found ", text_payloads.size(), " payload", ((text_payloads.size() == 1) ? "!\n" : "s!\n"));
+            payloads_found += binary_found;
+
+            if (binary_found > 0) { status_normal("Finished extracting payloads!\n"); }
+            else if (required) { status_error("No payloads found."); return 23; }
+            else { status_normal("No payloads found.\n"); }
          }
-         catch (exception::Exception &exc) {
-            status_error("Failed to extract payloads: ", exc.error);
-            return 14;
+      }
+
+      if (all_techniques || parser.is_used("--stego-payload"))
+      {
+         try {
+            status_normal("Loading input to check for stego data...");
+
+            if (!png->is_loaded()) { png->load(); }
+
+            status_normal("Input loaded.");
+         }
+         catch (exception::Exception &exc)
+         {
+            status_error("Failed to load payload: ", exc.error);
+            return 16;
          }
 
-         payloads_found += text_payloads.size();
+         /* the frames of an animation carry a payload of their own, apart from the default image */
+         bool has_frame_stego = false;
 
-         for (auto &extracted : text_payloads)
+         if (png->is_animated())
          {
-            found_payloads[keyword] += 1;
-            std::stringstream decoded_filename;
+            status_normal("Checking the frames of the animation for a frame stego payload...");
+
+            std::vector<std::uint8_t> frame_data;
 
-            decoded_filename << output << "/" << keyword << "." << std::setw(4) << std::setfill('0') << found_payloads[keyword] << ".bin";
-                  
             try {
-               status_normal("Saving payload to \"", decoded_filename.str(), "\"...");
-               write_file(decoded_filename.str(), extracted);
-               status_alert("Payload saved!");
+               frame_data = png->extract_frame_stego_payload();
+               has_frame_stego = true;
+               status_alert("Frame stego payload extracted!");
+            }
+            catch (exception::NoStegoData &) {
+               status_normal("No frame stego payload found.");
             }
             catch (exception::Exception &exc) {
-               status_error("Failed to write file: ", exc.error);
-               return 15;
+               status_error("Failed to extract frame stego payload: ", exc.error);
+               return 17;
             }
-         }
-      
-         if (payloads_found > 0) { status_normal("Finished extracting payloads!\n"); }
-         else { status_normal("No payloads found.\n"); }
-      }
-   }
 
-   if (all_techniques || parser.is_used("--stego-payload"))
-   {
-      try {
-         status_normal("Loading input to check for stego data...");
+            if (has_frame_stego)
+            {
+               std::string frame_filename = output + "/" + prefix + "frame_stego_payload.bin";
 
-         if (auto png = std::get_if<PNGPayload>(&payload))
-            png->load();
-         else if (auto ico = std::get_if<ICOPayload>(&payload))
-            (*ico)->load();
+               try {
+                  status_normal("Attempting to save frame stego payload to \"", frame_filename, "\"...");
+                  write_file(frame_filename, frame_data);
+                  status_alert("Stego data saved!\n");
+               }
+               catch (exception::Exception &exc) {
+                  status_error("Failed to save stego data: ", exc.error);
+                  return 18;
+               }
 
-         status_normal("Input loaded.");
-      }
-      catch (exception::Exception &exc)
-      {
-         status_error("Failed to load payload: ", exc.error);
-         return 16;
-      }
+               ++payloads_found;
+            }
+         }
 
-      bool has_stego = false;
+         bool has_stego = png->has_stego_payload();
 
-      if (auto png = std::get_if<PNGPayload>(&payload))
-         has_stego = png->has_stego_payload();
-      else if (auto ico = std::get_if<ICOPayload>(&payload))
-         has_stego = (*ico)->has_stego_payload();
+         if (has_stego) {
+            status_alert("Found stego payload!");
 
-      if (has_stego) {
-         status_alert("Found stego payload!");
+            /* the payload is written out as it's decoded, so a stego stream never has to fit in memory */
+            std::string stego_filename = output + "/" + prefix + "stego_payload.bin";
+            std::ofstream stego_file(stego_filename, std::ios::binary);
 
-         std::vector<std::uint8_t> stego_data;
+            if (!stego_file) {
+               status_error("Failed to save stego data: ", exception::OpenFileFailure(stego_filename).error);
+               return 18;
+            }
 
-         try {
-            status_normal("Attempting to decode stego data...");
+            try {
+               status_normal("Attempting to decode stego data to \"", stego_filename, "\"...");
 
-            if (auto png = std::get_if<PNGPayload>(&payload))
-               stego_data = png->extract_stego_payload();
-            else if (auto ico = std::get_if<ICOPayload>(&payload))
-               stego_data = (*ico)->extract_stego_payload();
-            
-            status_alert("Payload extracted!");
-         }
-         catch (exception::Exception &exc) {
-            status_error("Failed to extract stego payload: ", exc.error);
-            return 17;
-         }
+               png->extract_stego_payload(stego_file);
 
-         std::string stego_filename = output + std::string("/stego_payload.bin");
+               status_alert("Payload extracted!");
+               status_alert("Stego data saved!\n");
+            }
+            catch (exception::StreamFailure &exc) {
+               status_error("Failed to save stego data: ", exc.error);
+               return 18;
+            }
+            catch (exception::Exception &exc) {
+               status_error("Failed to extract stego payload: ", exc.error);
+               return 17;
+            }
 
-         try {
-            status_normal("Attempting to save stego payload to \"", stego_filename, "\"...");
-            write_file(stego_filename, stego_data);
-            status_alert("Stego data saved!\n");
+            ++payloads_found;
          }
-         catch (exception::Exception &exc) {
-            status_error("Failed to save stego data: ", exc.error);
-            return 18;
+         else if (!has_frame_stego) {
+            if (!required) { status_normal("No stego payload found."); }
+            else { status_error("No stego payload found."); return 19; }
          }
-
-         ++payloads_found;
-      }
-      else {
-         if (all_techniques) { status_normal("No stego payload found."); }
-         else { status_error("No stego payload found."); return 19; }
       }
    }
-   
+
+   if (!all_techniques && !required && payloads_found == 0)
+   {
+      status_error("No payloads found in any PNG entry.");
+      return 24;
+   }
+
    status_normal("Extraction techniques exhausted. Found ", payloads_found, " payload", ((payloads_found == 1) ? "." : "s."));
 
    return 0;
 }
 
-int detect_payloads(const argparse::ArgumentParser &parser) {
+int detect_payloads(const argparse::ArgumentParser &parser, const std::shared_ptr<Stats> &stats) {
    auto minimal = parser.get<bool>("--minimal");
 
    if (!minimal)
@@ -762,7 +1313,9 @@ int detect_payloads(const argparse::ArgumentParser &parser) {
        || (!parser.is_used("--trailing-data")
            && !parser.is_used("--text-data")
            && !parser.is_used("--ztxt-data")
-           && !parser.is_used("--stego-data")))
+           && !parser.is_used("--binary-data")
+           && !parser.is_used("--stego-data")
+           && !parser.is_used("--lsb-analysis")))
    {
       auto_detect = true;
 
@@ -775,7 +1328,7 @@ int detect_payloads(const argparse::ArgumentParser &parser) {
    try
    {
       if (!minimal) { status_normal("Parsing input file \"", input, "\"..."); }
-      payload = PNGPayload(input);
+      payload = parse_png(input, stats);
       if (!minimal) { status_alert("Image parsed!\n"); }
    }
    catch (exception::BadPNGSignature &bad_png)
@@ -783,7 +1336,7 @@ int detect_payloads(const argparse::ArgumentParser &parser) {
       try
       {
          if (!minimal) { status_normal("Not a PNG image. Trying to parse as icon with embedded PNG...");}
-         payload = ICOPayload(input);
+         payload = parse_ico(input, stats);
          if (!minimal) { status_alert("Icon parsed!"); }
       }
       catch (exception::Exception &exc)
@@ -800,170 +1353,316 @@ int detect_payloads(const argparse::ArgumentParser &parser) {
 
    std::vector<std::string> minimal_report;
 
-   if (auto_detect || parser.is_used("--trailing-data"))
+   std::vector<std::pair<std::string, PNGPayload>> images;
+
+   try {
+      auto load = auto_detect || parser.is_used("--stego-data") || parser.is_used("--lsb-analysis");
+      images = input_images(payload, stats, load);
+   }
+   catch (exception::Exception &exc)
    {
-      if (!minimal) { status_normal("Checking for trailing data..."); }
+      if (!minimal) { status_error("Failed to load input file: ", exc.error); }
+      return 1;
+   }
 
-      bool has_trailing = false;
+   auto ico = std::get_if<ICOPayload>(&payload);
 
-      if (auto png = std::get_if<PNGPayload>(&payload))
-         has_trailing = png->has_trailing_data();
-      else if (auto ico = std::get_if<ICOPayload>(&payload))
-         has_trailing = (*ico)->has_trailing_data();
-      
-      if (has_trailing) {
-         if (!minimal) { status_alert("Trailing data found!\n"); }
-         minimal_report.push_back("trailing-data");
+   if (ico != nullptr && (auto_detect || parser.is_used("--stego-data")))
+   {
+      if (!minimal) { status_normal("Checking the icon for a striped stego payload..."); }
+
+      bool has_striped = false;
+
+      try {
+         has_striped = ico->has_striped_stego_payload();
       }
-      else if (!minimal) { status_normal("No trailing data found.\n"); }
+      catch (exception::Exception &exc) {
+         if (!minimal) { status_error("Failed to load input: ", exc.error); }
+         return 3;
+      }
+
+      if (has_striped) {
+         if (!minimal) { status_alert("Striped stego data present!\n"); }
+         minimal_report.push_back("striped-stego");
+      }
+      else if (!minimal) { status_normal("No striped stego data present.\n"); }
+
+      if (!minimal) { status_normal("Checking the icon's bitmap entries for stego payloads..."); }
+
+      for (auto index : ico->bmp_indexes())
+      {
+         if (!ico->has_bmp_stego_payload(index)) { continue; }
+
+         if (!minimal) { status_alert("Stego data present in bitmap entry ", index, "!"); }
+         minimal_report.push_back("entry" + std::to_string(index) + ":bmp-stego");
+      }
+
+      if (!minimal) { status_normal("Finished scanning bitmap entries.\n"); }
    }
 
-   if (auto_detect || parser.is_used("--text-data"))
+   for (auto &image : images)
    {
-      if (!minimal) { status_normal("Checking for tEXt payloads..."); }
+      /* payloads in icon entries other than the primary one are reported as entry<index>:<payload> */
+      auto label = (image.first.empty()) ? std::string() : image.first.substr(0, image.first.size()-1) + ":";
+      auto png = &image.second;
 
-      auto keyword = parser.get<std::string>("--text-data");
+      if (images.size() > 1 && !minimal)
+         status_normal("Examining ", (label.empty()) ? std::string("primary PNG entry") : image.first.substr(0, image.first.size()-1), "...\n");
 
-      if (keyword.size() == 0 && !minimal) { status_normal("tEXt keyword is blank, scanning tEXt sections."); }
+      if (auto_detect || parser.is_used("--trailing-data"))
+      {
+         if (!minimal) { status_normal("Checking for trailing data..."); }
 
-      bool has_text = false;
+         bool has_trailing = png->has_trailing_data();
 
-      if (auto png = std::get_if<PNGPayload>(&payload))
-         has_text = png->has_chunk("tEXt");
-      else if (auto ico = std::get_if<ICOPayload>(&payload))
-         has_text = (*ico)->has_chunk("tEXt");
+         if (has_trailing) {
+            if (!minimal) { status_alert("Trailing data found! (", std::as_const(*png).get_trailing_data().size(), " bytes)"); }
+            minimal_report.push_back(label + "trailing-data");
 
-      if (!has_text)
-      {
-         if (!minimal) { status_normal("No tEXt sections present."); }
+            /* the embedded files describe the trailing data rather than being payloads of their own, so they're only
+               listed in the minimal report and don't add to the payload count */
+            for (auto &file : png->scan_trailing_data())
+            {
+               if (!minimal)
+               {
+                  status_alert("-> ", format_name(file.format), " at offset ", file.offset, ", ",
+                               (file.exact_size) ? "" : "up to ", file.size, " bytes");
+               }
+               else { minimal_report.push_back(label + "trailing-data:" + format_name(file.format) + "@" + std::to_string(file.offset)); }
+            }
+
+            if (!minimal) { std::cout << std::endl; }
+         }
+         else if (!minimal) { status_normal("No trailing data found.\n"); }
       }
-      else
+
+      if (auto_detect || parser.is_used("--text-data"))
       {
-         std::vector<png::ChunkVec> text_chunks;
+         if (!minimal) { status_normal("Checking for tEXt payloads..."); }
 
-         if (auto png = std::get_if<PNGPayload>(&payload))
-            text_chunks = png->get_chunks("tEXt");
-         else if (auto ico = std::get_if<ICOPayload>(&payload))
-            text_chunks = (*ico)->get_chunks("tEXt");
-         
-         std::vector<std::string> found_payloads;
+         auto keyword = parser.get<std::string>("--text-data");
+
+         if (keyword.size() == 0 && !minimal) { status_normal("tEXt keyword is blank, scanning tEXt sections."); }
 
-         for (auto &chunk : text_chunks)
+         bool has_text = png->has_chunk("tEXt");
+
+         if (!has_text)
+         {
+            if (!minimal) { status_normal("No tEXt sections present."); }
+         }
+         else
          {
-            auto text_chunk = chunk.upcast<png::Text>();
-            auto found_keyword = text_chunk.keyword();
-            if (keyword.size() > 0 && found_keyword != keyword) { continue; }
+            png::ChunkView<> text_chunks;
+
+            text_chunks = png->get_chunks("tEXt");
 
-            auto data = text_chunk.text();
+            std::vector<std::string> found_payloads;
 
-            if (is_base64_string(data)) {
-               if (!minimal) { status_alert("Found payload keyword in tEXt: ", found_keyword); }
-               found_payloads.push_back(found_keyword);
+            for (auto &chunk : text_chunks)
+            {
+               auto &text_chunk = chunk.upcast<png::Text>();
+               auto found_keyword = text_chunk.keyword_view();
+               if (keyword.size() > 0 && found_keyword != keyword) { continue; }
+
+               auto data = text_chunk.text_view();
+
+               if (is_base64_string(data)) {
+                  if (!minimal) { status_alert("Found payload keyword in tEXt: ", found_keyword); }
+                  found_payloads.push_back(std::string(found_keyword));
+               }
+            }
+
+            for (auto &found_keyword : found_payloads)
+            {
+               minimal_report.push_back(label + std::string("tEXt:") + found_keyword);
             }
          }
 
-         for (auto &found_keyword : found_payloads)
+         if (!minimal) { status_normal("Finished scanning for tEXt payloads.\n"); }
+      }
+
+      if (auto_detect || parser.is_used("--ztxt-data"))
+      {
+         if (!minimal) { status_normal("Checking for zTXt payloads..."); }
+
+         auto keyword = parser.get<std::string>("--ztxt-data");
+
+         if (keyword.size() == 0 && !minimal) { status_normal("zTXt keyword is blank, scanning zTXt sections."); }
+
+         bool has_text = png->has_chunk("zTXt");
+
+         if (!has_text)
          {
-            minimal_report.push_back(std::string("tEXt:") + found_keyword);
+            if (!minimal) { status_normal("No zTXt sections present."); }
          }
-      }
+         else
+         {
+            png::ChunkView<> text_chunks;
 
-      if (!minimal) { status_normal("Finished scanning for tEXt payloads.\n"); }
-   }
-   
-   if (auto_detect || parser.is_used("--ztxt-data"))
-   {
-      if (!minimal) { status_normal("Checking for zTXt payloads..."); }
+            text_chunks = png->get_chunks("zTXt");
 
-      auto keyword = parser.get<std::string>("--ztxt-data");
+            std::vector<std::string> found_payloads;
+            std::vector<std::string> segmented_keywords;
 
-      if (keyword.size() == 0 && !minimal) { status_normal("zTXt keyword is blank, scanning zTXt sections."); }
+            for (auto &chunk : text_chunks)
+            {
+               auto &text_chunk = chunk.upcast<png::ZText>();
+               auto found_keyword = text_chunk.keyword_view();
+               if (keyword.size() > 0 && found_keyword != keyword) { continue; }
 
-      bool has_text = false;
+               std::string_view data;
+               try {
+                  if (!minimal) { status_normal("Attempting to decompress zTXt section with keyword \"", found_keyword, "\"..."); }
+                  data = text_chunk.text_view();
+                  if (!minimal) { status_normal("Text decompressed!"); }
+               }
+               catch (exception::Exception &exc) {
+                  if (!minimal) { status_error("Decompression failed: ", exc.error); }
+                  return 2;
+               }
 
-      if (auto png = std::get_if<PNGPayload>(&payload))
-         has_text = png->has_chunk("zTXt");
-      else if (auto ico = std::get_if<ICOPayload>(&payload))
-         has_text = (*ico)->has_chunk("zTXt");
-      
-      if (!has_text)
+               if (is_base64_string(data)) {
+                  if (!minimal) { status_alert("Found payload keyword in zTXt: ", found_keyword); }
+                  found_payloads.push_back(std::string(found_keyword));
+               }
+               else if (PNGPayload::is_ztext_segment(data)) {
+                  /* report a segmented payload once, not once per segment */
+                  if (std::find(segmented_keywords.begin(), segmented_keywords.end(), found_keyword) != segmented_keywords.end()) { continue; }
+
+                  if (!minimal) { status_alert("Found segmented payload keyword in zTXt: ", found_keyword); }
+                  segmented_keywords.push_back(std::string(found_keyword));
+                  found_payloads.push_back(std::string(found_keyword));
+               }
+            }
+
+            for (auto &found_keyword : found_payloads)
+            {
+               minimal_report.push_back(label + std::string("zTXt:") + found_keyword);
+            }
+         }
+
+         if (!minimal) { status_normal("Finished scanning for zTXt payloads.\n"); }
+      }
+
+      if (auto_detect || parser.is_used("--binary-data"))
       {
-         if (!minimal) { status_normal("No zTXt sections present."); }
+         if (!minimal) { status_normal("Checking for faCd payloads..."); }
+
+         auto keyword = parser.get<std::string>("--binary-data");
+
+         if (keyword.size() == 0 && !minimal) { status_normal("faCd keyword is blank, scanning faCd sections."); }
+
+         bool has_binary = png->has_binary();
+
+         if (!has_binary)
+         {
+            if (!minimal) { status_normal("No faCd sections present."); }
+         }
+         else
+         {
+            png::ChunkView<> binary_chunks;
+
+            binary_chunks = png->get_chunks("faCd");
+
+            /* faCd chunks only ever hold payloads, so there's nothing to decode here */
+            for (auto &chunk : binary_chunks)
+            {
+               auto &binary_chunk = chunk.upcast<png::BinaryData>();
+               if (!binary_chunk.has_keyword()) { continue; }
+
+               auto found_keyword = binary_chunk.keyword();
+               if (keyword.size() > 0 && found_keyword != keyword) { continue; }
+
+               if (!minimal) { status_alert("Found payload keyword in faCd: ", found_keyword); }
+               minimal_report.push_back(label + std::string("faCd:") + found_keyword);
+            }
+         }
+
+         if (!minimal) { status_normal("Finished scanning for faCd payloads.\n"); }
       }
-      else
+
+      if (auto_detect || parser.is_used("--stego-data"))
       {
-         std::vector<png::ChunkVec> text_chunks;
+         if (!minimal) { status_normal("Checking for stego payload..."); }
 
-         if (auto png = std::get_if<PNGPayload>(&payload))
-            text_chunks = png->get_chunks("zTXt");
-         else if (auto ico = std::get_if<ICOPayload>(&payload))
-            text_chunks = (*ico)->get_chunks("zTXt");
-            
-         std::vector<std::string> found_payloads;
+         try {
+            if (!minimal) { status_normal("Loading input to check for stego data..."); }
+
+            if (!png->is_loaded()) { png->load(); }
+
+            if (!minimal) { status_normal("Input loaded!"); }
+         }
+         catch (exception::Exception &exc) {
+            if (!minimal) { status_error("Failed to load input: ", exc.error); }
+            return 3;
+         }
+
+         bool has_stego = png->has_stego_payload();
 
-         for (auto &chunk : text_chunks)
+         if (has_stego) {
+            if (!minimal) { status_alert("Stego data present!\n"); }
+            minimal_report.push_back(label + "stego");
+         }
+         else if (!minimal) { status_normal("No stego data present.\n"); }
+
+         if (png->is_animated())
          {
-            auto text_chunk = chunk.upcast<png::ZText>();
-            auto found_keyword = text_chunk.keyword();
-            if (keyword.size() > 0 && found_keyword != keyword) { continue; }
+            bool has_frame_stego = false;
 
-            std::string data;
             try {
-               if (!minimal) { status_normal("Attempting to decompress zTXt section with keyword \"", found_keyword, "\"..."); }
-               data = text_chunk.text();
-               if (!minimal) { status_normal("Text decompressed!"); }
+               has_frame_stego = png->has_frame_stego_payload();
             }
             catch (exception::Exception &exc) {
-               if (!minimal) { status_error("Decompression failed: ", exc.error); }
-               return 2;
+               if (!minimal) { status_error("Failed to load frames: ", exc.error); }
+               return 3;
             }
-            
-            if (is_base64_string(data)) {
-               if (!minimal) { status_alert("Found payload keyword in zTXt: ", found_keyword); }
-               found_payloads.push_back(found_keyword);
-            }
-         }
 
-         for (auto &found_keyword : found_payloads)
-         {
-            minimal_report.push_back(std::string("zTXt:") + found_keyword);
+            if (has_frame_stego) {
+               if (!minimal) { status_alert("Frame stego data present!\n"); }
+               minimal_report.push_back(label + "frame-stego");
+            }
+            else if (!minimal) { status_normal("No frame stego data present.\n"); }
          }
       }
 
-      if (!minimal) { status_normal("Finished scanning for zTXt payloads.\n"); }
-   }
+      if (parser.is_used("--lsb-analysis"))
+      {
+         if (!minimal) { status_normal("Running statistical analysis of the lowest bits..."); }
 
-   if (auto_detect || parser.is_used("--stego-data"))
-   {
-      if (!minimal) { status_normal("Checking for stego payload..."); }
+         try {
+            if (!png->is_loaded()) { png->load(); }
+         }
+         catch (exception::Exception &exc) {
+            if (!minimal) { status_error("Failed to load input: ", exc.error); }
+            return 3;
+         }
 
-      try {
-         if (!minimal) { status_normal("Loading input to check for stego data..."); }
+         auto format = [](double value) {
+            std::ostringstream stream;
+            stream << std::fixed << std::setprecision(3) << value;
+            return stream.str();
+         };
 
-         if (auto png = std::get_if<PNGPayload>(&payload))
-            png->load();
-         else if (auto ico = std::get_if<ICOPayload>(&payload))
-            (*ico)->load();
-         
-         if (!minimal) { status_normal("Input loaded!"); }
-      }
-      catch (exception::Exception &exc) {
-         if (!minimal) { status_error("Failed to load input: ", exc.error); }
-         return 3;
-      }
+         try {
+            auto analysis = analyze_lsb(*png);
 
-      bool has_stego = false;
+            if (!minimal)
+            {
+               for (std::size_t plane=0; plane<analysis.planes.size(); ++plane)
+               {
+                  auto &estimate = analysis.planes[plane];
+                  status_normal("Bit plane ", plane, ": chi-square ", format(estimate.chi_square), ", RS ", format(estimate.rs),
+                                ", sample pairs ", format(estimate.sample_pairs));
+               }
 
-      if (auto png = std::get_if<PNGPayload>(&payload))
-         has_stego = png->has_stego_payload();
-      else if (auto ico = std::get_if<ICOPayload>(&payload))
-         has_stego = (*ico)->has_stego_payload();
-      
-      if (has_stego) {
-         if (!minimal) { status_alert("Stego data present!\n"); }
-         minimal_report.push_back("stego");
+               status_alert("LSB suspicion score: ", format(analysis.score()), "\n");
+            }
+            else { minimal_report.push_back(label + "lsb-score:" + format(analysis.score())); }
+         }
+         catch (exception::UnsupportedPixelType &) {
+            if (!minimal) { status_normal("LSB analysis needs 8-bit grayscale or true color image data, skipping.\n"); }
+         }
       }
-      else if (!minimal) { status_normal("No stego data present.\n"); }
    }
 
    if (!minimal) { status_normal("Finished detecting payloads. Found ", minimal_report.size(), " payload", ((minimal_report.size() == 1) ? "." : "s.")); }
@@ -1019,9 +1718,51 @@ int main(int argc, char *argv[])
       .help("The keyword and filename to add as a 'zTXt' section payload (e.g., -z facade payload.bin). "
             "This can be set multiple times, with the same or differing keywords.");
 
+   create_args.add_argument("-b", "--binary-section-payload")
+      .nargs(2)
+      .append()
+      .help("The keyword and filename to add as a raw 'faCd' section payload (e.g., -b facade payload.bin). "
+            "This avoids the base64 overhead of 'tEXt' and 'zTXt' payloads. "
+            "This can be set multiple times, with the same or differing keywords.");
+
+   create_args.add_argument("-c", "--compress-binary")
+      .help("Compress the 'faCd' section payloads with zlib.")
+      .default_value(false)
+      .implicit_value(true);
+
    create_args.add_argument("-s", "--stego-payload")
       .help("Encode the given filename in the image with basic steganography.");
 
+   create_args.add_argument("--striped")
+      .help("With an icon input, spread the stego payload across every PNG entry instead of only the first.")
+      .default_value(false)
+      .implicit_value(true);
+
+   create_args.add_argument("--stream")
+      .help("With a PNG input, encode the stego payload as a stream of independently compressed blocks with a 64-bit size, reading the "
+            "payload file a block at a time. This lifts the 4 GiB limit and keeps the payload out of memory. "
+            "Only one of --stream, --frames, --striped and --bmp can be given.")
+      .default_value(false)
+      .implicit_value(true);
+
+   create_args.add_argument("--frames")
+      .help("With an animated PNG input, spread the stego payload across every frame of the animation. "
+            "Each frame is encoded on its own worker.")
+      .default_value(false)
+      .implicit_value(true);
+
+   create_args.add_argument("--bmp")
+      .help("With an icon input, encode the stego payload in its largest 24- or 32-bit bitmap entry instead of a PNG entry. "
+            "This skips recompressing an image entirely.")
+      .default_value(false)
+      .implicit_value(true);
+
+   create_args.add_argument("-n", "--deinterlace")
+      .help("Rewrite an Adam7-interlaced input without interlacing.")
+      .default_value(false)
+      .implicit_value(true);
+
+   add_common_arguments(create_args);
    args.add_subparser(create_args);
       
    argparse::ArgumentParser extract_args("extract");
@@ -1045,17 +1786,27 @@ int main(int argc, char *argv[])
       .default_value(false)
       .implicit_value(true);
 
+   extract_args.add_argument("-c", "--carve")
+      .help("Also carve files recognized in the trailing data, such as ZIP archives or executables, out into files of their own.")
+      .default_value(false)
+      .implicit_value(true);
+
    extract_args.add_argument("-t", "--text-section-payload")
       .help("The keyword of the 'tEXt' payload to extract. One keyword can have multiple payloads associated with it.");
    
    extract_args.add_argument("-z", "--ztxt-section-payload")
       .help("The keyword of the 'zTXt' payload to extract. One keyword can have multiple payloads associated with it.");
 
+   extract_args.add_argument("-b", "--binary-section-payload")
+      .help("The keyword of the 'faCd' payload to extract. One keyword can have multiple payloads associated with it.");
+
    extract_args.add_argument("-s", "--stego-payload")
       .help("Extract a stegonography-encoded file to the given file.")
       .default_value(false)
       .implicit_value(true);
 
+   add_common_arguments(extract_args);
+
    argparse::ArgumentParser detect_args("detect");
    detect_args.add_description("Detect what possible methods are encoded in this PNG file.");
 
@@ -1088,9 +1839,22 @@ int main(int argc, char *argv[])
             "Supply a blank string to detect all 'zTXt' payloads, or supply a keyword to detect a specific payload.")
       .default_value(std::string(""));
 
+   detect_args.add_argument("-b", "--binary-data")
+      .help("Check if this PNG has a 'faCd' section payload. "
+            "Supply a blank string to detect all 'faCd' payloads, or supply a keyword to detect a specific payload.")
+      .default_value(std::string(""));
+
    detect_args.add_argument("-s", "--stego-data")
       .help("Check if this PNG image has a steganographic payload.");
 
+   detect_args.add_argument("-l", "--lsb-analysis")
+      .help("Score how likely this PNG image is to hide data in the lowest bits of its pixels, by any tool, "
+            "with chi-square, RS and sample pair analysis. Not run by --auto-detect.")
+      .default_value(false)
+      .implicit_value(true);
+
+   add_common_arguments(detect_args);
+
    args.add_subparser(create_args);
    args.add_subparser(extract_args);
    args.add_subparser(detect_args);
@@ -1112,18 +1876,59 @@ int main(int argc, char *argv[])
       std::exit(2);
    }
    
+   auto &subcommand = args.at<argparse::ArgumentParser>(args.is_subcommand_used(create_args) ? "create"
+                                                        : args.is_subcommand_used(extract_args) ? "extract"
+                                                        : "detect");
+
+   if (subcommand.is_used("--stats"))
+   {
+      auto format = subcommand.get<std::string>("--stats");
+
+      if (format != "human" && format != "json")
+      {
+         std::cerr << "Argument parsing failed: --stats must be \"human\" or \"json\", not \"" << format << "\"." << std::endl;
+         std::exit(1);
+      }
+   }
+
+   TrackingResource tracker;
+
+   if (subcommand.is_used("--memory-limit"))
+      tracker.set_limit(get_number_argument(subcommand, "--memory-limit", "bytes"));
+
+   /* every parallel stage, including those of icons, runs on the default executor unless told otherwise */
+   std::unique_ptr<ThreadPool> pool;
+
+   if (subcommand.is_used("--threads"))
+   {
+      auto threads = get_number_argument(subcommand, "--threads", "threads");
+
+      if (threads == 0)
+      {
+         std::cerr << "Argument parsing failed: --threads must be at least 1." << std::endl;
+         std::exit(1);
+      }
+
+      pool = std::make_unique<ThreadPool>(threads);
+      set_default_executor(pool.get());
+   }
+
+   auto stats = make_stats(subcommand, tracker);
    int exit_code;
 
    try
    {
       if (args.is_subcommand_used(create_args))
-         exit_code = create_payload(args.at<argparse::ArgumentParser>("create"));
+         exit_code = create_payload(subcommand, stats);
       else if (args.is_subcommand_used(extract_args))
-         exit_code = extract_payloads(args.at<argparse::ArgumentParser>("extract"));
+         exit_code = extract_payloads(subcommand, stats);
       else if (args.is_subcommand_used(detect_args))
-         exit_code = detect_payloads(args.at<argparse::ArgumentParser>("detect"));
+         exit_code = detect_payloads(subcommand, stats);
+
+      /* the stats are reported even when the subcommand failed, since that's often when they're wanted most */
+      auto stats_code = report_stats(subcommand, stats);
 
-      return exit_code;
+      return (exit_code != 0) ? exit_code : stats_code;
    }
    catch (std::exception &exc)
    {